@@ -1324,7 +1324,7 @@ struct Aiger2Backend : Backend {
 		ct.setup_internals_eval();
 		log("    ");
 		int col = 0;
-		for (auto pair : ct.cell_types)
+		for (auto pair : ct.all_cell_types())
 		if (!supported.count(pair.first)) {
 			if (col + pair.first.size() + 2 > 72) {
 				log("\n    ");
@@ -1341,7 +1341,7 @@ struct Aiger2Backend : Backend {
 		ct2.setup_stdcells();
 		log("    ");
 		col = 0;
-		for (auto pair : ct2.cell_types)
+		for (auto pair : ct2.all_cell_types())
 		if (!supported.count(pair.first)) {
 			if (col + pair.first.size() + 2 > 72) {
 				log("\n    ");
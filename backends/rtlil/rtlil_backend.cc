@@ -438,10 +438,16 @@ struct RTLILBackend : public Backend {
 		log("    -selected\n");
 		log("        only write selected parts of the design.\n");
 		log("\n");
+		log("    -binary\n");
+		log("        write a binary file that read_rtlil loads much faster than the text\n");
+		log("        format, e.g. for checkpoints between steps of a flow. Together with\n");
+		log("        -selected only whole selected modules are written.\n");
+		log("\n");
 	}
 	void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		bool selected = false;
+		bool binary = false;
 
 		log_header(design, "Executing RTLIL backend.\n");
 
@@ -452,13 +458,21 @@ struct RTLILBackend : public Backend {
 				selected = true;
 				continue;
 			}
+			if (arg == "-binary") {
+				binary = true;
+				continue;
+			}
 			break;
 		}
-		extra_args(f, filename, args, argidx);
+		extra_args(f, filename, args, argidx, binary);
 
 		design->sort();
 
 		log("Output filename: %s\n", filename.c_str());
+		if (binary) {
+			RTLIL_BACKEND::dump_design_binary(*f, design, selected);
+			return;
+		}
 		*f << stringf("# Generated by %s\n", yosys_version_str);
 		RTLIL_BACKEND::dump_design(*f, design, selected, true, false);
 	}
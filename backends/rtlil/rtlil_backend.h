@@ -44,6 +44,7 @@ namespace RTLIL_BACKEND {
 	void dump_conn(std::ostream &f, std::string indent, const RTLIL::SigSpec &left, const RTLIL::SigSpec &right);
 	void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module, RTLIL::Design *design, bool only_selected, bool flag_m = true, bool flag_n = false);
 	void dump_design(std::ostream &f, RTLIL::Design *design, bool only_selected, bool flag_m = true, bool flag_n = false);
+	void dump_design_binary(std::ostream &f, RTLIL::Design *design, bool only_selected);
 }
 
 YOSYS_NAMESPACE_END
@@ -0,0 +1,295 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Writer for the binary RTLIL format, see rtlil_binary.h.
+ *
+ */
+
+#include "rtlil_backend.h"
+#include "rtlil_binary.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+using namespace RTLIL_BINARY;
+
+namespace {
+
+// hashlib containers iterate over the most recently inserted entries first,
+// so entries are written in reverse for the reader to recreate the order
+template<typename Dict>
+std::vector<const typename Dict::const_iterator::value_type*> insertion_order(const Dict &container)
+{
+	std::vector<const typename Dict::const_iterator::value_type*> entries;
+	entries.reserve(container.size());
+	for (auto &it : container)
+		entries.push_back(&it);
+	std::reverse(entries.begin(), entries.end());
+	return entries;
+}
+
+struct BinaryWriter
+{
+	dict<RTLIL::IdString, int> string_ids;
+	std::vector<RTLIL::IdString> strings;
+	dict<RTLIL::Wire*, int> wire_ids;
+	Encoder enc;
+
+	int string_id(RTLIL::IdString name)
+	{
+		auto it = string_ids.find(name);
+		if (it == string_ids.end()) {
+			it = string_ids.emplace(name, GetSize(strings)).first;
+			strings.push_back(name);
+		}
+		return it->second;
+	}
+
+	void id(RTLIL::IdString name)
+	{
+		enc.varint(string_id(name));
+	}
+
+	void states(const std::vector<RTLIL::State> &bits)
+	{
+		bool wide = false;
+		for (auto bit : bits)
+			if (bit > RTLIL::Sz)
+				wide = true;
+
+		int width = GetSize(bits);
+		int per_byte = wide ? 2 : 4;
+		enc.u8(wide ? ENC_4BIT : ENC_2BIT);
+		enc.varint(width);
+		for (int i = 0; i < width; i += per_byte) {
+			uint8_t byte = 0;
+			for (int j = 0; j < per_byte && i + j < width; j++)
+				byte |= uint8_t(bits[i + j]) << ((8 / per_byte) * j);
+			enc.u8(byte);
+		}
+	}
+
+	void constant(const RTLIL::Const &value)
+	{
+		enc.varint(uint16_t(value.flags));
+		if (value.flags & RTLIL::CONST_FLAG_STRING) {
+			std::string str = value.decode_string();
+			enc.u8(ENC_STRING);
+			enc.varint(str.size());
+			enc.bytes(str.data(), str.size());
+		} else {
+			states(value.to_bits());
+		}
+	}
+
+	void sigspec(const RTLIL::SigSpec &sig)
+	{
+		enc.varint(GetSize(sig.chunks()));
+		for (auto &chunk : sig.chunks()) {
+			if (chunk.wire == nullptr) {
+				enc.varint(0);
+				states(chunk.data);
+			} else {
+				enc.varint(wire_ids.at(chunk.wire) + 1);
+				enc.varint(chunk.offset);
+				enc.varint(chunk.width);
+			}
+		}
+	}
+
+	void attributes(const RTLIL::AttrObject *obj)
+	{
+		enc.varint(GetSize(obj->attributes));
+		for (auto it : insertion_order(obj->attributes)) {
+			id(it->first);
+			constant(it->second);
+		}
+	}
+
+	void sigsigs(const std::vector<RTLIL::SigSig> &actions)
+	{
+		enc.varint(GetSize(actions));
+		for (auto &it : actions) {
+			sigspec(it.first);
+			sigspec(it.second);
+		}
+	}
+
+	void switch_rule(const RTLIL::SwitchRule *sw);
+
+	void case_rule(const RTLIL::CaseRule *cs)
+	{
+		attributes(cs);
+		enc.varint(GetSize(cs->compare));
+		for (auto &sig : cs->compare)
+			sigspec(sig);
+		sigsigs(cs->actions);
+		enc.varint(GetSize(cs->switches));
+		for (auto sw : cs->switches)
+			switch_rule(sw);
+	}
+
+	void process(const RTLIL::Process *proc)
+	{
+		id(proc->name);
+		attributes(proc);
+		case_rule(&proc->root_case);
+		enc.varint(GetSize(proc->syncs));
+		for (auto sync : proc->syncs) {
+			enc.u8(sync->type);
+			sigspec(sync->signal);
+			sigsigs(sync->actions);
+			enc.varint(GetSize(sync->mem_write_actions));
+			for (auto &act : sync->mem_write_actions) {
+				attributes(&act);
+				id(act.memid);
+				sigspec(act.address);
+				sigspec(act.data);
+				sigspec(act.enable);
+				constant(act.priority_mask);
+			}
+		}
+	}
+
+	void module(RTLIL::Module *module)
+	{
+		attributes(module);
+
+		enc.varint(GetSize(module->avail_parameters));
+		for (auto param : module->avail_parameters)
+			id(param);
+		enc.varint(GetSize(module->parameter_default_values));
+		for (auto it : insertion_order(module->parameter_default_values)) {
+			id(it->first);
+			constant(it->second);
+		}
+
+		wire_ids.clear();
+		enc.varint(GetSize(module->wires_));
+		for (auto it : insertion_order(module->wires_)) {
+			RTLIL::Wire *wire = it->second;
+			int index = GetSize(wire_ids);
+			wire_ids[wire] = index;
+			id(wire->name);
+			attributes(wire);
+			enc.varint(wire->width);
+			enc.zigzag(wire->start_offset);
+			enc.varint(wire->port_id);
+			enc.u8((wire->port_input ? WIRE_INPUT : 0) | (wire->port_output ? WIRE_OUTPUT : 0) |
+					(wire->upto ? WIRE_UPTO : 0) | (wire->is_signed ? WIRE_SIGNED : 0));
+		}
+
+		enc.varint(GetSize(module->memories));
+		for (auto it : insertion_order(module->memories)) {
+			RTLIL::Memory *memory = it->second;
+			id(memory->name);
+			attributes(memory);
+			enc.varint(memory->width);
+			enc.zigzag(memory->start_offset);
+			enc.varint(memory->size);
+		}
+
+		enc.varint(GetSize(module->cells_));
+		for (auto it : insertion_order(module->cells_)) {
+			RTLIL::Cell *cell = it->second;
+			id(cell->name);
+			id(cell->type);
+			attributes(cell);
+			enc.varint(GetSize(cell->parameters));
+			for (auto param : insertion_order(cell->parameters)) {
+				id(param->first);
+				constant(param->second);
+			}
+			enc.varint(GetSize(cell->connections()));
+			for (auto conn : insertion_order(cell->connections())) {
+				id(conn->first);
+				sigspec(conn->second);
+			}
+		}
+
+		enc.varint(GetSize(module->processes));
+		for (auto it : insertion_order(module->processes))
+			process(it->second);
+
+		sigsigs(module->connections());
+	}
+};
+
+void BinaryWriter::switch_rule(const RTLIL::SwitchRule *sw)
+{
+	attributes(sw);
+	sigspec(sw->signal);
+	enc.varint(GetSize(sw->cases));
+	for (auto cs : sw->cases)
+		case_rule(cs);
+}
+
+}
+
+void RTLIL_BACKEND::dump_design_binary(std::ostream &f, RTLIL::Design *design, bool only_selected)
+{
+	BinaryWriter writer;
+	uint64_t pos = 0;
+
+	Encoder &enc = writer.enc;
+	enc.bytes(magic, sizeof(magic));
+	enc.fixed(version, 4);
+	enc.fixed(autoidx, 8);
+	f.write(enc.buf.data(), enc.buf.size());
+	pos += enc.buf.size();
+
+	std::vector<RTLIL::Module*> modules;
+	if (only_selected)
+		modules = design->selected_whole_modules_warn();
+	else
+		modules = design->modules().to_vector();
+	std::reverse(modules.begin(), modules.end());
+
+	std::vector<std::pair<uint64_t, uint64_t>> sections;
+	for (auto module : modules) {
+		enc.buf.clear();
+		writer.module(module);
+		f.write(enc.buf.data(), enc.buf.size());
+		sections.push_back({pos, enc.buf.size()});
+		pos += enc.buf.size();
+	}
+
+	Encoder index;
+	index.varint(GetSize(modules));
+	for (int i = 0; i < GetSize(modules); i++) {
+		index.varint(writer.string_id(modules[i]->name));
+		index.varint(sections[i].first);
+		index.varint(sections[i].second);
+	}
+
+	enc.buf.clear();
+	enc.varint(GetSize(writer.strings));
+	for (auto &str : writer.strings) {
+		enc.varint(str.size());
+		enc.bytes(str.c_str(), str.size() + 1);
+	}
+	uint64_t strings_pos = pos;
+	uint64_t index_pos = pos + enc.buf.size();
+	enc.bytes(index.buf.data(), index.buf.size());
+	enc.fixed(strings_pos, 8);
+	enc.fixed(index_pos, 8);
+	enc.bytes(magic, sizeof(magic));
+	f.write(enc.buf.data(), enc.buf.size());
+}
+
+YOSYS_NAMESPACE_END
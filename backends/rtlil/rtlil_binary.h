@@ -0,0 +1,160 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Binary RTLIL, written by `write_rtlil -binary` and read by `read_rtlil`.
+ *  It stores the same information as the text format in a form that can be
+ *  read without lexing and with each IdString interned only once:
+ *
+ *    header    magic, u32 version, u64 autoidx
+ *    modules   one section per module, see below
+ *    strings   varint count, then per string: varint length, bytes, '\0'
+ *    index     varint count, then per module: varint name, offset, size
+ *    trailer   u64 offset of the string table, u64 offset of the index, magic
+ *
+ *  Fixed width fields are little endian, all other integers are LEB128
+ *  varints (zigzag encoded where they can be negative), and IdStrings are
+ *  indices into the string table. The index allows loading single modules
+ *  without decoding the others.
+ *
+ *  A module section holds the attributes, parameters, wires, memories,
+ *  cells, processes and connections of the module, in this order. Signals
+ *  refer to wires by their position in the section. Constants are stored
+ *  as strings if they carry CONST_FLAG_STRING, otherwise with two bits per
+ *  state, or four bits per state if they contain '-' or 'm'. Modules, wires,
+ *  cells, attributes etc. are stored in the order they were added, so that
+ *  a design read back from the file iterates over them in the same order.
+ *
+ */
+
+#ifndef RTLIL_BINARY_H
+#define RTLIL_BINARY_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace RTLIL_BINARY
+{
+	static const char magic[8] = { '\x89', 'R', 'T', 'L', 'I', 'L', '\x1a', '\n' };
+	static const uint32_t version = 1;
+	static const int header_size = 8 + 4 + 8;
+	static const int trailer_size = 8 + 8 + 8;
+
+	enum ConstEncoding : uint8_t {
+		ENC_STRING = 0,
+		ENC_2BIT = 1,
+		ENC_4BIT = 2,
+	};
+
+	enum WireFlags : uint8_t {
+		WIRE_INPUT = 1,
+		WIRE_OUTPUT = 2,
+		WIRE_UPTO = 4,
+		WIRE_SIGNED = 8,
+	};
+
+	struct Encoder
+	{
+		std::string buf;
+
+		void u8(uint8_t v) {
+			buf.push_back(char(v));
+		}
+		void fixed(uint64_t v, int bytes) {
+			for (int i = 0; i < bytes; i++)
+				u8(v >> (8 * i));
+		}
+		void varint(uint64_t v) {
+			while (v >= 0x80) {
+				u8(v | 0x80);
+				v >>= 7;
+			}
+			u8(v);
+		}
+		void zigzag(int64_t v) {
+			varint((uint64_t(v) << 1) ^ uint64_t(v >> 63));
+		}
+		void bytes(const char *p, size_t n) {
+			buf.append(p, n);
+		}
+	};
+
+	// Reads from a buffer that stays valid for the lifetime of the decoder,
+	// calling log_error() with the given file name if it runs out of data
+	struct Decoder
+	{
+		const unsigned char *p, *end;
+		const std::string *filename;
+		const char *kind;
+
+		Decoder(const unsigned char *p, const unsigned char *end, const std::string *filename, const char *kind = "Binary RTLIL file") :
+				p(p), end(end), filename(filename), kind(kind) { }
+
+		[[noreturn]] void corrupt() const {
+			log_error("%s `%s' is truncated or corrupt.\n", kind, filename->c_str());
+		}
+		void need(size_t n) const {
+			if (size_t(end - p) < n)
+				corrupt();
+		}
+		uint8_t u8() {
+			need(1);
+			return *p++;
+		}
+		uint64_t fixed(int bytes) {
+			need(bytes);
+			uint64_t v = 0;
+			for (int i = 0; i < bytes; i++)
+				v |= uint64_t(p[i]) << (8 * i);
+			p += bytes;
+			return v;
+		}
+		uint64_t varint() {
+			uint64_t v = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				uint8_t b = u8();
+				v |= uint64_t(b & 0x7f) << shift;
+				if (!(b & 0x80))
+					return v;
+			}
+			corrupt();
+		}
+		int64_t zigzag() {
+			uint64_t v = varint();
+			return int64_t(v >> 1) ^ -int64_t(v & 1);
+		}
+		// number of elements that follow, each of which takes at least a byte
+		int count() {
+			uint64_t v = varint();
+			if (v > uint64_t(end - p))
+				corrupt();
+			return int(v);
+		}
+		const unsigned char *bytes(size_t n) {
+			need(n);
+			const unsigned char *q = p;
+			p += n;
+			return q;
+		}
+	};
+}
+
+YOSYS_NAMESPACE_END
+
+#endif
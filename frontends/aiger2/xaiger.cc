@@ -218,7 +218,7 @@ struct Xaiger2Frontend : public Frontend {
 							if (!cell->hasPort(port_id) || cell->getPort(port_id).size() != port->width)
 								log_error("Malformed design (1)\n");
 
-							SigSpec &conn = cell->connections_[port_id];
+							SigSpec conn = cell->getPort(port_id);
 							for (int j = 0; j < port->width; j++) {
 								if (conn[j].wire && conn[j].wire->port_output)
 									conn[j] = module->addWire(module->uniquify(
@@ -229,6 +229,7 @@ struct Xaiger2Frontend : public Frontend {
 
 								bits[2*(pi_num + ci_counter + box_ci_idx++) + 2] = conn[j];
 							}
+							cell->setPort(port_id, conn);
 						}
 					}
 
@@ -450,6 +451,9 @@ struct Xaiger2Frontend : public Frontend {
 			}
 		}
 
+		// box ports were rewritten bit by bit without going through the monitors
+		module->blackout();
+
 		int box_seq = 0;
 		for (auto [cell, def] : boxes) {
 			if (!retained_boxes[box_seq++])
@@ -304,6 +304,7 @@ AstNode::~AstNode()
 void AstNode::dumpAst(FILE *f, std::string indent) const
 {
 	if (f == NULL) {
+		log_flush();
 		for (auto f : log_files)
 			dumpAst(f, indent);
 		return;
@@ -408,6 +409,7 @@ void AstNode::dumpVlog(FILE *f, std::string indent) const
 	std::vector<AstNode*> rem_children1, rem_children2;
 
 	if (f == NULL) {
+		log_flush();
 		for (auto f : log_files)
 			dumpVlog(f, indent);
 		return;
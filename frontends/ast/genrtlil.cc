@@ -1303,6 +1303,7 @@ void AstNode::detectSignWidthWorker(int &width_hint, bool &sign_hint, bool *foun
 	// everything should have been handled above -> print error if not.
 	default:
 		AstNode *current_scope_ast = current_ast_mod == nullptr ? current_ast : current_ast_mod;
+		log_flush();
 		for (auto f : log_files)
 			current_scope_ast->dumpAst(f, "verilog-ast> ");
 		input_error("Don't know how to detect sign and width for %s node!\n", type2str(type).c_str());
@@ -2278,6 +2279,7 @@ RTLIL::SigSpec AstNode::genRTLIL(int width_hint, bool sign_hint)
 
 	// everything should have been handled above -> print error if not.
 	default:
+		log_flush();
 		for (auto f : log_files)
 			current_ast_mod->dumpAst(f, "verilog-ast> ");
 		input_error("Don't know how to generate RTLIL code for %s node!\n", type2str(type).c_str());
@@ -0,0 +1,421 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Reader for the binary RTLIL format, see backends/rtlil/rtlil_binary.h.
+ *
+ */
+
+#include "rtlil_frontend.h"
+#include "backends/rtlil/rtlil_binary.h"
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+using namespace RTLIL_BINARY;
+
+namespace {
+
+// The contents of the file, mapped into memory if it is a binary RTLIL file
+// on disk, and read from the stream otherwise (e.g. for gzip compressed or
+// inline files)
+struct InputBuffer
+{
+	const unsigned char *data = nullptr;
+	size_t size = 0;
+	void *mapping = nullptr;
+	std::string buffer;
+
+	InputBuffer(std::istream *f, const std::string &filename)
+	{
+#ifndef _WIN32
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd >= 0) {
+			struct stat st;
+			if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && size_t(st.st_size) >= sizeof(magic)) {
+				void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (p != MAP_FAILED && memcmp(p, magic, sizeof(magic)) == 0) {
+					mapping = p;
+					data = static_cast<const unsigned char*>(p);
+					size = st.st_size;
+				} else if (p != MAP_FAILED) {
+					munmap(p, st.st_size);
+				}
+			}
+			close(fd);
+		}
+		if (mapping != nullptr)
+			return;
+#endif
+		buffer.assign(std::istreambuf_iterator<char>(*f), std::istreambuf_iterator<char>());
+		data = reinterpret_cast<const unsigned char*>(buffer.data());
+		size = buffer.size();
+	}
+
+	~InputBuffer()
+	{
+#ifndef _WIN32
+		if (mapping != nullptr)
+			munmap(mapping, size);
+#endif
+	}
+};
+
+struct BinaryReader
+{
+	RTLIL::Design *design;
+	std::vector<const char*> strings;
+	std::vector<RTLIL::IdString> ids;
+	std::vector<RTLIL::Wire*> wires;
+	RTLIL::Module *module = nullptr;
+
+	BinaryReader(RTLIL::Design *design) : design(design) { }
+
+	RTLIL::IdString id(Decoder &d)
+	{
+		uint64_t index = d.varint();
+		if (index >= strings.size())
+			d.corrupt();
+		if (ids[index].empty())
+			ids[index] = strings[index];
+		return ids[index];
+	}
+
+	std::vector<RTLIL::State> states(Decoder &d, uint8_t encoding)
+	{
+		if (encoding != ENC_2BIT && encoding != ENC_4BIT)
+			d.corrupt();
+		int per_byte = encoding == ENC_4BIT ? 2 : 4;
+		int bits_per_state = 8 / per_byte;
+		uint64_t width = d.varint();
+		if (width > uint64_t(d.end - d.p) * per_byte)
+			d.corrupt();
+		const unsigned char *p = d.bytes((width + per_byte - 1) / per_byte);
+
+		std::vector<RTLIL::State> bits(width);
+		for (size_t i = 0; i < width; i++) {
+			int state = (p[i / per_byte] >> (bits_per_state * (i % per_byte))) & ((1 << bits_per_state) - 1);
+			if (state > RTLIL::Sm)
+				d.corrupt();
+			bits[i] = RTLIL::State(state);
+		}
+		return bits;
+	}
+
+	RTLIL::Const constant(Decoder &d)
+	{
+		int flags = d.varint();
+		uint8_t encoding = d.u8();
+		RTLIL::Const value;
+		if (encoding == ENC_STRING) {
+			int len = d.count();
+			value = RTLIL::Const(std::string(reinterpret_cast<const char*>(d.bytes(len)), len));
+		} else {
+			value = RTLIL::Const(states(d, encoding));
+		}
+		value.flags = flags;
+		return value;
+	}
+
+	RTLIL::SigChunk chunk(Decoder &d)
+	{
+		uint64_t wire_index = d.varint();
+		if (wire_index == 0) {
+			RTLIL::SigChunk chunk;
+			chunk.data = states(d, d.u8());
+			chunk.width = GetSize(chunk.data);
+			return chunk;
+		}
+		if (wire_index > wires.size())
+			d.corrupt();
+		RTLIL::Wire *wire = wires[wire_index - 1];
+		uint64_t offset = d.varint();
+		uint64_t width = d.varint();
+		if (offset + width > uint64_t(wire->width))
+			d.corrupt();
+		return RTLIL::SigChunk(wire, offset, width);
+	}
+
+	RTLIL::SigSpec sigspec(Decoder &d)
+	{
+		int count = d.count();
+		if (count == 1)
+			return chunk(d);
+		std::vector<RTLIL::SigChunk> chunks;
+		chunks.reserve(count);
+		for (int i = 0; i < count; i++)
+			chunks.push_back(chunk(d));
+		return chunks;
+	}
+
+	void attributes(Decoder &d, dict<RTLIL::IdString, RTLIL::Const> &attributes)
+	{
+		int count = d.count();
+		for (int i = 0; i < count; i++) {
+			RTLIL::IdString name = id(d);
+			attributes[name] = constant(d);
+		}
+	}
+
+	void sigsigs(Decoder &d, std::vector<RTLIL::SigSig> &actions)
+	{
+		int count = d.count();
+		actions.reserve(actions.size() + count);
+		for (int i = 0; i < count; i++) {
+			RTLIL::SigSpec lhs = sigspec(d);
+			actions.emplace_back(std::move(lhs), sigspec(d));
+		}
+	}
+
+	void switch_rule(Decoder &d, RTLIL::SwitchRule *sw);
+
+	void case_rule(Decoder &d, RTLIL::CaseRule *cs)
+	{
+		attributes(d, cs->attributes);
+		int count = d.count();
+		for (int i = 0; i < count; i++)
+			cs->compare.push_back(sigspec(d));
+		sigsigs(d, cs->actions);
+		count = d.count();
+		for (int i = 0; i < count; i++) {
+			RTLIL::SwitchRule *sw = new RTLIL::SwitchRule;
+			cs->switches.push_back(sw);
+			switch_rule(d, sw);
+		}
+	}
+
+	void process(Decoder &d)
+	{
+		RTLIL::IdString name = id(d);
+		if (module->processes.count(name) != 0)
+			log_error("RTLIL error: redefinition of process %s in module %s.\n", log_id(name), log_id(module));
+		RTLIL::Process *proc = module->addProcess(name);
+		attributes(d, proc->attributes);
+		case_rule(d, &proc->root_case);
+
+		int count = d.count();
+		for (int i = 0; i < count; i++) {
+			RTLIL::SyncRule *sync = new RTLIL::SyncRule;
+			proc->syncs.push_back(sync);
+			uint8_t type = d.u8();
+			if (type > RTLIL::STi)
+				d.corrupt();
+			sync->type = RTLIL::SyncType(type);
+			sync->signal = sigspec(d);
+			sigsigs(d, sync->actions);
+			int num_actions = d.count();
+			for (int j = 0; j < num_actions; j++) {
+				RTLIL::MemWriteAction act;
+				attributes(d, act.attributes);
+				act.memid = id(d);
+				act.address = sigspec(d);
+				act.data = sigspec(d);
+				act.enable = sigspec(d);
+				act.priority_mask = constant(d);
+				sync->mem_write_actions.push_back(std::move(act));
+			}
+		}
+	}
+
+	void read_module(Decoder d, RTLIL::IdString name)
+	{
+		dict<RTLIL::IdString, RTLIL::Const> module_attributes;
+		attributes(d, module_attributes);
+
+		// handle re-definitions the same way as the text parser
+		if (design->has(name)) {
+			RTLIL::Module *existing_mod = design->module(name);
+			if (!RTLIL_FRONTEND::flag_overwrite && (RTLIL_FRONTEND::flag_lib || (module_attributes.count(ID::blackbox) && module_attributes.at(ID::blackbox).as_bool()))) {
+				log("Ignoring blackbox re-definition of module %s.\n", log_id(name));
+				return;
+			} else if (!RTLIL_FRONTEND::flag_nooverwrite && !RTLIL_FRONTEND::flag_overwrite && !existing_mod->get_bool_attribute(ID::blackbox)) {
+				log_error("RTLIL error: redefinition of module %s.\n", log_id(name));
+			} else if (RTLIL_FRONTEND::flag_nooverwrite) {
+				log("Ignoring re-definition of module %s.\n", log_id(name));
+				return;
+			} else {
+				log("Replacing existing%s module %s.\n", existing_mod->get_bool_attribute(ID::blackbox) ? " blackbox" : "", log_id(name));
+				design->remove(existing_mod);
+			}
+		}
+
+		module = new RTLIL::Module;
+		module->name = name;
+		module->attributes = std::move(module_attributes);
+		design->add(module);
+
+		int count = d.count();
+		for (int i = 0; i < count; i++)
+			module->avail_parameters(id(d));
+		count = d.count();
+		for (int i = 0; i < count; i++) {
+			RTLIL::IdString param = id(d);
+			module->parameter_default_values[param] = constant(d);
+		}
+
+		wires.clear();
+		count = d.count();
+		wires.reserve(count);
+		for (int i = 0; i < count; i++) {
+			RTLIL::IdString wire_name = id(d);
+			if (module->wire(wire_name) != nullptr)
+				log_error("RTLIL error: redefinition of wire %s in module %s.\n", log_id(wire_name), log_id(module));
+			RTLIL::Wire *wire = module->addWire(wire_name);
+			attributes(d, wire->attributes);
+			wire->width = d.varint();
+			wire->start_offset = d.zigzag();
+			wire->port_id = d.varint();
+			uint8_t flags = d.u8();
+			wire->port_input = (flags & WIRE_INPUT) != 0;
+			wire->port_output = (flags & WIRE_OUTPUT) != 0;
+			wire->upto = (flags & WIRE_UPTO) != 0;
+			wire->is_signed = (flags & WIRE_SIGNED) != 0;
+			wires.push_back(wire);
+		}
+
+		count = d.count();
+		for (int i = 0; i < count; i++) {
+			RTLIL::Memory *memory = new RTLIL::Memory;
+			memory->name = id(d);
+			if (module->memories.count(memory->name) != 0)
+				log_error("RTLIL error: redefinition of memory %s in module %s.\n", log_id(memory->name), log_id(module));
+			module->memories[memory->name] = memory;
+			attributes(d, memory->attributes);
+			memory->width = d.varint();
+			memory->start_offset = d.zigzag();
+			memory->size = d.varint();
+		}
+
+		count = d.count();
+		for (int i = 0; i < count; i++) {
+			RTLIL::IdString cell_name = id(d);
+			if (module->cell(cell_name) != nullptr)
+				log_error("RTLIL error: redefinition of cell %s in module %s.\n", log_id(cell_name), log_id(module));
+			RTLIL::Cell *cell = module->addCell(cell_name, id(d));
+			attributes(d, cell->attributes);
+			int num_params = d.count();
+			for (int j = 0; j < num_params; j++) {
+				RTLIL::IdString param = id(d);
+				cell->parameters[param] = constant(d);
+			}
+			int num_ports = d.count();
+			for (int j = 0; j < num_ports; j++) {
+				RTLIL::IdString port = id(d);
+				cell->setPort(port, sigspec(d));
+			}
+		}
+
+		count = d.count();
+		for (int i = 0; i < count; i++)
+			process(d);
+
+		std::vector<RTLIL::SigSig> connections;
+		sigsigs(d, connections);
+		for (auto &conn : connections)
+			module->connect(conn);
+
+		if (d.p != d.end)
+			d.corrupt();
+
+		module->fixup_ports();
+		if (RTLIL_FRONTEND::flag_lib)
+			module->makeblackbox();
+		module = nullptr;
+	}
+};
+
+void BinaryReader::switch_rule(Decoder &d, RTLIL::SwitchRule *sw)
+{
+	attributes(d, sw->attributes);
+	sw->signal = sigspec(d);
+	int count = d.count();
+	for (int i = 0; i < count; i++) {
+		RTLIL::CaseRule *cs = new RTLIL::CaseRule;
+		sw->cases.push_back(cs);
+		case_rule(d, cs);
+	}
+}
+
+}
+
+void RTLIL_FRONTEND::read_binary(std::istream *f, const std::string &filename, RTLIL::Design *design, const pool<RTLIL::IdString> &only_modules)
+{
+	InputBuffer input(f, filename);
+	const unsigned char *data = input.data;
+	Decoder file(data, data + input.size, &filename);
+	if (input.size < size_t(header_size + trailer_size))
+		file.corrupt();
+
+	Decoder header(data, data + header_size, &filename);
+	if (memcmp(header.bytes(sizeof(magic)), magic, sizeof(magic)) != 0)
+		file.corrupt();
+	uint32_t file_version = header.fixed(4);
+	if (file_version != version)
+		log_error("Binary RTLIL file `%s' has unsupported version %u.\n", filename.c_str(), file_version);
+	autoidx = std::max<int64_t>(autoidx, header.fixed(8));
+
+	Decoder trailer(data + input.size - trailer_size, data + input.size, &filename);
+	uint64_t strings_pos = trailer.fixed(8);
+	uint64_t index_pos = trailer.fixed(8);
+	if (memcmp(trailer.bytes(sizeof(magic)), magic, sizeof(magic)) != 0)
+		file.corrupt();
+	if (strings_pos < uint64_t(header_size) || strings_pos > index_pos || index_pos > input.size - trailer_size)
+		file.corrupt();
+
+	BinaryReader reader(design);
+	Decoder strings(data + strings_pos, data + index_pos, &filename);
+	int num_strings = strings.count();
+	reader.strings.reserve(num_strings);
+	for (int i = 0; i < num_strings; i++) {
+		uint64_t len = strings.varint();
+		if (len == 0 || len >= uint64_t(strings.end - strings.p))
+			strings.corrupt();
+		const char *str = reinterpret_cast<const char*>(strings.bytes(len + 1));
+		if (str[len] != 0 || (str[0] != '\\' && str[0] != '$'))
+			strings.corrupt();
+		reader.strings.push_back(str);
+	}
+	reader.ids.resize(num_strings);
+
+	Decoder index(data + index_pos, data + input.size - trailer_size, &filename);
+	int num_modules = index.count();
+	pool<RTLIL::IdString> found;
+	for (int i = 0; i < num_modules; i++) {
+		RTLIL::IdString name = reader.id(index);
+		uint64_t offset = index.varint();
+		uint64_t size = index.varint();
+		if (offset < uint64_t(header_size) || offset > strings_pos || size > strings_pos - offset)
+			index.corrupt();
+		if (!only_modules.empty() && !only_modules.count(name))
+			continue;
+		reader.read_module(Decoder(data + offset, data + offset + size, &filename), name);
+		found.insert(name);
+	}
+
+	for (auto name : only_modules)
+		if (!found.count(name))
+			log_error("Module %s not found in `%s'.\n", log_id(name), filename.c_str());
+}
+
+YOSYS_NAMESPACE_END
@@ -23,6 +23,7 @@
  */
 
 #include "rtlil_frontend.h"
+#include "backends/rtlil/rtlil_binary.h"
 #include "kernel/register.h"
 #include "kernel/log.h"
 
@@ -42,7 +43,8 @@ struct RTLILFrontend : public Frontend {
 		log("    read_rtlil [filename]\n");
 		log("\n");
 		log("Load modules from an RTLIL file to the current design. (RTLIL is a text\n");
-		log("representation of a design in yosys's internal format.)\n");
+		log("representation of a design in yosys's internal format.) Binary files written\n");
+		log("by 'write_rtlil -binary' are detected automatically.\n");
 		log("\n");
 		log("    -nooverwrite\n");
 		log("        ignore re-definitions of modules. (the default behavior is to\n");
@@ -55,6 +57,10 @@ struct RTLILFrontend : public Frontend {
 		log("    -lib\n");
 		log("        only create empty blackbox modules\n");
 		log("\n");
+		log("    -module <name>\n");
+		log("        only load the given module from a binary file, without decoding the\n");
+		log("        other modules. Can be specified multiple times.\n");
+		log("\n");
 	}
 	void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
 	{
@@ -62,6 +68,8 @@ struct RTLILFrontend : public Frontend {
 		RTLIL_FRONTEND::flag_overwrite = false;
 		RTLIL_FRONTEND::flag_lib = false;
 
+		pool<RTLIL::IdString> only_modules;
+
 		log_header(design, "Executing RTLIL frontend.\n");
 
 		size_t argidx;
@@ -81,12 +89,23 @@ struct RTLILFrontend : public Frontend {
 				RTLIL_FRONTEND::flag_lib = true;
 				continue;
 			}
+			if (arg == "-module" && argidx+1 < args.size()) {
+				only_modules.insert(RTLIL::escape_id(args[++argidx]));
+				continue;
+			}
 			break;
 		}
-		extra_args(f, filename, args, argidx);
+		extra_args(f, filename, args, argidx, true);
 
 		log("Input filename: %s\n", filename.c_str());
 
+		if (f->peek() == (unsigned char)RTLIL_BINARY::magic[0]) {
+			RTLIL_FRONTEND::read_binary(f, filename, design, only_modules);
+			return;
+		}
+		if (!only_modules.empty())
+			log_cmd_error("Option -module is only supported for binary RTLIL files.\n");
+
 		RTLIL_FRONTEND::lexin = f;
 		RTLIL_FRONTEND::current_design = design;
 		rtlil_frontend_yydebug = false;
@@ -35,6 +35,10 @@ namespace RTLIL_FRONTEND {
 	extern bool flag_nooverwrite;
 	extern bool flag_overwrite;
 	extern bool flag_lib;
+
+	// Reads a binary RTLIL file (see backends/rtlil/rtlil_binary.h), only
+	// loading the given modules unless the pool is empty
+	void read_binary(std::istream *f, const std::string &filename, RTLIL::Design *design, const pool<RTLIL::IdString> &only_modules);
 }
 
 YOSYS_NAMESPACE_END
@@ -0,0 +1,324 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef BITINDEX_H
+#define BITINDEX_H
+
+#include "kernel/yosys.h"
+
+#include <atomic>
+
+YOSYS_NAMESPACE_BEGIN
+
+/**
+ * BitIndex numbers all bits of a module densely, so that per-bit data can be
+ * kept in plain vectors instead of dict<SigBit, T>. The constant states come
+ * first (index == RTLIL::State value), followed by the bits of each wire in
+ * the order of module->wires(). The index keeps the number of bit 0 of each
+ * wire and a table for the reverse direction, so any number of indexes for
+ * the same module can be used at the same time. Building an index also
+ * stores the number in Wire::bitidx_, tagged with a generation number unique
+ * to the build, so lookups in the most recently built index are a single
+ * addition. Lookups in older indexes fall back to the wire_offsets dict.
+ *
+ * The index describes the module at the time it was built. Adding wires,
+ * changing wire widths or reordering the wires with Module::sort()
+ * afterwards invalidates it, which can be checked with valid() (based on the
+ * module change counter, so direct writes to wire->width are not detected).
+ * Building a new index for an unchanged module yields the same numbering.
+ */
+struct BitIndex
+{
+	static constexpr int num_const_bits = RTLIL::State::Sm + 1;
+	static inline std::atomic<int> next_generation = 0;
+
+	RTLIL::Module *module = nullptr;
+	uint64_t change_count = 0;
+	int generation = -1;
+	int num_bits = num_const_bits;
+
+	dict<RTLIL::Wire*, int> wire_offsets;
+	std::vector<RTLIL::SigBit> bits;
+
+	BitIndex(RTLIL::Module *module = nullptr)
+	{
+		if (module != nullptr)
+			set(module);
+	}
+
+	void set(RTLIL::Module *module)
+	{
+		this->module = module;
+		change_count = module->change_count_;
+		generation = next_generation++;
+		num_bits = num_const_bits;
+		for (auto wire : module->wires())
+			num_bits += wire->width;
+
+		wire_offsets.clear();
+		bits.clear();
+		bits.reserve(num_bits);
+		for (int i = 0; i < num_const_bits; i++)
+			bits.push_back(RTLIL::State(i));
+		for (auto wire : module->wires()) {
+			wire->bitidx_ = GetSize(bits);
+			wire->bitidx_gen_ = generation;
+			wire_offsets[wire] = GetSize(bits);
+			for (int i = 0; i < wire->width; i++)
+				bits.push_back(RTLIL::SigBit(wire, i));
+		}
+	}
+
+	bool valid() const
+	{
+		return module != nullptr && module->change_count_ == change_count;
+	}
+
+	int size() const
+	{
+		return num_bits;
+	}
+
+	int operator()(const RTLIL::SigBit &bit) const
+	{
+		if (bit.wire == nullptr)
+			return bit.data;
+		if (bit.wire->bitidx_gen_ == generation)
+			return bit.wire->bitidx_ + bit.offset;
+		return lookup_offset(bit.wire) + bit.offset;
+	}
+
+	// Out of line and pure (it only reads memory), so that lookups in a loop
+	// are inlined and the compiler keeps the loop state in registers.
+	YS_ATTRIBUTE(noinline, pure) int lookup_offset(RTLIL::Wire *wire) const
+	{
+		auto it = wire_offsets.find(wire);
+		log_assert(it != wire_offsets.end());
+		return it->second;
+	}
+
+	const RTLIL::SigBit &operator[](int index) const
+	{
+		return bits[index];
+	}
+};
+
+/**
+ * Per-bit storage on top of a BitIndex, a drop-in for the common uses of
+ * dict<SigBit, T> where every bit of a module is expected to have a value.
+ */
+template<typename T>
+struct BitVectorMap
+{
+	const BitIndex *index = nullptr;
+	std::vector<T> data;
+
+	BitVectorMap() { }
+
+	BitVectorMap(const BitIndex &index, const T &init = T())
+	{
+		set(index, init);
+	}
+
+	void set(const BitIndex &index, const T &init = T())
+	{
+		this->index = &index;
+		data.assign(index.size(), init);
+	}
+
+	T &operator[](const RTLIL::SigBit &bit) { return data[(*index)(bit)]; }
+	const T &operator[](const RTLIL::SigBit &bit) const { return data[(*index)(bit)]; }
+	const T &at(const RTLIL::SigBit &bit) const { return data.at((*index)(bit)); }
+
+	T &operator[](int i) { return data[i]; }
+	const T &operator[](int i) const { return data[i]; }
+
+	int size() const { return GetSize(data); }
+	void fill(const T &value) { std::fill(data.begin(), data.end(), value); }
+};
+
+/**
+ * DenseSigMap has the same interface and the same choice of representatives
+ * as SigMap, but keeps the union-find parents in a vector over a BitIndex
+ * instead of an mfp<SigBit>. It owns its index unless one is passed in.
+ * All bits must belong to the indexed module: use SigMap while wires are
+ * still being added.
+ */
+struct DenseSigMap
+{
+	BitIndex own_index;
+	const BitIndex *index = &own_index;
+	mutable std::vector<int> parents;
+
+	DenseSigMap(RTLIL::Module *module = nullptr)
+	{
+		if (module != nullptr)
+			set(module);
+	}
+
+	DenseSigMap(const DenseSigMap &other) : own_index(other.own_index),
+			index(other.index == &other.own_index ? &own_index : other.index), parents(other.parents) { }
+
+	DenseSigMap &operator=(const DenseSigMap &other)
+	{
+		own_index = other.own_index;
+		index = other.index == &other.own_index ? &own_index : other.index;
+		parents = other.parents;
+		return *this;
+	}
+
+	void clear()
+	{
+		parents.assign(index->size(), -1);
+	}
+
+	// Rebuild the map for all connections in module, reusing the index if
+	// it was built for the same unchanged module
+	void set(RTLIL::Module *module)
+	{
+		if (index == &own_index && !(own_index.module == module && own_index.valid()))
+			own_index.set(module);
+		log_assert(index->module == module);
+		clear();
+		for (auto &it : module->connections())
+			add(it.first, it.second);
+	}
+
+	// Use an index owned by the caller, e.g. to share it with BitVectorMaps
+	void set(RTLIL::Module *module, const BitIndex &shared_index)
+	{
+		index = &shared_index;
+		set(module);
+	}
+
+	int ifind(int i) const
+	{
+		int p = i, k = i;
+
+		while (parents[p] != -1)
+			p = parents[p];
+
+		while (k != p) {
+			int next_k = parents[k];
+			parents[k] = p;
+			k = next_k;
+		}
+
+		return p;
+	}
+
+	void ipromote(int i)
+	{
+		int k = i;
+
+		while (k != -1) {
+			int next_k = parents[k];
+			parents[k] = i;
+			k = next_k;
+		}
+
+		parents[i] = -1;
+	}
+
+	// Add connections from "from" to "to", bit-by-bit
+	void add(const RTLIL::SigSpec &from, const RTLIL::SigSpec &to)
+	{
+		log_assert(GetSize(from) == GetSize(to));
+
+		for (int i = 0; i < GetSize(from); i++)
+		{
+			int bfi = ifind((*index)(from[i]));
+			int bti = ifind((*index)(to[i]));
+
+			bool bf_const = bfi < BitIndex::num_const_bits;
+			bool bt_const = bti < BitIndex::num_const_bits;
+
+			if (!bf_const || !bt_const)
+			{
+				if (bfi != bti)
+					parents[bfi] = bti;
+
+				if (bf_const)
+					ipromote(bfi);
+
+				if (bt_const)
+					ipromote(bti);
+			}
+		}
+	}
+
+	// Make bit the representative of its set, unless that is a constant
+	void add(const RTLIL::SigBit &bit)
+	{
+		int i = (*index)(bit);
+		if (ifind(i) >= BitIndex::num_const_bits)
+			ipromote(i);
+	}
+
+	void add(const RTLIL::SigSpec &sig)
+	{
+		for (const auto &bit : sig)
+			add(bit);
+	}
+
+	inline void add(RTLIL::Wire *wire) { return add(RTLIL::SigSpec(wire)); }
+
+	// Index of the representative of bit
+	int lookup(const RTLIL::SigBit &bit) const
+	{
+		return ifind((*index)(bit));
+	}
+
+	void apply(RTLIL::SigBit &bit) const
+	{
+		int i = (*index)(bit);
+		int p = ifind(i);
+		if (p != i)
+			bit = (*index)[p];
+	}
+
+	void apply(RTLIL::SigSpec &sig) const
+	{
+		for (auto &bit : sig)
+			apply(bit);
+	}
+
+	RTLIL::SigBit operator()(RTLIL::SigBit bit) const
+	{
+		apply(bit);
+		return bit;
+	}
+
+	RTLIL::SigSpec operator()(RTLIL::SigSpec sig) const
+	{
+		apply(sig);
+		return sig;
+	}
+
+	RTLIL::SigSpec operator()(RTLIL::Wire *wire) const
+	{
+		SigSpec sig(wire);
+		apply(sig);
+		return sig;
+	}
+};
+
+YOSYS_NAMESPACE_END
+
+#endif /* BITINDEX_H */
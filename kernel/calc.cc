@@ -97,6 +97,35 @@ static RTLIL::Const big2const(const BigInteger &val, int result_len, int undef_b
 	return result;
 }
 
+// Fast path for fully defined operands of up to max_width bits: returns the
+// value (sign extended to 64 bits if as_signed), or false if the operand is
+// too wide or has undefined bits, in which case the caller uses BigInteger.
+static bool const2word(const RTLIL::Const &val, bool as_signed, uint64_t &word, int max_width = 64)
+{
+	int width = val.size();
+	if (width > max_width)
+		return false;
+
+	word = 0;
+	for (int i = 0; i < width; i++) {
+		RTLIL::State bit = val[i];
+		if (bit == RTLIL::State::S1)
+			word |= uint64_t(1) << i;
+		else if (bit != RTLIL::State::S0)
+			return false;
+	}
+
+	if (as_signed && width > 0 && width < 64 && ((word >> (width - 1)) & 1) != 0)
+		word |= ~uint64_t(0) << width;
+	return true;
+}
+
+// Only valid for result_len <= 64
+static RTLIL::Const word2const(uint64_t word, int result_len)
+{
+	return RTLIL::Const((long long)word, result_len);
+}
+
 static RTLIL::State logic_and(RTLIL::State a, RTLIL::State b)
 {
 	if (a == RTLIL::State::S0) return RTLIL::State::S0;
@@ -134,6 +163,10 @@ RTLIL::Const RTLIL::const_not(const RTLIL::Const &arg1, const RTLIL::Const&, boo
 	if (result_len < 0)
 		result_len = arg1.size();
 
+	uint64_t a;
+	if (result_len <= 64 && const2word(arg1, signed1, a))
+		return word2const(~a, result_len);
+
 	RTLIL::Const arg1_ext = arg1;
 	extend_u0(arg1_ext, result_len, signed1);
 
@@ -150,12 +183,16 @@ RTLIL::Const RTLIL::const_not(const RTLIL::Const &arg1, const RTLIL::Const&, boo
 	return result;
 }
 
-static RTLIL::Const logic_wrapper(RTLIL::State(*logic_func)(RTLIL::State, RTLIL::State),
+static RTLIL::Const logic_wrapper(RTLIL::State(*logic_func)(RTLIL::State, RTLIL::State), uint64_t(*word_func)(uint64_t, uint64_t),
 		RTLIL::Const arg1, RTLIL::Const arg2, bool signed1, bool signed2, int result_len = -1)
 {
 	if (result_len < 0)
 		result_len = max(arg1.size(), arg2.size());
 
+	uint64_t a, b;
+	if (result_len <= 64 && const2word(arg1, signed1, a) && const2word(arg2, signed2, b))
+		return word2const(word_func(a, b), result_len);
+
 	extend_u0(arg1, result_len, signed1);
 	extend_u0(arg2, result_len, signed2);
 
@@ -171,22 +208,22 @@ static RTLIL::Const logic_wrapper(RTLIL::State(*logic_func)(RTLIL::State, RTLIL:
 
 RTLIL::Const RTLIL::const_and(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_and, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper(logic_and, [](uint64_t a, uint64_t b) { return a & b; }, arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_or(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_or, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper(logic_or, [](uint64_t a, uint64_t b) { return a | b; }, arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_xor(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_xor, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper(logic_xor, [](uint64_t a, uint64_t b) { return a ^ b; }, arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_xnor(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_xnor, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper(logic_xnor, [](uint64_t a, uint64_t b) { return ~(a ^ b); }, arg1, arg2, signed1, signed2, result_len);
 }
 
 static RTLIL::Const logic_reduce_wrapper(RTLIL::State initial, RTLIL::State(*logic_func)(RTLIL::State, RTLIL::State), const RTLIL::Const &arg1, int result_len)
@@ -283,7 +320,7 @@ RTLIL::Const RTLIL::const_logic_or(const RTLIL::Const &arg1, const RTLIL::Const
 static RTLIL::Const const_shift_worker(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool sign_ext, bool signed2, int direction, int result_len, RTLIL::State vacant_bits = RTLIL::State::S0)
 {
 	int undef_bit_pos = -1;
-	BigInteger offset = const2big(arg2, signed2, undef_bit_pos) * direction;
+	BigInteger big_offset = const2big(arg2, signed2, undef_bit_pos) * direction;
 
 	if (result_len < 0)
 		result_len = arg1.size();
@@ -292,14 +329,27 @@ static RTLIL::Const const_shift_worker(const RTLIL::Const &arg1, const RTLIL::Co
 	if (undef_bit_pos >= 0)
 		return result;
 
+	// Beyond +/- limit every result bit is padding, so the offset can be
+	// clamped and the loop below can run on machine integers.
+	long limit = (long)arg1.size() + result_len + 1;
+	long offset;
+	if (big_offset > BigInteger(limit))
+		offset = limit;
+	else if (big_offset < BigInteger(-limit))
+		offset = -limit;
+	else
+		offset = big_offset.toLong();
+
+	RTLIL::State fill_bit = sign_ext && !arg1.empty() ? arg1.back() : vacant_bits;
+	std::vector<RTLIL::State> &bits = result.bits();
 	for (int i = 0; i < result_len; i++) {
-		BigInteger pos = BigInteger(i) + offset;
+		long pos = i + offset;
 		if (pos < 0)
-			result.bits()[i] = vacant_bits;
-		else if (pos >= BigInteger(int(arg1.size())))
-			result.bits()[i] = sign_ext ? arg1.back() : vacant_bits;
+			bits[i] = vacant_bits;
+		else if (pos >= arg1.size())
+			bits[i] = fill_bit;
 		else
-			result.bits()[i] = arg1[pos.toInt()];
+			bits[i] = arg1[pos];
 	}
 
 	return result;
@@ -343,6 +393,14 @@ RTLIL::Const RTLIL::const_shiftx(const RTLIL::Const &arg1, const RTLIL::Const &a
 
 RTLIL::Const RTLIL::const_lt(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	uint64_t a, b;
+	if (const2word(arg1, signed1, a, 63) && const2word(arg2, signed2, b, 63)) {
+		RTLIL::Const result((int64_t)a < (int64_t)b ? RTLIL::State::S1 : RTLIL::State::S0);
+		while (int(result.size()) < result_len)
+			result.bits().push_back(RTLIL::State::S0);
+		return result;
+	}
+
 	int undef_bit_pos = -1;
 	bool y = const2big(arg1, signed1, undef_bit_pos) < const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
@@ -354,6 +412,14 @@ RTLIL::Const RTLIL::const_lt(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 
 RTLIL::Const RTLIL::const_le(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	uint64_t a, b;
+	if (const2word(arg1, signed1, a, 63) && const2word(arg2, signed2, b, 63)) {
+		RTLIL::Const result((int64_t)a <= (int64_t)b ? RTLIL::State::S1 : RTLIL::State::S0);
+		while (int(result.size()) < result_len)
+			result.bits().push_back(RTLIL::State::S0);
+		return result;
+	}
+
 	int undef_bit_pos = -1;
 	bool y = const2big(arg1, signed1, undef_bit_pos) <= const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
@@ -428,6 +494,14 @@ RTLIL::Const RTLIL::const_nex(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_ge(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	uint64_t a, b;
+	if (const2word(arg1, signed1, a, 63) && const2word(arg2, signed2, b, 63)) {
+		RTLIL::Const result((int64_t)a >= (int64_t)b ? RTLIL::State::S1 : RTLIL::State::S0);
+		while (int(result.size()) < result_len)
+			result.bits().push_back(RTLIL::State::S0);
+		return result;
+	}
+
 	int undef_bit_pos = -1;
 	bool y = const2big(arg1, signed1, undef_bit_pos) >= const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
@@ -439,6 +513,14 @@ RTLIL::Const RTLIL::const_ge(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 
 RTLIL::Const RTLIL::const_gt(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	uint64_t a, b;
+	if (const2word(arg1, signed1, a, 63) && const2word(arg2, signed2, b, 63)) {
+		RTLIL::Const result((int64_t)a > (int64_t)b ? RTLIL::State::S1 : RTLIL::State::S0);
+		while (int(result.size()) < result_len)
+			result.bits().push_back(RTLIL::State::S0);
+		return result;
+	}
+
 	int undef_bit_pos = -1;
 	bool y = const2big(arg1, signed1, undef_bit_pos) > const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
@@ -450,6 +532,11 @@ RTLIL::Const RTLIL::const_gt(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 
 RTLIL::Const RTLIL::const_add(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	uint64_t a, b;
+	int word_result_len = result_len >= 0 ? result_len : max(arg1.size(), arg2.size());
+	if (word_result_len <= 64 && const2word(arg1, signed1, a) && const2word(arg2, signed2, b))
+		return word2const(a + b, word_result_len);
+
 	int undef_bit_pos = -1;
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) + const2big(arg2, signed2, undef_bit_pos);
 	return big2const(y, result_len >= 0 ? result_len : max(arg1.size(), arg2.size()), undef_bit_pos);
@@ -457,6 +544,11 @@ RTLIL::Const RTLIL::const_add(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_sub(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	uint64_t a, b;
+	int word_result_len = result_len >= 0 ? result_len : max(arg1.size(), arg2.size());
+	if (word_result_len <= 64 && const2word(arg1, signed1, a) && const2word(arg2, signed2, b))
+		return word2const(a - b, word_result_len);
+
 	int undef_bit_pos = -1;
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) - const2big(arg2, signed2, undef_bit_pos);
 	return big2const(y, result_len >= 0 ? result_len : max(arg1.size(), arg2.size()), undef_bit_pos);
@@ -464,6 +556,11 @@ RTLIL::Const RTLIL::const_sub(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_mul(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	uint64_t a, b;
+	int word_result_len = result_len >= 0 ? result_len : max(arg1.size(), arg2.size());
+	if (word_result_len <= 64 && const2word(arg1, signed1, a) && const2word(arg2, signed2, b))
+		return word2const(a * b, word_result_len);
+
 	int undef_bit_pos = -1;
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) * const2big(arg2, signed2, undef_bit_pos);
 	return big2const(y, result_len >= 0 ? result_len : max(arg1.size(), arg2.size()), min(undef_bit_pos, 0));
@@ -0,0 +1,293 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/celltypes.h"
+
+#include <array>
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace {
+
+// All port names of the builtin cell types. Bit i of a port mask stands for
+// builtin_ports[i].
+constexpr const char *builtin_ports[] = {
+	"A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M", "N", "O", "P",
+	"Q", "R", "S", "T", "U", "V", "X", "Y",
+	"AD", "ADDR", "ALOAD", "ARGS", "ARST", "BI", "CI", "CLK", "CLR", "CO",
+	"CTRL_IN", "CTRL_OUT", "DAT", "DATA", "DST", "EN", "EN_DST", "EN_SRC",
+	"RD_ADDR", "RD_ARST", "RD_CLK", "RD_DATA", "RD_EN", "RD_SRST",
+	"SET", "SRC", "SRST", "TRG", "WR_ADDR", "WR_CLK", "WR_DATA", "WR_EN",
+};
+
+constexpr int num_builtin_ports = sizeof(builtin_ports) / sizeof(builtin_ports[0]);
+static_assert(num_builtin_ports <= 64, "port masks are 64 bits wide");
+
+constexpr bool name_equals(const char *name, const char *begin, const char *end)
+{
+	for (; begin != end; name++, begin++)
+		if (*name != *begin)
+			return false;
+	return *name == 0;
+}
+
+// Port mask for a space separated list of port names. Unknown names make the
+// table fail to compile.
+constexpr uint64_t ports(const char *list)
+{
+	uint64_t mask = 0;
+	while (*list) {
+		if (*list == ' ') {
+			list++;
+			continue;
+		}
+		const char *end = list;
+		while (*end && *end != ' ')
+			end++;
+		int i = 0;
+		while (!name_equals(builtin_ports[i], list, end))
+			if (++i == num_builtin_ports)
+				throw "unknown port name";
+		mask |= uint64_t(1) << i;
+		list = end;
+	}
+	return mask;
+}
+
+struct BuiltinDesc
+{
+	char name[24];
+	uint64_t inputs, outputs;
+	uint8_t group;
+	bool is_evaluable;
+};
+
+constexpr int max_builtin_types = 320;
+
+struct BuiltinTable
+{
+	std::array<BuiltinDesc, max_builtin_types> types = {};
+	int count = 0;
+
+	constexpr void add(const char *name, uint8_t group, const char *inputs, const char *outputs, bool is_evaluable = false)
+	{
+		BuiltinDesc &desc = types[count++];
+		int i = 0;
+		for (; name[i]; i++)
+			desc.name[i] = name[i];
+		desc.name[i] = 0;
+		desc.inputs = ports(inputs);
+		desc.outputs = ports(outputs);
+		desc.group = group;
+		desc.is_evaluable = is_evaluable;
+	}
+
+	// Adds one type for every combination of polarity letters, e.g. prefix
+	// "$_DFF_" with options "NP NP 01" gives $_DFF_NN0_ up to $_DFF_PP1_, in
+	// the order of nested loops with the first option outermost.
+	constexpr void add_family(const char *prefix, const char *options, uint8_t group, const char *inputs, const char *outputs)
+	{
+		char choices[8][2] = {};
+		int num_choices = 0;
+		for (const char *p = options; *p; p++)
+			if (*p != ' ') {
+				choices[num_choices][0] = p[0];
+				choices[num_choices][1] = p[1];
+				num_choices++;
+				p++;
+			}
+
+		for (int combination = 0; combination < (1 << num_choices); combination++) {
+			char name[24] = {};
+			int len = 0;
+			for (; prefix[len]; len++)
+				name[len] = prefix[len];
+			for (int i = 0; i < num_choices; i++)
+				name[len++] = choices[i][(combination >> (num_choices - 1 - i)) & 1];
+			name[len++] = '_';
+			add(name, group, inputs, outputs);
+		}
+	}
+};
+
+constexpr BuiltinTable make_builtin_table()
+{
+	using G = BuiltinCellTypes;
+	BuiltinTable t;
+
+	// CellTypes::setup_internals_eval()
+	for (auto type : {"$not", "$pos", "$buf", "$neg",
+			"$reduce_and", "$reduce_or", "$reduce_xor", "$reduce_xnor", "$reduce_bool",
+			"$logic_not", "$slice", "$lut", "$sop"})
+		t.add(type, G::INTERNALS_EVAL, "A", "Y", true);
+
+	for (auto type : {"$and", "$or", "$xor", "$xnor",
+			"$shl", "$shr", "$sshl", "$sshr", "$shift", "$shiftx",
+			"$lt", "$le", "$eq", "$ne", "$eqx", "$nex", "$ge", "$gt",
+			"$add", "$sub", "$mul", "$div", "$mod", "$divfloor", "$modfloor", "$pow",
+			"$logic_and", "$logic_or", "$concat", "$macc",
+			"$bweqx"})
+		t.add(type, G::INTERNALS_EVAL, "A B", "Y", true);
+
+	for (auto type : {"$mux", "$pmux", "$bwmux"})
+		t.add(type, G::INTERNALS_EVAL, "A B S", "Y", true);
+
+	for (auto type : {"$bmux", "$demux"})
+		t.add(type, G::INTERNALS_EVAL, "A S", "Y", true);
+
+	t.add("$lcu", G::INTERNALS_EVAL, "P G CI", "CO", true);
+	t.add("$alu", G::INTERNALS_EVAL, "A B CI BI", "X Y CO", true);
+	t.add("$fa", G::INTERNALS_EVAL, "A B C", "X Y", true);
+
+	// CellTypes::setup_internals()
+	t.add("$tribuf", G::INTERNALS_OTHER, "A EN", "Y", true);
+	for (auto type : {"$assert", "$assume", "$live", "$fair", "$cover"})
+		t.add(type, G::INTERNALS_OTHER, "A EN", "", true);
+	for (auto type : {"$initstate", "$anyconst", "$anyseq", "$allconst", "$allseq"})
+		t.add(type, G::INTERNALS_OTHER, "", "Y", true);
+	t.add("$equiv", G::INTERNALS_OTHER, "A B", "Y", true);
+	t.add("$specify2", G::INTERNALS_OTHER, "EN SRC DST", "", true);
+	t.add("$specify3", G::INTERNALS_OTHER, "EN SRC DST DAT", "", true);
+	t.add("$specrule", G::INTERNALS_OTHER, "EN_SRC EN_DST SRC DST", "", true);
+	t.add("$print", G::INTERNALS_OTHER, "EN ARGS TRG", "");
+	t.add("$check", G::INTERNALS_OTHER, "A EN ARGS TRG", "");
+	t.add("$set_tag", G::INTERNALS_OTHER, "A SET CLR", "Y");
+	t.add("$get_tag", G::INTERNALS_OTHER, "A", "Y");
+	t.add("$overwrite_tag", G::INTERNALS_OTHER, "A SET CLR", "");
+	t.add("$original_tag", G::INTERNALS_OTHER, "A", "Y");
+	t.add("$future_ff", G::INTERNALS_OTHER, "A", "Y");
+	t.add("$scopeinfo", G::INTERNALS_OTHER, "", "");
+
+	// CellTypes::setup_internals_ff()
+	t.add("$sr", G::INTERNALS_FF, "SET CLR", "Q");
+	t.add("$ff", G::INTERNALS_FF, "D", "Q");
+	t.add("$dff", G::INTERNALS_FF, "CLK D", "Q");
+	t.add("$dffe", G::INTERNALS_FF, "CLK EN D", "Q");
+	t.add("$dffsr", G::INTERNALS_FF, "CLK SET CLR D", "Q");
+	t.add("$dffsre", G::INTERNALS_FF, "CLK SET CLR D EN", "Q");
+	t.add("$adff", G::INTERNALS_FF, "CLK ARST D", "Q");
+	t.add("$adffe", G::INTERNALS_FF, "CLK ARST D EN", "Q");
+	t.add("$aldff", G::INTERNALS_FF, "CLK ALOAD AD D", "Q");
+	t.add("$aldffe", G::INTERNALS_FF, "CLK ALOAD AD D EN", "Q");
+	t.add("$sdff", G::INTERNALS_FF, "CLK SRST D", "Q");
+	t.add("$sdffe", G::INTERNALS_FF, "CLK SRST D EN", "Q");
+	t.add("$sdffce", G::INTERNALS_FF, "CLK SRST D EN", "Q");
+	t.add("$dlatch", G::INTERNALS_FF, "EN D", "Q");
+	t.add("$adlatch", G::INTERNALS_FF, "EN D ARST", "Q");
+	t.add("$dlatchsr", G::INTERNALS_FF, "EN SET CLR D", "Q");
+
+	// CellTypes::setup_internals_anyinit()
+	t.add("$anyinit", G::INTERNALS_ANYINIT, "D", "Q");
+
+	// CellTypes::setup_internals_mem()
+	t.add("$memrd", G::INTERNALS_MEM, "CLK EN ADDR", "DATA");
+	t.add("$memrd_v2", G::INTERNALS_MEM, "CLK EN ARST SRST ADDR", "DATA");
+	t.add("$memwr", G::INTERNALS_MEM, "CLK EN ADDR DATA", "");
+	t.add("$memwr_v2", G::INTERNALS_MEM, "CLK EN ADDR DATA", "");
+	t.add("$meminit", G::INTERNALS_MEM, "ADDR DATA", "");
+	t.add("$meminit_v2", G::INTERNALS_MEM, "ADDR DATA EN", "");
+	t.add("$mem", G::INTERNALS_MEM, "RD_CLK RD_EN RD_ADDR WR_CLK WR_EN WR_ADDR WR_DATA", "RD_DATA");
+	t.add("$mem_v2", G::INTERNALS_MEM, "RD_CLK RD_EN RD_ARST RD_SRST RD_ADDR WR_CLK WR_EN WR_ADDR WR_DATA", "RD_DATA");
+	t.add("$fsm", G::INTERNALS_MEM, "CLK ARST CTRL_IN", "CTRL_OUT");
+
+	// CellTypes::setup_stdcells()
+	t.add("$_TBUF_", G::STDCELLS_TBUF, "A E", "Y", true);
+
+	// CellTypes::setup_stdcells_eval()
+	t.add("$_BUF_", G::STDCELLS_EVAL, "A", "Y", true);
+	t.add("$_NOT_", G::STDCELLS_EVAL, "A", "Y", true);
+	for (auto type : {"$_AND_", "$_NAND_", "$_OR_", "$_NOR_", "$_XOR_", "$_XNOR_", "$_ANDNOT_", "$_ORNOT_"})
+		t.add(type, G::STDCELLS_EVAL, "A B", "Y", true);
+	t.add("$_MUX_", G::STDCELLS_EVAL, "A B S", "Y", true);
+	t.add("$_NMUX_", G::STDCELLS_EVAL, "A B S", "Y", true);
+	t.add("$_MUX4_", G::STDCELLS_EVAL, "A B C D S T", "Y", true);
+	t.add("$_MUX8_", G::STDCELLS_EVAL, "A B C D E F G H S T U", "Y", true);
+	t.add("$_MUX16_", G::STDCELLS_EVAL, "A B C D E F G H I J K L M N O P S T U V", "Y", true);
+	t.add("$_AOI3_", G::STDCELLS_EVAL, "A B C", "Y", true);
+	t.add("$_OAI3_", G::STDCELLS_EVAL, "A B C", "Y", true);
+	t.add("$_AOI4_", G::STDCELLS_EVAL, "A B C D", "Y", true);
+	t.add("$_OAI4_", G::STDCELLS_EVAL, "A B C D", "Y", true);
+
+	// CellTypes::setup_stdcells_mem()
+	t.add_family("$_SR_", "NP NP", G::STDCELLS_MEM, "S R", "Q");
+	t.add("$_FF_", G::STDCELLS_MEM, "D", "Q");
+	t.add_family("$_DFF_", "NP", G::STDCELLS_MEM, "C D", "Q");
+	t.add_family("$_DFFE_", "NP NP", G::STDCELLS_MEM, "C D E", "Q");
+	t.add_family("$_DFF_", "NP NP 01", G::STDCELLS_MEM, "C R D", "Q");
+	t.add_family("$_DFFE_", "NP NP 01 NP", G::STDCELLS_MEM, "C R D E", "Q");
+	t.add_family("$_ALDFF_", "NP NP", G::STDCELLS_MEM, "C L AD D", "Q");
+	t.add_family("$_ALDFFE_", "NP NP NP", G::STDCELLS_MEM, "C L AD D E", "Q");
+	t.add_family("$_DFFSR_", "NP NP NP", G::STDCELLS_MEM, "C S R D", "Q");
+	t.add_family("$_DFFSRE_", "NP NP NP NP", G::STDCELLS_MEM, "C S R D E", "Q");
+	t.add_family("$_SDFF_", "NP NP 01", G::STDCELLS_MEM, "C R D", "Q");
+	t.add_family("$_SDFFE_", "NP NP 01 NP", G::STDCELLS_MEM, "C R D E", "Q");
+	t.add_family("$_SDFFCE_", "NP NP 01 NP", G::STDCELLS_MEM, "C R D E", "Q");
+	t.add_family("$_DLATCH_", "NP", G::STDCELLS_MEM, "E D", "Q");
+	t.add_family("$_DLATCH_", "NP NP 01", G::STDCELLS_MEM, "E R D", "Q");
+	t.add_family("$_DLATCHSR_", "NP NP NP", G::STDCELLS_MEM, "E S R D", "Q");
+
+	return t;
+}
+
+constexpr BuiltinTable builtin_table = make_builtin_table();
+
+}
+
+BuiltinCellTypes::BuiltinCellTypes()
+{
+	for (int i = 0; i < num_builtin_ports; i++) {
+		RTLIL::IdString name = RTLIL::escape_id(builtin_ports[i]);
+		if (name.index_ >= GetSize(port_bits))
+			port_bits.resize(name.index_ + 1, -1);
+		port_bits[name.index_] = i;
+		port_names.push_back(name);
+	}
+
+	for (int i = 0; i < builtin_table.count; i++) {
+		const BuiltinDesc &desc = builtin_table.types[i];
+		RTLIL::IdString type = desc.name;
+		if (type.index_ >= GetSize(type_slots))
+			type_slots.resize(type.index_ + 1, -1);
+		log_assert(type_slots[type.index_] < 0);
+		type_slots[type.index_] = GetSize(entries);
+		entries.push_back({type, desc.inputs, desc.outputs, desc.group, desc.is_evaluable});
+	}
+}
+
+const BuiltinCellTypes &BuiltinCellTypes::get()
+{
+	static const BuiltinCellTypes table;
+	return table;
+}
+
+CellType BuiltinCellTypes::cell_type(int slot) const
+{
+	const Entry &entry = entries[slot];
+	CellType ct = {entry.type, {}, {}, entry.is_evaluable, false, false};
+	for (int i = 0; i < GetSize(port_names); i++) {
+		if (entry.inputs & (uint64_t(1) << i))
+			ct.inputs.insert(port_names[i]);
+		if (entry.outputs & (uint64_t(1) << i))
+			ct.outputs.insert(port_names[i]);
+	}
+	return ct;
+}
+
+YOSYS_NAMESPACE_END
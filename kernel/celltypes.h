@@ -33,9 +33,64 @@ struct CellType
 	bool is_synthesizable;
 };
 
+// The internal cell types known to CellTypes::setup_internals() and friends,
+// generated at compile time in celltypes.cc. Types and port names are mapped
+// to table rows and port bits through arrays indexed by IdString::index_, so
+// queries for internal cells don't need any hashing.
+struct BuiltinCellTypes
+{
+	enum Group : uint8_t {
+		INTERNALS_EVAL = 1,
+		INTERNALS_OTHER = 2,
+		INTERNALS_FF = 4,
+		INTERNALS_ANYINIT = 8,
+		INTERNALS_MEM = 16,
+		STDCELLS_EVAL = 32,
+		STDCELLS_TBUF = 64,
+		STDCELLS_MEM = 128,
+	};
+
+	struct Entry {
+		RTLIL::IdString type;
+		uint64_t inputs, outputs;
+		uint8_t group;
+		bool is_evaluable;
+	};
+
+	std::vector<Entry> entries;
+	std::vector<RTLIL::IdString> port_names;
+	std::vector<int16_t> type_slots;
+	std::vector<int8_t> port_bits;
+
+	static const BuiltinCellTypes &get();
+
+	// row of a builtin cell type in entries, or -1
+	int slot(const RTLIL::IdString &type) const {
+		return type.index_ < GetSize(type_slots) ? type_slots[type.index_] : -1;
+	}
+
+	// bit of a port name in the input and output masks, or -1
+	int port_bit(const RTLIL::IdString &port) const {
+		return port.index_ < GetSize(port_bits) ? port_bits[port.index_] : -1;
+	}
+
+	CellType cell_type(int slot) const;
+
+private:
+	BuiltinCellTypes();
+};
+
 struct CellTypes
 {
+	// Types added with setup_type(), including the builtin types whose
+	// description was replaced. The builtin types enabled by the other
+	// setup_*() functions are only in builtin_groups.
 	dict<RTLIL::IdString, CellType> cell_types;
+	const BuiltinCellTypes *builtin = &BuiltinCellTypes::get();
+	uint8_t builtin_groups = 0;
+	// builtin types that were replaced or erased, and so are looked up in
+	// cell_types even if their group is enabled
+	std::vector<bool> builtin_masked;
 
 	CellTypes()
 	{
@@ -62,6 +117,49 @@ struct CellTypes
 	{
 		CellType ct = {type, inputs, outputs, is_evaluable, is_combinatorial, is_synthesizable};
 		cell_types[ct.type] = ct;
+		mask_builtin(type);
+	}
+
+	void erase_type(RTLIL::IdString type)
+	{
+		cell_types.erase(type);
+		mask_builtin(type);
+	}
+
+	void mask_builtin(RTLIL::IdString type)
+	{
+		int slot = builtin->slot(type);
+		if (slot < 0)
+			return;
+		if (builtin_masked.empty())
+			builtin_masked.resize(GetSize(builtin->entries));
+		builtin_masked[slot] = true;
+	}
+
+	// Enables a group of builtin types, replacing any earlier description
+	// of its members.
+	void setup_builtin(uint8_t group)
+	{
+		builtin_groups |= group;
+		if (builtin_masked.empty())
+			return;
+		for (int slot = 0; slot < GetSize(builtin->entries); slot++)
+			if (builtin->entries[slot].group & group && builtin_masked[slot]) {
+				cell_types.erase(builtin->entries[slot].type);
+				builtin_masked[slot] = false;
+			}
+	}
+
+	// All known types, e.g. for listing them
+	dict<RTLIL::IdString, CellType> all_cell_types() const
+	{
+		dict<RTLIL::IdString, CellType> result;
+		for (int slot = 0; slot < GetSize(builtin->entries); slot++)
+			if (builtin->entries[slot].group & builtin_groups && (builtin_masked.empty() || !builtin_masked[slot]))
+				result[builtin->entries[slot].type] = builtin->cell_type(slot);
+		for (auto &it : cell_types)
+			result[it.first] = it.second;
+		return result;
 	}
 
 	void setup_module(RTLIL::Module *module)
@@ -86,241 +184,102 @@ struct CellTypes
 	void setup_internals()
 	{
 		setup_internals_eval();
-
-		setup_type(ID($tribuf), {ID::A, ID::EN}, {ID::Y}, true);
-
-		setup_type(ID($assert), {ID::A, ID::EN}, pool<RTLIL::IdString>(), true);
-		setup_type(ID($assume), {ID::A, ID::EN}, pool<RTLIL::IdString>(), true);
-		setup_type(ID($live), {ID::A, ID::EN}, pool<RTLIL::IdString>(), true);
-		setup_type(ID($fair), {ID::A, ID::EN}, pool<RTLIL::IdString>(), true);
-		setup_type(ID($cover), {ID::A, ID::EN}, pool<RTLIL::IdString>(), true);
-		setup_type(ID($initstate), pool<RTLIL::IdString>(), {ID::Y}, true);
-		setup_type(ID($anyconst), pool<RTLIL::IdString>(), {ID::Y}, true);
-		setup_type(ID($anyseq), pool<RTLIL::IdString>(), {ID::Y}, true);
-		setup_type(ID($allconst), pool<RTLIL::IdString>(), {ID::Y}, true);
-		setup_type(ID($allseq), pool<RTLIL::IdString>(), {ID::Y}, true);
-		setup_type(ID($equiv), {ID::A, ID::B}, {ID::Y}, true);
-		setup_type(ID($specify2), {ID::EN, ID::SRC, ID::DST}, pool<RTLIL::IdString>(), true);
-		setup_type(ID($specify3), {ID::EN, ID::SRC, ID::DST, ID::DAT}, pool<RTLIL::IdString>(), true);
-		setup_type(ID($specrule), {ID::EN_SRC, ID::EN_DST, ID::SRC, ID::DST}, pool<RTLIL::IdString>(), true);
-		setup_type(ID($print), {ID::EN, ID::ARGS, ID::TRG}, pool<RTLIL::IdString>());
-		setup_type(ID($check), {ID::A, ID::EN, ID::ARGS, ID::TRG}, pool<RTLIL::IdString>());
-		setup_type(ID($set_tag), {ID::A, ID::SET, ID::CLR}, {ID::Y});
-		setup_type(ID($get_tag), {ID::A}, {ID::Y});
-		setup_type(ID($overwrite_tag), {ID::A, ID::SET, ID::CLR}, pool<RTLIL::IdString>());
-		setup_type(ID($original_tag), {ID::A}, {ID::Y});
-		setup_type(ID($future_ff), {ID::A}, {ID::Y});
-		setup_type(ID($scopeinfo), {}, {});
+		setup_builtin(BuiltinCellTypes::INTERNALS_OTHER);
 	}
 
 	void setup_internals_eval()
 	{
-		std::vector<RTLIL::IdString> unary_ops = {
-			ID($not), ID($pos), ID($buf), ID($neg),
-			ID($reduce_and), ID($reduce_or), ID($reduce_xor), ID($reduce_xnor), ID($reduce_bool),
-			ID($logic_not), ID($slice), ID($lut), ID($sop)
-		};
-
-		std::vector<RTLIL::IdString> binary_ops = {
-			ID($and), ID($or), ID($xor), ID($xnor),
-			ID($shl), ID($shr), ID($sshl), ID($sshr), ID($shift), ID($shiftx),
-			ID($lt), ID($le), ID($eq), ID($ne), ID($eqx), ID($nex), ID($ge), ID($gt),
-			ID($add), ID($sub), ID($mul), ID($div), ID($mod), ID($divfloor), ID($modfloor), ID($pow),
-			ID($logic_and), ID($logic_or), ID($concat), ID($macc),
-			ID($bweqx)
-		};
-
-		for (auto type : unary_ops)
-			setup_type(type, {ID::A}, {ID::Y}, true);
-
-		for (auto type : binary_ops)
-			setup_type(type, {ID::A, ID::B}, {ID::Y}, true);
-
-		for (auto type : std::vector<RTLIL::IdString>({ID($mux), ID($pmux), ID($bwmux)}))
-			setup_type(type, {ID::A, ID::B, ID::S}, {ID::Y}, true);
-
-		for (auto type : std::vector<RTLIL::IdString>({ID($bmux), ID($demux)}))
-			setup_type(type, {ID::A, ID::S}, {ID::Y}, true);
-
-		setup_type(ID($lcu), {ID::P, ID::G, ID::CI}, {ID::CO}, true);
-		setup_type(ID($alu), {ID::A, ID::B, ID::CI, ID::BI}, {ID::X, ID::Y, ID::CO}, true);
-		setup_type(ID($fa), {ID::A, ID::B, ID::C}, {ID::X, ID::Y}, true);
+		setup_builtin(BuiltinCellTypes::INTERNALS_EVAL);
 	}
 
 	void setup_internals_ff()
 	{
-		setup_type(ID($sr), {ID::SET, ID::CLR}, {ID::Q});
-		setup_type(ID($ff), {ID::D}, {ID::Q});
-		setup_type(ID($dff), {ID::CLK, ID::D}, {ID::Q});
-		setup_type(ID($dffe), {ID::CLK, ID::EN, ID::D}, {ID::Q});
-		setup_type(ID($dffsr), {ID::CLK, ID::SET, ID::CLR, ID::D}, {ID::Q});
-		setup_type(ID($dffsre), {ID::CLK, ID::SET, ID::CLR, ID::D, ID::EN}, {ID::Q});
-		setup_type(ID($adff), {ID::CLK, ID::ARST, ID::D}, {ID::Q});
-		setup_type(ID($adffe), {ID::CLK, ID::ARST, ID::D, ID::EN}, {ID::Q});
-		setup_type(ID($aldff), {ID::CLK, ID::ALOAD, ID::AD, ID::D}, {ID::Q});
-		setup_type(ID($aldffe), {ID::CLK, ID::ALOAD, ID::AD, ID::D, ID::EN}, {ID::Q});
-		setup_type(ID($sdff), {ID::CLK, ID::SRST, ID::D}, {ID::Q});
-		setup_type(ID($sdffe), {ID::CLK, ID::SRST, ID::D, ID::EN}, {ID::Q});
-		setup_type(ID($sdffce), {ID::CLK, ID::SRST, ID::D, ID::EN}, {ID::Q});
-		setup_type(ID($dlatch), {ID::EN, ID::D}, {ID::Q});
-		setup_type(ID($adlatch), {ID::EN, ID::D, ID::ARST}, {ID::Q});
-		setup_type(ID($dlatchsr), {ID::EN, ID::SET, ID::CLR, ID::D}, {ID::Q});
+		setup_builtin(BuiltinCellTypes::INTERNALS_FF);
 	}
 
 	void setup_internals_anyinit()
 	{
-		setup_type(ID($anyinit), {ID::D}, {ID::Q});
+		setup_builtin(BuiltinCellTypes::INTERNALS_ANYINIT);
 	}
 
 	void setup_internals_mem()
 	{
 		setup_internals_ff();
-
-		setup_type(ID($memrd), {ID::CLK, ID::EN, ID::ADDR}, {ID::DATA});
-		setup_type(ID($memrd_v2), {ID::CLK, ID::EN, ID::ARST, ID::SRST, ID::ADDR}, {ID::DATA});
-		setup_type(ID($memwr), {ID::CLK, ID::EN, ID::ADDR, ID::DATA}, pool<RTLIL::IdString>());
-		setup_type(ID($memwr_v2), {ID::CLK, ID::EN, ID::ADDR, ID::DATA}, pool<RTLIL::IdString>());
-		setup_type(ID($meminit), {ID::ADDR, ID::DATA}, pool<RTLIL::IdString>());
-		setup_type(ID($meminit_v2), {ID::ADDR, ID::DATA, ID::EN}, pool<RTLIL::IdString>());
-		setup_type(ID($mem), {ID::RD_CLK, ID::RD_EN, ID::RD_ADDR, ID::WR_CLK, ID::WR_EN, ID::WR_ADDR, ID::WR_DATA}, {ID::RD_DATA});
-		setup_type(ID($mem_v2), {ID::RD_CLK, ID::RD_EN, ID::RD_ARST, ID::RD_SRST, ID::RD_ADDR, ID::WR_CLK, ID::WR_EN, ID::WR_ADDR, ID::WR_DATA}, {ID::RD_DATA});
-
-		setup_type(ID($fsm), {ID::CLK, ID::ARST, ID::CTRL_IN}, {ID::CTRL_OUT});
+		setup_builtin(BuiltinCellTypes::INTERNALS_MEM);
 	}
 
 	void setup_stdcells()
 	{
 		setup_stdcells_eval();
-
-		setup_type(ID($_TBUF_), {ID::A, ID::E}, {ID::Y}, true);
+		setup_builtin(BuiltinCellTypes::STDCELLS_TBUF);
 	}
 
 	void setup_stdcells_eval()
 	{
-		setup_type(ID($_BUF_), {ID::A}, {ID::Y}, true);
-		setup_type(ID($_NOT_), {ID::A}, {ID::Y}, true);
-		setup_type(ID($_AND_), {ID::A, ID::B}, {ID::Y}, true);
-		setup_type(ID($_NAND_), {ID::A, ID::B}, {ID::Y}, true);
-		setup_type(ID($_OR_),  {ID::A, ID::B}, {ID::Y}, true);
-		setup_type(ID($_NOR_),  {ID::A, ID::B}, {ID::Y}, true);
-		setup_type(ID($_XOR_), {ID::A, ID::B}, {ID::Y}, true);
-		setup_type(ID($_XNOR_), {ID::A, ID::B}, {ID::Y}, true);
-		setup_type(ID($_ANDNOT_), {ID::A, ID::B}, {ID::Y}, true);
-		setup_type(ID($_ORNOT_), {ID::A, ID::B}, {ID::Y}, true);
-		setup_type(ID($_MUX_), {ID::A, ID::B, ID::S}, {ID::Y}, true);
-		setup_type(ID($_NMUX_), {ID::A, ID::B, ID::S}, {ID::Y}, true);
-		setup_type(ID($_MUX4_), {ID::A, ID::B, ID::C, ID::D, ID::S, ID::T}, {ID::Y}, true);
-		setup_type(ID($_MUX8_), {ID::A, ID::B, ID::C, ID::D, ID::E, ID::F, ID::G, ID::H, ID::S, ID::T, ID::U}, {ID::Y}, true);
-		setup_type(ID($_MUX16_), {ID::A, ID::B, ID::C, ID::D, ID::E, ID::F, ID::G, ID::H, ID::I, ID::J, ID::K, ID::L, ID::M, ID::N, ID::O, ID::P, ID::S, ID::T, ID::U, ID::V}, {ID::Y}, true);
-		setup_type(ID($_AOI3_), {ID::A, ID::B, ID::C}, {ID::Y}, true);
-		setup_type(ID($_OAI3_), {ID::A, ID::B, ID::C}, {ID::Y}, true);
-		setup_type(ID($_AOI4_), {ID::A, ID::B, ID::C, ID::D}, {ID::Y}, true);
-		setup_type(ID($_OAI4_), {ID::A, ID::B, ID::C, ID::D}, {ID::Y}, true);
+		setup_builtin(BuiltinCellTypes::STDCELLS_EVAL);
 	}
 
 	void setup_stdcells_mem()
 	{
-		std::vector<char> list_np = {'N', 'P'}, list_01 = {'0', '1'};
-
-		for (auto c1 : list_np)
-		for (auto c2 : list_np)
-			setup_type(stringf("$_SR_%c%c_", c1, c2), {ID::S, ID::R}, {ID::Q});
-
-		setup_type(ID($_FF_), {ID::D}, {ID::Q});
-
-		for (auto c1 : list_np)
-			setup_type(stringf("$_DFF_%c_", c1), {ID::C, ID::D}, {ID::Q});
-
-		for (auto c1 : list_np)
-		for (auto c2 : list_np)
-			setup_type(stringf("$_DFFE_%c%c_", c1, c2), {ID::C, ID::D, ID::E}, {ID::Q});
-
-		for (auto c1 : list_np)
-		for (auto c2 : list_np)
-		for (auto c3 : list_01)
-			setup_type(stringf("$_DFF_%c%c%c_", c1, c2, c3), {ID::C, ID::R, ID::D}, {ID::Q});
-
-		for (auto c1 : list_np)
-		for (auto c2 : list_np)
-		for (auto c3 : list_01)
-		for (auto c4 : list_np)
-			setup_type(stringf("$_DFFE_%c%c%c%c_", c1, c2, c3, c4), {ID::C, ID::R, ID::D, ID::E}, {ID::Q});
-
-		for (auto c1 : list_np)
-		for (auto c2 : list_np)
-			setup_type(stringf("$_ALDFF_%c%c_", c1, c2), {ID::C, ID::L, ID::AD, ID::D}, {ID::Q});
-
-		for (auto c1 : list_np)
-		for (auto c2 : list_np)
-		for (auto c3 : list_np)
-			setup_type(stringf("$_ALDFFE_%c%c%c_", c1, c2, c3), {ID::C, ID::L, ID::AD, ID::D, ID::E}, {ID::Q});
-
-		for (auto c1 : list_np)
-		for (auto c2 : list_np)
-		for (auto c3 : list_np)
-			setup_type(stringf("$_DFFSR_%c%c%c_", c1, c2, c3), {ID::C, ID::S, ID::R, ID::D}, {ID::Q});
-
-		for (auto c1 : list_np)
-		for (auto c2 : list_np)
-		for (auto c3 : list_np)
-		for (auto c4 : list_np)
-			setup_type(stringf("$_DFFSRE_%c%c%c%c_", c1, c2, c3, c4), {ID::C, ID::S, ID::R, ID::D, ID::E}, {ID::Q});
-
-		for (auto c1 : list_np)
-		for (auto c2 : list_np)
-		for (auto c3 : list_01)
-			setup_type(stringf("$_SDFF_%c%c%c_", c1, c2, c3), {ID::C, ID::R, ID::D}, {ID::Q});
-
-		for (auto c1 : list_np)
-		for (auto c2 : list_np)
-		for (auto c3 : list_01)
-		for (auto c4 : list_np)
-			setup_type(stringf("$_SDFFE_%c%c%c%c_", c1, c2, c3, c4), {ID::C, ID::R, ID::D, ID::E}, {ID::Q});
-
-		for (auto c1 : list_np)
-		for (auto c2 : list_np)
-		for (auto c3 : list_01)
-		for (auto c4 : list_np)
-			setup_type(stringf("$_SDFFCE_%c%c%c%c_", c1, c2, c3, c4), {ID::C, ID::R, ID::D, ID::E}, {ID::Q});
-
-		for (auto c1 : list_np)
-			setup_type(stringf("$_DLATCH_%c_", c1), {ID::E, ID::D}, {ID::Q});
-
-		for (auto c1 : list_np)
-		for (auto c2 : list_np)
-		for (auto c3 : list_01)
-			setup_type(stringf("$_DLATCH_%c%c%c_", c1, c2, c3), {ID::E, ID::R, ID::D}, {ID::Q});
-
-		for (auto c1 : list_np)
-		for (auto c2 : list_np)
-		for (auto c3 : list_np)
-			setup_type(stringf("$_DLATCHSR_%c%c%c_", c1, c2, c3), {ID::E, ID::S, ID::R, ID::D}, {ID::Q});
+		setup_builtin(BuiltinCellTypes::STDCELLS_MEM);
 	}
 
 	void clear()
 	{
 		cell_types.clear();
+		builtin_groups = 0;
+		builtin_masked.clear();
+	}
+
+	// row of type in the builtin table if it is described by it, or -1 if
+	// it must be looked up in cell_types
+	int builtin_slot(const RTLIL::IdString &type) const
+	{
+		int slot = builtin->slot(type);
+		if (slot >= 0 && !builtin_masked.empty() && builtin_masked[slot])
+			return -1;
+		return slot;
 	}
 
-	bool cell_known(RTLIL::IdString type) const
+	bool cell_known(const RTLIL::IdString &type) const
 	{
+		int slot = builtin_slot(type);
+		if (slot >= 0)
+			return builtin->entries[slot].group & builtin_groups;
 		return cell_types.count(type) != 0;
 	}
 
-	bool cell_output(RTLIL::IdString type, RTLIL::IdString port) const
+	bool cell_output(const RTLIL::IdString &type, const RTLIL::IdString &port) const
 	{
+		int slot = builtin_slot(type);
+		if (slot >= 0) {
+			const BuiltinCellTypes::Entry &entry = builtin->entries[slot];
+			int bit = builtin->port_bit(port);
+			return entry.group & builtin_groups && bit >= 0 && (entry.outputs >> bit & 1);
+		}
 		auto it = cell_types.find(type);
 		return it != cell_types.end() && it->second.outputs.count(port) != 0;
 	}
 
-	bool cell_input(RTLIL::IdString type, RTLIL::IdString port) const
+	bool cell_input(const RTLIL::IdString &type, const RTLIL::IdString &port) const
 	{
+		int slot = builtin_slot(type);
+		if (slot >= 0) {
+			const BuiltinCellTypes::Entry &entry = builtin->entries[slot];
+			int bit = builtin->port_bit(port);
+			return entry.group & builtin_groups && bit >= 0 && (entry.inputs >> bit & 1);
+		}
 		auto it = cell_types.find(type);
 		return it != cell_types.end() && it->second.inputs.count(port) != 0;
 	}
 
-	bool cell_evaluable(RTLIL::IdString type) const
+	bool cell_evaluable(const RTLIL::IdString &type) const
 	{
+		int slot = builtin_slot(type);
+		if (slot >= 0) {
+			const BuiltinCellTypes::Entry &entry = builtin->entries[slot];
+			return entry.group & builtin_groups && entry.is_evaluable;
+		}
 		auto it = cell_types.find(type);
 		return it != cell_types.end() && it->second.is_evaluable;
 	}
@@ -18,6 +18,7 @@
  */
 
 #include "kernel/yosys.h"
+#include "kernel/profiler.h"
 #include "libs/sha1/sha1.h"
 #include "libs/cxxopts/include/cxxopts.hpp"
 #include <iostream>
@@ -128,6 +129,39 @@ const char *prompt()
 #if defined(YOSYS_ENABLE_READLINE) || defined(YOSYS_ENABLE_EDITLINE)
 int yosys_history_offset = 0;
 std::string yosys_history_file;
+
+// Only called once an interactive shell starts, so that non-interactive runs
+// neither read nor rewrite the history file.
+static void yosys_history_init()
+{
+	std::string state_dir;
+	#if defined(_WIN32)
+		if (getenv("HOMEDRIVE") != NULL && getenv("HOMEPATH") != NULL) {
+			state_dir = stringf("%s%s/.local/state", getenv("HOMEDRIVE"), getenv("HOMEPATH"));
+		} else {
+			log_debug("$HOMEDRIVE and/or $HOMEPATH is empty. No history file will be created.\n");
+		}
+	#else
+		if (getenv("XDG_STATE_HOME") == NULL || getenv("XDG_STATE_HOME")[0] == '\0') {
+			if (getenv("HOME") != NULL) {
+				state_dir = stringf("%s/.local/state", getenv("HOME"));
+			} else {
+				log_debug("$HOME is empty. No history file will be created.\n");
+			}
+		} else {
+			state_dir = stringf("%s", getenv("XDG_STATE_HOME"));
+		}
+	#endif
+
+	if (!state_dir.empty()) {
+		std::string yosys_dir = state_dir + "/yosys";
+		create_directory(yosys_dir);
+
+		yosys_history_file = yosys_dir + "/history";
+		read_history(yosys_history_file.c_str());
+		yosys_history_offset = where_history();
+	}
+}
 #endif
 
 #if defined(__wasm)
@@ -194,6 +228,8 @@ int main(int argc, char **argv)
 	std::string depsfile = "";
 	std::string topmodule = "";
 	std::string perffile = "";
+	std::string profile_file = "";
+	std::string server_socket = "";
 	bool scriptfile_tcl = false;
 	bool scriptfile_python = false;
 	bool print_banner = true;
@@ -232,6 +268,11 @@ int main(int argc, char **argv)
 			cxxopts::value<std::vector<std::string>>(), "<plugin>")
 		("D,define", "set the specified Verilog define to <value> if supplied via command \"read -define\"",
 			cxxopts::value<std::vector<std::string>>(), "<define>[=<value>]")
+		("j,jobs", "process independent modules on up to <N> threads in passes that support it. " \
+					"Auto-generated names created by these passes are then numbered " \
+					"<base>.<job>.<n> instead of using the global counter, so netlists " \
+					"written with -j differ in those names (but not in function) from -j 1",
+			cxxopts::value<int>(), "<N>")
 		("S,synth", "shortcut for calling the \"synth\" command, a default script for transforming " \
 					"the Verilog input to a gate-level netlist. For example: " \
 					"yosys -o output.blif -S input.v " \
@@ -242,6 +283,10 @@ int main(int argc, char **argv)
 		("h,help", "print this help message. If given, print help for <command>.",
 			cxxopts::value<std::string>(), "[<command>]")
 		("V,version", "print version information and exit")
+		("server", "after running the given scripts and commands, serve requests on the Unix domain " \
+					"socket <socket> instead of starting the interactive shell. Each request is a line " \
+					"of JSON with the commands to run, see kernel/server.cc for the protocol",
+			cxxopts::value<std::string>(), "<socket>")
 		("infile", "input files", cxxopts::value<std::vector<std::string>>())
 	;
 	options.add_options("logging")
@@ -253,6 +298,8 @@ int main(int argc, char **argv)
                       "Implies -q for everything except the 'End of script.' message.",
 			cxxopts::value<int>(), "<level>")
 		("t,timestamp", "annotate all log messages with a time stamp")
+		("async-log", "write log messages to the console and log files from a background thread. " \
+					  "Messages are written in batches and may show up with a short delay")
 		("d,detailed-timing", "print more detailed timing stats at exit")
 		("l,logfile", "write log messages to <logfile>",
 			cxxopts::value<std::vector<std::string>>(), "<logfile>")
@@ -281,6 +328,9 @@ int main(int argc, char **argv)
 			cxxopts::value<std::vector<std::string>>(), "<feature>")
 		("g,debug", "globally enable debug log messages")
 		("perffile", "write a JSON performance log to <perffile>", cxxopts::value<std::string>(), "<perffile>")
+		("profile", "write a profile of all executed commands to <tracefile>, in the Chrome " \
+			"trace event format that chrome://tracing and https://ui.perfetto.dev can load",
+			cxxopts::value<std::string>(), "<tracefile>")
 	;
 
 	options.parse_positional({"infile"});
@@ -318,6 +368,10 @@ int main(int argc, char **argv)
 			run_shell = false;
 		}
 		if (result.count("C")) run_tcl_shell = true;
+		if (result.count("server")) {
+			server_socket = result["server"].as<std::string>();
+			run_shell = false;
+		}
 		if (result.count("g")) log_force_debug++;
 		if (result.count("m")) plugin_filenames = result["m"].as<std::vector<std::string>>();
 		if (result.count("f")) frontend_command = result["f"].as<std::string>();
@@ -367,6 +421,7 @@ int main(int argc, char **argv)
 			log_verbose_level = result["v"].as<int>();
 		}
 		if (result.count("t")) log_time = true;
+		if (result.count("async-log")) log_async = true;
 		if (result.count("d")) timing_details = true;
 		for (const auto& key : {"s", "c"}) {
 			if (result.count(key)) {
@@ -395,6 +450,7 @@ int main(int argc, char **argv)
 		}
 		if (result.count("r")) topmodule = result["r"].as<std::string>();
 		if (result.count("D")) vlog_defines = result["D"].as<std::vector<std::string>>();
+		if (result.count("j")) yosys_jobs = std::max(1, result["j"].as<int>());
 		if (result.count("P")) {
 			auto dump_args = result["P"].as<std::vector<std::string>>();
 			for (const auto& arg : dump_args) {
@@ -424,6 +480,10 @@ int main(int argc, char **argv)
 			log_experimentals_ignored.insert(ignores.begin(), ignores.end());
 		}
 		if (result.count("perffile")) perffile = result["perffile"].as<std::string>();
+		if (result.count("profile")) {
+			profile_file = result["profile"].as<std::string>();
+			yosys_profiler = new Profiler;
+		}
 		if (result.count("infile")) {
 			frontend_files = result["infile"].as<std::vector<std::string>>();
 		}
@@ -444,33 +504,7 @@ int main(int argc, char **argv)
 	}
 
 #if defined(YOSYS_ENABLE_READLINE) || defined(YOSYS_ENABLE_EDITLINE)
-	std::string state_dir;
-	#if defined(_WIN32)
-		if (getenv("HOMEDRIVE") != NULL && getenv("HOMEPATH") != NULL) {
-			state_dir = stringf("%s%s/.local/state", getenv("HOMEDRIVE"), getenv("HOMEPATH"));
-		} else {
-			log_debug("$HOMEDRIVE and/or $HOMEPATH is empty. No history file will be created.\n");
-		}
-	#else
-		if (getenv("XDG_STATE_HOME") == NULL || getenv("XDG_STATE_HOME")[0] == '\0') {
-			if (getenv("HOME") != NULL) {
-				state_dir = stringf("%s/.local/state", getenv("HOME"));
-			} else {
-				log_debug("$HOME is empty. No history file will be created.\n");
-			}
-		} else {
-			state_dir = stringf("%s", getenv("XDG_STATE_HOME"));
-		}
-	#endif
-
-	if (!state_dir.empty()) {
-		std::string yosys_dir = state_dir + "/yosys";
-		create_directory(yosys_dir);
-
-		yosys_history_file = yosys_dir + "/history";
-		read_history(yosys_history_file.c_str());
-		yosys_history_offset = where_history();
-	}
+	shell_init_hook = yosys_history_init;
 #endif
 
 	if (print_stats)
@@ -494,6 +528,8 @@ int main(int argc, char **argv)
 	}
 #endif
 
+	int startup_span = yosys_profiler ? yosys_profiler->begin("startup", nullptr, {}, "startup") : -1;
+
 	yosys_setup();
 #ifdef WITH_PYTHON
 	PyRun_SimpleString(("sys.path.append(\""+proc_self_dirname()+"\")").c_str());
@@ -504,6 +540,9 @@ int main(int argc, char **argv)
 	for (auto &fn : plugin_filenames)
 		load_plugin(fn, {});
 
+	if (yosys_profiler)
+		yosys_profiler->end(startup_span, yosys_design);
+
 	log_suppressed();
 
 	if (!vlog_defines.empty()) {
@@ -588,6 +627,8 @@ int main(int argc, char **argv)
 #else
 		log_error("Can't exectue TCL shell: this version of yosys is not built with TCL support enabled.\n");
 #endif
+	} else if (!server_socket.empty()) {
+		server(server_socket);
 	} else {
 		if (run_shell)
 			shell(yosys_design);
@@ -619,6 +660,16 @@ int main(int argc, char **argv)
 		fprintf(f, "\n");
 	}
 
+	if (yosys_profiler)
+	{
+		std::ofstream f(profile_file);
+		if (f.fail())
+			log_error("Can't open profile file for writing: %s\n", strerror(errno));
+		yosys_profiler->write(f);
+		delete yosys_profiler;
+		yosys_profiler = nullptr;
+	}
+
 	if (log_expect_no_warnings && log_warnings_count_noexpect)
 		log_error("Unexpected warnings found: %d unique messages, %d total, %d expected\n", GetSize(log_warnings),
 					log_warnings_count, log_warnings_count - log_warnings_count_noexpect);
@@ -64,6 +64,7 @@ FstData::FstData(std::string filename) : ctx(nullptr)
 	for (int i=0;i<zeros; i++) timescale_str += "0";
 	timescale_str += g_units[unit];
 	extractVarNames();
+	handle_index.resize(fstReaderGetMaxHandle(ctx) + 1, -1);
 }
 
 FstData::~FstData()
@@ -90,19 +91,37 @@ static void normalize_brackets(std::string &str)
 
 fstHandle FstData::getHandle(std::string name) { 
 	normalize_brackets(name);
-	if (name_to_handle.find(name) != name_to_handle.end())
+	if (name_to_handle.find(name) != name_to_handle.end()) {
+		useHandle(name_to_handle[name]);
 		return name_to_handle[name];
-	else 
+	} else 
 		return 0;
 };
 
 dict<int,fstHandle> FstData::getMemoryHandles(std::string name) { 
-	if (memory_to_handle.find(name) != memory_to_handle.end())
+	if (memory_to_handle.find(name) != memory_to_handle.end()) {
+		for (auto &it : memory_to_handle[name])
+			useHandle(it.second);
 		return memory_to_handle[name];
-	else 
+	} else 
 		return dict<int,fstHandle>();
 };
 
+void FstData::useHandle(fstHandle signal)
+{
+	if (signal == 0 || signal >= handle_index.size() || handle_index[signal] >= 0)
+		return;
+	int width = handle_to_var.at(signal).width;
+	handle_index[signal] = GetSize(used_handles);
+	used_handles.push_back(signal);
+	value_offset.push_back(GetSize(last_values));
+	value_width.push_back(width);
+	last_values.resize(last_values.size() + width, State::Sx);
+	past_values.resize(past_values.size() + width, State::Sx);
+	is_changed.push_back(false);
+	is_clock.push_back(false);
+}
+
 static std::string remove_spaces(std::string str)
 {
 	str.erase(std::remove(str.begin(), str.end(), ' '), str.end());
@@ -195,22 +214,34 @@ static void reconstruct_clb_attimes(void *user_data, uint64_t pnt_time, fstHandl
 	ptr->reconstruct_callback_attimes(pnt_time, pnt_facidx, pnt_value, plen);
 }
 
-void FstData::reconstruct_callback_attimes(uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value, uint32_t /* plen */)
+static inline State decode_state(unsigned char c)
 {
-	if (pnt_time > end_time || !pnt_value) return;
-	// if we are past the timestamp
-	bool is_clock = false;
-	if (!all_samples) {
-		for(auto &s : clk_signals) {
-			if (s==pnt_facidx)  { 
-				is_clock=true;
-				break;
-			}
-		}
+	switch (c) {
+		case '0': return State::S0;
+		case '1': return State::S1;
+		case 'z': case 'Z': return State::Sz;
+		default: return State::Sx;
 	}
+}
 
+void FstData::commitValues()
+{
+	for (int idx : changed) {
+		std::copy_n(last_values.begin() + value_offset[idx], value_width[idx], past_values.begin() + value_offset[idx]);
+		is_changed[idx] = false;
+	}
+	changed.clear();
+}
+
+void FstData::reconstruct_callback_attimes(uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value, uint32_t plen)
+{
+	if (pnt_time > end_time || !pnt_value) return;
+	int idx = pnt_facidx < handle_index.size() ? handle_index[pnt_facidx] : -1;
+	if (idx < 0) return;
+
+	// if we are past the timestamp
 	if (pnt_time > past_time) {
-		past_data = last_data;
+		commitValues();
 		past_time = pnt_time;
 	}
 
@@ -218,47 +249,71 @@ void FstData::reconstruct_callback_attimes(uint64_t pnt_time, fstHandle pnt_faci
 		if (all_samples) {
 			callback(last_time);
 			last_time = pnt_time;
-		} else {
-			if (is_clock) {
-				std::string val = std::string((const char *)pnt_value);
-				std::string prev = past_data[pnt_facidx];
-				if ((prev!="1" && val=="1") || (prev!="0" && val=="0")) {
-					callback(last_time);
-					last_time = pnt_time;
-				}
+		} else if (is_clock[idx] && plen == 1) {
+			State val = decode_state(pnt_value[0]);
+			State prev = value_width[idx] == 1 ? past_values[value_offset[idx]] : State::Sx;
+			if ((prev != State::S1 && val == State::S1) || (prev != State::S0 && val == State::S0)) {
+				callback(last_time);
+				last_time = pnt_time;
 			}
 		}
 	}
-	// always update last_data
-	last_data[pnt_facidx] =  std::string((const char *)pnt_value);
+
+	// always update last_values, the value string is MSB first and
+	// extended like a VCD value if it is shorter than the signal
+	int width = value_width[idx];
+	auto bits = last_values.begin() + value_offset[idx];
+	int n = std::min<int>(width, plen);
+	for (int i = 0; i < n; i++)
+		bits[i] = decode_state(pnt_value[plen - 1 - i]);
+	if (n < width) {
+		State ext = (plen == 0 || pnt_value[0] == '1') ? State::S0 : decode_state(pnt_value[0]);
+		std::fill(bits + n, bits + width, ext);
+	}
+	if (!is_changed[idx]) {
+		is_changed[idx] = true;
+		changed.push_back(idx);
+	}
 }
 
 void FstData::reconstructAllAtTimes(std::vector<fstHandle> &signal, uint64_t start, uint64_t end, CallbackFunction cb)
 {
-	clk_signals = signal;
 	callback = cb;
 	start_time = start;
 	end_time = end;
-	last_data.clear();
+	std::fill(last_values.begin(), last_values.end(), State::Sx);
 	last_time = start_time;
-	past_data.clear();
+	std::fill(past_values.begin(), past_values.end(), State::Sx);
 	past_time = start_time;
-	all_samples = clk_signals.empty();
+	changed.clear();
+	std::fill(is_changed.begin(), is_changed.end(), false);
+	std::fill(is_clock.begin(), is_clock.end(), false);
+	all_samples = signal.empty();
+	for (auto handle : signal) {
+		useHandle(handle);
+		is_clock[handle_index[handle]] = true;
+	}
 
-	fstReaderSetUnlimitedTimeRange(ctx);
-	fstReaderSetFacProcessMaskAll(ctx);
+	// only decode the signals that were asked for, and skip the blocks
+	// that end before the window
+	fstReaderSetLimitTimeRange(ctx, start_time, end_time);
+	fstReaderClrFacProcessMaskAll(ctx);
+	for (auto handle : used_handles)
+		fstReaderSetFacProcessMask(ctx, handle);
 	fstReaderIterBlocks2(ctx, reconstruct_clb_attimes, reconstruct_clb_varlen_attimes, this, nullptr);
 	if (last_time!=end_time) {
-		past_data = last_data;
+		commitValues();
 		callback(last_time);
 	}
-	past_data = last_data;
+	commitValues();
 	callback(end_time);
 }
 
-std::string FstData::valueOf(fstHandle signal)
+RTLIL::Const FstData::valueOf(fstHandle signal)
 {
-	if (past_data.find(signal) == past_data.end())
+	int idx = signal < handle_index.size() ? handle_index[signal] : -1;
+	if (idx < 0)
 		log_error("Signal id %d not found\n", (int)signal);
-	return past_data[signal];
+	auto bits = past_values.begin() + value_offset[idx];
+	return RTLIL::Const(std::vector<RTLIL::State>(bits, bits + value_width[idx]));
 }
@@ -52,9 +52,12 @@ class FstData
 	void reconstruct_callback_attimes(uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value, uint32_t plen);
 	void reconstructAllAtTimes(std::vector<fstHandle> &signal, uint64_t start_time, uint64_t end_time, CallbackFunction cb);
 
-	std::string valueOf(fstHandle signal);
+	// Only signals returned by getHandle()/getMemoryHandles() or passed to
+	// useHandle() are read from the file, valueOf() fails for all others.
+	RTLIL::Const valueOf(fstHandle signal);
 	fstHandle getHandle(std::string name);
 	dict<int,fstHandle> getMemoryHandles(std::string name);
+	void useHandle(fstHandle signal);
 	double getTimescale() { return timescale; }
 	const char *getTimescaleString() { return timescale_str.c_str(); }
 private:
@@ -65,16 +68,26 @@ private:
 	std::map<fstHandle, FstVar> handle_to_var;
 	std::map<std::string, fstHandle> name_to_handle;
 	std::map<std::string, dict<int, fstHandle>> memory_to_handle;
-	std::map<fstHandle, std::string> last_data;
+	void commitValues();
+
+	// values of the used signals, packed into flat buffers at value_offset[idx]
+	// where idx is the dense index of the signal in used_handles
+	std::vector<int> handle_index;
+	std::vector<fstHandle> used_handles;
+	std::vector<int> value_offset;
+	std::vector<int> value_width;
+	std::vector<RTLIL::State> last_values;
 	uint64_t last_time;
-	std::map<fstHandle, std::string> past_data;
+	std::vector<RTLIL::State> past_values;
 	uint64_t past_time;
+	std::vector<int> changed;
+	std::vector<bool> is_changed;
+	std::vector<bool> is_clock;
 	double timescale;
 	std::string timescale_str;
 	uint64_t start_time;
 	uint64_t end_time;
 	CallbackFunction callback;
-	std::vector<fstHandle> clk_signals;
 	bool all_samples;
 	std::string tmp_file;
 };
@@ -14,11 +14,17 @@
 
 #include <stdexcept>
 #include <algorithm>
+#include <limits>
 #include <string>
 #include <variant>
 #include <vector>
 
 #include <stdint.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
 
 namespace hashlib {
 
@@ -246,10 +252,204 @@ inline int hashtable_size(int min_size)
 	throw std::length_error("hash table exceeded maximum size.");
 }
 
+inline int flat_ctz(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(x);
+#else
+	int n = 0;
+	while (!(x & 1))
+		x >>= 1, n++;
+	return n;
+#endif
+}
+
+// A group of slots of a flat_table that is probed at once. The 16 control
+// bytes and 12 entry indices of a group fill exactly one cache line. The
+// control bytes are compared with SSE2 instructions where available, and
+// otherwise as two 64 bit words. The match functions return a bit mask with
+// bit i set if control byte i matches.
+struct flat_group
+{
+	static constexpr int width = 12;
+	static constexpr uint64_t mask = (1 << width) - 1;
+
+	struct alignas(64) storage {
+		int8_t ctrl[16];
+		int slots[width];
+	};
+
+#ifdef __SSE2__
+	__m128i ctrl;
+
+	explicit flat_group(const storage &group) : ctrl(_mm_load_si128((const __m128i*)group.ctrl)) { }
+
+	uint64_t match(int8_t h2) const {
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)) & mask;
+	}
+	uint64_t match_empty() const {
+		return match(-128);
+	}
+	uint64_t match_free() const {
+		return _mm_movemask_epi8(ctrl) & mask;
+	}
+#else
+	static constexpr uint64_t lsbs = 0x0101010101010101ull;
+	static constexpr uint64_t msbs = 0x8080808080808080ull;
+	uint64_t lo, hi;
+
+	explicit flat_group(const storage &group) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		memcpy(&lo, group.ctrl, 8);
+		memcpy(&hi, group.ctrl + 8, 8);
+#else
+		lo = hi = 0;
+		for (int i = 0; i < 8; i++) {
+			lo |= uint64_t(uint8_t(group.ctrl[i])) << (8 * i);
+			hi |= uint64_t(uint8_t(group.ctrl[i + 8])) << (8 * i);
+		}
+#endif
+	}
+
+	// collects the most significant bits of the bytes of a word in one byte
+	static uint64_t gather(uint64_t bits) {
+		return ((bits >> 7) * 0x0102040810204080ull) >> 56;
+	}
+	// may report false positives for full slots next to a real match, which
+	// are filtered out by the key comparison
+	static uint64_t match_word(uint64_t word, int8_t h2) {
+		uint64_t x = word ^ (lsbs * uint8_t(h2));
+		return gather((x - lsbs) & ~x & msbs);
+	}
+	uint64_t match(int8_t h2) const {
+		return (match_word(lo, h2) | match_word(hi, h2) << 8) & mask;
+	}
+	uint64_t match_empty() const {
+		return (gather(lo & ~(lo << 6) & msbs) | gather(hi & ~(hi << 6) & msbs) << 8) & mask;
+	}
+	uint64_t match_free() const {
+		return (gather(lo & msbs) | gather(hi & msbs) << 8) & mask;
+	}
+#endif
+
+	static int offset(uint64_t bits) {
+		return flat_ctz(bits);
+	}
+};
+
+// The index of flat_dict and flat_pool, an open-addressing hash table in the
+// style of Swiss tables. For every slot there is a control byte, which holds
+// 7 bits of the hash of the entry in the slot or marks the slot as empty or
+// deleted, and the index of the entry in the entries vector of the container.
+// Lookups compare the control bytes of a whole group at once and only look at
+// the entries whose hash bits match.
+//
+// Like the chained hash table of dict and pool, the table picks the home group
+// of a key as hash modulo the number of groups, which keeps e.g. IdStrings that
+// were created together close together in the table.
+struct flat_table
+{
+	static constexpr int8_t ctrl_empty = -128;
+	static constexpr int8_t ctrl_deleted = -2;
+	static constexpr int group_load = flat_group::width - flat_group::width / 6;
+
+	std::vector<flat_group::storage> groups;
+	int growth_left = 0;
+
+	// the control byte for a hash, taken from the upper bits of the product
+	// with a large odd constant so that it does not correlate with the group
+	static inline int8_t h2(unsigned int hash) {
+		return (uint32_t(hash) * 0x9e3779b1u) >> 25;
+	}
+
+	static inline int groups_for(size_t n) {
+		size_t num_groups = std::max<size_t>(1, (n + group_load - 1) / group_load);
+		if (num_groups > size_t(std::numeric_limits<int>::max() / flat_group::width))
+			throw std::length_error("hash table exceeded maximum size.");
+		// small tables use any odd number of groups, the primes used by the
+		// chained hash tables only start at 23
+		if (num_groups < 23)
+			return num_groups | 1;
+		return hashtable_size(num_groups);
+	}
+
+	void clear() {
+		groups.clear();
+		growth_left = 0;
+	}
+
+	void reset(int num_groups) {
+		flat_group::storage empty;
+		std::fill(std::begin(empty.ctrl), std::end(empty.ctrl), ctrl_empty);
+		std::fill(std::begin(empty.slots), std::end(empty.slots), -1);
+		groups.assign(num_groups, empty);
+		growth_left = num_groups * group_load;
+	}
+
+	int &slot(int pos) {
+		return groups[pos / flat_group::width].slots[pos % flat_group::width];
+	}
+
+	// returns the position (group * width + offset) of the first entry with
+	// the given hash for which match(entry_index) is true, or -1
+	template<typename Match>
+	int find(unsigned int hash, Match match) const
+	{
+		unsigned int num_groups = groups.size();
+		if (num_groups == 0)
+			return -1;
+		int8_t tag = h2(hash);
+		for (unsigned int index = hash % num_groups;; index = index + 1 == num_groups ? 0 : index + 1) {
+			const flat_group::storage &group = groups[index];
+			flat_group g(group);
+			for (uint64_t bits = g.match(tag); bits; bits &= bits - 1) {
+				int offset = flat_group::offset(bits);
+				if (match(group.slots[offset]))
+					return index * flat_group::width + offset;
+			}
+			if (g.match_empty())
+				return -1;
+		}
+	}
+
+	// requires growth_left > 0
+	void insert(unsigned int hash, int entry)
+	{
+		unsigned int num_groups = groups.size();
+		for (unsigned int index = hash % num_groups;; index = index + 1 == num_groups ? 0 : index + 1) {
+			flat_group::storage &group = groups[index];
+			uint64_t bits = flat_group(group).match_free();
+			if (bits) {
+				int offset = flat_group::offset(bits);
+				if (group.ctrl[offset] == ctrl_empty)
+					growth_left--;
+				group.ctrl[offset] = h2(hash);
+				group.slots[offset] = entry;
+				return;
+			}
+		}
+	}
+
+	void erase(int pos)
+	{
+		flat_group::storage &group = groups[pos / flat_group::width];
+		int offset = pos % flat_group::width;
+		// a lookup only continues past a group without empty slots, so the
+		// slot can only become empty again if its group has another one
+		if (flat_group(group).match_empty()) {
+			group.ctrl[offset] = ctrl_empty;
+			growth_left++;
+		} else
+			group.ctrl[offset] = ctrl_deleted;
+		group.slots[offset] = -1;
+	}
+};
+
 template<typename K, typename T, typename OPS = hash_ops<K>> class dict;
-template<typename K, int offset = 0, typename OPS = hash_ops<K>> class idict;
 template<typename K, typename OPS = hash_ops<K>> class pool;
-template<typename K, typename OPS = hash_ops<K>> class mfp;
+template<typename K, typename T, typename OPS = hash_ops<K>> class flat_dict;
+template<typename K, typename OPS = hash_ops<K>> class flat_pool;
+template<typename K, int offset = 0, typename OPS = hash_ops<K>, typename POOL = pool<K, OPS>> class idict;
+template<typename K, typename OPS = hash_ops<K>, typename POOL = pool<K, OPS>> class mfp;
 
 template<typename K, typename T, typename OPS>
 class dict
@@ -709,7 +909,7 @@ public:
 template<typename K, typename OPS>
 class pool
 {
-	template<typename, int, typename> friend class idict;
+	template<typename, int, typename, typename> friend class idict;
 
 protected:
 	struct entry_t
@@ -1072,111 +1272,779 @@ public:
 	const_iterator end() const { return const_iterator(nullptr, -1); }
 };
 
-template<typename K, int offset, typename OPS>
-class idict
+// flat_dict and flat_pool have the same interface and iteration order as dict
+// and pool, but use a flat_table as index instead of the chained hash table.
+// The entries are kept in a vector in insertion order as for dict and pool,
+// each together with its hash, so that rehashing does not need to hash the
+// keys again.
+
+template<typename K, typename T, typename OPS>
+class flat_dict
 {
-	pool<K, OPS> database;
+	struct entry_t
+	{
+		std::pair<K, T> udata;
+		unsigned int hash;
+
+		entry_t() { }
+		entry_t(const std::pair<K, T> &udata, unsigned int hash) : udata(udata), hash(hash) { }
+		entry_t(std::pair<K, T> &&udata, unsigned int hash) : udata(std::move(udata)), hash(hash) { }
+		bool operator<(const entry_t &other) const { return udata.first < other.udata.first; }
+	};
+
+	flat_table table;
+	std::vector<entry_t> entries;
+	OPS ops;
+
+	unsigned int do_hash(const K &key) const
+	{
+		return ops.hash(key);
+	}
+
+	void do_rehash(size_t min_size)
+	{
+		table.reset(flat_table::groups_for(std::max(min_size, entries.size())));
+		for (int i = 0; i < int(entries.size()); i++)
+			table.insert(entries[i].hash, i);
+	}
+
+	int do_erase(int index)
+	{
+		if (index < 0)
+			return 0;
+
+		table.erase(table.find(entries[index].hash, [&](int i) { return i == index; }));
+
+		int back_idx = entries.size()-1;
+
+		if (index != back_idx)
+		{
+			table.slot(table.find(entries[back_idx].hash, [&](int i) { return i == back_idx; })) = index;
+			entries[index] = std::move(entries[back_idx]);
+		}
+
+		entries.pop_back();
+
+		if (entries.empty())
+			table.clear();
+
+		return 1;
+	}
+
+	int do_lookup(const K &key, unsigned int hash) const
+	{
+		int index = -1;
+		table.find(hash, [&](int i) {
+			if (entries[i].hash != hash || !ops.cmp(entries[i].udata.first, key))
+				return false;
+			index = i;
+			return true;
+		});
+		return index;
+	}
+
+	template<typename V>
+	int do_insert(V &&value, unsigned int hash)
+	{
+		if (table.growth_left == 0)
+			do_rehash(2 * entries.size() + 1);
+		entries.emplace_back(std::forward<V>(value), hash);
+		table.insert(hash, entries.size() - 1);
+		return entries.size() - 1;
+	}
 
 public:
 	class const_iterator
 	{
-		friend class idict;
+		friend class flat_dict;
 	protected:
-		const idict &container;
+		const flat_dict *ptr;
 		int index;
-		const_iterator(const idict &container, int index) : container(container), index(index) { }
+		const_iterator(const flat_dict *ptr, int index) : ptr(ptr), index(index) { }
 	public:
 		typedef std::forward_iterator_tag iterator_category;
-		typedef K value_type;
+		typedef std::pair<K, T> value_type;
 		typedef ptrdiff_t difference_type;
-		typedef K* pointer;
-		typedef K& reference;
+		typedef std::pair<K, T>* pointer;
+		typedef std::pair<K, T>& reference;
 		const_iterator() { }
-		const_iterator operator++() { index++; return *this; }
+		const_iterator operator++() { index--; return *this; }
+		const_iterator operator+=(int amt) { index -= amt; return *this; }
+		bool operator<(const const_iterator &other) const { return index > other.index; }
 		bool operator==(const const_iterator &other) const { return index == other.index; }
 		bool operator!=(const const_iterator &other) const { return index != other.index; }
-		const K &operator*() const { return container[index]; }
-		const K *operator->() const { return &container[index]; }
+		const std::pair<K, T> &operator*() const { return ptr->entries[index].udata; }
+		const std::pair<K, T> *operator->() const { return &ptr->entries[index].udata; }
 	};
 
-	constexpr idict()
+	class iterator
+	{
+		friend class flat_dict;
+	protected:
+		flat_dict *ptr;
+		int index;
+		iterator(flat_dict *ptr, int index) : ptr(ptr), index(index) { }
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef std::pair<K, T> value_type;
+		typedef ptrdiff_t difference_type;
+		typedef std::pair<K, T>* pointer;
+		typedef std::pair<K, T>& reference;
+		iterator() { }
+		iterator operator++() { index--; return *this; }
+		iterator operator+=(int amt) { index -= amt; return *this; }
+		bool operator<(const iterator &other) const { return index > other.index; }
+		bool operator==(const iterator &other) const { return index == other.index; }
+		bool operator!=(const iterator &other) const { return index != other.index; }
+		std::pair<K, T> &operator*() { return ptr->entries[index].udata; }
+		std::pair<K, T> *operator->() { return &ptr->entries[index].udata; }
+		const std::pair<K, T> &operator*() const { return ptr->entries[index].udata; }
+		const std::pair<K, T> *operator->() const { return &ptr->entries[index].udata; }
+		operator const_iterator() const { return const_iterator(ptr, index); }
+	};
+
+	constexpr flat_dict()
 	{
 	}
 
-	int operator()(const K &key)
+	flat_dict(const flat_dict &other) : table(other.table), entries(other.entries)
 	{
-		int hash = database.do_hash(key);
-		int i = database.do_lookup(key, hash);
-		if (i < 0)
-			i = database.do_insert(key, hash);
-		return i + offset;
 	}
 
-	int at(const K &key) const
+	flat_dict(flat_dict &&other)
 	{
-		int hash = database.do_hash(key);
-		int i = database.do_lookup(key, hash);
-		if (i < 0)
-			throw std::out_of_range("idict::at()");
-		return i + offset;
+		swap(other);
 	}
 
-	int at(const K &key, int defval) const
+	flat_dict &operator=(const flat_dict &other) {
+		table = other.table;
+		entries = other.entries;
+		return *this;
+	}
+
+	flat_dict &operator=(flat_dict &&other) {
+		clear();
+		swap(other);
+		return *this;
+	}
+
+	flat_dict(const std::initializer_list<std::pair<K, T>> &list)
 	{
-		int hash = database.do_hash(key);
-		int i = database.do_lookup(key, hash);
-		if (i < 0)
-			return defval;
-		return i + offset;
+		for (auto &it : list)
+			insert(it);
 	}
 
-	int count(const K &key) const
+	template<class InputIterator>
+	flat_dict(InputIterator first, InputIterator last)
 	{
-		int hash = database.do_hash(key);
-		int i = database.do_lookup(key, hash);
-		return i < 0 ? 0 : 1;
+		insert(first, last);
 	}
 
-	void expect(const K &key, int i)
+	template<class InputIterator>
+	void insert(InputIterator first, InputIterator last)
 	{
-		int j = (*this)(key);
-		if (i != j)
-			throw std::out_of_range("idict::expect()");
+		for (; first != last; ++first)
+			insert(*first);
 	}
 
-	const K &operator[](int index) const
+	std::pair<iterator, bool> insert(const K &key)
 	{
-		return database.entries.at(index - offset).udata;
+		unsigned int hash = do_hash(key);
+		int i = do_lookup(key, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(std::pair<K, T>(key, T()), hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
 	}
 
-	void swap(idict &other)
+	std::pair<iterator, bool> insert(const std::pair<K, T> &value)
 	{
-		database.swap(other.database);
+		unsigned int hash = do_hash(value.first);
+		int i = do_lookup(value.first, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(value, hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
 	}
 
-	void reserve(size_t n) { database.reserve(n); }
-	size_t size() const { return database.size(); }
-	bool empty() const { return database.empty(); }
-	void clear() { database.clear(); }
+	std::pair<iterator, bool> insert(std::pair<K, T> &&rvalue)
+	{
+		unsigned int hash = do_hash(rvalue.first);
+		int i = do_lookup(rvalue.first, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(std::move(rvalue), hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
 
-	const_iterator begin() const { return const_iterator(*this, offset); }
-	const_iterator element(int n) const { return const_iterator(*this, n); }
-	const_iterator end() const { return const_iterator(*this, offset + size()); }
-};
+	std::pair<iterator, bool> emplace(K const &key, T const &value)
+	{
+		unsigned int hash = do_hash(key);
+		int i = do_lookup(key, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(std::make_pair(key, value), hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
 
-/**
- * Union-find data structure with a promotion method
- * mfp stands for "merge, find, promote"
- * i-prefixed methods operate on indices in parents
-*/
-template<typename K, typename OPS>
+	std::pair<iterator, bool> emplace(K const &key, T &&rvalue)
+	{
+		unsigned int hash = do_hash(key);
+		int i = do_lookup(key, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(std::make_pair(key, std::move(rvalue)), hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
+
+	std::pair<iterator, bool> emplace(K &&rkey, T const &value)
+	{
+		unsigned int hash = do_hash(rkey);
+		int i = do_lookup(rkey, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(std::make_pair(std::move(rkey), value), hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
+
+	std::pair<iterator, bool> emplace(K &&rkey, T &&rvalue)
+	{
+		unsigned int hash = do_hash(rkey);
+		int i = do_lookup(rkey, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(std::make_pair(std::move(rkey), std::move(rvalue)), hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
+
+	int erase(const K &key)
+	{
+		return do_erase(do_lookup(key, do_hash(key)));
+	}
+
+	iterator erase(iterator it)
+	{
+		do_erase(it.index);
+		return ++it;
+	}
+
+	int count(const K &key) const
+	{
+		int i = do_lookup(key, do_hash(key));
+		return i < 0 ? 0 : 1;
+	}
+
+	int count(const K &key, const_iterator it) const
+	{
+		int i = do_lookup(key, do_hash(key));
+		return i < 0 || i > it.index ? 0 : 1;
+	}
+
+	iterator find(const K &key)
+	{
+		int i = do_lookup(key, do_hash(key));
+		if (i < 0)
+			return end();
+		return iterator(this, i);
+	}
+
+	const_iterator find(const K &key) const
+	{
+		int i = do_lookup(key, do_hash(key));
+		if (i < 0)
+			return end();
+		return const_iterator(this, i);
+	}
+
+	T& at(const K &key)
+	{
+		int i = do_lookup(key, do_hash(key));
+		if (i < 0)
+			throw std::out_of_range("flat_dict::at()");
+		return entries[i].udata.second;
+	}
+
+	const T& at(const K &key) const
+	{
+		int i = do_lookup(key, do_hash(key));
+		if (i < 0)
+			throw std::out_of_range("flat_dict::at()");
+		return entries[i].udata.second;
+	}
+
+	const T& at(const K &key, const T &defval) const
+	{
+		int i = do_lookup(key, do_hash(key));
+		if (i < 0)
+			return defval;
+		return entries[i].udata.second;
+	}
+
+	T& operator[](const K &key)
+	{
+		unsigned int hash = do_hash(key);
+		int i = do_lookup(key, hash);
+		if (i < 0)
+			i = do_insert(std::pair<K, T>(key, T()), hash);
+		return entries[i].udata.second;
+	}
+
+	template<typename Compare = std::less<K>>
+	void sort(Compare comp = Compare())
+	{
+		std::sort(entries.begin(), entries.end(), [comp](const entry_t &a, const entry_t &b){ return comp(b.udata.first, a.udata.first); });
+		do_rehash(entries.size());
+	}
+
+	void swap(flat_dict &other)
+	{
+		std::swap(table, other.table);
+		entries.swap(other.entries);
+	}
+
+	bool operator==(const flat_dict &other) const {
+		if (size() != other.size())
+			return false;
+		for (auto &it : entries) {
+			auto oit = other.find(it.udata.first);
+			if (oit == other.end() || !(oit->second == it.udata.second))
+				return false;
+		}
+		return true;
+	}
+
+	bool operator!=(const flat_dict &other) const {
+		return !operator==(other);
+	}
+
+	unsigned int hash() const {
+		unsigned int h = mkhash_init;
+		for (auto &entry : entries) {
+			h ^= hash_ops<K>::hash(entry.udata.first);
+			h ^= hash_ops<T>::hash(entry.udata.second);
+		}
+		return h;
+	}
+
+	void reserve(size_t n) {
+		entries.reserve(n);
+		if (n > entries.size() + table.growth_left)
+			do_rehash(n);
+	}
+	size_t size() const { return entries.size(); }
+	bool empty() const { return entries.empty(); }
+	void clear() { table.clear(); entries.clear(); }
+
+	iterator begin() { return iterator(this, int(entries.size())-1); }
+	iterator element(int n) { return iterator(this, int(entries.size())-1-n); }
+	iterator end() { return iterator(nullptr, -1); }
+
+	const_iterator begin() const { return const_iterator(this, int(entries.size())-1); }
+	const_iterator element(int n) const { return const_iterator(this, int(entries.size())-1-n); }
+	const_iterator end() const { return const_iterator(nullptr, -1); }
+};
+
+template<typename K, typename OPS>
+class flat_pool
+{
+	template<typename, int, typename, typename> friend class idict;
+
+protected:
+	struct entry_t
+	{
+		K udata;
+		unsigned int hash;
+
+		entry_t() { }
+		entry_t(const K &udata, unsigned int hash) : udata(udata), hash(hash) { }
+		entry_t(K &&udata, unsigned int hash) : udata(std::move(udata)), hash(hash) { }
+	};
+
+	flat_table table;
+	std::vector<entry_t> entries;
+	OPS ops;
+
+	unsigned int do_hash(const K &key) const
+	{
+		return ops.hash(key);
+	}
+
+	void do_rehash(size_t min_size)
+	{
+		table.reset(flat_table::groups_for(std::max(min_size, entries.size())));
+		for (int i = 0; i < int(entries.size()); i++)
+			table.insert(entries[i].hash, i);
+	}
+
+	int do_erase(int index)
+	{
+		if (index < 0)
+			return 0;
+
+		table.erase(table.find(entries[index].hash, [&](int i) { return i == index; }));
+
+		int back_idx = entries.size()-1;
+
+		if (index != back_idx)
+		{
+			table.slot(table.find(entries[back_idx].hash, [&](int i) { return i == back_idx; })) = index;
+			entries[index] = std::move(entries[back_idx]);
+		}
+
+		entries.pop_back();
+
+		if (entries.empty())
+			table.clear();
+
+		return 1;
+	}
+
+	int do_lookup(const K &key, unsigned int hash) const
+	{
+		int index = -1;
+		table.find(hash, [&](int i) {
+			if (entries[i].hash != hash || !ops.cmp(entries[i].udata, key))
+				return false;
+			index = i;
+			return true;
+		});
+		return index;
+	}
+
+	template<typename V>
+	int do_insert(V &&value, unsigned int hash)
+	{
+		if (table.growth_left == 0)
+			do_rehash(2 * entries.size() + 1);
+		entries.emplace_back(std::forward<V>(value), hash);
+		table.insert(hash, entries.size() - 1);
+		return entries.size() - 1;
+	}
+
+public:
+	class const_iterator
+	{
+		friend class flat_pool;
+	protected:
+		const flat_pool *ptr;
+		int index;
+		const_iterator(const flat_pool *ptr, int index) : ptr(ptr), index(index) { }
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef K value_type;
+		typedef ptrdiff_t difference_type;
+		typedef K* pointer;
+		typedef K& reference;
+		const_iterator() { }
+		const_iterator operator++() { index--; return *this; }
+		bool operator==(const const_iterator &other) const { return index == other.index; }
+		bool operator!=(const const_iterator &other) const { return index != other.index; }
+		const K &operator*() const { return ptr->entries[index].udata; }
+		const K *operator->() const { return &ptr->entries[index].udata; }
+	};
+
+	class iterator
+	{
+		friend class flat_pool;
+	protected:
+		flat_pool *ptr;
+		int index;
+		iterator(flat_pool *ptr, int index) : ptr(ptr), index(index) { }
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef K value_type;
+		typedef ptrdiff_t difference_type;
+		typedef K* pointer;
+		typedef K& reference;
+		iterator() { }
+		iterator operator++() { index--; return *this; }
+		bool operator==(const iterator &other) const { return index == other.index; }
+		bool operator!=(const iterator &other) const { return index != other.index; }
+		K &operator*() { return ptr->entries[index].udata; }
+		K *operator->() { return &ptr->entries[index].udata; }
+		const K &operator*() const { return ptr->entries[index].udata; }
+		const K *operator->() const { return &ptr->entries[index].udata; }
+		operator const_iterator() const { return const_iterator(ptr, index); }
+	};
+
+	constexpr flat_pool()
+	{
+	}
+
+	flat_pool(const flat_pool &other) : table(other.table), entries(other.entries)
+	{
+	}
+
+	flat_pool(flat_pool &&other)
+	{
+		swap(other);
+	}
+
+	flat_pool &operator=(const flat_pool &other) {
+		table = other.table;
+		entries = other.entries;
+		return *this;
+	}
+
+	flat_pool &operator=(flat_pool &&other) {
+		clear();
+		swap(other);
+		return *this;
+	}
+
+	flat_pool(const std::initializer_list<K> &list)
+	{
+		for (auto &it : list)
+			insert(it);
+	}
+
+	template<class InputIterator>
+	flat_pool(InputIterator first, InputIterator last)
+	{
+		insert(first, last);
+	}
+
+	template<class InputIterator>
+	void insert(InputIterator first, InputIterator last)
+	{
+		for (; first != last; ++first)
+			insert(*first);
+	}
+
+	std::pair<iterator, bool> insert(const K &value)
+	{
+		unsigned int hash = do_hash(value);
+		int i = do_lookup(value, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(value, hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
+
+	std::pair<iterator, bool> insert(K &&rvalue)
+	{
+		unsigned int hash = do_hash(rvalue);
+		int i = do_lookup(rvalue, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(std::move(rvalue), hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
+
+	template<typename... Args>
+	std::pair<iterator, bool> emplace(Args&&... args)
+	{
+		return insert(K(std::forward<Args>(args)...));
+	}
+
+	int erase(const K &key)
+	{
+		return do_erase(do_lookup(key, do_hash(key)));
+	}
+
+	iterator erase(iterator it)
+	{
+		do_erase(it.index);
+		return ++it;
+	}
+
+	int count(const K &key) const
+	{
+		int i = do_lookup(key, do_hash(key));
+		return i < 0 ? 0 : 1;
+	}
+
+	int count(const K &key, const_iterator it) const
+	{
+		int i = do_lookup(key, do_hash(key));
+		return i < 0 || i > it.index ? 0 : 1;
+	}
+
+	iterator find(const K &key)
+	{
+		int i = do_lookup(key, do_hash(key));
+		if (i < 0)
+			return end();
+		return iterator(this, i);
+	}
+
+	const_iterator find(const K &key) const
+	{
+		int i = do_lookup(key, do_hash(key));
+		if (i < 0)
+			return end();
+		return const_iterator(this, i);
+	}
+
+	bool operator[](const K &key)
+	{
+		return do_lookup(key, do_hash(key)) >= 0;
+	}
+
+	template<typename Compare = std::less<K>>
+	void sort(Compare comp = Compare())
+	{
+		std::sort(entries.begin(), entries.end(), [comp](const entry_t &a, const entry_t &b){ return comp(b.udata, a.udata); });
+		do_rehash(entries.size());
+	}
+
+	K pop()
+	{
+		iterator it = begin();
+		K ret = *it;
+		erase(it);
+		return ret;
+	}
+
+	void swap(flat_pool &other)
+	{
+		std::swap(table, other.table);
+		entries.swap(other.entries);
+	}
+
+	bool operator==(const flat_pool &other) const {
+		if (size() != other.size())
+			return false;
+		for (auto &it : entries)
+			if (!other.count(it.udata))
+				return false;
+		return true;
+	}
+
+	bool operator!=(const flat_pool &other) const {
+		return !operator==(other);
+	}
+
+	unsigned int hash() const {
+		unsigned int hashval = mkhash_init;
+		for (auto &it : entries)
+			hashval ^= ops.hash(it.udata);
+		return hashval;
+	}
+
+	void reserve(size_t n) {
+		entries.reserve(n);
+		if (n > entries.size() + table.growth_left)
+			do_rehash(n);
+	}
+	size_t size() const { return entries.size(); }
+	bool empty() const { return entries.empty(); }
+	void clear() { table.clear(); entries.clear(); }
+
+	iterator begin() { return iterator(this, int(entries.size())-1); }
+	iterator element(int n) { return iterator(this, int(entries.size())-1-n); }
+	iterator end() { return iterator(nullptr, -1); }
+
+	const_iterator begin() const { return const_iterator(this, int(entries.size())-1); }
+	const_iterator element(int n) const { return const_iterator(this, int(entries.size())-1-n); }
+	const_iterator end() const { return const_iterator(nullptr, -1); }
+};
+
+template<typename K, int offset, typename OPS, typename POOL>
+class idict
+{
+	POOL database;
+
+public:
+	class const_iterator
+	{
+		friend class idict;
+	protected:
+		const idict &container;
+		int index;
+		const_iterator(const idict &container, int index) : container(container), index(index) { }
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef K value_type;
+		typedef ptrdiff_t difference_type;
+		typedef K* pointer;
+		typedef K& reference;
+		const_iterator() { }
+		const_iterator operator++() { index++; return *this; }
+		bool operator==(const const_iterator &other) const { return index == other.index; }
+		bool operator!=(const const_iterator &other) const { return index != other.index; }
+		const K &operator*() const { return container[index]; }
+		const K *operator->() const { return &container[index]; }
+	};
+
+	constexpr idict()
+	{
+	}
+
+	int operator()(const K &key)
+	{
+		auto hash = database.do_hash(key);
+		int i = database.do_lookup(key, hash);
+		if (i < 0)
+			i = database.do_insert(key, hash);
+		return i + offset;
+	}
+
+	int at(const K &key) const
+	{
+		auto hash = database.do_hash(key);
+		int i = database.do_lookup(key, hash);
+		if (i < 0)
+			throw std::out_of_range("idict::at()");
+		return i + offset;
+	}
+
+	int at(const K &key, int defval) const
+	{
+		auto hash = database.do_hash(key);
+		int i = database.do_lookup(key, hash);
+		if (i < 0)
+			return defval;
+		return i + offset;
+	}
+
+	int count(const K &key) const
+	{
+		auto hash = database.do_hash(key);
+		int i = database.do_lookup(key, hash);
+		return i < 0 ? 0 : 1;
+	}
+
+	void expect(const K &key, int i)
+	{
+		int j = (*this)(key);
+		if (i != j)
+			throw std::out_of_range("idict::expect()");
+	}
+
+	const K &operator[](int index) const
+	{
+		return database.entries.at(index - offset).udata;
+	}
+
+	void swap(idict &other)
+	{
+		database.swap(other.database);
+	}
+
+	void reserve(size_t n) { database.reserve(n); }
+	size_t size() const { return database.size(); }
+	bool empty() const { return database.empty(); }
+	void clear() { database.clear(); }
+
+	const_iterator begin() const { return const_iterator(*this, offset); }
+	const_iterator element(int n) const { return const_iterator(*this, n); }
+	const_iterator end() const { return const_iterator(*this, offset + size()); }
+};
+
+/**
+ * Union-find data structure with a promotion method
+ * mfp stands for "merge, find, promote"
+ * i-prefixed methods operate on indices in parents
+*/
+template<typename K, typename OPS, typename POOL>
 class mfp
 {
-	mutable idict<K, 0, OPS> database;
+	mutable idict<K, 0, OPS, POOL> database;
 	mutable std::vector<int> parents;
 
 public:
-	typedef typename idict<K, 0, OPS>::const_iterator const_iterator;
+	typedef typename idict<K, 0, OPS, POOL>::const_iterator const_iterator;
 
 	constexpr mfp()
 	{
@@ -35,6 +35,7 @@
 #include <stdarg.h>
 #include <vector>
 #include <list>
+#include <algorithm>
 
 YOSYS_NAMESPACE_BEGIN
 
@@ -53,8 +54,10 @@ FILE *log_errfile = NULL;
 SHA1 *log_hasher = NULL;
 
 bool log_time = false;
+bool log_async = false;
 bool log_error_stderr = false;
 bool log_cmd_error_throw = false;
+bool log_error_throw = false;
 bool log_quiet_warnings = false;
 int log_verbose_level;
 string log_last_error;
@@ -63,12 +66,20 @@ void (*log_verific_callback)(int msg_type, const char *message_id, const char* f
 
 int log_make_debug = 0;
 int log_force_debug = 0;
-int log_debug_suppressed = 0;
+thread_local int log_debug_suppressed = 0;
+thread_local LogBuffer *log_thread_buffer = nullptr;
 
 vector<int> header_count;
-vector<char*> log_id_cache;
-vector<shared_str> string_buf;
-int string_buf_index = -1;
+thread_local vector<shared_str> string_buf;
+thread_local int string_buf_index = -1;
+
+// strings returned by log_id() and log_str() are owned by this cache
+static thread_local struct log_id_cache_t : vector<char*> {
+	~log_id_cache_t() {
+		for (auto p : *this)
+			free(p);
+	}
+} log_id_cache;
 
 static struct timeval initial_tv = { 0, 0 };
 static bool next_print_log = false;
@@ -81,6 +92,139 @@ static void log_id_cache_clear()
 	log_id_cache.clear();
 }
 
+#ifdef YOSYS_ENABLE_THREADS
+// The background writer for log_async. Log text is appended to `pending',
+// together with the log_files it goes to, and picked up by the writer thread
+// when a batch is full, when log_flush() asks for it, or at the latest after
+// batch_delay. Appending only takes a lock that is hardly ever contended, the
+// files are written while the lock is not held.
+struct LogWriter
+{
+	struct Chunk {
+		std::vector<FILE*> files;
+		std::string text;
+	};
+
+	static constexpr size_t batch_size = 64 << 10;
+	static constexpr size_t max_backlog = 16 << 20;
+	static constexpr std::chrono::milliseconds batch_delay{100};
+
+	std::mutex mutex;
+	std::condition_variable wakeup, written_cond;
+	std::vector<Chunk> pending;
+	// bytes appended, picked up by the writer, and written out so far
+	uint64_t appended = 0, taken = 0, written = 0;
+	bool flush_requested = false;
+	bool stopping = false;
+	std::thread thread;
+
+	~LogWriter()
+	{
+		stop();
+	}
+
+	void append(const std::vector<FILE*> &files, const std::string &str)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!thread.joinable())
+			thread = std::thread([this]{ run(); });
+
+		// don't let a slow console make us buffer the whole log
+		if (appended - written > max_backlog) {
+			flush_requested = true;
+			wakeup.notify_one();
+			written_cond.wait(lock, [&]{ return appended - written <= max_backlog / 2; });
+		}
+
+		bool was_empty = pending.empty();
+		if (was_empty || pending.back().files != files)
+			pending.push_back({files, std::string()});
+		pending.back().text += str;
+		appended += str.size();
+
+		if (was_empty || appended - taken >= batch_size)
+			wakeup.notify_one();
+	}
+
+	// waits until everything appended so far has been written
+	void flush()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (written == appended)
+			return;
+		uint64_t target = appended;
+		flush_requested = true;
+		wakeup.notify_one();
+		written_cond.wait(lock, [&]{ return written >= target; });
+	}
+
+	void stop()
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (!thread.joinable())
+				return;
+			stopping = true;
+			wakeup.notify_one();
+		}
+		thread.join();
+		thread = std::thread();
+		stopping = false;
+	}
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			wakeup.wait(lock, [&]{ return stopping || !pending.empty(); });
+			if (pending.empty())
+				break;
+
+			// give the main thread some time to fill up the batch
+			wakeup.wait_for(lock, batch_delay, [&]{ return stopping || flush_requested || appended - taken >= batch_size; });
+
+			std::vector<Chunk> batch;
+			batch.swap(pending);
+			uint64_t target = appended;
+			taken = appended;
+			flush_requested = false;
+			lock.unlock();
+
+			std::vector<FILE*> touched;
+			for (auto &chunk : batch)
+				for (auto f : chunk.files) {
+					fwrite(chunk.text.data(), 1, chunk.text.size(), f);
+					if (std::find(touched.begin(), touched.end(), f) == touched.end())
+						touched.push_back(f);
+				}
+			for (auto f : touched)
+				fflush(f);
+
+			lock.lock();
+			written = target;
+			written_cond.notify_all();
+		}
+	}
+};
+
+static LogWriter log_writer;
+#endif
+
+// writes str to all log_files, or hands it to the writer thread
+static void log_write_files(const std::string &str)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	if (log_async) {
+		if (!log_files.empty() && !str.empty())
+			log_writer.append(log_files, str);
+		return;
+	}
+#endif
+	for (auto f : log_files)
+		fputs(str.c_str(), f);
+}
+
 #if defined(_WIN32) && !defined(__MINGW32__)
 // this will get time information and return it in timeval, simulating gettimeofday()
 int gettimeofday(struct timeval *tv, struct timezone *tz)
@@ -116,6 +260,11 @@ void logv(const char *format, va_list ap)
 	if (str.empty())
 		return;
 
+	if (log_thread_buffer != nullptr) {
+		log_thread_buffer->items.push_back({false, std::string(), str});
+		return;
+	}
+
 	size_t nnl_pos = str.find_last_not_of('\n');
 	if (nnl_pos == std::string::npos)
 		log_newline_count += GetSize(str);
@@ -153,15 +302,13 @@ void logv(const char *format, va_list ap)
 		if (!strcmp(format, "%s") && str.back() == '\n')
 			next_print_log = true;
 
-		for (auto f : log_files)
-			fputs(time_str.c_str(), f);
+		log_write_files(time_str);
 
 		for (auto f : log_streams)
 			*f << time_str;
 	}
 
-	for (auto f : log_files)
-		fputs(str.c_str(), f);
+	log_write_files(str);
 
 	for (auto f : log_streams)
 		*f << str;
@@ -248,6 +395,11 @@ static void logv_warning_with_prefix(const char *prefix,
 	std::string message = vstringf(format, ap);
 	bool suppressed = false;
 
+	if (log_thread_buffer != nullptr) {
+		log_thread_buffer->items.push_back({true, prefix, message});
+		return;
+	}
+
 	for (auto &re : log_nowarn_regexes)
 		if (std::regex_search(message, re))
 			suppressed = true;
@@ -298,6 +450,14 @@ static void logv_warning_with_prefix(const char *prefix,
 	}
 }
 
+static void log_warning_with_prefix(const char *prefix, const char *format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	logv_warning_with_prefix(prefix, format, ap);
+	va_end(ap);
+}
+
 void logv_warning(const char *format, va_list ap)
 {
 	logv_warning_with_prefix("Warning: ", format, ap);
@@ -334,9 +494,17 @@ void log_file_info(const std::string &filename, int lineno,
 static void logv_error_with_prefix(const char *prefix,
                                    const char *format, va_list ap)
 {
-#ifdef EMSCRIPTEN
+	// Errors on worker threads are written out right away, one at a time.
+	// Unless errors are thrown, only the first one gets through and the lock
+	// is never released as we are going to exit.
+	static Mutex worker_error_mutex;
+	LogBuffer *worker_log_buffer = log_thread_buffer;
+	if (worker_log_buffer != nullptr) {
+		worker_error_mutex.lock();
+		log_thread_buffer = nullptr;
+	}
+
 	auto backup_log_files = log_files;
-#endif
 	int bak_log_make_debug = log_make_debug;
 	log_make_debug = 0;
 	log_suppressed();
@@ -359,6 +527,16 @@ static void logv_error_with_prefix(const char *prefix,
 		if (std::regex_search(log_last_error, item.second.pattern))
 			item.second.current_count++;
 
+	if (log_error_throw) {
+		log_files = backup_log_files;
+		// Pass::parallel_for_modules() rethrows this on the main thread
+		if (worker_log_buffer != nullptr) {
+			log_thread_buffer = worker_log_buffer;
+			worker_error_mutex.unlock();
+		}
+		throw log_cmd_error_exception();
+	}
+
 	log_check_expected();
 
 	if (log_error_atexit)
@@ -500,6 +678,20 @@ void log_pop()
 	log_flush();
 }
 
+void log_replay(const LogBuffer &buffer)
+{
+	log_assert(log_thread_buffer == nullptr);
+
+	for (auto &item : buffer.items) {
+		if (item.warning)
+			log_warning_with_prefix(item.prefix.c_str(), "%s", item.text.c_str());
+		else
+			log("%s", item.text.c_str());
+	}
+
+	log_debug_suppressed += buffer.debug_suppressed;
+}
+
 #if (defined(__linux__) || defined(__FreeBSD__)) && defined(YOSYS_ENABLE_PLUGINS)
 void log_backtrace(const char *prefix, int levels)
 {
@@ -609,6 +801,10 @@ void log_reset_stack()
 
 void log_flush()
 {
+#ifdef YOSYS_ENABLE_THREADS
+	log_writer.flush();
+#endif
+
 	for (auto f : log_files)
 		fflush(f);
 
@@ -110,6 +110,10 @@ extern SHA1 *log_hasher;
 extern bool log_time;
 extern bool log_error_stderr;
 extern bool log_cmd_error_throw;
+// Makes log_error() throw log_cmd_error_exception instead of exiting, for
+// callers that must survive a failing command (the --server mode). The
+// design may be left in a half-modified state.
+extern bool log_error_throw;
 extern bool log_quiet_warnings;
 extern int log_verbose_level;
 extern string log_last_error;
@@ -117,7 +121,7 @@ extern void (*log_error_atexit)();
 
 extern int log_make_debug;
 extern int log_force_debug;
-extern int log_debug_suppressed;
+extern thread_local int log_debug_suppressed;
 
 void logv(const char *format, va_list ap);
 void logv_header(RTLIL::Design *design, const char *format, va_list ap);
@@ -185,10 +189,35 @@ void log_spacer();
 void log_push();
 void log_pop();
 
+// While log_thread_buffer is set, log messages and warnings of the current thread
+// are collected in that buffer instead of being written out. This is used for worker
+// threads (see Pass::parallel_for_modules()), whose buffers are then written out
+// in a fixed order by the main thread with log_replay().
+struct LogBuffer
+{
+	struct Item {
+		bool warning;
+		std::string prefix, text;
+	};
+
+	std::vector<Item> items;
+	int debug_suppressed = 0;
+};
+
+extern thread_local LogBuffer *log_thread_buffer;
+void log_replay(const LogBuffer &buffer);
+
 void log_backtrace(const char *prefix, int levels);
 void log_reset_stack();
 void log_flush();
 
+// When set, the output for log_files is written by a background thread, so
+// that slow consoles and log files don't hold up the main thread (set with the
+// --async-log command line option). Output is handed over in batches and shows
+// up with a short delay. log_flush() waits until everything logged so far has
+// been written, so code that writes to log_files directly must call it first.
+extern bool log_async;
+
 struct LogExpectedItem
 {
 	LogExpectedItem(const std::regex &pat, int expected) :
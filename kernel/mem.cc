@@ -260,7 +260,9 @@ void Mem::emit() {
 				init.cell = nullptr;
 			}
 		}
+		// init data of large memories takes a quarter of the space when packed
 		cell->parameters[ID::INIT] = get_init_data();
+		cell->parameters[ID::INIT].pack();
 	} else {
 		if (cell) {
 			module->remove(cell);
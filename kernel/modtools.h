@@ -78,6 +78,14 @@ struct ModIndex : public RTLIL::Monitor
 	int auto_reload_counter;
 	bool auto_reload_module;
 
+	// When set, the index stops following cell port changes once more port
+	// bits changed since the last query than it has entries, and is rebuilt
+	// on the next query instead. Used for the long-lived ModIndexCache entries,
+	// which would otherwise slow down passes that rewrite whole modules.
+	bool lazy_updates = false;
+	int lazy_update_count = 0;
+	bool lazy_reload = false;
+
 	void port_add(RTLIL::Cell *cell, RTLIL::IdString port, const RTLIL::SigSpec &sig)
 	{
 		for (int i = 0; i < GetSize(sig); i++) {
@@ -123,10 +131,12 @@ struct ModIndex : public RTLIL::Monitor
 				port_add(cell, conn.first, conn.second);
 
 		if (auto_reload_module) {
-			if (++auto_reload_counter > 2)
+			if (!lazy_reload && ++auto_reload_counter > 2)
 				log_warning("Auto-reload in ModIndex -- possible performance bug!\n");
 			auto_reload_module = false;
+			lazy_reload = false;
 		}
+		lazy_update_count = 0;
 	}
 
 	void check()
@@ -165,6 +175,16 @@ struct ModIndex : public RTLIL::Monitor
 		if (auto_reload_module)
 			return;
 
+		if (lazy_updates) {
+			lazy_update_count += GetSize(old_sig) + GetSize(sig);
+			if (lazy_update_count > GetSize(database)) {
+				database.clear();
+				auto_reload_module = true;
+				lazy_reload = true;
+				return;
+			}
+		}
+
 		port_del(cell, port, old_sig);
 		port_add(cell, port, sig);
 	}
@@ -173,8 +193,12 @@ struct ModIndex : public RTLIL::Monitor
 	{
 		log_assert(module == mod);
 
-		if (auto_reload_module)
+		// keep the sigmap usable for passes that use it between queries
+		if (auto_reload_module) {
+			if (lazy_reload)
+				sigmap.add(sigsig.first, sigsig.second);
 			return;
+		}
 
 		for (int i = 0; i < GetSize(sigsig.first); i++)
 		{
@@ -218,12 +242,14 @@ struct ModIndex : public RTLIL::Monitor
 	{
 		log_assert(module == mod);
 		auto_reload_module = true;
+		lazy_reload = false;
 	}
 
 	void notify_blackout(RTLIL::Module *mod) override
 	{
 		log_assert(module == mod);
 		auto_reload_module = true;
+		lazy_reload = false;
 	}
 
 	ModIndex(RTLIL::Module *_m) : sigmap(_m), module(_m)
@@ -242,6 +268,7 @@ struct ModIndex : public RTLIL::Monitor
 	{
 		if (auto_reload_module)
 			reload_module();
+		lazy_update_count = 0;
 
 		auto it = database.find(sigmap(bit));
 		if (it == database.end())
@@ -297,6 +324,78 @@ struct ModIndex : public RTLIL::Monitor
 	}
 };
 
+/**
+ * ModIndexCache holds the ModIndex instances handed out by
+ * RTLIL::Design::modindex(). There is at most one per module; it follows all
+ * changes made through the RTLIL API (setPort, connect, remove, ...) like any
+ * other ModIndex, and falls back to a full rebuild on its next use after the
+ * module got a blackout, e.g. from fixup_ports(), rewrite_sigspecs() or
+ * removing wires. Indexes are dropped when their module is removed from the
+ * design or on modindex_invalidate().
+ *
+ * The cache is not a design monitor itself: RTLIL::Design::remove() calls
+ * invalidate() directly, so that an attached cache does not make
+ * Pass::parallel_for_modules() fall back to a single thread. Workers of
+ * that function may call get() concurrently for their own modules.
+ */
+struct ModIndexCache
+{
+	RTLIL::Design *design;
+	dict<RTLIL::Module*, ModIndex*> indexes;
+	Mutex mutex;
+
+	ModIndexCache(RTLIL::Design *design) : design(design) { }
+
+	~ModIndexCache()
+	{
+		clear();
+	}
+
+	ModIndex &get(RTLIL::Module *module)
+	{
+		log_assert(module->design == design);
+		ModIndex *index;
+		bool is_new = false;
+		{
+			MutexLock lock(mutex);
+			ModIndex *&entry = indexes[module];
+			if (entry == nullptr) {
+				entry = new ModIndex(module);
+				is_new = true;
+			}
+			index = entry;
+		}
+		// passes may use the sigmap before their first query, so hand out
+		// the index in a loaded state
+		if (is_new) {
+			index->lazy_updates = true;
+			index->reload_module(false);
+		} else if (index->auto_reload_module)
+			index->reload_module();
+		index->auto_reload_counter = 0;
+		index->lazy_update_count = 0;
+		return *index;
+	}
+
+	void invalidate(RTLIL::Module *module)
+	{
+		MutexLock lock(mutex);
+		auto it = indexes.find(module);
+		if (it == indexes.end())
+			return;
+		delete it->second;
+		indexes.erase(it);
+	}
+
+	void clear()
+	{
+		MutexLock lock(mutex);
+		for (auto &it : indexes)
+			delete it.second;
+		indexes.clear();
+	}
+};
+
 struct ModWalker
 {
 	struct PortBit
@@ -387,6 +486,14 @@ struct ModWalker
 			setup(module);
 	}
 
+	// Takes cell types that the caller set up for the design beforehand,
+	// e.g. for workers of Pass::parallel_for_modules() that must not look
+	// at other modules while those are being changed
+	ModWalker(RTLIL::Design *design, const CellTypes &ct, RTLIL::Module *module) : design(design), module(NULL), ct(ct)
+	{
+		setup(module);
+	}
+
 	void setup(RTLIL::Module *module, CellTypes *filter_ct = NULL)
 	{
 		this->module = module;
@@ -0,0 +1,100 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef OBJPOOL_H
+#define OBJPOOL_H
+
+#include "kernel/yosys_common.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+/**
+ * Raw storage for objects of type T, carved out of slabs that grow
+ * geometrically. Freed slots are kept on a free list for reuse, and all
+ * slabs are released together when the pool is destroyed. Constructing and
+ * destroying the objects is up to the caller, and every object must be
+ * destroyed and deallocated before the pool goes away.
+ *
+ * Builds without YOSYS_ENABLE_OBJECT_POOL (e.g. with ASan, where pooling
+ * would hide use-after-free errors) allocate each object individually.
+ */
+template<typename T>
+class ObjectPool
+{
+	union Slot {
+		Slot *next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	static constexpr int max_slab_size = 4096;
+
+	std::vector<Slot*> slabs;
+	Slot *free_list = nullptr;
+	int next_slab_size = 16;
+
+	void grow()
+	{
+		Slot *slab = static_cast<Slot*>(::operator new(next_slab_size * sizeof(Slot)));
+		slabs.push_back(slab);
+		for (int i = next_slab_size - 1; i >= 0; i--) {
+			slab[i].next = free_list;
+			free_list = &slab[i];
+		}
+		next_slab_size = std::min(2 * next_slab_size, max_slab_size);
+	}
+
+public:
+	ObjectPool() { }
+	ObjectPool(const ObjectPool &) = delete;
+	ObjectPool &operator=(const ObjectPool &) = delete;
+
+	~ObjectPool()
+	{
+		for (auto slab : slabs)
+			::operator delete(slab);
+	}
+
+	void *allocate()
+	{
+#ifdef YOSYS_ENABLE_OBJECT_POOL
+		if (free_list == nullptr)
+			grow();
+		Slot *slot = free_list;
+		free_list = slot->next;
+		return slot->storage;
+#else
+		return ::operator new(sizeof(T));
+#endif
+	}
+
+	void deallocate(void *p)
+	{
+#ifdef YOSYS_ENABLE_OBJECT_POOL
+		Slot *slot = static_cast<Slot*>(p);
+		slot->next = free_list;
+		free_list = slot;
+#else
+		::operator delete(p);
+#endif
+	}
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/profiler.h"
+#include "kernel/json.h"
+
+#include <ctime>
+
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__APPLE__)
+#  include <sys/resource.h>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+Profiler *yosys_profiler = nullptr;
+
+static int64_t peak_rss_kb()
+{
+#if defined(__linux__) || defined(__FreeBSD__)
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+#elif defined(__APPLE__)
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss / 1024;
+#else
+	return 0;
+#endif
+}
+
+Profiler::Sample Profiler::sample(const RTLIL::Design *design)
+{
+	Sample s;
+	s.wall_ns = PerformanceTimer::query();
+	s.cpu_ns = int64_t(std::clock()) * (1000000000 / CLOCKS_PER_SEC);
+	s.peak_rss_kb = peak_rss_kb();
+
+	s.num_ids = RTLIL::IdString::global_id_count_.load(std::memory_order_relaxed);
+#ifndef YOSYS_NO_IDS_REFCNT
+	s.num_ids -= GetSize(RTLIL::IdString::global_free_idx_list_);
+#endif
+
+	if (design != nullptr)
+		for (auto &it : design->modules_) {
+			s.num_cells += GetSize(it.second->cells_);
+			s.num_wires += GetSize(it.second->wires_);
+		}
+	return s;
+}
+
+int Profiler::begin(const std::string &name, const RTLIL::Design *design, const std::vector<std::string> &args,
+		const char *category)
+{
+	std::string command;
+	for (auto &arg : args)
+		command += (command.empty() ? "" : " ") + arg;
+
+	if (!open_spans.empty()) {
+		const Span &parent = spans[open_spans.back()];
+		if (parent.name == name && (args.empty() || parent.command == command))
+			return -1;
+	}
+
+	Span span;
+	span.name = name;
+	span.command = command.empty() ? name : command;
+	span.category = category;
+	span.depth = GetSize(open_spans);
+	span.begin = sample(design);
+	open_spans.push_back(GetSize(spans));
+	spans.push_back(std::move(span));
+	return open_spans.back();
+}
+
+void Profiler::end(int span, const RTLIL::Design *design)
+{
+	if (span < 0)
+		return;
+
+	// spans of commands that were aborted by an exception are closed together
+	// with the command that caught it
+	Sample s = sample(design);
+	while (!open_spans.empty()) {
+		int index = open_spans.back();
+		open_spans.pop_back();
+		spans[index].end = s;
+		if (index == span)
+			break;
+	}
+}
+
+void Profiler::write(std::ostream &f) const
+{
+	int64_t origin = spans.empty() ? 0 : spans.front().begin.wall_ns;
+	auto timestamp = [&](const Sample &s) { return (s.wall_ns - origin) / 1000.0; };
+
+	Json::array events;
+	events.push_back(Json::object {
+		{"name", "process_name"}, {"ph", "M"}, {"pid", 1},
+		{"args", Json::object {{"name", "yosys"}}},
+	});
+
+	for (auto &span : spans) {
+		// still running, e.g. the script that is writing the profile
+		if (span.end.wall_ns == 0)
+			continue;
+
+		events.push_back(Json::object {
+			{"name", span.name}, {"cat", span.category}, {"ph", "X"}, {"pid", 1}, {"tid", 1},
+			{"ts", timestamp(span.begin)},
+			{"dur", (span.end.wall_ns - span.begin.wall_ns) / 1000.0},
+			{"args", Json::object {
+				{"command", span.command},
+				{"cpu_ms", (span.end.cpu_ns - span.begin.cpu_ns) / 1000000.0},
+				{"peak_rss_growth_kb", double(span.end.peak_rss_kb - span.begin.peak_rss_kb)},
+				{"idstrings_before", span.begin.num_ids},
+				{"idstrings_after", span.end.num_ids},
+				{"cells_before", span.begin.num_cells},
+				{"cells_after", span.end.num_cells},
+				{"wires_before", span.begin.num_wires},
+				{"wires_after", span.end.num_wires},
+			}},
+		});
+
+		events.push_back(Json::object {
+			{"name", "design"}, {"ph", "C"}, {"pid", 1}, {"ts", timestamp(span.end)},
+			{"args", Json::object {{"cells", span.end.num_cells}, {"wires", span.end.num_wires}}},
+		});
+		events.push_back(Json::object {
+			{"name", "memory"}, {"ph", "C"}, {"pid", 1}, {"ts", timestamp(span.end)},
+			{"args", Json::object {{"peak_rss_mb", span.end.peak_rss_kb / 1024.0}, {"idstrings", span.end.num_ids}}},
+		});
+	}
+
+	f << Json(Json::object {{"traceEvents", events}, {"displayTimeUnit", "ms"}}).dump() << "\n";
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,71 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+/**
+ * Records a span for every executed command, nested like the commands that
+ * call each other, with wall and CPU time, the growth of the peak RSS and of
+ * the IdString table, and the number of cells and wires in the design the
+ * command runs on. The spans are written as Chrome trace event JSON, which
+ * can be loaded into chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Profiling is enabled by setting yosys_profiler, e.g. with
+ * `yosys --profile <file>`. Pass::pre_execute() and post_execute() open and
+ * close the spans. The driver adds a span in the "startup" category for the
+ * time spent in yosys_setup() and loading plugins.
+ */
+struct Profiler
+{
+	struct Sample {
+		int64_t wall_ns = 0, cpu_ns = 0;
+		int64_t peak_rss_kb = 0;
+		int num_ids = 0, num_cells = 0, num_wires = 0;
+	};
+
+	struct Span {
+		std::string name, command, category;
+		int depth;
+		Sample begin, end;
+	};
+
+	std::vector<Span> spans;
+	std::vector<int> open_spans;
+
+	static Sample sample(const RTLIL::Design *design);
+
+	// returns -1 instead of opening a new span if the command is already the
+	// innermost open span, as for frontends which are entered twice
+	int begin(const std::string &name, const RTLIL::Design *design, const std::vector<std::string> &args,
+			const char *category = "command");
+	void end(int span, const RTLIL::Design *design);
+
+	void write(std::ostream &f) const;
+};
+
+extern Profiler *yosys_profiler;
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -20,6 +20,7 @@
 #include "kernel/yosys.h"
 #include "kernel/satgen.h"
 #include "kernel/json.h"
+#include "kernel/profiler.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -149,10 +150,12 @@ Pass::~Pass()
 {
 }
 
-Pass::pre_post_exec_state_t Pass::pre_execute()
+Pass::pre_post_exec_state_t Pass::pre_execute(RTLIL::Design *design, const std::vector<std::string> &args)
 {
 	pre_post_exec_state_t state;
 	call_counter++;
+	state.design = design;
+	state.profiler_span = yosys_profiler ? yosys_profiler->begin(pass_name, design, args) : -1;
 	state.begin_ns = PerformanceTimer::query();
 	state.parent_pass = current_pass;
 	current_pass = this;
@@ -170,6 +173,9 @@ void Pass::post_execute(Pass::pre_post_exec_state_t state)
 	current_pass = state.parent_pass;
 	if (current_pass)
 		current_pass->runtime_ns -= time_ns;
+
+	if (yosys_profiler)
+		yosys_profiler->end(state.profiler_span, state.design);
 }
 
 void Pass::help()
@@ -314,13 +320,95 @@ void Pass::call(RTLIL::Design *design, std::vector<std::string> args)
 		log_experimental("%s", args[0].c_str());
 
 	size_t orig_sel_stack_pos = design->selection_stack.size();
-	auto state = pass_register[args[0]]->pre_execute();
+	auto state = pass_register[args[0]]->pre_execute(design, args);
 	pass_register[args[0]]->execute(args, design);
 	pass_register[args[0]]->post_execute(state);
 	while (design->selection_stack.size() > orig_sel_stack_pos)
 		design->selection_stack.pop_back();
 }
 
+void Pass::parallel_for_modules(RTLIL::Design *design, const std::vector<RTLIL::Module*> &modules,
+		const std::function<void(RTLIL::Module*)> &worker)
+{
+	// design monitors are not prepared to be notified from more than one thread
+	int num_threads = design->monitors.empty() ? std::min(yosys_jobs, GetSize(modules)) : 1;
+
+	// Workers look at the ports of the modules that their module instantiates
+	// (e.g. through Cell::input() and Cell::output()), so a module must not
+	// run at the same time as one of the given modules it instantiates. Run
+	// the modules in levels instead, starting with the ones that do not
+	// instantiate any of the others.
+	std::vector<std::vector<int>> levels;
+	if (num_threads > 1) {
+		dict<RTLIL::Module*, int> module_index;
+		for (int i = 0; i < GetSize(modules); i++)
+			module_index[modules[i]] = i;
+
+		std::vector<int> module_level(GetSize(modules), -1);
+		bool recursive = false;
+		std::function<int(int)> get_level = [&](int i) {
+			if (module_level[i] == -2)
+				recursive = true;
+			if (module_level[i] < 0) {
+				module_level[i] = -2;
+				int level = 0;
+				for (auto cell : modules[i]->cells()) {
+					auto it = module_index.find(design->module(cell->type));
+					if (it != module_index.end())
+						level = std::max(level, get_level(it->second) + 1);
+				}
+				module_level[i] = level;
+			}
+			return module_level[i];
+		};
+
+		for (int i = 0; i < GetSize(modules); i++) {
+			int level = get_level(i);
+			if (level >= GetSize(levels))
+				levels.resize(level + 1);
+			levels[level].push_back(i);
+		}
+		if (recursive)
+			num_threads = 1;
+	}
+
+	if (num_threads <= 1) {
+		for (auto module : modules)
+			worker(module);
+		return;
+	}
+
+	int id_base = autoidx++;
+	std::vector<LogBuffer> log_buffers(GetSize(modules));
+	std::vector<std::exception_ptr> errors(GetSize(modules));
+
+	for (auto &level : levels)
+		parallel_for(GetSize(level), num_threads, [&](int k) {
+			int i = level[k];
+			int bak_log_debug_suppressed = log_debug_suppressed;
+			log_debug_suppressed = 0;
+			log_thread_buffer = &log_buffers[i];
+			new_id_begin_job(id_base, i);
+
+			try {
+				worker(modules[i]);
+			} catch (...) {
+				errors[i] = std::current_exception();
+			}
+
+			new_id_end_job();
+			log_thread_buffer = nullptr;
+			log_buffers[i].debug_suppressed = log_debug_suppressed;
+			log_debug_suppressed = bak_log_debug_suppressed;
+		});
+
+	for (int i = 0; i < GetSize(modules); i++) {
+		log_replay(log_buffers[i]);
+		if (errors[i])
+			std::rethrow_exception(errors[i]);
+	}
+}
+
 void Pass::call_on_selection(RTLIL::Design *design, const RTLIL::Selection &selection, std::string command)
 {
 	std::string backup_selected_active_module = design->selected_active_module;
@@ -466,7 +554,7 @@ void Frontend::execute(std::vector<std::string> args, RTLIL::Design *design)
 	do {
 		std::istream *f = NULL;
 		next_args.clear();
-		auto state = pre_execute();
+		auto state = pre_execute(design, args);
 		execute(f, std::string(), args, design);
 		post_execute(state);
 		args = next_args;
@@ -608,12 +696,12 @@ void Frontend::frontend_call(RTLIL::Design *design, std::istream *f, std::string
 		log_cmd_error("No such frontend: %s\n", args[0].c_str());
 
 	if (f != NULL) {
-		auto state = frontend_register[args[0]]->pre_execute();
+		auto state = frontend_register[args[0]]->pre_execute(design, args);
 		frontend_register[args[0]]->execute(f, filename, args, design);
 		frontend_register[args[0]]->post_execute(state);
 	} else if (filename == "-") {
 		std::istream *f_cin = &std::cin;
-		auto state = frontend_register[args[0]]->pre_execute();
+		auto state = frontend_register[args[0]]->pre_execute(design, args);
 		frontend_register[args[0]]->execute(f_cin, "<stdin>", args, design);
 		frontend_register[args[0]]->post_execute(state);
 	} else {
@@ -647,7 +735,7 @@ Backend::~Backend()
 void Backend::execute(std::vector<std::string> args, RTLIL::Design *design)
 {
 	std::ostream *f = NULL;
-	auto state = pre_execute();
+	auto state = pre_execute(design, args);
 	execute(f, std::string(), args, design);
 	post_execute(state);
 	if (f != &std::cout)
@@ -730,12 +818,12 @@ void Backend::backend_call(RTLIL::Design *design, std::ostream *f, std::string f
 	size_t orig_sel_stack_pos = design->selection_stack.size();
 
 	if (f != NULL) {
-		auto state = backend_register[args[0]]->pre_execute();
+		auto state = backend_register[args[0]]->pre_execute(design, args);
 		backend_register[args[0]]->execute(f, filename, args, design);
 		backend_register[args[0]]->post_execute(state);
 	} else if (filename == "-") {
 		std::ostream *f_cout = &std::cout;
-		auto state = backend_register[args[0]]->pre_execute();
+		auto state = backend_register[args[0]]->pre_execute(design, args);
 		backend_register[args[0]]->execute(f_cout, "<stdout>", args, design);
 		backend_register[args[0]]->post_execute(state);
 	} else {
@@ -964,7 +1052,7 @@ struct HelpPass : public Pass {
 
 		// iterate over cells
 		bool raise_error = false;
-		for (auto &it : yosys_celltypes.cell_types) {
+		for (auto &it : yosys_celltypes.all_cell_types()) {
 			auto name = it.first.str();
 			if (cell_help_messages.contains(name)) {
 				auto cell_help = cell_help_messages.get(name);
@@ -1093,7 +1181,7 @@ struct HelpPass : public Pass {
 			// this option is also undocumented as it is for internal use only
 			else if (args[1] == "-write-rst-cells-manual") {
 				bool raise_error = false;
-				for (auto &it : yosys_celltypes.cell_types) {
+				for (auto &it : yosys_celltypes.all_cell_types()) {
 					auto name = it.first.str();
 					if (cell_help_messages.contains(name)) {
 						write_cell_rst(cell_help_messages.get(name), it.second);
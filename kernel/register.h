@@ -46,9 +46,12 @@ struct Pass
 	struct pre_post_exec_state_t {
 		Pass *parent_pass;
 		int64_t begin_ns;
+		RTLIL::Design *design;
+		int profiler_span;
 	};
 
-	pre_post_exec_state_t pre_execute();
+	// the design and arguments are only used for profiling (see kernel/profiler.h)
+	pre_post_exec_state_t pre_execute(RTLIL::Design *design = nullptr, const std::vector<std::string> &args = {});
 	void post_execute(pre_post_exec_state_t state);
 
 	void cmd_log_args(const std::vector<std::string> &args);
@@ -64,6 +67,17 @@ struct Pass
 	static void call_on_module(RTLIL::Design *design, RTLIL::Module *module, std::string command);
 	static void call_on_module(RTLIL::Design *design, RTLIL::Module *module, std::vector<std::string> args);
 
+	// Calls worker(module) for each of the modules, using up to yosys_jobs threads.
+	// The worker must only change its own module. It may read the modules that its
+	// module instantiates, which never run at the same time as their parents. Log
+	// output is buffered per module and written out in the order of the modules
+	// vector. NEW_ID names are numbered per module when running in parallel, so the
+	// result does not depend on thread scheduling, but the names differ from the ones
+	// a serial run would create (see new_id_begin_job()). Designs with monitors
+	// attached are always processed serially.
+	static void parallel_for_modules(RTLIL::Design *design, const std::vector<RTLIL::Module*> &modules,
+			const std::function<void(RTLIL::Module*)> &worker);
+
 	Pass *next_queued_pass;
 	virtual void run_register();
 	static void init_register();
@@ -22,6 +22,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/binding.h"
 #include "kernel/sigtools.h"
+#include "kernel/modtools.h"
 #include "frontends/verilog/verilog_frontend.h"
 #include "frontends/verilog/preproc.h"
 #include "backends/rtlil/rtlil_backend.h"
@@ -34,10 +35,12 @@ YOSYS_NAMESPACE_BEGIN
 
 bool RTLIL::IdString::destruct_guard_ok = false;
 RTLIL::IdString::destruct_guard_t RTLIL::IdString::destruct_guard;
-std::vector<char*> RTLIL::IdString::global_id_storage_;
-dict<char*, int, hash_cstr_ops> RTLIL::IdString::global_id_index_;
+std::atomic<RTLIL::IdString::storage_entry_t*> RTLIL::IdString::global_id_chunks_[storage_max_chunks_];
+RTLIL::IdString::index_shard_t RTLIL::IdString::global_id_index_[index_shards_];
+Mutex RTLIL::IdString::global_alloc_mutex_;
+std::atomic<int> RTLIL::IdString::global_id_count_;
+std::atomic<int> RTLIL::IdString::concurrent_sections_;
 #ifndef YOSYS_NO_IDS_REFCNT
-std::vector<int> RTLIL::IdString::global_refcount_storage_;
 std::vector<int> RTLIL::IdString::global_free_idx_list_;
 #endif
 #ifdef YOSYS_USE_STICKY_IDS
@@ -214,6 +217,35 @@ std::string& Const::get_str() const {
 	return *get_if_str();
 }
 
+Const::packedtype& Const::get_packed() const {
+	check(is_packed());
+	return *get_if_packed();
+}
+
+// construct the union member matching other.tag, as a copy of other
+void Const::construct_backing(const RTLIL::Const &other) {
+	tag = other.tag;
+	if (is_str())
+		new ((void*)&str_) std::string(other.get_str());
+	else if (is_bits())
+		new ((void*)&bits_) bitvectype(other.get_bits());
+	else if (is_packed())
+		new ((void*)&packed_) packedtype(other.get_packed());
+	else
+		check(false);
+}
+
+void Const::destruct_backing() {
+	if (is_bits())
+		bits_.~bitvectype();
+	else if (is_str())
+		str_.~string();
+	else if (is_packed())
+		packed_.~packedtype();
+	else
+		check(false);
+}
+
 RTLIL::Const::Const(const std::string &str)
 {
 	flags = RTLIL::CONST_FLAG_STRING;
@@ -257,14 +289,8 @@ RTLIL::Const::Const(const std::vector<bool> &bits)
 }
 
 RTLIL::Const::Const(const RTLIL::Const &other) {
-	tag = other.tag;
 	flags = other.flags;
-	if (is_str())
-		new ((void*)&str_) std::string(other.get_str());
-	else if (is_bits())
-		new ((void*)&bits_) bitvectype(other.get_bits());
-	else
-		check(false);
+	construct_backing(other);
 }
 
 RTLIL::Const::Const(RTLIL::Const &&other) {
@@ -274,43 +300,34 @@ RTLIL::Const::Const(RTLIL::Const &&other) {
 		new ((void*)&str_) std::string(std::move(other.get_str()));
 	else if (is_bits())
 		new ((void*)&bits_) bitvectype(std::move(other.get_bits()));
-	else
+	else if (is_packed()) {
+		new ((void*)&packed_) packedtype(std::move(other.get_packed()));
+		other.get_packed().width = 0;
+	} else
 		check(false);
 }
 
 RTLIL::Const &RTLIL::Const::operator =(const RTLIL::Const &other) {
+	if (this == &other)
+		return *this;
 	flags = other.flags;
-	if (other.is_str()) {
-		if (!is_str()) {
-			// sketchy zone
-			check(is_bits());
-			bits_.~bitvectype();
-			(void)new ((void*)&str_) std::string();
-		}
-		tag = other.tag;
-		get_str() = other.get_str();
-	} else if (other.is_bits()) {
-		if (!is_bits()) {
-			// sketchy zone
-			check(is_str());
-			str_.~string();
-			(void)new ((void*)&bits_) bitvectype();
-		}
-		tag = other.tag;
-		get_bits() = other.get_bits();
+	if (other.tag == tag) {
+		if (is_str())
+			get_str() = other.get_str();
+		else if (is_bits())
+			get_bits() = other.get_bits();
+		else
+			get_packed() = other.get_packed();
 	} else {
-		check(false);
+		// sketchy zone
+		destruct_backing();
+		construct_backing(other);
 	}
 	return *this;
 }
 
 RTLIL::Const::~Const() {
-	if (is_bits())
-		bits_.~bitvectype();
-	else if (is_str())
-		str_.~string();
-	else
-		check(false);
+	destruct_backing();
 }
 
 bool RTLIL::Const::operator<(const RTLIL::Const &other) const
@@ -330,6 +347,9 @@ bool RTLIL::Const::operator ==(const RTLIL::Const &other) const
 	if (size() != other.size())
 		return false;
 
+	if (is_packed() && other.is_packed())
+		return packed_.words == other.packed_.words;
+
 	for (int i = 0; i < size(); i++)
 	if ((*this)[i] != other[i])
 		return false;
@@ -356,8 +376,26 @@ std::vector<RTLIL::State> RTLIL::Const::to_bits() const
 	return v;
 }
 
+// for each 2-bit state in a packed word, mask selecting the low bit
+static const uint64_t packed_lo_mask = 0x5555555555555555ull;
+
+// mask of the valid states in word w of a packed value of the given width
+static uint64_t packed_word_mask(int width, int w)
+{
+	int n = std::min(32, width - 32 * w);
+	return n == 32 ? ~uint64_t(0) : (uint64_t(1) << (2 * n)) - 1;
+}
+
 bool RTLIL::Const::as_bool() const
 {
+	if (auto pv = get_if_packed()) {
+		// S1 is the only state with the low bit set and the high bit clear
+		for (auto word : pv->words)
+			if (word & ~(word >> 1) & packed_lo_mask)
+				return true;
+		return false;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
 	for (size_t i = 0; i < bv.size(); i++)
@@ -368,14 +406,13 @@ bool RTLIL::Const::as_bool() const
 
 int RTLIL::Const::as_int(bool is_signed) const
 {
-	bitvectorize();
-	bitvectype& bv = get_bits();
 	int32_t ret = 0;
-	for (size_t i = 0; i < bv.size() && i < 32; i++)
-		if (bv[i] == State::S1)
+	int width = size();
+	for (int i = 0; i < width && i < 32; i++)
+		if ((*this)[i] == State::S1)
 			ret |= 1 << i;
-	if (is_signed && bv.back() == State::S1)
-		for (size_t i = bv.size(); i < 32; i++)
+	if (is_signed && back() == State::S1)
+		for (int i = width; i < 32; i++)
 			ret |= 1 << i;
 	return ret;
 }
@@ -428,6 +465,14 @@ std::optional<int> RTLIL::Const::as_int_compress(bool is_signed) const
 
 std::string RTLIL::Const::as_string(const char* any) const
 {
+	if (auto pv = get_if_packed()) {
+		std::string ret;
+		ret.reserve(pv->width);
+		for (int i = pv->width; i > 0; i--)
+			ret += "01xz"[pv->get(i-1)];
+		return ret;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
 	std::string ret;
@@ -500,6 +545,8 @@ std::string RTLIL::Const::decode_string() const
 int RTLIL::Const::size() const {
 	if (is_str())
 		return 8 * str_.size();
+	else if (is_packed())
+		return packed_.width;
 	else {
 		check(is_bits());
 		return bits_.size();
@@ -509,6 +556,8 @@ int RTLIL::Const::size() const {
 bool RTLIL::Const::empty() const {
 	if (is_str())
 		return str_.empty();
+	else if (is_packed())
+		return packed_.width == 0;
 	else {
 		check(is_bits());
 		return bits_.empty();
@@ -519,10 +568,22 @@ void RTLIL::Const::bitvectorize() const {
 	if (tag == backing_tag::bits)
 		return;
 
-	check(is_str());
-
 	bitvectype new_bits;
 
+	if (is_packed()) {
+		new_bits.reserve(packed_.width);
+		for (int i = 0; i < packed_.width; i++)
+			new_bits.push_back(packed_.get(i));
+
+		// sketchy zone
+		packed_.~packedtype();
+		(void)new ((void*)&bits_) bitvectype(std::move(new_bits));
+		tag = backing_tag::bits;
+		return;
+	}
+
+	check(is_str());
+
 	new_bits.reserve(str_.size() * 8);
 	for (int i = str_.size() - 1; i >= 0; i--) {
 		unsigned char ch = str_[i];
@@ -540,10 +601,35 @@ void RTLIL::Const::bitvectorize() const {
 	}
 }
 
+bool RTLIL::Const::pack()
+{
+	if (is_packed())
+		return true;
+
+	packedtype new_packed;
+	new_packed.width = size();
+	new_packed.words.resize((new_packed.width + 31) / 32);
+	for (int i = 0; i < new_packed.width; i++) {
+		State bit = (*this)[i];
+		if (bit > State::Sz)
+			return false;
+		new_packed.words[i / 32] |= uint64_t(bit) << (2 * (i % 32));
+	}
+
+	// sketchy zone
+	destruct_backing();
+	(void)new ((void*)&packed_) packedtype(std::move(new_packed));
+	tag = backing_tag::packed;
+	return true;
+}
+
 RTLIL::State RTLIL::Const::const_iterator::operator*() const {
 	if (auto bv = parent.get_if_bits())
 		return (*bv)[idx];
 
+	if (auto pv = parent.get_if_packed())
+		return pv->get(idx);
+
 	int char_idx = parent.get_str().size() - idx / 8 - 1;
 	bool bit = (parent.get_str()[char_idx] & (1 << (idx % 8)));
 	return bit ? State::S1 : State::S0;
@@ -551,6 +637,13 @@ RTLIL::State RTLIL::Const::const_iterator::operator*() const {
 
 bool RTLIL::Const::is_fully_zero() const
 {
+	if (auto pv = get_if_packed()) {
+		for (auto word : pv->words)
+			if (word != 0)
+				return false;
+		return true;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
 	cover("kernel.rtlil.const.is_fully_zero");
@@ -564,6 +657,13 @@ bool RTLIL::Const::is_fully_zero() const
 
 bool RTLIL::Const::is_fully_ones() const
 {
+	if (auto pv = get_if_packed()) {
+		for (int w = 0; w < GetSize(pv->words); w++)
+			if (pv->words[w] != (packed_lo_mask & packed_word_mask(pv->width, w)))
+				return false;
+		return true;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
 	cover("kernel.rtlil.const.is_fully_ones");
@@ -579,6 +679,14 @@ bool RTLIL::Const::is_fully_def() const
 {
 	cover("kernel.rtlil.const.is_fully_def");
 
+	if (auto pv = get_if_packed()) {
+		// Sx and Sz have the high bit set
+		for (auto word : pv->words)
+			if (word & ~packed_lo_mask)
+				return false;
+		return true;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
 
@@ -593,6 +701,14 @@ bool RTLIL::Const::is_fully_undef() const
 {
 	cover("kernel.rtlil.const.is_fully_undef");
 
+	if (auto pv = get_if_packed()) {
+		// Sx and Sz have the high bit set
+		for (int w = 0; w < GetSize(pv->words); w++)
+			if (~pv->words[w] & ~packed_lo_mask & packed_word_mask(pv->width, w))
+				return false;
+		return true;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
 
@@ -607,6 +723,13 @@ bool RTLIL::Const::is_fully_undef_x_only() const
 {
 	cover("kernel.rtlil.const.is_fully_undef_x_only");
 
+	if (auto pv = get_if_packed()) {
+		for (int w = 0; w < GetSize(pv->words); w++)
+			if (pv->words[w] != (~packed_lo_mask & packed_word_mask(pv->width, w)))
+				return false;
+		return true;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
 
@@ -850,7 +973,7 @@ void RTLIL::Selection::optimize(RTLIL::Design *design)
 }
 
 RTLIL::Design::Design()
-  : verilog_defines (new define_map_t)
+  : verilog_defines (new define_map_t), modindex_cache_ (new ModIndexCache(this))
 {
 	static unsigned int hashidx_count = 123456789;
 	hashidx_count = mkhash_xorshift(hashidx_count);
@@ -866,6 +989,7 @@ RTLIL::Design::Design()
 
 RTLIL::Design::~Design()
 {
+	modindex_cache_.reset();
 	for (auto &pr : modules_)
 		delete pr.second;
 	for (auto n : bindings_)
@@ -961,6 +1085,19 @@ RTLIL::Module *RTLIL::Design::addModule(RTLIL::IdString name)
 	return module;
 }
 
+ModIndex &RTLIL::Design::modindex(RTLIL::Module *module)
+{
+	return modindex_cache_->get(module);
+}
+
+void RTLIL::Design::modindex_invalidate(RTLIL::Module *module)
+{
+	if (module == nullptr)
+		modindex_cache_->clear();
+	else
+		modindex_cache_->invalidate(module);
+}
+
 void RTLIL::Design::scratchpad_unset(const std::string &varname)
 {
 	scratchpad.erase(varname);
@@ -1030,6 +1167,7 @@ void RTLIL::Design::remove(RTLIL::Module *module)
 {
 	for (auto mon : monitors)
 		mon->notify_module_del(module);
+	modindex_invalidate(module);
 
 	if (yosys_xtrace) {
 		log("#X# Remove Module: %s\n", log_id(module));
@@ -1159,6 +1297,7 @@ RTLIL::Module::Module()
 	design = nullptr;
 	refcount_wires_ = 0;
 	refcount_cells_ = 0;
+	change_count_ = 0;
 
 #ifdef WITH_PYTHON
 	RTLIL::Module::get_all_modules()->insert(std::pair<unsigned int, RTLIL::Module*>(hashidx_, this));
@@ -1168,11 +1307,11 @@ RTLIL::Module::Module()
 RTLIL::Module::~Module()
 {
 	for (auto &pr : wires_)
-		delete pr.second;
+		destroy(pr.second);
 	for (auto &pr : memories)
 		delete pr.second;
 	for (auto &pr : cells_)
-		delete pr.second;
+		destroy(pr.second);
 	for (auto &pr : processes)
 		delete pr.second;
 	for (auto binding : bindings_)
@@ -1203,7 +1342,7 @@ void RTLIL::Module::makeblackbox()
 	memories.clear();
 
 	for (auto it = cells_.begin(); it != cells_.end(); ++it)
-		delete it->second;
+		destroy(it->second);
 	cells_.clear();
 
 	for (auto it = processes.begin(); it != processes.end(); ++it)
@@ -2153,8 +2292,26 @@ namespace {
 }
 #endif
 
+// Whether the keys of a container are already visited in sort_by_id_str order
+template<typename T>
+static bool is_sorted_by_id_str(const T &container)
+{
+	const RTLIL::IdString *prev = nullptr;
+	for (auto &it : container) {
+		if (prev != nullptr && RTLIL::sort_by_id_str()(it.first, *prev))
+			return false;
+		prev = &it.first;
+	}
+	return true;
+}
+
 void RTLIL::Module::sort()
 {
+	// passes visit wires and cells in this order, so reordering them counts
+	// as a change (but sorting a sorted module does not)
+	if (!is_sorted_by_id_str(wires_) || !is_sorted_by_id_str(cells_))
+		change_count_++;
+
 	wires_.sort(sort_by_id_str());
 	cells_.sort(sort_by_id_str());
 	parameter_default_values.sort(sort_by_id_str());
@@ -2383,6 +2540,7 @@ void RTLIL::Module::add(RTLIL::Wire *wire)
 	log_assert(refcount_wires_ == 0);
 	wires_[wire->name] = wire;
 	wire->module = this;
+	change_count_++;
 }
 
 void RTLIL::Module::add(RTLIL::Cell *cell)
@@ -2392,6 +2550,7 @@ void RTLIL::Module::add(RTLIL::Cell *cell)
 	log_assert(refcount_cells_ == 0);
 	cells_[cell->name] = cell;
 	cell->module = this;
+	change_count_++;
 }
 
 void RTLIL::Module::add(RTLIL::Process *process)
@@ -2400,6 +2559,21 @@ void RTLIL::Module::add(RTLIL::Process *process)
 	log_assert(count_id(process->name) == 0);
 	processes[process->name] = process;
 	process->module = this;
+	change_count_++;
+}
+
+void RTLIL::Module::destroy(RTLIL::Wire *wire)
+{
+	log_assert(wire->module == this);
+	wire->~Wire();
+	wire_pool_.deallocate(wire);
+}
+
+void RTLIL::Module::destroy(RTLIL::Cell *cell)
+{
+	log_assert(cell->module == this);
+	cell->~Cell();
+	cell_pool_.deallocate(cell);
 }
 
 void RTLIL::Module::add(RTLIL::Binding *binding)
@@ -2421,7 +2595,7 @@ void RTLIL::Module::remove(const pool<RTLIL::Wire*> &wires)
 			sig.pack();
 			for (auto &c : sig.chunks_)
 				if (c.wire != NULL && wires_p->count(c.wire)) {
-					c.wire = module->addWire(stringf("$delete_wire$%d", autoidx++), c.width);
+					c.wire = module->addWire("$delete_wire$" + new_id_index(), c.width);
 					c.offset = 0;
 				}
 		}
@@ -2442,8 +2616,9 @@ void RTLIL::Module::remove(const pool<RTLIL::Wire*> &wires)
 	for (auto &it : wires) {
 		log_assert(wires_.count(it->name) != 0);
 		wires_.erase(it->name);
-		delete it;
+		destroy(it);
 	}
+	change_count_++;
 }
 
 void RTLIL::Module::remove(RTLIL::Cell *cell)
@@ -2454,7 +2629,8 @@ void RTLIL::Module::remove(RTLIL::Cell *cell)
 	log_assert(cells_.count(cell->name) != 0);
 	log_assert(refcount_cells_ == 0);
 	cells_.erase(cell->name);
-	delete cell;
+	destroy(cell);
+	change_count_++;
 }
 
 void RTLIL::Module::remove(RTLIL::Process *process)
@@ -2462,6 +2638,7 @@ void RTLIL::Module::remove(RTLIL::Process *process)
 	log_assert(processes.count(process->name) != 0);
 	processes.erase(process->name);
 	delete process;
+	change_count_++;
 }
 
 void RTLIL::Module::rename(RTLIL::Wire *wire, RTLIL::IdString new_name)
@@ -2506,6 +2683,7 @@ void RTLIL::Module::swap_names(RTLIL::Wire *w1, RTLIL::Wire *w2)
 
 	wires_[w1->name] = w1;
 	wires_[w2->name] = w2;
+	change_count_++;
 }
 
 void RTLIL::Module::swap_names(RTLIL::Cell *c1, RTLIL::Cell *c2)
@@ -2521,6 +2699,7 @@ void RTLIL::Module::swap_names(RTLIL::Cell *c1, RTLIL::Cell *c2)
 
 	cells_[c1->name] = c1;
 	cells_[c2->name] = c2;
+	change_count_++;
 }
 
 RTLIL::IdString RTLIL::Module::uniquify(RTLIL::IdString name)
@@ -2586,6 +2765,7 @@ void RTLIL::Module::connect(const RTLIL::SigSig &conn)
 
 	log_assert(GetSize(conn.first) == GetSize(conn.second));
 	connections_.push_back(conn);
+	change_count_++;
 }
 
 void RTLIL::Module::connect(const RTLIL::SigSpec &lhs, const RTLIL::SigSpec &rhs)
@@ -2610,6 +2790,7 @@ void RTLIL::Module::new_connections(const std::vector<RTLIL::SigSig> &new_conn)
 	}
 
 	connections_ = new_conn;
+	change_count_++;
 }
 
 const std::vector<RTLIL::SigSig> &RTLIL::Module::connections() const
@@ -2634,11 +2815,24 @@ void RTLIL::Module::fixup_ports()
 		ports.push_back(all_ports[i]->name);
 		all_ports[i]->port_id = i+1;
 	}
+
+	// the port flags were set without going through the monitors
+	blackout();
+}
+
+void RTLIL::Module::blackout()
+{
+	for (auto mon : monitors)
+		mon->notify_blackout(this);
+
+	if (design)
+		for (auto mon : design->monitors)
+			mon->notify_blackout(this);
 }
 
 RTLIL::Wire *RTLIL::Module::addWire(RTLIL::IdString name, int width)
 {
-	RTLIL::Wire *wire = new RTLIL::Wire;
+	RTLIL::Wire *wire = new (wire_pool_.allocate()) RTLIL::Wire;
 	wire->name = name;
 	wire->width = width;
 	add(wire);
@@ -2661,7 +2855,7 @@ RTLIL::Wire *RTLIL::Module::addWire(RTLIL::IdString name, const RTLIL::Wire *oth
 
 RTLIL::Cell *RTLIL::Module::addCell(RTLIL::IdString name, RTLIL::IdString type)
 {
-	RTLIL::Cell *cell = new RTLIL::Cell;
+	RTLIL::Cell *cell = new (cell_pool_.allocate()) RTLIL::Cell;
 	cell->name = name;
 	cell->type = type;
 	add(cell);
@@ -2674,6 +2868,14 @@ RTLIL::Cell *RTLIL::Module::addCell(RTLIL::IdString name, const RTLIL::Cell *oth
 	cell->connections_ = other->connections_;
 	cell->parameters = other->parameters;
 	cell->attributes = other->attributes;
+
+	for (auto &conn : cell->connections_) {
+		for (auto mon : monitors)
+			mon->notify_connect(cell, conn.first, RTLIL::SigSpec(), conn.second);
+		if (design)
+			for (auto mon : design->monitors)
+				mon->notify_connect(cell, conn.first, RTLIL::SigSpec(), conn.second);
+	}
 	return cell;
 }
 
@@ -3683,11 +3885,18 @@ RTLIL::SigSpec RTLIL::Module::FutureFF(RTLIL::IdString name, const RTLIL::SigSpe
 	return sig;
 }
 
+// wires, memories, processes and cells may be created by parallel jobs
+static unsigned int next_hashidx(std::atomic<unsigned int> &hashidx_count)
+{
+	unsigned int hashidx = hashidx_count.load(std::memory_order_relaxed);
+	while (!hashidx_count.compare_exchange_weak(hashidx, mkhash_xorshift(hashidx), std::memory_order_relaxed)) { }
+	return mkhash_xorshift(hashidx);
+}
+
 RTLIL::Wire::Wire()
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static std::atomic<unsigned int> hashidx_count(123456789);
+	hashidx_ = next_hashidx(hashidx_count);
 
 	module = nullptr;
 	width = 1;
@@ -3697,6 +3906,8 @@ RTLIL::Wire::Wire()
 	port_output = false;
 	upto = false;
 	is_signed = false;
+	bitidx_ = -1;
+	bitidx_gen_ = -1;
 
 #ifdef WITH_PYTHON
 	RTLIL::Wire::get_all_wires()->insert(std::pair<unsigned int, RTLIL::Wire*>(hashidx_, this));
@@ -3720,9 +3931,8 @@ std::map<unsigned int, RTLIL::Wire*> *RTLIL::Wire::get_all_wires(void)
 
 RTLIL::Memory::Memory()
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static std::atomic<unsigned int> hashidx_count(123456789);
+	hashidx_ = next_hashidx(hashidx_count);
 
 	width = 1;
 	start_offset = 0;
@@ -3734,16 +3944,14 @@ RTLIL::Memory::Memory()
 
 RTLIL::Process::Process() : module(nullptr)
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static std::atomic<unsigned int> hashidx_count(123456789);
+	hashidx_ = next_hashidx(hashidx_count);
 }
 
 RTLIL::Cell::Cell() : module(nullptr)
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static std::atomic<unsigned int> hashidx_count(123456789);
+	hashidx_ = next_hashidx(hashidx_count);
 
 	// log("#memtrace# %p\n", this);
 	memhasher();
@@ -3793,6 +4001,7 @@ void RTLIL::Cell::unsetPort(const RTLIL::IdString& portname)
 		}
 
 		connections_.erase(conn_it);
+		module->change_count_++;
 	}
 }
 
@@ -3954,6 +4163,7 @@ void RTLIL::Cell::setPort(const RTLIL::IdString& portname, RTLIL::SigSpec signal
 	}
 
 	conn_it->second = std::move(signal);
+	module->change_count_++;
 }
 
 const RTLIL::SigSpec &RTLIL::Cell::getPort(const RTLIL::IdString& portname) const
@@ -4006,11 +4216,14 @@ bool RTLIL::Cell::hasParam(const RTLIL::IdString& paramname) const
 
 void RTLIL::Cell::unsetParam(const RTLIL::IdString& paramname)
 {
-	parameters.erase(paramname);
+	if (parameters.erase(paramname) && module)
+		module->change_count_++;
 }
 
 void RTLIL::Cell::setParam(const RTLIL::IdString& paramname, RTLIL::Const value)
 {
+	if (module)
+		module->change_count_++;
 	parameters[paramname] = std::move(value);
 }
 
@@ -4406,7 +4619,7 @@ void RTLIL::SigSpec::pack() const
 	cover("kernel.rtlil.sigspec.convert.pack");
 	log_assert(that->chunks_.empty());
 
-	std::vector<RTLIL::SigBit> old_bits;
+	decltype(that->bits_) old_bits;
 	old_bits.swap(that->bits_);
 
 	RTLIL::SigChunk *last = NULL;
@@ -4807,7 +5020,7 @@ void RTLIL::SigSpec::remove_const()
 	{
 		cover("kernel.rtlil.sigspec.remove_const.packed");
 
-		std::vector<RTLIL::SigChunk> new_chunks;
+		decltype(chunks_) new_chunks;
 		new_chunks.reserve(GetSize(chunks_));
 
 		width_ = 0;
@@ -4829,7 +5042,7 @@ void RTLIL::SigSpec::remove_const()
 	{
 		cover("kernel.rtlil.sigspec.remove_const.unpacked");
 
-		std::vector<RTLIL::SigBit> new_bits;
+		decltype(bits_) new_bits;
 		new_bits.reserve(width_);
 
 		for (auto &bit : bits_)
@@ -22,6 +22,9 @@
 
 #include "kernel/yosys_common.h"
 #include "kernel/yosys.h"
+#include "kernel/threading.h"
+#include "kernel/smallvec.h"
+#include "kernel/objpool.h"
 
 YOSYS_NAMESPACE_BEGIN
 
@@ -93,6 +96,13 @@ namespace RTLIL
 		#undef YOSYS_NO_IDS_REFCNT
 
 		// the global id string cache
+		//
+		// The string storage is a two-level table of fixed size chunks that are never
+		// moved once allocated, so c_str() for an index the caller holds a reference to
+		// is a lock-free read. The name->index map is split into shards that are locked
+		// individually, and reference counts are atomic. While a concurrent section is
+		// active (see concurrent_scope) ids whose refcount drops to zero are not freed
+		// right away. They stay in the index and are swept when the last section ends.
 
 		static bool destruct_guard_ok; // POD, will be initialized to zero
 		static struct destruct_guard_t {
@@ -100,10 +110,27 @@ namespace RTLIL
 			~destruct_guard_t() { destruct_guard_ok = false; }
 		} destruct_guard;
 
-		static std::vector<char*> global_id_storage_;
-		static dict<char*, int, hash_cstr_ops> global_id_index_;
+		struct storage_entry_t {
+			char *str;
+			std::atomic<int> refcount;
+		};
+
+		struct index_shard_t {
+			Mutex mutex;
+			dict<char*, int, hash_cstr_ops> index;
+		};
+
+		static constexpr int storage_chunk_bits_ = 16;
+		static constexpr int storage_chunk_size_ = 1 << storage_chunk_bits_;
+		static constexpr int storage_max_chunks_ = 0x40000000 >> storage_chunk_bits_;
+		static constexpr int index_shards_ = 16;
+
+		static std::atomic<storage_entry_t*> global_id_chunks_[storage_max_chunks_];
+		static index_shard_t global_id_index_[index_shards_];
+		static Mutex global_alloc_mutex_;
+		static std::atomic<int> global_id_count_;
+		static std::atomic<int> concurrent_sections_;
 	#ifndef YOSYS_NO_IDS_REFCNT
-		static std::vector<int> global_refcount_storage_;
 		static std::vector<int> global_free_idx_list_;
 	#endif
 
@@ -112,15 +139,26 @@ namespace RTLIL
 		static int last_created_idx_[8];
 	#endif
 
+		static inline storage_entry_t &storage_entry(int idx)
+		{
+			storage_entry_t *chunk = global_id_chunks_[idx >> storage_chunk_bits_].load(std::memory_order_acquire);
+			return chunk[idx & (storage_chunk_size_ - 1)];
+		}
+
+		static inline index_shard_t &index_shard(const char *p)
+		{
+			return global_id_index_[hashlib::mkhash_xorshift(hash_cstr_ops::hash(p)) % index_shards_];
+		}
+
 		static inline void xtrace_db_dump()
 		{
 		#ifdef YOSYS_XTRACE_GET_PUT
-			for (int idx = 0; idx < GetSize(global_id_storage_); idx++)
+			for (int idx = 0; idx < global_id_count_; idx++)
 			{
-				if (global_id_storage_.at(idx) == nullptr)
+				if (storage_entry(idx).str == nullptr)
 					log("#X# DB-DUMP index %d: FREE\n", idx);
 				else
-					log("#X# DB-DUMP index %d: '%s' (ref %d)\n", idx, global_id_storage_.at(idx), global_refcount_storage_.at(idx));
+					log("#X# DB-DUMP index %d: '%s' (ref %d)\n", idx, storage_entry(idx).str, storage_entry(idx).refcount.load());
 			}
 		#endif
 		}
@@ -136,6 +174,7 @@ namespace RTLIL
 			}
 		#endif
 		#ifdef YOSYS_SORT_ID_FREE_LIST
+			MutexLock lock(global_alloc_mutex_);
 			std::sort(global_free_idx_list_.begin(), global_free_idx_list_.end(), std::greater<int>());
 		#endif
 		}
@@ -144,33 +183,69 @@ namespace RTLIL
 		{
 			if (idx) {
 		#ifndef YOSYS_NO_IDS_REFCNT
-				global_refcount_storage_[idx]++;
+				storage_entry(idx).refcount.fetch_add(1, std::memory_order_relaxed);
 		#endif
 		#ifdef YOSYS_XTRACE_GET_PUT
 				if (yosys_xtrace)
-					log("#X# GET-BY-INDEX '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx));
+					log("#X# GET-BY-INDEX '%s' (index %d, refcount %d)\n", storage_entry(idx).str, idx, storage_entry(idx).refcount.load());
 		#endif
 			}
 			return idx;
 		}
 
-		static int get_reference(const char *p)
+		static int new_index()
 		{
-			log_assert(destruct_guard_ok);
+			MutexLock lock(global_alloc_mutex_);
 
-			if (!p[0])
-				return 0;
+		#ifndef YOSYS_NO_IDS_REFCNT
+			if (!global_free_idx_list_.empty()) {
+				int idx = global_free_idx_list_.back();
+				global_free_idx_list_.pop_back();
+				return idx;
+			}
+		#endif
 
-			auto it = global_id_index_.find((char*)p);
-			if (it != global_id_index_.end()) {
+			int idx = global_id_count_.load(std::memory_order_relaxed);
+			log_assert(idx < 0x40000000);
+			if ((idx & (storage_chunk_size_ - 1)) == 0)
+				global_id_chunks_[idx >> storage_chunk_bits_].store(new storage_entry_t[storage_chunk_size_](), std::memory_order_release);
+			if (idx == 0) {
+				// index 0 is the empty string, which is never looked up by name
+				storage_entry(0).str = (char*)"";
+				idx++;
+			}
+			global_id_count_.store(idx + 1, std::memory_order_release);
+			return idx;
+		}
+
+		static inline int lookup_reference(index_shard_t &shard, const char *p)
+		{
+			auto it = shard.index.find((char*)p);
+			if (it == shard.index.end())
+				return 0;
 		#ifndef YOSYS_NO_IDS_REFCNT
-				global_refcount_storage_.at(it->second)++;
+			storage_entry(it->second).refcount.fetch_add(1, std::memory_order_relaxed);
 		#endif
 		#ifdef YOSYS_XTRACE_GET_PUT
-				if (yosys_xtrace)
-					log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", global_id_storage_.at(it->second), it->second, global_refcount_storage_.at(it->second));
+			if (yosys_xtrace)
+				log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", storage_entry(it->second).str, it->second, storage_entry(it->second).refcount.load());
 		#endif
-				return it->second;
+			return it->second;
+		}
+
+		static int get_reference(const char *p)
+		{
+			log_assert(destruct_guard_ok);
+
+			if (!p[0])
+				return 0;
+
+			index_shard_t &shard = index_shard(p);
+
+			{
+				MutexLock lock(shard.mutex);
+				if (int idx = lookup_reference(shard, p))
+					return idx;
 			}
 
 			log_assert(p[0] == '$' || p[0] == '\\');
@@ -179,33 +254,22 @@ namespace RTLIL
 				if ((unsigned)*c <= (unsigned)' ')
 					log_error("Found control character or space (0x%02x) in string '%s' which is not allowed in RTLIL identifiers\n", *c, p);
 
-		#ifndef YOSYS_NO_IDS_REFCNT
-			if (global_free_idx_list_.empty()) {
-				if (global_id_storage_.empty()) {
-					global_refcount_storage_.push_back(0);
-					global_id_storage_.push_back((char*)"");
-					global_id_index_[global_id_storage_.back()] = 0;
-				}
-				log_assert(global_id_storage_.size() < 0x40000000);
-				global_free_idx_list_.push_back(global_id_storage_.size());
-				global_id_storage_.push_back(nullptr);
-				global_refcount_storage_.push_back(0);
-			}
+			int idx;
+			{
+				MutexLock lock(shard.mutex);
 
-			int idx = global_free_idx_list_.back();
-			global_free_idx_list_.pop_back();
-			global_id_storage_.at(idx) = strdup(p);
-			global_id_index_[global_id_storage_.at(idx)] = idx;
-			global_refcount_storage_.at(idx)++;
-		#else
-			if (global_id_storage_.empty()) {
-				global_id_storage_.push_back((char*)"");
-				global_id_index_[global_id_storage_.back()] = 0;
-			}
-			int idx = global_id_storage_.size();
-			global_id_storage_.push_back(strdup(p));
-			global_id_index_[global_id_storage_.back()] = idx;
+				// another thread may have created the id while the shard was unlocked
+				if ((idx = lookup_reference(shard, p)) != 0)
+					return idx;
+
+				idx = new_index();
+				storage_entry_t &entry = storage_entry(idx);
+				entry.str = strdup(p);
+				shard.index[entry.str] = idx;
+		#ifndef YOSYS_NO_IDS_REFCNT
+				entry.refcount.store(1, std::memory_order_relaxed);
 		#endif
+			}
 
 			if (yosys_xtrace) {
 				log("#X# New IdString '%s' with index %d.\n", p, idx);
@@ -214,7 +278,7 @@ namespace RTLIL
 
 		#ifdef YOSYS_XTRACE_GET_PUT
 			if (yosys_xtrace)
-				log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx));
+				log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", storage_entry(idx).str, idx, storage_entry(idx).refcount.load());
 		#endif
 
 		#ifdef YOSYS_USE_STICKY_IDS
@@ -233,40 +297,84 @@ namespace RTLIL
 		static inline void put_reference(int idx)
 		{
 			// put_reference() may be called from destructors after the destructor of
-			// global_refcount_storage_ has been run. in this case we simply do nothing.
+			// the global storage has been run. in this case we simply do nothing.
 			if (!destruct_guard_ok || !idx)
 				return;
 
 		#ifdef YOSYS_XTRACE_GET_PUT
 			if (yosys_xtrace) {
-				log("#X# PUT '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx));
+				log("#X# PUT '%s' (index %d, refcount %d)\n", storage_entry(idx).str, idx, storage_entry(idx).refcount.load());
 			}
 		#endif
 
-			int &refcount = global_refcount_storage_[idx];
+			int refcount = storage_entry(idx).refcount.fetch_sub(1, std::memory_order_acq_rel) - 1;
 
-			if (--refcount > 0)
+			if (refcount > 0)
 				return;
 
 			log_assert(refcount == 0);
-			free_reference(idx);
+			if (concurrent_sections_.load(std::memory_order_relaxed) == 0)
+				free_reference(idx);
 		}
-		static inline void free_reference(int idx)
+		static void free_reference(int idx)
 		{
-			if (yosys_xtrace) {
-				log("#X# Removed IdString '%s' with index %d.\n", global_id_storage_.at(idx), idx);
-				log_backtrace("-X- ", yosys_xtrace-1);
+			storage_entry_t &entry = storage_entry(idx);
+			index_shard_t &shard = index_shard(entry.str);
+
+			{
+				MutexLock lock(shard.mutex);
+
+				// the id may have been looked up again by name since its refcount dropped to zero
+				if (entry.refcount.load(std::memory_order_relaxed) != 0)
+					return;
+
+				if (yosys_xtrace) {
+					log("#X# Removed IdString '%s' with index %d.\n", entry.str, idx);
+					log_backtrace("-X- ", yosys_xtrace-1);
+				}
+
+				shard.index.erase(entry.str);
+				free(entry.str);
+				entry.str = nullptr;
 			}
 
-			global_id_index_.erase(global_id_storage_.at(idx));
-			free(global_id_storage_.at(idx));
-			global_id_storage_.at(idx) = nullptr;
+			MutexLock lock(global_alloc_mutex_);
 			global_free_idx_list_.push_back(idx);
 		}
 	#else
 		static inline void put_reference(int) { }
 	#endif
 
+		// Worker threads must only create or drop IdStrings while at least one
+		// concurrent section is active. Sections nest and are entered and left on
+		// the main thread, before the workers start and after they are joined.
+
+		static void begin_concurrent()
+		{
+			concurrent_sections_.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		static void end_concurrent()
+		{
+			int sections = concurrent_sections_.fetch_sub(1, std::memory_order_relaxed) - 1;
+			log_assert(sections >= 0);
+		#ifndef YOSYS_NO_IDS_REFCNT
+			if (sections > 0)
+				return;
+			int count = global_id_count_.load(std::memory_order_acquire);
+			for (int idx = 1; idx < count; idx++) {
+				storage_entry_t &entry = storage_entry(idx);
+				if (entry.str != nullptr && entry.refcount.load(std::memory_order_relaxed) == 0)
+					free_reference(idx);
+			}
+		#endif
+		}
+
+		struct concurrent_scope {
+			concurrent_scope() { begin_concurrent(); }
+			~concurrent_scope() { end_concurrent(); }
+		};
+
 		// the actual IdString object is just is a single int
 
 		int index_;
@@ -294,11 +402,11 @@ namespace RTLIL
 		}
 
 		inline const char *c_str() const {
-			return global_id_storage_.at(index_);
+			return storage_entry(index_).str;
 		}
 
 		inline std::string str() const {
-			return std::string(global_id_storage_.at(index_));
+			return std::string(storage_entry(index_).str);
 		}
 
 		inline bool operator<(const IdString &rhs) const {
@@ -523,6 +631,14 @@ namespace RTLIL
 	RTLIL::Const const_bwmux       (const RTLIL::Const &arg1, const RTLIL::Const &arg2, const RTLIL::Const &arg3);
 
 
+	// The container type of Design::modules_, Module::wires_ and Module::cells_.
+	// Builds with YOSYS_ENABLE_FLAT_HASHLIB use the open-addressing flat_dict.
+#ifdef YOSYS_ENABLE_FLAT_HASHLIB
+	template<typename T> using ObjDict = flat_dict<RTLIL::IdString, T>;
+#else
+	template<typename T> using ObjDict = dict<RTLIL::IdString, T>;
+#endif
+
 	// This iterator-range-pair is used for Design::modules(), Module::wires() and Module::cells().
 	// It maintains a reference counter that is used to make sure that the container is not modified while being iterated over.
 
@@ -533,8 +649,8 @@ namespace RTLIL
 		using difference_type = ptrdiff_t;
 		using pointer = T*;
 		using reference = T&;
-		typename dict<RTLIL::IdString, T>::iterator it;
-		dict<RTLIL::IdString, T> *list_p;
+		typename RTLIL::ObjDict<T>::iterator it;
+		RTLIL::ObjDict<T> *list_p;
 		int *refcount_p;
 
 		ObjIterator() : list_p(nullptr), refcount_p(nullptr) {
@@ -633,7 +749,7 @@ namespace RTLIL
 	template<typename T>
 	struct ObjRange
 	{
-		dict<RTLIL::IdString, T> *list_p;
+		RTLIL::ObjDict<T> *list_p;
 		int *refcount_p;
 
 		ObjRange(decltype(list_p) list_p, int *refcount_p) : list_p(list_p), refcount_p(refcount_p) { }
@@ -670,24 +786,38 @@ struct RTLIL::Const
 private:
 	friend class KernelRtlilTest;
 	FRIEND_TEST(KernelRtlilTest, ConstStr);
+	FRIEND_TEST(KernelRtlilTest, ConstPacked);
 	using bitvectype = std::vector<RTLIL::State>;
-	enum class backing_tag: bool { bits, string };
+	// two bits per state, 32 states per word, only for S0, S1, Sx and Sz
+	struct packedtype {
+		std::vector<uint64_t> words;
+		int width = 0;
+		RTLIL::State get(int i) const { return RTLIL::State((words[i / 32] >> (2 * (i % 32))) & 3); }
+	};
+	enum class backing_tag: uint8_t { bits, string, packed };
 	// Do not access the union or tag even in Const methods unless necessary
 	mutable backing_tag tag;
 	union {
 		mutable bitvectype bits_;
 		mutable std::string str_;
+		mutable packedtype packed_;
 	};
 
 	// Use these private utilities instead
 	bool is_bits() const { return tag == backing_tag::bits; }
 	bool is_str() const { return tag == backing_tag::string; }
+	bool is_packed() const { return tag == backing_tag::packed; }
 
 	bitvectype* get_if_bits() const { return is_bits() ? &bits_ : NULL; }
 	std::string* get_if_str() const { return is_str() ? &str_ : NULL; }
+	packedtype* get_if_packed() const { return is_packed() ? &packed_ : NULL; }
 
 	bitvectype& get_bits() const;
 	std::string& get_str() const;
+	packedtype& get_packed() const;
+
+	void construct_backing(const RTLIL::Const &other);
+	void destruct_backing();
 public:
 	Const() : flags(RTLIL::CONST_FLAG_NONE), tag(backing_tag::bits), bits_(std::vector<RTLIL::State>()) {}
 	Const(const std::string &str);
@@ -716,6 +846,12 @@ public:
 	bool empty() const;
 	void bitvectorize() const;
 
+	// Store the value with two bits per state if it only contains 0, 1, x
+	// and z, e.g. for large memory init data. The value is read in place and
+	// unpacked again by the first call to bits(). Returns false if the value
+	// can not be packed.
+	bool pack();
+
 	class const_iterator {
 	private:
 		const Const& parent;
@@ -937,8 +1073,10 @@ struct RTLIL::SigSpec
 private:
 	int width_;
 	unsigned long hash_;
-	std::vector<RTLIL::SigChunk> chunks_; // LSB at index 0
-	std::vector<RTLIL::SigBit> bits_; // LSB at index 0
+	// Most signals are a single chunk of a wire or a single bit, which is kept
+	// inline so that constructing and copying them does not allocate
+	smallvec<RTLIL::SigChunk, 1> chunks_; // LSB at index 0
+	smallvec<RTLIL::SigBit, 1> bits_; // LSB at index 0
 
 	void pack() const;
 	void unpack() const;
@@ -982,8 +1120,8 @@ public:
 		return hash_;
 	}
 
-	inline const std::vector<RTLIL::SigChunk> &chunks() const { pack(); return chunks_; }
-	inline const std::vector<RTLIL::SigBit> &bits() const { inline_unpack(); return bits_; }
+	inline const smallvec<RTLIL::SigChunk, 1> &chunks() const { pack(); return chunks_; }
+	inline const smallvec<RTLIL::SigBit, 1> &bits() const { inline_unpack(); return bits_; }
 
 	inline int size() const { return width_; }
 	inline bool empty() const { return width_ == 0; }
@@ -1150,6 +1288,10 @@ struct RTLIL::Monitor
 // Forward declaration; defined in preproc.h.
 struct define_map_t;
 
+// Forward declarations; defined in modtools.h.
+struct ModIndex;
+struct ModIndexCache;
+
 struct RTLIL::Design
 {
 	unsigned int hashidx_;
@@ -1162,7 +1304,7 @@ struct RTLIL::Design
 	void bufNormalize(bool enable=true);
 
 	int refcount_modules_;
-	dict<RTLIL::IdString, RTLIL::Module*> modules_;
+	RTLIL::ObjDict<RTLIL::Module*> modules_;
 	std::vector<RTLIL::Binding*> bindings_;
 
 	std::vector<AST::AstNode*> verilog_packages, verilog_globals;
@@ -1172,6 +1314,9 @@ struct RTLIL::Design
 	dict<RTLIL::IdString, RTLIL::Selection> selection_vars;
 	std::string selected_active_module;
 
+	// ModIndex instances shared by all passes, see modindex()
+	std::unique_ptr<ModIndexCache> modindex_cache_;
+
 	Design();
 	~Design();
 
@@ -1191,6 +1336,15 @@ struct RTLIL::Design
 	void remove(RTLIL::Module *module);
 	void rename(RTLIL::Module *module, RTLIL::IdString new_name);
 
+	// Returns the shared ModIndex of a module of this design. It is built on
+	// first use and then kept up to date through the monitor interface, so
+	// that consecutive passes do not have to rebuild it. The reference stays
+	// valid until the module is removed or modindex_invalidate() is called.
+	// Workers of Pass::parallel_for_modules() may call this for their module.
+	ModIndex &modindex(RTLIL::Module *module);
+	// Drops the shared ModIndex of the given module, or of all modules
+	void modindex_invalidate(RTLIL::Module *module = nullptr);
+
 	void scratchpad_unset(const std::string &varname);
 
 	void scratchpad_set_int(const std::string &varname, int value);
@@ -1265,6 +1419,15 @@ protected:
 	void add(RTLIL::Cell *cell);
 	void add(RTLIL::Process *process);
 
+private:
+	// Storage for the wires and cells created by addWire() and addCell(),
+	// which is released in bulk when the module is destroyed
+	ObjectPool<RTLIL::Wire> wire_pool_;
+	ObjectPool<RTLIL::Cell> cell_pool_;
+
+	void destroy(RTLIL::Wire *wire);
+	void destroy(RTLIL::Cell *cell);
+
 public:
 	RTLIL::Design *design;
 	pool<RTLIL::Monitor*> monitors;
@@ -1272,8 +1435,16 @@ public:
 	int refcount_wires_;
 	int refcount_cells_;
 
-	dict<RTLIL::IdString, RTLIL::Wire*> wires_;
-	dict<RTLIL::IdString, RTLIL::Cell*> cells_;
+	// Incremented by every add/remove/rename/connect on this module, by a
+	// sort() that reorders its wires or cells and by
+	// Cell::setPort/unsetPort/setParam/unsetParam on its cells, so that passes
+	// can tell which modules changed since they last looked. Writes directly to
+	// public members (e.g. cell->type or wire->width) are not counted; passes
+	// that make them increment the counter themselves (see the opt_* passes).
+	uint64_t change_count_;
+
+	RTLIL::ObjDict<RTLIL::Wire*> wires_;
+	RTLIL::ObjDict<RTLIL::Cell*> cells_;
 
 	std::vector<RTLIL::SigSig>   connections_;
 	std::vector<RTLIL::Binding*> bindings_;
@@ -1302,6 +1473,11 @@ public:
 	void new_connections(const std::vector<RTLIL::SigSig> &new_conn);
 	const std::vector<RTLIL::SigSig> &connections() const;
 
+	// Tells the monitors that the module was changed behind their back, e.g.
+	// by writing to connections_ or cell->connections_ directly, so that they
+	// rebuild their state. Code that does such writes must call this.
+	void blackout();
+
 	std::vector<RTLIL::IdString> ports;
 	void fixup_ports();
 
@@ -1633,6 +1809,11 @@ public:
 	int width, start_offset, port_id;
 	bool port_input, port_output, upto, is_signed;
 
+	// index of bit 0 of this wire in the last BitIndex built for its module
+	// and the generation of that index, -1 if the wire was never indexed.
+	// Only a hint for lookups in that index (see kernel/bitindex.h).
+	int bitidx_, bitidx_gen_;
+
 	RTLIL::Cell *driverCell() const    { log_assert(driverCell_); return driverCell_; };
 	RTLIL::IdString driverPort() const { log_assert(driverCell_); return driverPort_; };
 
@@ -1847,6 +2028,7 @@ void RTLIL::Module::rewrite_sigspecs(T &functor)
 		functor(it.first);
 		functor(it.second);
 	}
+	blackout();
 }
 
 template<typename T>
@@ -1859,6 +2041,7 @@ void RTLIL::Module::rewrite_sigspecs2(T &functor)
 	for (auto &it : connections_) {
 		functor(it.first, it.second);
 	}
+	blackout();
 }
 
 template<typename T>
@@ -0,0 +1,268 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// The `yosys --server <socket>' mode. Clients connect to a Unix domain socket
+// and send one JSON object per line:
+//
+//   {"id": 1, "design": "top", "script": "read_verilog top.v\nsynth"}
+//
+//   id        optional, copied into the response
+//   design    optional, name of the design to run on. Designs other than the
+//             main design are kept in saved_designs between requests, so
+//             `design -copy-from <name>' and `techmap -map %<name>' can use
+//             libraries that were parsed by an earlier request.
+//   script    commands, one per line, as in a script file
+//   commands  alternatively, an array of commands
+//   reset     optional, start from an empty design
+//   shutdown  optional, stop the server after answering this request
+//
+// Every request is answered with one line:
+//
+//   {"id": 1, "status": "ok", "log": "...", "warnings": 0, "result": ...}
+//
+// where status is "error" (with the message in "error") if a command failed,
+// and result is what the last command left in the result.json or
+// result.string scratchpad entry, as with the TCL `yosys' command.
+//
+// Requests are handled one after the other. A failed command doesn't stop the
+// server, but it can leave its design in a half-modified state, so clients
+// should reset a design after an error.
+
+#include "kernel/yosys.h"
+#include "kernel/json.h"
+
+#if !defined(_WIN32) && !defined(__wasm)
+#  include <sys/socket.h>
+#  include <sys/un.h>
+#  include <signal.h>
+#  include <unistd.h>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+#if !defined(_WIN32) && !defined(__wasm)
+
+static bool write_all(int fd, const std::string &data)
+{
+	size_t pos = 0;
+	while (pos < data.size()) {
+		ssize_t n = write(fd, data.data() + pos, data.size() - pos);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		pos += n;
+	}
+	return true;
+}
+
+static Json run_request(const Json &request, bool &shutdown)
+{
+	std::map<std::string, Json> response;
+	if (!request["id"].is_null())
+		response["id"] = request["id"];
+
+	std::vector<std::string> commands;
+	if (request["script"].is_string()) {
+		std::string script = request["script"].string_value();
+		std::string line;
+		for (size_t pos = 0; pos <= script.size(); pos++) {
+			if (pos == script.size() || script[pos] == '\n') {
+				if (!line.empty() && line.back() == '\\')
+					line.pop_back();
+				else if (!line.empty()) {
+					commands.push_back(line);
+					line.clear();
+				}
+			} else
+				line += script[pos];
+		}
+	}
+	for (auto &cmd : request["commands"].array_items())
+		commands.push_back(cmd.string_value());
+
+	std::string design_name = request["design"].string_value();
+	RTLIL::Design *main_design = yosys_design;
+	RTLIL::Design *design = main_design;
+	if (!design_name.empty()) {
+		auto it = saved_designs.find(design_name);
+		if (it != saved_designs.end()) {
+			design = it->second;
+			saved_designs.erase(it);
+		} else
+			design = new RTLIL::Design;
+		yosys_design = design;
+	}
+
+	std::ostringstream log_buffer;
+	log_streams.push_back(&log_buffer);
+	int warnings_count = log_warnings_count;
+	Json result;
+
+	auto fail = [&](const std::string &error) {
+		while (design->selection_stack.size() > 1)
+			design->selection_stack.pop_back();
+		log_reset_stack();
+		response["status"] = "error";
+		response["error"] = error;
+	};
+
+	try {
+		if (request["reset"].bool_value())
+			Pass::call(design, "design -reset");
+		for (auto &cmd : commands) {
+			design->scratchpad_unset("result.json");
+			design->scratchpad_unset("result.string");
+			Pass::call(design, cmd);
+			design->check();
+			if (design->scratchpad.count("result.json")) {
+				std::string err;
+				result = Json::parse(design->scratchpad.at("result.json"), err);
+				if (!err.empty())
+					log_warning("Ignoring result.json scratchpad value due to parse error: %s\n", err.c_str());
+			} else if (design->scratchpad.count("result.string"))
+				result = design->scratchpad.at("result.string");
+		}
+		response["status"] = "ok";
+	} catch (log_cmd_error_exception) {
+		fail(log_last_error);
+	} catch (std::exception &e) {
+		// e.g. std::out_of_range from a dict lookup in a pass, which would
+		// otherwise take the whole server down
+		std::string error = stringf("Internal error: %s", e.what());
+		log("ERROR: %s\n", error.c_str());
+		fail(error);
+	}
+
+	log_streams.erase(std::find(log_streams.begin(), log_streams.end(), &log_buffer));
+	response["log"] = log_buffer.str();
+	response["warnings"] = log_warnings_count - warnings_count;
+	response["result"] = result;
+
+	if (!design_name.empty()) {
+		// a `design -save <name>' of the design itself is superseded by it
+		auto it = saved_designs.find(design_name);
+		if (it != saved_designs.end())
+			delete it->second;
+		saved_designs[design_name] = design;
+		yosys_design = main_design;
+	}
+
+	if (request["shutdown"].bool_value())
+		shutdown = true;
+	return Json(response);
+}
+
+void server(const std::string &socket_path)
+{
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(addr.sun_path))
+		log_error("Socket path `%s' is too long.\n", socket_path.c_str());
+	strcpy(addr.sun_path, socket_path.c_str());
+
+	int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listen_fd < 0)
+		log_error("Can't create socket: %s\n", strerror(errno));
+	unlink(socket_path.c_str());
+	if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_fd, 16) < 0)
+		log_error("Can't listen on socket `%s': %s\n", socket_path.c_str(), strerror(errno));
+
+	// a client going away must not take the server with it
+	signal(SIGPIPE, SIG_IGN);
+
+	bool restore_log_cmd_error_throw = log_cmd_error_throw;
+	bool restore_log_error_throw = log_error_throw;
+	log_cmd_error_throw = true;
+	log_error_throw = true;
+
+	log("\n-- Listening on `%s' --\n", socket_path.c_str());
+	log_flush();
+
+	bool shutdown = false;
+	while (!shutdown)
+	{
+		int fd = accept(listen_fd, nullptr, nullptr);
+		if (fd < 0) {
+			if (errno == EINTR)
+				continue;
+			log_error_throw = restore_log_error_throw;
+			log_error("Can't accept connection on `%s': %s\n", socket_path.c_str(), strerror(errno));
+		}
+
+		std::string buffer;
+		char chunk[4096];
+		bool connected = true;
+		while (connected && !shutdown)
+		{
+			size_t newline;
+			while (!shutdown && (newline = buffer.find('\n')) != std::string::npos) {
+				std::string line = buffer.substr(0, newline);
+				buffer.erase(0, newline + 1);
+				if (line.find_first_not_of(" \t\r") == std::string::npos)
+					continue;
+
+				std::string err;
+				Json request = Json::parse(line, err);
+				Json response;
+				if (!err.empty() || !request.is_object())
+					response = Json::object {
+						{"status", "error"},
+						{"error", err.empty() ? std::string("request is not a JSON object") : err},
+					};
+				else
+					response = run_request(request, shutdown);
+				log_flush();
+
+				if (!write_all(fd, response.dump() + "\n")) {
+					connected = false;
+					break;
+				}
+			}
+			if (!connected || shutdown)
+				break;
+
+			ssize_t n = read(fd, chunk, sizeof(chunk));
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				break;
+			buffer.append(chunk, n);
+		}
+		close(fd);
+	}
+
+	close(listen_fd);
+	unlink(socket_path.c_str());
+
+	log_cmd_error_throw = restore_log_cmd_error_throw;
+	log_error_throw = restore_log_error_throw;
+}
+
+#else
+
+void server(const std::string &socket_path)
+{
+	log_error("Can't listen on `%s': server mode is not supported on this platform.\n", socket_path.c_str());
+}
+
+#endif
+
+YOSYS_NAMESPACE_END
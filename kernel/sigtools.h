@@ -238,7 +238,11 @@ class SigSet<T, sort_by_name_id_guard<T>> : public SigSet<T, RTLIL::sort_by_name
  */
 struct SigMap
 {
+#ifdef YOSYS_ENABLE_FLAT_HASHLIB
+	mfp<SigBit, hash_ops<SigBit>, flat_pool<SigBit>> database;
+#else
 	mfp<SigBit> database;
+#endif
 
 	SigMap(RTLIL::Module *module = NULL)
 	{
@@ -0,0 +1,358 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef SMALLVEC_H
+#define SMALLVEC_H
+
+#include "kernel/yosys_common.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+/**
+ * A vector that keeps up to N elements in the object itself and only goes
+ * to the heap when it grows beyond that. The inline buffer shares its
+ * storage with the heap pointer, so for small N it is no larger than a
+ * std::vector. It implements the subset of the std::vector interface used
+ * by the kernel and converts implicitly to std::vector<T>, so code that
+ * only reads from it (iterating, indexing, copying into a std::vector)
+ * does not need to know the difference.
+ *
+ * Iterators are plain pointers and, unlike with std::vector, moving or
+ * swapping a smallvec that is still inline invalidates them.
+ */
+template<typename T, int N>
+class smallvec
+{
+	static_assert(N > 0, "use std::vector for smallvec without inline storage");
+
+	union {
+		T *heap_;
+		alignas(T) unsigned char inline_[N * sizeof(T)];
+	};
+	int size_ = 0;
+	int capacity_ = N;
+
+	bool is_inline() const { return capacity_ == N; }
+	T *inline_data() { return reinterpret_cast<T*>(inline_); }
+
+	// Move the elements to a heap buffer with room for new_capacity elements
+	void reallocate(int new_capacity)
+	{
+		T *old_data = data();
+		T *new_data = static_cast<T*>(::operator new(new_capacity * sizeof(T)));
+		for (int i = 0; i < size_; i++) {
+			new (new_data + i) T(std::move(old_data[i]));
+			old_data[i].~T();
+		}
+		if (!is_inline())
+			::operator delete(heap_);
+		heap_ = new_data;
+		capacity_ = new_capacity;
+	}
+
+	void grow(int min_capacity)
+	{
+		reallocate(std::max(min_capacity, 2 * capacity_));
+	}
+
+	// Leave the vector empty and inline, releasing any heap buffer
+	void reset()
+	{
+		clear();
+		if (!is_inline()) {
+			::operator delete(heap_);
+			capacity_ = N;
+		}
+	}
+
+	void move_from(smallvec &other)
+	{
+		if (other.is_inline()) {
+			for (int i = 0; i < other.size_; i++)
+				new (inline_data() + i) T(std::move(other.inline_data()[i]));
+			size_ = other.size_;
+			other.clear();
+		} else {
+			heap_ = other.heap_;
+			size_ = other.size_;
+			capacity_ = other.capacity_;
+			other.size_ = 0;
+			other.capacity_ = N;
+		}
+	}
+
+public:
+	typedef T value_type;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	typedef T &reference;
+	typedef const T &const_reference;
+	typedef T *pointer;
+	typedef const T *const_pointer;
+	typedef T *iterator;
+	typedef const T *const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	smallvec() { }
+
+	smallvec(std::initializer_list<T> init)
+	{
+		insert(end(), init.begin(), init.end());
+	}
+
+	template<typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	smallvec(InputIt first, InputIt last)
+	{
+		insert(end(), first, last);
+	}
+
+	smallvec(const std::vector<T> &other)
+	{
+		insert(end(), other.begin(), other.end());
+	}
+
+	smallvec(const smallvec &other)
+	{
+		insert(end(), other.begin(), other.end());
+	}
+
+	smallvec(smallvec &&other)
+	{
+		move_from(other);
+	}
+
+	~smallvec()
+	{
+		reset();
+	}
+
+	smallvec &operator=(const smallvec &other)
+	{
+		if (this != &other) {
+			clear();
+			insert(end(), other.begin(), other.end());
+		}
+		return *this;
+	}
+
+	smallvec &operator=(smallvec &&other)
+	{
+		if (this != &other) {
+			reset();
+			move_from(other);
+		}
+		return *this;
+	}
+
+	smallvec &operator=(const std::vector<T> &other)
+	{
+		clear();
+		insert(end(), other.begin(), other.end());
+		return *this;
+	}
+
+	operator std::vector<T>() const
+	{
+		return std::vector<T>(begin(), end());
+	}
+
+	T *data() { return is_inline() ? inline_data() : heap_; }
+	const T *data() const { return const_cast<smallvec*>(this)->data(); }
+
+	iterator begin() { return data(); }
+	iterator end() { return data() + size_; }
+	const_iterator begin() const { return data(); }
+	const_iterator end() const { return data() + size_; }
+	const_iterator cbegin() const { return begin(); }
+	const_iterator cend() const { return end(); }
+	reverse_iterator rbegin() { return reverse_iterator(end()); }
+	reverse_iterator rend() { return reverse_iterator(begin()); }
+	const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+	size_t size() const { return size_; }
+	size_t capacity() const { return capacity_; }
+	bool empty() const { return size_ == 0; }
+
+	T &operator[](size_t i) { return data()[i]; }
+	const T &operator[](size_t i) const { return data()[i]; }
+
+	T &at(size_t i)
+	{
+		if (i >= size())
+			throw std::out_of_range("smallvec::at");
+		return data()[i];
+	}
+
+	const T &at(size_t i) const
+	{
+		if (i >= size())
+			throw std::out_of_range("smallvec::at");
+		return data()[i];
+	}
+
+	T &front() { return data()[0]; }
+	T &back() { return data()[size_ - 1]; }
+	const T &front() const { return data()[0]; }
+	const T &back() const { return data()[size_ - 1]; }
+
+	void reserve(size_t n)
+	{
+		if (int(n) > capacity_)
+			reallocate(n);
+	}
+
+	void clear()
+	{
+		T *p = data();
+		for (int i = 0; i < size_; i++)
+			p[i].~T();
+		size_ = 0;
+	}
+
+	template<typename... Args>
+	T &emplace_back(Args &&... args)
+	{
+		if (size_ == capacity_) {
+			// construct the new element before moving the old ones, in
+			// case the arguments refer to elements of this vector
+			int new_capacity = std::max(size_ + 1, 2 * capacity_);
+			T *new_data = static_cast<T*>(::operator new(new_capacity * sizeof(T)));
+			new (new_data + size_) T(std::forward<Args>(args)...);
+			T *old_data = data();
+			for (int i = 0; i < size_; i++) {
+				new (new_data + i) T(std::move(old_data[i]));
+				old_data[i].~T();
+			}
+			if (!is_inline())
+				::operator delete(heap_);
+			heap_ = new_data;
+			capacity_ = new_capacity;
+		} else
+			new (data() + size_) T(std::forward<Args>(args)...);
+		return data()[size_++];
+	}
+
+	void push_back(const T &value) { emplace_back(value); }
+	void push_back(T &&value) { emplace_back(std::move(value)); }
+
+	void pop_back()
+	{
+		data()[--size_].~T();
+	}
+
+	void resize(size_t n)
+	{
+		while (size() > n)
+			pop_back();
+		reserve(n);
+		while (size() < n)
+			emplace_back();
+	}
+
+	void resize(size_t n, const T &value)
+	{
+		while (size() > n)
+			pop_back();
+		if (size() < n) {
+			T copy = value;
+			reserve(n);
+			while (size() < n)
+				emplace_back(copy);
+		}
+	}
+
+	iterator insert(const_iterator pos, const T &value)
+	{
+		int index = pos - begin();
+		T copy = value;
+		emplace_back(std::move(copy));
+		std::rotate(begin() + index, end() - 1, end());
+		return begin() + index;
+	}
+
+	template<typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	iterator insert(const_iterator pos, InputIt first, InputIt last)
+	{
+		int index = pos - begin();
+		int old_size = size_;
+		if (index == old_size) {
+			for (; first != last; ++first)
+				emplace_back(*first);
+		} else {
+			// the range may point into this vector
+			std::vector<T> values(first, last);
+			reserve(size_ + values.size());
+			for (auto &value : values)
+				emplace_back(std::move(value));
+			std::rotate(begin() + index, begin() + old_size, end());
+		}
+		return begin() + index;
+	}
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		T *p = begin() + (first - begin());
+		int count = last - first;
+		if (count > 0) {
+			std::move(p + count, end(), p);
+			for (int i = 0; i < count; i++)
+				pop_back();
+		}
+		return p;
+	}
+
+	iterator erase(const_iterator pos)
+	{
+		return erase(pos, pos + 1);
+	}
+
+	void swap(smallvec &other)
+	{
+		if (!is_inline() && !other.is_inline()) {
+			std::swap(heap_, other.heap_);
+			std::swap(size_, other.size_);
+			std::swap(capacity_, other.capacity_);
+		} else {
+			smallvec tmp(std::move(other));
+			other = std::move(*this);
+			*this = std::move(tmp);
+		}
+	}
+
+	bool operator==(const smallvec &other) const
+	{
+		return size_ == other.size_ && std::equal(begin(), end(), other.begin());
+	}
+
+	bool operator!=(const smallvec &other) const
+	{
+		return !(*this == other);
+	}
+
+	bool operator<(const smallvec &other) const
+	{
+		return std::lexicographical_compare(begin(), end(), other.begin(), other.end());
+	}
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
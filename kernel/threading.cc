@@ -0,0 +1,118 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/threading.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+int yosys_jobs = 1;
+
+void parallel_for(int num_jobs, int num_threads, const std::function<void(int)> &job)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	num_threads = std::min(num_threads, num_jobs);
+
+	if (num_threads > 1)
+	{
+		RTLIL::IdString::concurrent_scope id_scope;
+		std::atomic<int> next_job(0);
+		std::vector<std::exception_ptr> errors(num_jobs);
+
+		auto run_jobs = [&]() {
+			for (int i = next_job++; i < num_jobs; i = next_job++) {
+				try {
+					job(i);
+				} catch (...) {
+					errors[i] = std::current_exception();
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (int i = 1; i < num_threads; i++)
+			threads.emplace_back(run_jobs);
+		run_jobs();
+		for (auto &thread : threads)
+			thread.join();
+
+		for (auto &error : errors)
+			if (error)
+				std::rethrow_exception(error);
+		return;
+	}
+#else
+	(void)num_threads;
+#endif
+
+	for (int i = 0; i < num_jobs; i++)
+		job(i);
+}
+
+#ifdef YOSYS_ENABLE_THREADS
+
+ThreadPool::ThreadPool(int num_threads)
+{
+	for (int i = 0; i < std::max(num_threads, 1); i++)
+		threads.emplace_back([this]() { run_jobs(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	cond.notify_all();
+	for (auto &thread : threads)
+		thread.join();
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> job)
+{
+	std::packaged_task<void()> task(std::move(job));
+	std::future<void> result = task.get_future();
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		queue.push_back(std::move(task));
+	}
+	cond.notify_one();
+	return result;
+}
+
+void ThreadPool::run_jobs()
+{
+	while (1)
+	{
+		std::packaged_task<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cond.wait(lock, [this]() { return stopping || !queue.empty(); });
+			if (queue.empty())
+				return;
+			task = std::move(queue.front());
+			queue.pop_front();
+		}
+		task();
+	}
+}
+
+#endif
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,98 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// Thin wrappers around the C++ threading primitives. Builds without thread
+// support (YOSYS_ENABLE_THREADS undefined, e.g. wasi) get no-op stand-ins
+// so that kernel code can use the same locking code unconditionally.
+
+#ifndef THREADING_H
+#define THREADING_H
+
+#include "kernel/yosys_common.h"
+
+#include <atomic>
+
+#ifdef YOSYS_ENABLE_THREADS
+#  include <mutex>
+#  include <thread>
+#  include <condition_variable>
+#  include <future>
+#  include <deque>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+#ifdef YOSYS_ENABLE_THREADS
+
+typedef std::mutex Mutex;
+typedef std::lock_guard<std::mutex> MutexLock;
+
+#else
+
+struct Mutex {
+	void lock() { }
+	void unlock() { }
+	bool try_lock() { return true; }
+};
+
+struct MutexLock {
+	MutexLock(Mutex &) { }
+};
+
+#endif
+
+// Upper limit for the number of threads used by parallel_for() callers that
+// do not have a more specific setting (set with the "-j" command line option).
+extern int yosys_jobs;
+
+// Calls job(0) .. job(num_jobs-1) on up to num_threads threads, including the
+// calling thread, and returns when all jobs are done. Jobs are started in index
+// order. If jobs throw, the exception of the lowest job index is rethrown after
+// all threads are joined. The jobs run inside an IdString concurrent section.
+void parallel_for(int num_jobs, int num_threads, const std::function<void(int)> &job);
+
+#ifdef YOSYS_ENABLE_THREADS
+
+// A fixed set of worker threads that run submitted jobs in submission order,
+// for callers that keep working on the calling thread while the jobs run
+// (e.g. waiting for external processes). An exception thrown by a job is
+// passed on through its future. The destructor waits for all submitted jobs.
+class ThreadPool
+{
+public:
+	ThreadPool(int num_threads);
+	~ThreadPool();
+
+	std::future<void> submit(std::function<void()> job);
+
+private:
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::deque<std::packaged_task<void()>> queue;
+	std::vector<std::thread> threads;
+	bool stopping = false;
+
+	void run_jobs();
+};
+
+#endif
+
+YOSYS_NAMESPACE_END
+
+#endif
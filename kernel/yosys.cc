@@ -591,6 +591,7 @@ void yosys_shutdown()
 	delete yosys_design;
 	yosys_design = NULL;
 
+	log_flush();
 	for (auto f : log_files)
 		if (f != stderr)
 			fclose(f);
@@ -625,6 +626,27 @@ void yosys_shutdown()
 #endif
 }
 
+static thread_local int new_id_job = -1, new_id_job_base, new_id_job_count;
+
+void new_id_begin_job(int base, int job)
+{
+	new_id_job = job;
+	new_id_job_base = base;
+	new_id_job_count = 0;
+}
+
+void new_id_end_job()
+{
+	new_id_job = -1;
+}
+
+std::string new_id_index()
+{
+	if (new_id_job >= 0)
+		return stringf("%d.%d.%d", new_id_job_base, new_id_job, new_id_job_count++);
+	return stringf("%d", autoidx++);
+}
+
 RTLIL::IdString new_id(std::string file, int line, std::string func)
 {
 #ifdef _WIN32
@@ -639,7 +661,7 @@ RTLIL::IdString new_id(std::string file, int line, std::string func)
 	if (pos != std::string::npos)
 		func = func.substr(pos+1);
 
-	return stringf("$auto$%s:%d:%s$%d", file.c_str(), line, func.c_str(), autoidx++);
+	return stringf("$auto$%s:%d:%s$%s", file.c_str(), line, func.c_str(), new_id_index().c_str());
 }
 
 RTLIL::IdString new_id_suffix(std::string file, int line, std::string func, std::string suffix)
@@ -656,7 +678,7 @@ RTLIL::IdString new_id_suffix(std::string file, int line, std::string func, std:
 	if (pos != std::string::npos)
 		func = func.substr(pos+1);
 
-	return stringf("$auto$%s:%d:%s$%s$%d", file.c_str(), line, func.c_str(), suffix.c_str(), autoidx++);
+	return stringf("$auto$%s:%d:%s$%s$%s", file.c_str(), line, func.c_str(), suffix.c_str(), new_id_index().c_str());
 }
 
 RTLIL::Design *yosys_get_design()
@@ -1408,10 +1430,18 @@ static char **readline_completion(const char *text, int start, int)
 }
 #endif
 
+void (*shell_init_hook)() = nullptr;
+
 void shell(RTLIL::Design *design)
 {
 	static int recursion_counter = 0;
 
+	if (shell_init_hook) {
+		auto hook = shell_init_hook;
+		shell_init_hook = nullptr;
+		hook();
+	}
+
 	recursion_counter++;
 	log_cmd_error_throw = true;
 
@@ -73,6 +73,10 @@ void run_pass(std::string command, RTLIL::Design *design = nullptr);
 bool run_frontend(std::string filename, std::string command, RTLIL::Design *design = nullptr, std::string *from_to_label = nullptr);
 void run_backend(std::string filename, std::string command, RTLIL::Design *design = nullptr);
 void shell(RTLIL::Design *design);
+// called by shell() before its first prompt, then reset (the driver loads the
+// readline history there)
+extern void (*shell_init_hook)();
+void server(const std::string &socket_path);
 
 // journal of all input and output files read (for "yosys -E")
 extern std::set<std::string> yosys_input_files, yosys_output_files;
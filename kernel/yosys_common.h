@@ -201,6 +201,8 @@ using hashlib::dict;
 using hashlib::idict;
 using hashlib::pool;
 using hashlib::mfp;
+using hashlib::flat_dict;
+using hashlib::flat_pool;
 
 namespace RTLIL {
 	struct IdString;
@@ -353,6 +355,16 @@ extern int yosys_xtrace;
 RTLIL::IdString new_id(std::string file, int line, std::string func);
 RTLIL::IdString new_id_suffix(std::string file, int line, std::string func, std::string suffix);
 
+// Between these calls, new_id() on the current thread numbers names <base>.<job>.<n>
+// with a per-job counter <n> instead of using autoidx. This keeps names created by
+// parallel jobs deterministic, no matter how the jobs are scheduled onto threads.
+void new_id_begin_job(int base, int job);
+void new_id_end_job();
+
+// The unique number at the end of a NEW_ID name, for code that makes up names
+// in its own format: autoidx++, or <base>.<job>.<n> inside a parallel job.
+std::string new_id_index();
+
 #define NEW_ID \
 	YOSYS_NAMESPACE_PREFIX new_id(__FILE__, __LINE__, __FUNCTION__)
 #define NEW_ID_SUFFIX(suffix) \
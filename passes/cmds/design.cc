@@ -26,6 +26,20 @@ YOSYS_NAMESPACE_BEGIN
 std::map<std::string, RTLIL::Design*> saved_designs;
 std::vector<RTLIL::Design*> pushed_designs;
 
+// Hand all modules of one design over to another without copying them, for
+// the modes that clear the source design afterwards anyway
+static void move_modules(RTLIL::Design *from, RTLIL::Design *to)
+{
+	log_assert(from->refcount_modules_ == 0);
+	for (auto mod : from->modules().to_vector()) {
+		for (auto mon : from->monitors)
+			mon->notify_module_del(mod);
+		from->modindex_invalidate(mod);
+		from->modules_.erase(mod->name);
+		to->add(mod);
+	}
+}
+
 struct DesignPass : public Pass {
 	DesignPass() : Pass("design", "save, restore and reset current design") { }
 	~DesignPass() override {
@@ -53,11 +67,14 @@ struct DesignPass : public Pass {
 		log("    design -stash <name>\n");
 		log("\n");
 		log("Save the current design under the given name and then clear the current design.\n");
+		log("Unlike -save, this moves the modules instead of copying them.\n");
 		log("\n");
 		log("\n");
 		log("    design -push\n");
 		log("\n");
 		log("Push the current design to the stack and then clear the current design.\n");
+		log("The modules are moved to the stack instead of being copied, and -pop moves\n");
+		log("them back.\n");
 		log("\n");
 		log("\n");
 		log("    design -push-copy\n");
@@ -343,8 +360,11 @@ struct DesignPass : public Pass {
 		{
 			RTLIL::Design *design_copy = new RTLIL::Design;
 
-			for (auto mod : design->modules())
-				design_copy->add(mod->clone());
+			if (push_mode || reset_mode)
+				move_modules(design, design_copy);
+			else
+				for (auto mod : design->modules())
+					design_copy->add(mod->clone());
 
 			design_copy->selection_stack = design->selection_stack;
 			design_copy->selection_vars = design->selection_vars;
@@ -388,8 +408,11 @@ struct DesignPass : public Pass {
 		{
 			RTLIL::Design *saved_design = pop_mode ? pushed_designs.back() : saved_designs.at(load_name);
 
-			for (auto mod : saved_design->modules())
-				design->add(mod->clone());
+			if (pop_mode)
+				move_modules(saved_design, design);
+			else
+				for (auto mod : saved_design->modules())
+					design->add(mod->clone());
 
 			design->selection_stack = saved_design->selection_stack;
 			design->selection_vars = saved_design->selection_vars;
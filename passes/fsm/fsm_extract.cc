@@ -395,7 +395,9 @@ static void extract_fsm(RTLIL::Wire *wire)
 		RTLIL::SigSpec port_sig = assign_map(cell->getPort(cellport.second));
 		RTLIL::SigSpec unconn_sig = port_sig.extract(ctrl_out);
 		RTLIL::Wire *unconn_wire = module->addWire(stringf("$fsm_unconnect$%d", autoidx++), unconn_sig.size());
-		port_sig.replace(unconn_sig, RTLIL::SigSpec(unconn_wire), &cell->connections_[cellport.second]);
+		RTLIL::SigSpec new_port_sig = cell->getPort(cellport.second);
+		port_sig.replace(unconn_sig, RTLIL::SigSpec(unconn_wire), &new_port_sig);
+		cell->setPort(cellport.second, new_port_sig);
 	}
 }
 
@@ -158,7 +158,7 @@ struct FsmOpt
 
 	void opt_alias_inputs()
 	{
-		RTLIL::SigSpec &ctrl_in = cell->connections_[ID::CTRL_IN];
+		RTLIL::SigSpec ctrl_in = cell->getPort(ID::CTRL_IN);
 
 		for (int i = 0; i < ctrl_in.size(); i++)
 		for (int j = i+1; j < ctrl_in.size(); j++)
@@ -191,12 +191,14 @@ struct FsmOpt
 				fsm_data.transition_table.swap(new_transition_table);
 				new_transition_table.clear();
 			}
+
+		cell->setPort(ID::CTRL_IN, ctrl_in);
 	}
 
 	void opt_feedback_inputs()
 	{
-		RTLIL::SigSpec &ctrl_in = cell->connections_[ID::CTRL_IN];
-		RTLIL::SigSpec &ctrl_out = cell->connections_[ID::CTRL_OUT];
+		RTLIL::SigSpec ctrl_in = cell->getPort(ID::CTRL_IN);
+		RTLIL::SigSpec ctrl_out = cell->getPort(ID::CTRL_OUT);
 
 		for (int j = 0; j < ctrl_out.size(); j++)
 		for (int i = 0; i < ctrl_in.size(); i++)
@@ -224,6 +226,8 @@ struct FsmOpt
 				fsm_data.transition_table.swap(new_transition_table);
 				new_transition_table.clear();
 			}
+
+		cell->setPort(ID::CTRL_IN, ctrl_in);
 	}
 
 	void opt_find_dont_care_worker(std::set<RTLIL::Const> &set, int bit, FsmData::transition_t &tr, bool &did_something)
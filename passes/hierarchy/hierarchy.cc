@@ -315,6 +315,8 @@ struct IFExpander
 		for(unsigned int i=0;i<connections_to_remove.size();i++) {
 			cell.connections_.erase(connections_to_remove[i]);
 		}
+		if (!connections_to_add_name.empty() || !connections_to_remove.empty())
+			cell.module->blackout();
 	}
 };
 
@@ -596,6 +598,9 @@ bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check
 		}
 	}
 
+	if (!array_cells.empty())
+		module->blackout();
+
 	return did_something;
 }
 
@@ -1204,6 +1209,7 @@ struct HierarchyPass : public Pass {
 						new_connections[conn.first] = conn.second;
 				}
 				cell->connections_ = new_connections;
+				module->blackout();
 			}
 		}
 
@@ -25,6 +25,73 @@
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
+// Remembers the change counters of the selected modules at the start of an
+// iteration, so that the next iteration can be restricted to the modules
+// that were changed by the previous one.
+struct OptDirtyModules
+{
+	RTLIL::Design *design;
+	dict<RTLIL::IdString, uint64_t> change_counts;
+	bool pushed = false;
+
+	OptDirtyModules(RTLIL::Design *design) : design(design) { }
+
+	void snapshot()
+	{
+		change_counts.clear();
+		for (auto module : design->selected_modules())
+			change_counts[module->name] = module->change_count_;
+	}
+
+	// Pushes a selection that only contains the modules changed since the last
+	// snapshot. If the design changed without moving any counter (a pass that
+	// does not count its direct writes to public members) the current selection
+	// is kept as it is.
+	void push()
+	{
+		log_assert(!pushed);
+
+		pool<RTLIL::IdString> dirty;
+		for (auto &it : change_counts) {
+			RTLIL::Module *module = design->module(it.first);
+			if (module != nullptr && module->change_count_ != it.second)
+				dirty.insert(it.first);
+		}
+
+		if (dirty.empty())
+			return;
+
+		log("Rerunning on %d of %d modules.\n", GetSize(dirty), GetSize(change_counts));
+
+		RTLIL::Selection sel = design->selection();
+		if (sel.full_selection) {
+			sel.full_selection = false;
+			sel.selected_modules = dirty;
+		} else {
+			for (auto it = sel.selected_modules.begin(); it != sel.selected_modules.end();)
+				if (dirty.count(*it))
+					++it;
+				else
+					it = sel.selected_modules.erase(it);
+			for (auto it = sel.selected_members.begin(); it != sel.selected_members.end();)
+				if (dirty.count(it->first))
+					++it;
+				else
+					it = sel.selected_members.erase(it);
+		}
+
+		design->selection_stack.push_back(sel);
+		pushed = true;
+	}
+
+	void pop()
+	{
+		if (pushed)
+			design->selection_stack.pop_back();
+		pushed = false;
+	}
+};
+
 struct OptPass : public Pass {
 	OptPass() : Pass("opt", "perform simple optimizations") { }
 	void help() override
@@ -59,6 +126,12 @@ struct OptPass : public Pass {
 		log("        opt_clean [-purge]\n");
 		log("    while <changed design in opt_dff>\n");
 		log("\n");
+		log("When called with -dirty, every iteration after the first one only visits the\n");
+		log("modules that were changed by the previous iteration. Changes are detected\n");
+		log("with the per-module change counters, which the opt_* passes also increment\n");
+		log("for the modules they change by writing to cell or wire members directly, so\n");
+		log("the result is the same as without -dirty.\n");
+		log("\n");
 		log("Note: Options in square brackets (such as [-keepdc]) are passed through to\n");
 		log("the opt_* commands when given to 'opt'.\n");
 		log("\n");
@@ -74,6 +147,7 @@ struct OptPass : public Pass {
 		bool opt_share = false;
 		bool fast_mode = false;
 		bool noff_mode = false;
+		bool dirty_mode = false;
 
 		log_header(design, "Executing OPT pass (performing simple optimizations).\n");
 		log_push();
@@ -141,13 +215,24 @@ struct OptPass : public Pass {
 				noff_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-dirty") {
+				dirty_mode = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		OptDirtyModules dirty_modules(design);
+
 		if (fast_mode)
 		{
-			while (1) {
+			for (int iter = 0;; iter++) {
+				if (dirty_mode) {
+					if (iter > 0)
+						dirty_modules.push();
+					dirty_modules.snapshot();
+				}
 				Pass::call(design, "opt_expr" + opt_expr_args);
 				Pass::call(design, "opt_merge" + opt_merge_args);
 				design->scratchpad_unset("opt.did_something");
@@ -156,15 +241,22 @@ struct OptPass : public Pass {
 				if (design->scratchpad_get_bool("opt.did_something") == false)
 					break;
 				Pass::call(design, "opt_clean" + opt_clean_args);
+				dirty_modules.pop();
 				log_header(design, "Rerunning OPT passes. (Removed registers in this run.)\n");
 			}
 			Pass::call(design, "opt_clean" + opt_clean_args);
+			dirty_modules.pop();
 		}
 		else
 		{
 			Pass::call(design, "opt_expr" + opt_expr_args);
 			Pass::call(design, "opt_merge -nomux" + opt_merge_args);
-			while (1) {
+			for (int iter = 0;; iter++) {
+				if (dirty_mode) {
+					if (iter > 0)
+						dirty_modules.push();
+					dirty_modules.snapshot();
+				}
 				design->scratchpad_unset("opt.did_something");
 				Pass::call(design, "opt_muxtree");
 				Pass::call(design, "opt_reduce" + opt_reduce_args);
@@ -175,6 +267,7 @@ struct OptPass : public Pass {
 					Pass::call(design, "opt_dff" + opt_dff_args);
 				Pass::call(design, "opt_clean" + opt_clean_args);
 				Pass::call(design, "opt_expr" + opt_expr_args);
+				dirty_modules.pop();
 				if (design->scratchpad_get_bool("opt.did_something") == false)
 					break;
 				log_header(design, "Rerunning OPT passes. (Maybe there is more to do..)\n");
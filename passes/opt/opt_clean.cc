@@ -42,6 +42,11 @@ struct keep_cache_t
 		this->design = design;
 		this->purge_mode = purge_mode;
 		cache.clear();
+		// fill in all modules up front, so that modules that are cleaned
+		// in parallel only read the cache
+		if (design != nullptr)
+			for (auto module : design->modules())
+				query(module);
 	}
 
 	bool query(Module *module)
@@ -102,7 +107,9 @@ struct keep_cache_t
 
 keep_cache_t keep_cache;
 CellTypes ct_reg, ct_all;
-int count_rm_cells, count_rm_wires;
+std::atomic<int> count_rm_cells, count_rm_wires;
+std::atomic<bool> changed_design;
+thread_local bool changed_module;
 
 void rmunused_module_cells(Module *module, bool verbose)
 {
@@ -205,7 +212,7 @@ void rmunused_module_cells(Module *module, bool verbose)
 	for (auto cell : unused) {
 		if (verbose)
 			log_debug("  removing unused `%s' cell `%s'.\n", cell->type.c_str(), cell->name.c_str());
-		module->design->scratchpad_set_bool("opt.did_something", true);
+		changed_module = true;
 		if (RTLIL::builtin_ff_cell_types().count(cell->type))
 			ffinit.remove_init(cell->getPort(ID::Q));
 		module->remove(cell);
@@ -348,8 +355,9 @@ bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 		}
 	}
 
-	// we are removing all connections
-	module->connections_.clear();
+	// we are replacing all connections, but only touch the module if they
+	// actually changed so that its change counter stays put otherwise
+	std::vector<RTLIL::SigSig> new_connections;
 
 	// used signals sigmapped
 	SigPool used_signals;
@@ -469,7 +477,7 @@ bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 					wire->attributes.at(ID::init) = initval;
 				used_signals.add(new_conn.first);
 				used_signals.add(new_conn.second);
-				module->connect(new_conn);
+				new_connections.push_back(new_conn);
 			}
 
 			if (!used_signals_nodrivers.check_all(s2)) {
@@ -501,14 +509,18 @@ bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 			del_temp_wires_count++;
 	}
 
-	module->remove(del_wires_queue);
+	if (new_connections != module->connections())
+		module->new_connections(new_connections);
+
+	if (!del_wires_queue.empty())
+		module->remove(del_wires_queue);
 	count_rm_wires += GetSize(del_wires_queue);
 
 	if (verbose && del_temp_wires_count)
 		log_debug("  removed %d unused temporary wires.\n", del_temp_wires_count);
 
 	if (!del_wires_queue.empty())
-		module->design->scratchpad_set_bool("opt.did_something", true);
+		changed_module = true;
 
 	return !del_wires_queue.empty();
 }
@@ -589,7 +601,7 @@ bool rmunused_module_init(RTLIL::Module *module, bool verbose)
 	}
 
 	if (did_something)
-		module->design->scratchpad_set_bool("opt.did_something", true);
+		changed_module = true;
 
 	return did_something;
 }
@@ -598,6 +610,7 @@ void rmunused_module(RTLIL::Module *module, bool purge_mode, bool verbose, bool
 {
 	if (verbose)
 		log("Finding unused cells or wires in module %s..\n", module->name.c_str());
+	changed_module = false;
 
 	std::vector<RTLIL::Cell*> delcells;
 	for (auto cell : module->cells())
@@ -616,13 +629,20 @@ void rmunused_module(RTLIL::Module *module, bool purge_mode, bool verbose, bool
 		module->remove(cell);
 	}
 	if (!delcells.empty())
-		module->design->scratchpad_set_bool("opt.did_something", true);
+		changed_module = true;
 
 	rmunused_module_cells(module, verbose);
 	while (rmunused_module_signals(module, purge_mode, verbose)) { }
 
 	if (rminit && rmunused_module_init(module, verbose))
 		while (rmunused_module_signals(module, purge_mode, verbose)) { }
+
+	// init attributes are changed without the change counter seeing it,
+	// count them too for opt -dirty
+	if (changed_module) {
+		module->change_count_++;
+		changed_design = true;
+	}
 }
 
 struct OptCleanPass : public Pass {
@@ -671,15 +691,18 @@ struct OptCleanPass : public Pass {
 
 		count_rm_cells = 0;
 		count_rm_wires = 0;
+		changed_design = false;
 
-		for (auto module : design->selected_whole_modules_warn()) {
+		parallel_for_modules(design, design->selected_whole_modules_warn(), [&](RTLIL::Module *module) {
 			if (module->has_processes_warn())
-				continue;
+				return;
 			rmunused_module(module, purge_mode, true, true);
-		}
+		});
 
+		if (changed_design)
+			design->scratchpad_set_bool("opt.did_something", true);
 		if (count_rm_cells > 0 || count_rm_wires > 0)
-			log("Removed %d unused cells and %d unused wires.\n", count_rm_cells, count_rm_wires);
+			log("Removed %d unused cells and %d unused wires.\n", count_rm_cells.load(), count_rm_wires.load());
 
 		design->optimize();
 		design->sort();
@@ -733,16 +756,19 @@ struct CleanPass : public Pass {
 
 		count_rm_cells = 0;
 		count_rm_wires = 0;
+		changed_design = false;
 
-		for (auto module : design->selected_whole_modules()) {
+		parallel_for_modules(design, design->selected_whole_modules(), [&](RTLIL::Module *module) {
 			if (module->has_processes())
-				continue;
+				return;
 			rmunused_module(module, purge_mode, ys_debug(), true);
-		}
+		});
 
+		if (changed_design)
+			design->scratchpad_set_bool("opt.did_something", true);
 		log_suppressed();
 		if (count_rm_cells > 0 || count_rm_wires > 0)
-			log("Removed %d unused cells and %d unused wires.\n", count_rm_cells, count_rm_wires);
+			log("Removed %d unused cells and %d unused wires.\n", count_rm_cells.load(), count_rm_wires.load());
 
 		design->optimize();
 		design->sort();
@@ -189,7 +189,7 @@ struct OptDemorganPass : public Pass {
 		unsigned int cells_changed = 0;
 		for (auto module : design->selected_modules())
 		{
-			ModIndex index(module);
+			ModIndex &index = design->modindex(module);
 			for (auto cell : module->selected_cells())
 				demorgan_worker(index, cell, cells_changed);
 		}
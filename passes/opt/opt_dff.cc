@@ -45,6 +45,7 @@ struct OptDffOptions
 struct OptDffWorker
 {
 	const OptDffOptions &opt;
+	const CellTypes &ct;
 
 	Module *module;
 	typedef std::pair<RTLIL::Cell*, int> cell_int_t;
@@ -61,7 +62,7 @@ struct OptDffWorker
 	// Used as a queue.
 	std::vector<Cell *> dff_cells;
 
-	OptDffWorker(const OptDffOptions &opt, Module *mod) : opt(opt), module(mod), sigmap(mod), initvals(&sigmap, mod) {
+	OptDffWorker(const OptDffOptions &opt, const CellTypes &ct, Module *mod) : opt(opt), ct(ct), module(mod), sigmap(mod), initvals(&sigmap, mod) {
 		// Gathering two kinds of information here for every sigmapped SigBit:
 		//
 		// - bitusers: how many users it has (muxes will only be merged into FFs if this is 1, making the FF the only user)
@@ -735,7 +736,7 @@ struct OptDffWorker
 	}
 
 	bool run_constbits() {
-		ModWalker modwalker(module->design, module);
+		ModWalker modwalker(module->design, ct, module);
 		QuickConeSat qcsat(modwalker);
 
 		// Run as a separate sub-pass, so that we don't mutate (non-FF) cells under ModWalker.
@@ -916,14 +917,19 @@ struct OptDffPass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
-		bool did_something = false;
-		for (auto mod : design->selected_modules()) {
-			OptDffWorker worker(opt, mod);
-			if (worker.run())
-				did_something = true;
+		CellTypes ct(design);
+		std::atomic<bool> did_something(false);
+		parallel_for_modules(design, design->selected_modules(), [&](Module *mod) {
+			OptDffWorker worker(opt, ct, mod);
+			bool changed_module = worker.run();
 			if (worker.run_constbits())
+				changed_module = true;
+			if (changed_module) {
+				// count changes made through public members too, for opt -dirty
+				mod->change_count_++;
 				did_something = true;
-		}
+			}
+		});
 
 		if (did_something)
 			design->scratchpad_set_bool("opt.did_something", true);
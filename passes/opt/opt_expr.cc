@@ -29,7 +29,8 @@
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-bool did_something;
+// per thread, for modules optimized in parallel
+thread_local bool did_something;
 
 void replace_undriven(RTLIL::Module *module, const CellTypes &ct)
 {
@@ -2304,15 +2305,17 @@ struct OptExprPass : public Pass {
 		extra_args(args, argidx, design);
 
 		CellTypes ct(design);
-		for (auto module : design->selected_modules())
+		std::atomic<bool> changed_design(false);
+		parallel_for_modules(design, design->selected_modules(), [&](RTLIL::Module *module)
 		{
 			log("Optimizing module %s.\n", log_id(module));
+			bool changed_module = false;
 
 			if (undriven) {
 				did_something = false;
 				replace_undriven(module, ct);
 				if (did_something)
-					design->scratchpad_set_bool("opt.did_something", true);
+					changed_module = true;
 			}
 
 			do {
@@ -2320,21 +2323,31 @@ struct OptExprPass : public Pass {
 					did_something = false;
 					replace_const_cells(design, module, false /* consume_x */, mux_undef, mux_bool, do_fine, keepdc, noclkinv);
 					if (did_something)
-						design->scratchpad_set_bool("opt.did_something", true);
+						changed_module = true;
 				} while (did_something);
 				if (!keepdc)
 					replace_const_cells(design, module, true /* consume_x */, mux_undef, mux_bool, do_fine, keepdc, noclkinv);
 				if (did_something)
-					design->scratchpad_set_bool("opt.did_something", true);
+					changed_module = true;
 			} while (did_something);
 
 			did_something = false;
 			replace_const_connections(module);
 			if (did_something)
-				design->scratchpad_set_bool("opt.did_something", true);
+				changed_module = true;
+
+			// cells were also changed through their public members, which
+			// the change counter does not see (opt -dirty relies on it)
+			if (changed_module) {
+				module->change_count_++;
+				changed_design = true;
+			}
 
 			log_suppressed();
-		}
+		});
+
+		if (changed_design)
+			design->scratchpad_set_bool("opt.did_something", true);
 
 		log_pop();
 	}
@@ -38,7 +38,7 @@ struct OptLutWorker
 {
 	const std::vector<dlogic_t> &dlogic;
 	RTLIL::Module *module;
-	ModIndex index;
+	ModIndex &index;
 	SigMap sigmap;
 
 	pool<RTLIL::Cell*> luts;
@@ -104,7 +104,7 @@ struct OptLutWorker
 	}
 
 	OptLutWorker(const std::vector<dlogic_t> &dlogic, RTLIL::Module *module, int limit) :
-		dlogic(dlogic), module(module), index(module), sigmap(module)
+		dlogic(dlogic), module(module), index(module->design->modindex(module)), sigmap(module)
 	{
 		log("Discovering LUTs.\n");
 		for (auto cell : module->selected_cells())
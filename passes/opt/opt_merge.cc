@@ -65,90 +65,126 @@ struct OptMergeWorker
 		}
 	}
 
-	std::string int_to_hash_string(unsigned int v)
+	// The hash only groups candidate cells, which are then compared with
+	// compare_cell_parameters_and_connections(). It is 64 bits wide because
+	// a collision between non-identical cells prevents merging the second one.
+
+	static inline uint64_t hash_mix(uint64_t h)
 	{
-		if (v == 0)
-			return "0";
-		std::string str = "";
-		while (v > 0) {
-			str += 'a' + (v & 15);
-			v = v >> 4;
-		}
-		return str;
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
 	}
 
-        uint64_t hash_cell_parameters_and_connections(const RTLIL::Cell *cell)
+	static inline uint64_t hash_add(uint64_t h, uint64_t v)
 	{
-		vector<string> hash_conn_strings;
-		std::string hash_string = cell->type.str() + "\n";
-
-		const dict<RTLIL::IdString, RTLIL::SigSpec> *conn = &cell->connections();
-		dict<RTLIL::IdString, RTLIL::SigSpec> alt_conn;
-
-		if (cell->type.in(ID($and), ID($or), ID($xor), ID($xnor), ID($add), ID($mul),
-				ID($logic_and), ID($logic_or), ID($_AND_), ID($_OR_), ID($_XOR_))) {
-			alt_conn = *conn;
-			if (assign_map(alt_conn.at(ID::A)) < assign_map(alt_conn.at(ID::B))) {
-				alt_conn[ID::A] = conn->at(ID::B);
-				alt_conn[ID::B] = conn->at(ID::A);
-			}
-			conn = &alt_conn;
-		} else
-		if (cell->type.in(ID($reduce_xor), ID($reduce_xnor))) {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at(ID::A));
-			alt_conn.at(ID::A).sort();
-			conn = &alt_conn;
-		} else
-		if (cell->type.in(ID($reduce_and), ID($reduce_or), ID($reduce_bool))) {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at(ID::A));
-			alt_conn.at(ID::A).sort_and_unify();
-			conn = &alt_conn;
-		} else
-		if (cell->type == ID($pmux)) {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at(ID::A));
-			assign_map.apply(alt_conn.at(ID::B));
-			assign_map.apply(alt_conn.at(ID::S));
-			sort_pmux_conn(alt_conn);
-			conn = &alt_conn;
-		}
+		return hash_mix(h ^ (v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2)));
+	}
+
+	static inline uint64_t hash_bit(const RTLIL::SigBit &bit)
+	{
+		if (bit.wire != nullptr)
+			return hash_mix((uint64_t(bit.wire->hash()) << 32) | uint32_t(bit.offset));
+		return hash_mix(~uint64_t(bit.data));
+	}
+
+	uint64_t hash_sig(const RTLIL::SigSpec &sig)
+	{
+		uint64_t h = GetSize(sig);
+		for (auto bit : sig)
+			h = hash_add(h, hash_bit(assign_map(bit)));
+		return h;
+	}
+
+	static uint64_t hash_const(const RTLIL::Const &value)
+	{
+		uint64_t h = value.size();
+		for (auto bit : value)
+			h = hash_add(h, bit);
+		return h;
+	}
 
-		for (auto &it : *conn) {
-			RTLIL::SigSpec sig;
+	uint64_t hash_cell_parameters_and_connections(const RTLIL::Cell *cell)
+	{
+		// Ports and parameters are combined with a sum, since cells with the
+		// same connections and parameters may store them in a different order.
+		uint64_t hash_conn = 0;
+
+		bool commutative = cell->type.in(ID($and), ID($or), ID($xor), ID($xnor), ID($add), ID($mul),
+				ID($logic_and), ID($logic_or), ID($_AND_), ID($_OR_), ID($_XOR_));
+
+		for (auto &it : cell->connections()) {
+			uint64_t h;
 			if (cell->output(it.first)) {
 				if (it.first == ID::Q && RTLIL::builtin_ff_cell_types().count(cell->type)) {
 					// For the 'Q' output of state elements,
 					//   use its (* init *) attribute value
-					sig = initvals(it.second);
+					h = hash_const(initvals(it.second));
 				}
 				else
 					continue;
 			}
-			else
-				sig = assign_map(it.second);
-			string s = "C " + it.first.str() + "=";
-			for (auto &chunk : sig.chunks()) {
-				if (chunk.wire)
-					s += "{" + chunk.wire->name.str() + " " +
-							int_to_hash_string(chunk.offset) + " " +
-							int_to_hash_string(chunk.width) + "}";
-				else
-					s += RTLIL::Const(chunk.data).as_string();
+			else if (commutative && (it.first == ID::A || it.first == ID::B)) {
+				// A and B may be swapped, handled below
+				continue;
+			}
+			else if (it.first == ID::A && cell->type.in(ID($reduce_xor), ID($reduce_xnor))) {
+				// the order of the bits does not matter, their number does
+				h = 0;
+				for (auto bit : it.second)
+					h += hash_bit(assign_map(bit));
+			}
+			else if (it.first == ID::A && cell->type.in(ID($reduce_and), ID($reduce_or), ID($reduce_bool))) {
+				// neither the order nor the number of copies of a bit matters
+				std::vector<uint64_t> bits;
+				bits.reserve(GetSize(it.second));
+				for (auto bit : it.second)
+					bits.push_back(hash_bit(assign_map(bit)));
+				std::sort(bits.begin(), bits.end());
+				bits.erase(std::unique(bits.begin(), bits.end()), bits.end());
+				h = 0;
+				for (auto bit_hash : bits)
+					h += bit_hash;
+			}
+			else if ((it.first == ID::B || it.first == ID::S) && cell->type == ID($pmux)) {
+				// the order of the (S, B) pairs does not matter, handled below
+				continue;
 			}
-			hash_conn_strings.push_back(s + "\n");
+			else
+				h = hash_sig(it.second);
+			hash_conn += hash_add(it.first.index_, h);
 		}
 
-		for (auto &it : cell->parameters)
-			hash_conn_strings.push_back("P " + it.first.str() + "=" + it.second.as_string() + "\n");
+		if (commutative) {
+			uint64_t h_a = hash_sig(cell->getPort(ID::A));
+			uint64_t h_b = hash_sig(cell->getPort(ID::B));
+			hash_conn += hash_add(ID::A.index_, std::max(h_a, h_b));
+			hash_conn += hash_add(ID::B.index_, std::min(h_a, h_b));
+		}
 
-		std::sort(hash_conn_strings.begin(), hash_conn_strings.end());
+		if (cell->type == ID($pmux)) {
+			const RTLIL::SigSpec &sig_s = cell->getPort(ID::S);
+			const RTLIL::SigSpec &sig_b = cell->getPort(ID::B);
+			int s_width = GetSize(sig_s);
+			int width = s_width ? GetSize(sig_b) / s_width : 0;
+			uint64_t h = 0;
+			for (int i = 0; i < s_width; i++) {
+				uint64_t h_case = hash_bit(assign_map(sig_s[i]));
+				for (int j = 0; j < width; j++)
+					h_case = hash_add(h_case, hash_bit(assign_map(sig_b[i*width + j])));
+				h += hash_mix(h_case);
+			}
+			hash_conn += hash_add(ID::S.index_, h);
+		}
 
-		for (auto it : hash_conn_strings)
-			hash_string += it;
+		uint64_t hash_param = 0;
+		for (auto &it : cell->parameters)
+			hash_param += hash_add(it.first.index_, hash_const(it.second));
 
-		return std::hash<std::string>{}(hash_string);
+		return hash_add(hash_add(cell->type.index_, hash_conn), hash_param);
 	}
 
 	bool compare_cell_parameters_and_connections(const RTLIL::Cell *cell1, const RTLIL::Cell *cell2)
@@ -235,16 +271,16 @@ struct OptMergeWorker
 		ct.setup_stdcells_mem();
 
 		if (mode_nomux) {
-			ct.cell_types.erase(ID($mux));
-			ct.cell_types.erase(ID($pmux));
+			ct.erase_type(ID($mux));
+			ct.erase_type(ID($pmux));
 		}
 
-		ct.cell_types.erase(ID($tribuf));
-		ct.cell_types.erase(ID($_TBUF_));
-		ct.cell_types.erase(ID($anyseq));
-		ct.cell_types.erase(ID($anyconst));
-		ct.cell_types.erase(ID($allseq));
-		ct.cell_types.erase(ID($allconst));
+		ct.erase_type(ID($tribuf));
+		ct.erase_type(ID($_TBUF_));
+		ct.erase_type(ID($anyseq));
+		ct.erase_type(ID($anyconst));
+		ct.erase_type(ID($allseq));
+		ct.erase_type(ID($allconst));
 
 		log("Finding identical cells in module `%s'.\n", module->name.c_str());
 		assign_map.set(module);
@@ -361,15 +397,18 @@ struct OptMergePass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
-		int total_count = 0;
-		for (auto module : design->selected_modules()) {
+		std::atomic<int> total_count(0);
+		parallel_for_modules(design, design->selected_modules(), [&](RTLIL::Module *module) {
 			OptMergeWorker worker(design, module, mode_nomux, mode_share_all, mode_keepdc);
 			total_count += worker.total_count;
-		}
+			// count changes made through public members too, for opt -dirty
+			if (worker.total_count)
+				module->change_count_++;
+		});
 
 		if (total_count)
 			design->scratchpad_set_bool("opt.did_something", true);
-		log("Removed a total of %d cells.\n", total_count);
+		log("Removed a total of %d cells.\n", total_count.load());
 	}
 } OptMergePass;
 
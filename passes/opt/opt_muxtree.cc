@@ -496,6 +496,9 @@ struct OptMuxtreePass : public Pass {
 				continue;
 			OptMuxtreeWorker worker(design, module);
 			total_count += worker.removed_count;
+			// count changes made through public members too, for opt -dirty
+			if (worker.removed_count)
+				module->change_count_++;
 		}
 		if (total_count)
 			design->scratchpad_set_bool("opt.did_something", true);
@@ -655,6 +655,8 @@ struct OptReducePass : public Pass {
 				total_count += worker.total_count;
 				if (worker.total_count == 0)
 					break;
+				// count changes made through public members too, for opt -dirty
+				module->change_count_++;
 			}
 
 		if (total_count)
@@ -1072,7 +1072,7 @@ struct ShareWorker
 		ct.setup_internals();
 		ct.setup_stdcells();
 
-		ModIndex mi(module);
+		ModIndex &mi = module->design->modindex(module);
 
 		pool<RTLIL::Cell*> queue, covered;
 		queue.insert(cell);
@@ -1131,16 +1131,16 @@ struct ShareWorker
 		fwd_ct.setup_internals();
 
 		cone_ct.setup_internals();
-		cone_ct.cell_types.erase(ID($mul));
-		cone_ct.cell_types.erase(ID($mod));
-		cone_ct.cell_types.erase(ID($div));
-		cone_ct.cell_types.erase(ID($modfloor));
-		cone_ct.cell_types.erase(ID($divfloor));
-		cone_ct.cell_types.erase(ID($pow));
-		cone_ct.cell_types.erase(ID($shl));
-		cone_ct.cell_types.erase(ID($shr));
-		cone_ct.cell_types.erase(ID($sshl));
-		cone_ct.cell_types.erase(ID($sshr));
+		cone_ct.erase_type(ID($mul));
+		cone_ct.erase_type(ID($mod));
+		cone_ct.erase_type(ID($div));
+		cone_ct.erase_type(ID($modfloor));
+		cone_ct.erase_type(ID($divfloor));
+		cone_ct.erase_type(ID($pow));
+		cone_ct.erase_type(ID($shl));
+		cone_ct.erase_type(ID($shr));
+		cone_ct.erase_type(ID($sshl));
+		cone_ct.erase_type(ID($sshr));
 	}
 
 	void operator()(RTLIL::Module *module) {
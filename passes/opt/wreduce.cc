@@ -51,7 +51,7 @@ struct WreduceWorker
 {
 	WreduceConfig *config;
 	Module *module;
-	ModIndex mi;
+	ModIndex &mi;
 
 	std::set<Cell*, IdString::compare_ptr_by_name<Cell>> work_queue_cells;
 	std::set<SigBit> work_queue_bits;
@@ -59,7 +59,7 @@ struct WreduceWorker
 	FfInitVals initvals;
 
 	WreduceWorker(WreduceConfig *config, Module *module) :
-			config(config), module(module), mi(module) { }
+			config(config), module(module), mi(module->design->modindex(module)) { }
 
 	void run_cell_mux(Cell *cell)
 	{
@@ -518,10 +518,10 @@ struct WreducePass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
-		for (auto module : design->selected_modules())
+		parallel_for_modules(design, design->selected_modules(), [&](Module *module)
 		{
 			if (module->has_processes_warn())
-				continue;
+				return;
 
 			for (auto c : module->selected_cells())
 			{
@@ -592,7 +592,7 @@ struct WreducePass : public Pass {
 
 			WreduceWorker worker(&config, module);
 			worker.run();
-		}
+		});
 	}
 } WreducePass;
 
@@ -311,8 +311,11 @@ struct Ice40DspPass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
-		for (auto module : design->selected_modules())
+		for (auto module : design->selected_modules()) {
 			ice40_dsp_pm(module, module->selected_cells()).run_ice40_dsp(create_ice40_dsp);
+			// create_ice40_dsp() edits the port of a register in place
+			module->blackout();
+		}
 	}
 } Ice40DspPass;
 
@@ -355,6 +355,8 @@ struct MicrochipDspPass : public Pass {
 				microchip_dsp_cascade_pm pm(module, module->selected_cells());
 				pm.run_microchip_dsp_cascade();
 			}
+			// the packers edit some cell ports in place
+			module->blackout();
 		}
 	}
 } MicrochipDspPass;
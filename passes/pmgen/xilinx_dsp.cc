@@ -829,6 +829,8 @@ struct XilinxDspPass : public Pass {
 				xilinx_dsp_cascade_pm pm(module, module->selected_cells());
 				pm.run_xilinx_dsp_cascade();
 			}
+			// the packers edit some cell ports in place
+			module->blackout();
 		}
 	}
 } XilinxDspPass;
@@ -19,6 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/sigtools.h"
+#include "kernel/bitindex.h"
 #include "kernel/celltypes.h"
 #include "kernel/mem.h"
 #include "kernel/fstdata.h"
@@ -26,6 +27,9 @@
 #include "kernel/yw.h"
 #include "kernel/json.h"
 #include "kernel/fmt.h"
+#include "kernel/threading.h"
+#include "backends/rtlil/rtlil_binary.h"
+#include "passes/sat/simlanes.h"
 
 #include <ctime>
 
@@ -73,18 +77,148 @@ struct OutputWriter
 {
 	OutputWriter(SimWorker *w) { worker = w;};
 	virtual ~OutputWriter() {};
-	virtual void write(std::map<int, bool> &use_signal) = 0;
+	// write_header() is called once, on the simulation thread, and then
+	// write_step() for each output step in time order, possibly on the
+	// output thread
+	virtual void write_header(std::map<int, bool> &use_signal) = 0;
+	virtual void write_step(int time, const std::map<int, Const> &data) = 0;
 	SimWorker *worker;
 };
 
+// Runs the output writers on a background thread, so that formatting and
+// compressing the waveforms overlaps with the simulation. Steps are handed to
+// the thread in batches of about batch_size bits of values, and the simulation
+// thread blocks while more than max_backlog bits are waiting to be written.
+struct OutputThread
+{
+	static constexpr size_t batch_size = 1 << 20;
+	static constexpr size_t max_backlog = 64 << 20;
+
+	std::vector<std::unique_ptr<OutputWriter>> &writers;
+#ifdef YOSYS_ENABLE_THREADS
+	struct Step {
+		int time;
+		size_t size;
+		std::map<int, Const> data;
+	};
+
+	std::mutex mutex;
+	std::condition_variable queued_cond, written_cond;
+	std::vector<Step> queue;
+	// bits queued but not picked up by the thread, and queued but not written
+	size_t queued = 0, backlog = 0;
+	bool stopping = false;
+	std::exception_ptr error;
+	std::thread thread;
+#endif
+
+	OutputThread(std::vector<std::unique_ptr<OutputWriter>> &writers) : writers(writers)
+	{
+#ifdef YOSYS_ENABLE_THREADS
+		thread = std::thread([this]{ run(); });
+#endif
+	}
+
+	~OutputThread()
+	{
+		stop();
+	}
+
+	void push(int time, std::map<int, Const> &&data)
+	{
+#ifdef YOSYS_ENABLE_THREADS
+		size_t size = 0;
+		for (auto &it : data)
+			size += GetSize(it.second) + 16;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		if (backlog > max_backlog)
+			written_cond.wait(lock, [&]{ return backlog <= max_backlog / 2 || error; });
+		if (error)
+			return;
+		queue.push_back({time, size, std::move(data)});
+		queued += size;
+		backlog += size;
+		if (queued >= batch_size)
+			queued_cond.notify_one();
+#else
+		for (auto &writer : writers)
+			writer->write_step(time, data);
+#endif
+	}
+
+	// waits until all queued steps are written and stops the thread
+	void stop()
+	{
+#ifdef YOSYS_ENABLE_THREADS
+		if (!thread.joinable())
+			return;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			stopping = true;
+			queued_cond.notify_one();
+		}
+		thread.join();
+#endif
+	}
+
+	// like stop(), but passes on an exception thrown by a writer
+	void finish()
+	{
+		stop();
+#ifdef YOSYS_ENABLE_THREADS
+		if (error)
+			std::rethrow_exception(error);
+#endif
+	}
+
+#ifdef YOSYS_ENABLE_THREADS
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			queued_cond.wait(lock, [&]{ return stopping || queued >= batch_size; });
+			if (queue.empty())
+				break;
+
+			std::vector<Step> batch;
+			batch.swap(queue);
+			queued = 0;
+			lock.unlock();
+
+			size_t written = 0;
+			try {
+				for (auto &step : batch) {
+					for (auto &writer : writers)
+						writer->write_step(step.time, step.data);
+					written += step.size;
+				}
+			} catch (...) {
+				lock.lock();
+				error = std::current_exception();
+				written_cond.notify_all();
+				break;
+			}
+			batch.clear();
+
+			lock.lock();
+			backlog -= written;
+			written_cond.notify_all();
+		}
+	}
+#endif
+};
+
 struct SimInstance;
 struct TriggeredAssertion {
 	int step;
 	SimInstance *instance;
 	Cell *cell;
+	int lane;
 
-	TriggeredAssertion(int step, SimInstance *instance, Cell *cell) :
-		step(step), instance(instance), cell(cell)
+	TriggeredAssertion(int step, SimInstance *instance, Cell *cell, int lane = -1) :
+		step(step), instance(instance), cell(cell), lane(lane)
 	{ }
 };
 
@@ -99,6 +233,303 @@ struct DisplayOutput {
 	{ }
 };
 
+static inline State sim_not(State a)
+{
+	// as CellTypes::eval_not, values other than 0 and 1 are kept
+	return a == State::S0 ? State::S1 : a == State::S1 ? State::S0 : a;
+}
+
+static inline State sim_bitnot(State a)
+{
+	return a == State::S0 ? State::S1 : a == State::S1 ? State::S0 : State::Sx;
+}
+
+static inline State sim_and(State a, State b)
+{
+	if (a == State::S0 || b == State::S0) return State::S0;
+	return a == State::S1 && b == State::S1 ? State::S1 : State::Sx;
+}
+
+static inline State sim_or(State a, State b)
+{
+	if (a == State::S1 || b == State::S1) return State::S1;
+	return a == State::S0 && b == State::S0 ? State::S0 : State::Sx;
+}
+
+static inline State sim_xor(State a, State b)
+{
+	if ((a != State::S0 && a != State::S1) || (b != State::S0 && b != State::S1)) return State::Sx;
+	return a != b ? State::S1 : State::S0;
+}
+
+// The instance-independent part of a simulated module, compiled once and
+// shared by all instances of the module. Every bit is numbered by a BitIndex
+// and mapped to the number of its sigmap representative, so an instance keeps
+// its state in one flat vector. The cells evaluated in update_ph1 are sorted
+// by level (i.e. after the cells driving their inputs) and get an evaluation
+// kernel by cell type, falling back to CellTypes::eval.
+struct SimModule
+{
+	enum kernel_t {
+		K_MEMORY,
+		K_CHILD,
+		K_BUF,
+		K_NOT,
+		K_BITNOT,
+		K_AND,
+		K_NAND,
+		K_OR,
+		K_NOR,
+		K_XOR,
+		K_XNOR,
+		K_ANDNOT,
+		K_ORNOT,
+		K_MUX,
+		K_EVAL_AB,
+		K_EVAL_ABC,
+		K_EVAL_AS,
+		K_EVAL_ABS,
+		K_EVAL_UNSUPPORTED,
+		K_UNSUPPORTED,
+	};
+
+	struct cell_t
+	{
+		Cell *cell;
+		kernel_t kernel;
+		int level;
+		IdString memid;
+		std::vector<int> a, b, c, s, y;
+	};
+
+	Module *module;
+	BitIndex index;
+	std::vector<int> nets;
+
+	std::vector<cell_t> cells;
+	int num_levels = 0;
+
+	// cells reading each net
+	std::vector<int> reader_offsets, readers;
+
+	// output ports driven by each net
+	std::vector<Wire*> outports;
+	std::vector<int> outport_offsets, outport_indices;
+
+	int net(const SigBit &bit) const
+	{
+		return nets[index(bit)];
+	}
+
+	std::vector<int> port_nets(Cell *cell, IdString port) const
+	{
+		std::vector<int> result;
+		if (cell->hasPort(port))
+			for (auto bit : cell->getPort(port))
+				result.push_back(net(bit));
+		return result;
+	}
+
+	static kernel_t eval_kernel(Cell *cell)
+	{
+		bool has_a = cell->hasPort(ID::A);
+		bool has_b = cell->hasPort(ID::B);
+		bool has_c = cell->hasPort(ID::C);
+		bool has_d = cell->hasPort(ID::D);
+		bool has_s = cell->hasPort(ID::S);
+		bool has_y = cell->hasPort(ID::Y);
+
+		// same port patterns as supported by CellTypes::eval
+		kernel_t generic;
+		if (has_a && !has_c && !has_d && !has_s && has_y)
+			generic = K_EVAL_AB;
+		else if (has_a && has_b && has_c && !has_d && !has_s && has_y)
+			generic = K_EVAL_ABC;
+		else if (has_a && !has_b && !has_c && !has_d && has_s && has_y)
+			generic = K_EVAL_AS;
+		else if (has_a && has_b && !has_c && !has_d && has_s && has_y)
+			generic = K_EVAL_ABS;
+		else
+			return K_EVAL_UNSUPPORTED;
+
+		// bitwise kernels, where no operand is extended
+		int width = GetSize(cell->getPort(ID::Y));
+		if (GetSize(cell->getPort(ID::A)) != width || (has_b && GetSize(cell->getPort(ID::B)) != width))
+			return generic;
+
+		if (generic == K_EVAL_AB && !has_b) {
+			if (cell->type.in(ID($_BUF_), ID($buf), ID($pos)))
+				return K_BUF;
+			if (cell->type == ID($_NOT_))
+				return K_NOT;
+			if (cell->type == ID($not))
+				return K_BITNOT;
+		}
+
+		if (generic == K_EVAL_AB && has_b) {
+			if (cell->type.in(ID($_AND_), ID($and)))
+				return K_AND;
+			if (cell->type == ID($_NAND_))
+				return K_NAND;
+			if (cell->type.in(ID($_OR_), ID($or)))
+				return K_OR;
+			if (cell->type == ID($_NOR_))
+				return K_NOR;
+			if (cell->type.in(ID($_XOR_), ID($xor)))
+				return K_XOR;
+			if (cell->type.in(ID($_XNOR_), ID($xnor)))
+				return K_XNOR;
+			if (cell->type == ID($_ANDNOT_))
+				return K_ANDNOT;
+			if (cell->type == ID($_ORNOT_))
+				return K_ORNOT;
+		}
+
+		if (generic == K_EVAL_ABS && cell->type.in(ID($mux), ID($_MUX_)) && GetSize(cell->getPort(ID::S)) == 1)
+			return K_MUX;
+
+		return generic;
+	}
+
+	SimModule(Module *module) : module(module), index(module)
+	{
+		DenseSigMap sigmap;
+		sigmap.set(module, index);
+		nets.resize(index.size());
+		for (int i = 0; i < index.size(); i++)
+			nets[i] = sigmap.ifind(i);
+
+		std::vector<std::vector<int>> inputs;
+
+		for (auto cell : module->cells())
+		{
+			// state and checks are handled in update_ph2 and update_ph3
+			if (RTLIL::builtin_ff_cell_types().count(cell->type) || cell->type.in(ID($anyinit),
+					ID($assert), ID($cover), ID($assume), ID($print)))
+				continue;
+
+			std::vector<int> cell_inputs;
+			for (auto &conn : cell->connections())
+				if (cell->input(conn.first))
+					for (auto bit : conn.second)
+						cell_inputs.push_back(net(bit));
+			if (cell_inputs.empty())
+				continue;
+			std::sort(cell_inputs.begin(), cell_inputs.end());
+			cell_inputs.erase(std::unique(cell_inputs.begin(), cell_inputs.end()), cell_inputs.end());
+
+			cell_t c;
+			c.cell = cell;
+			c.level = 0;
+			if (cell->is_mem_cell()) {
+				c.kernel = K_MEMORY;
+				c.memid = cell->parameters.at(ID::MEMID).decode_string();
+			} else if (module->design->module(cell->type) != nullptr)
+				c.kernel = K_CHILD;
+			else if (yosys_celltypes.cell_evaluable(cell->type))
+				c.kernel = eval_kernel(cell);
+			else
+				c.kernel = K_UNSUPPORTED;
+
+			if (c.kernel >= K_BUF && c.kernel <= K_EVAL_ABS) {
+				c.a = port_nets(cell, ID::A);
+				c.b = port_nets(cell, ID::B);
+				c.c = port_nets(cell, ID::C);
+				c.s = port_nets(cell, ID::S);
+				c.y = port_nets(cell, ID::Y);
+			}
+
+			cells.push_back(c);
+			inputs.push_back(std::move(cell_inputs));
+		}
+
+		// levelize with Kahn's algorithm
+		int num_cells = GetSize(cells);
+		std::vector<int> driver(index.size(), -1);
+		for (int i = 0; i < num_cells; i++)
+			for (int n : cells[i].y)
+				driver[n] = i;
+
+		std::vector<std::vector<int>> fanout(num_cells);
+		std::vector<int> num_pending(num_cells);
+		for (int i = 0; i < num_cells; i++)
+			for (int n : inputs[i])
+				if (driver[n] >= 0) {
+					fanout[driver[n]].push_back(i);
+					num_pending[i]++;
+				}
+
+		std::vector<int> order;
+		for (int i = 0; i < num_cells; i++)
+			if (num_pending[i] == 0)
+				order.push_back(i);
+		for (int k = 0; k < GetSize(order); k++)
+			for (int j : fanout[order[k]]) {
+				cells[j].level = std::max(cells[j].level, cells[order[k]].level + 1);
+				if (--num_pending[j] == 0)
+					order.push_back(j);
+			}
+
+		// cells on combinational loops go last, and are evaluated again
+		// from update_ph1 until the loop settles
+		int max_level = 0;
+		for (auto &c : cells)
+			max_level = std::max(max_level, c.level);
+		for (int i = 0; i < num_cells; i++)
+			if (num_pending[i] > 0) {
+				cells[i].level = max_level + 1;
+				order.push_back(i);
+			}
+		num_levels = num_cells ? max_level + 2 : 0;
+
+		std::stable_sort(order.begin(), order.end(), [&](int i, int j) { return cells[i].level < cells[j].level; });
+
+		std::vector<cell_t> sorted_cells;
+		std::vector<std::vector<int>> sorted_inputs;
+		for (int i : order) {
+			sorted_cells.push_back(std::move(cells[i]));
+			sorted_inputs.push_back(std::move(inputs[i]));
+		}
+		cells.swap(sorted_cells);
+
+		reader_offsets.assign(index.size() + 1, 0);
+		for (int k = 0; k < num_cells; k++)
+			for (int n : sorted_inputs[k])
+				if (n >= BitIndex::num_const_bits)
+					reader_offsets[n + 1]++;
+		for (int n = 0; n < index.size(); n++)
+			reader_offsets[n + 1] += reader_offsets[n];
+		readers.resize(reader_offsets.back());
+		std::vector<int> fill(reader_offsets.begin(), reader_offsets.end() - 1);
+		for (int k = 0; k < num_cells; k++)
+			for (int n : sorted_inputs[k])
+				if (n >= BitIndex::num_const_bits)
+					readers[fill[n]++] = k;
+
+		std::vector<std::pair<int, int>> outport_list;
+		for (auto wire : module->wires())
+			if (wire->port_output) {
+				std::vector<int> wire_nets;
+				for (auto bit : SigSpec(wire))
+					if (net(bit) >= BitIndex::num_const_bits)
+						wire_nets.push_back(net(bit));
+				std::sort(wire_nets.begin(), wire_nets.end());
+				wire_nets.erase(std::unique(wire_nets.begin(), wire_nets.end()), wire_nets.end());
+				for (int n : wire_nets)
+					outport_list.emplace_back(n, GetSize(outports));
+				outports.push_back(wire);
+			}
+		std::sort(outport_list.begin(), outport_list.end());
+		outport_offsets.assign(index.size() + 1, 0);
+		for (auto &it : outport_list) {
+			outport_offsets[it.first + 1]++;
+			outport_indices.push_back(it.second);
+		}
+		for (int n = 0; n < index.size(); n++)
+			outport_offsets[n + 1] += outport_offsets[n];
+	}
+};
+
 struct SimShared
 {
 	bool debug = false;
@@ -115,6 +546,7 @@ struct SimShared
 	bool cycles_set = false;
 	std::vector<std::unique_ptr<OutputWriter>> outputfiles;
 	std::vector<std::pair<int,std::map<int,Const>>> output_data;
+	std::unique_ptr<OutputThread> output_thread;
 	bool ignore_x = false;
 	bool date = false;
 	bool multiclock = false;
@@ -125,6 +557,15 @@ struct SimShared
 	bool serious_asserts = false;
 	bool fst_noinit = false;
 	bool initstate = true;
+	std::map<Module*, std::unique_ptr<SimModule>> compiled_modules;
+
+	const SimModule *compile(Module *module)
+	{
+		auto &compiled = compiled_modules[module];
+		if (compiled == nullptr)
+			compiled.reset(new SimModule(module));
+		return compiled.get();
+	}
 };
 
 void zinit(State &v)
@@ -139,6 +580,93 @@ void zinit(Const &v)
 		zinit(bit);
 }
 
+// Checkpoints written by `sim -checkpoint-every' and read by `sim -restore'
+// use the integer and state encodings of binary RTLIL:
+//
+//   header     magic, u32 version
+//   position   varint mode (0: sim, 1: -r replay), varint cycle, varint time,
+//              varint step
+//   instances  the state of the top instance, followed by its children, see
+//              SimInstance::write_checkpoint()
+//   results    the triggered assertions and $print outputs so far
+//
+// Cells, memories and child instances are identified by name and the net
+// states are stored in the order of the compiled modules, so a checkpoint
+// can only be restored into the design it was written for.
+static const char checkpoint_magic[8] = { '\x89', 'Y', 'S', 'I', 'M', 'C', 'K', '\n' };
+static const uint32_t checkpoint_version = 1;
+
+static void checkpoint_string(RTLIL_BINARY::Encoder &enc, const std::string &str)
+{
+	enc.varint(str.size());
+	enc.bytes(str.data(), str.size());
+}
+
+static std::string checkpoint_string(RTLIL_BINARY::Decoder &dec)
+{
+	size_t size = dec.count();
+	return std::string(reinterpret_cast<const char*>(dec.bytes(size)), size);
+}
+
+static void checkpoint_states(RTLIL_BINARY::Encoder &enc, const State *bits, int width)
+{
+	bool wide = false;
+	for (int i = 0; i < width; i++)
+		if (bits[i] > State::Sz)
+			wide = true;
+
+	int per_byte = wide ? 2 : 4;
+	enc.u8(wide ? RTLIL_BINARY::ENC_4BIT : RTLIL_BINARY::ENC_2BIT);
+	enc.varint(width);
+	for (int i = 0; i < width; i += per_byte) {
+		uint8_t byte = 0;
+		for (int j = 0; j < per_byte && i + j < width; j++)
+			byte |= uint8_t(bits[i + j]) << ((8 / per_byte) * j);
+		enc.u8(byte);
+	}
+}
+
+static std::vector<State> checkpoint_states(RTLIL_BINARY::Decoder &dec)
+{
+	uint8_t encoding = dec.u8();
+	if (encoding != RTLIL_BINARY::ENC_2BIT && encoding != RTLIL_BINARY::ENC_4BIT)
+		dec.corrupt();
+	int per_byte = encoding == RTLIL_BINARY::ENC_4BIT ? 2 : 4;
+	int bits_per_state = 8 / per_byte;
+	uint64_t width = dec.varint();
+	if (width > uint64_t(dec.end - dec.p) * per_byte)
+		dec.corrupt();
+	const unsigned char *p = dec.bytes((width + per_byte - 1) / per_byte);
+
+	std::vector<State> bits(width);
+	for (size_t i = 0; i < width; i++) {
+		int state = (p[i / per_byte] >> (bits_per_state * (i % per_byte))) & ((1 << bits_per_state) - 1);
+		if (state > State::Sm)
+			dec.corrupt();
+		bits[i] = State(state);
+	}
+	return bits;
+}
+
+static void checkpoint_const(RTLIL_BINARY::Encoder &enc, const Const &value)
+{
+	std::vector<State> bits = value.to_bits();
+	checkpoint_states(enc, bits.data(), GetSize(bits));
+}
+
+static Const checkpoint_const(RTLIL_BINARY::Decoder &dec)
+{
+	return Const(checkpoint_states(dec));
+}
+
+static State checkpoint_state(RTLIL_BINARY::Decoder &dec)
+{
+	uint8_t state = dec.u8();
+	if (state > State::Sm)
+		dec.corrupt();
+	return State(state);
+}
+
 struct SimInstance
 {
 	SimShared *shared;
@@ -151,15 +679,21 @@ struct SimInstance
 	dict<Cell*, SimInstance*> children;
 
 	SigMap sigmap;
-	dict<SigBit, State> state_nets;
-	dict<SigBit, pool<Cell*>> upd_cells;
-	dict<SigBit, pool<Wire*>> upd_outports;
+	const SimModule *compiled;
+	std::vector<State> state_nets;
 
 	dict<SigBit, SigBit> in_parent_drivers;
 	dict<SigBit, SigBit> clk2fflogic_drivers;
 
-	pool<SigBit> dirty_bits;
-	pool<Cell*> dirty_cells;
+	// cells waiting for evaluation, bucketed by level
+	std::vector<std::vector<int>> queued_cells;
+	std::vector<bool> cell_queued;
+	int num_queued_cells = 0;
+	int first_queued_level = 0;
+
+	std::vector<int> queued_outports;
+	std::vector<bool> outport_queued;
+
 	pool<IdString> dirty_memories;
 	pool<SimInstance*, hash_ptr_ops> dirty_children;
 
@@ -182,6 +716,8 @@ struct SimInstance
 		std::vector<Const> past_wr_addr;
 		std::vector<Const> past_wr_data;
 		Const data;
+		// contents at the checkpoint the simulation was restored from
+		Const restored_data;
 	};
 
 	struct print_state_t
@@ -215,7 +751,6 @@ struct SimInstance
 	dict<IdString, mem_state_t> mem_database;
 	pool<Cell*> formal_database;
 	pool<Cell*> initstate_database;
-	dict<Cell*, IdString> mem_cells;
 	std::vector<print_state_t> print_database;
 
 	std::vector<Mem> memories;
@@ -245,19 +780,28 @@ struct SimInstance
 			parent->children[instance] = this;
 		}
 
+		compiled = shared->compile(module);
+		state_nets.assign(compiled->index.size(), State::Sx);
+		for (int i = 0; i < BitIndex::num_const_bits; i++)
+			state_nets[i] = State(i);
+
+		queued_cells.resize(compiled->num_levels);
+		cell_queued.assign(GetSize(compiled->cells), false);
+		// Evaluate all cells in the first cycle, including those with
+		// inputs that never change from their initial value
+		for (int k = 0; k < GetSize(compiled->cells); k++)
+			queue_cell(k);
+
+		// Output ports are propagated to the parent in the first cycle
+		outport_queued.assign(GetSize(compiled->outports), parent != nullptr);
+		if (parent != nullptr)
+			for (int i = 0; i < GetSize(compiled->outports); i++)
+				queued_outports.push_back(i);
+
 		for (auto wire : module->wires())
 		{
 			SigSpec sig = sigmap(wire);
 
-			for (int i = 0; i < GetSize(sig); i++) {
-				if (state_nets.count(sig[i]) == 0)
-					state_nets[sig[i]] = State::Sx;
-				if (wire->port_output) {
-					upd_outports[sig[i]].insert(wire);
-					dirty_bits.insert(sig[i]);
-				}
-			}
-
 			if ((shared->fst) && !(shared->hide_internal && wire->name[0] == '$')) {
 				fstHandle id = shared->fst->getHandle(scope + "." + RTLIL::unescape_id(wire->name));
 				if (id==0 && wire->name.isPublic())
@@ -268,10 +812,8 @@ struct SimInstance
 			if (wire->attributes.count(ID::init)) {
 				Const initval = wire->attributes.at(ID::init);
 				for (int i = 0; i < GetSize(sig) && i < GetSize(initval); i++)
-					if (initval[i] == State::S0 || initval[i] == State::S1) {
-						state_nets[sig[i]] = initval[i];
-						dirty_bits.insert(sig[i]);
-					}
+					if (initval[i] == State::S0 || initval[i] == State::S1)
+						set_net(compiled->net(sig[i]), initval[i]);
 			}
 
 			if (wire->port_input && instance != nullptr && parent != nullptr) {
@@ -303,16 +845,6 @@ struct SimInstance
 				dirty_children.insert(new SimInstance(shared, scope + "." + RTLIL::unescape_id(cell->name), mod, cell, this));
 			}
 
-			for (auto &port : cell->connections()) {
-				if (cell->input(port.first))
-					for (auto bit : sigmap(port.second)) {
-						upd_cells[bit].insert(cell);
-						// Make sure cell inputs connected to constants are updated in the first cycle
-						if (bit.wire == nullptr)
-							dirty_bits.insert(bit);
-					}
-			}
-
 			if (RTLIL::builtin_ff_cell_types().count(cell->type) || cell->type == ID($anyinit)) {
 				FfData ff_data(nullptr, cell);
 				ff_state_t ff;
@@ -333,7 +865,6 @@ struct SimInstance
 			if (cell->is_mem_cell())
 			{
 				std::string name = cell->parameters.at(ID::MEMID).decode_string();
-				mem_cells[cell] = name;
 				if (shared->fst)
 					fst_memories[name] = shared->fst->getMemoryHandles(scope + "." + RTLIL::unescape_id(name));
 			}
@@ -417,17 +948,70 @@ struct SimInstance
 		return result;
 	}
 
+	void queue_cell(int k)
+	{
+		if (cell_queued[k])
+			return;
+		int level = compiled->cells[k].level;
+		cell_queued[k] = true;
+		queued_cells[level].push_back(k);
+		first_queued_level = std::min(first_queued_level, level);
+		num_queued_cells++;
+	}
+
+	bool set_net(int net, State value)
+	{
+		if (value == State::Sa || net < BitIndex::num_const_bits || state_nets[net] == value)
+			return false;
+
+		state_nets[net] = value;
+
+		for (int i = compiled->reader_offsets[net]; i < compiled->reader_offsets[net+1]; i++)
+			queue_cell(compiled->readers[i]);
+
+		if (parent != nullptr)
+			for (int i = compiled->outport_offsets[net]; i < compiled->outport_offsets[net+1]; i++) {
+				int idx = compiled->outport_indices[i];
+				if (!outport_queued[idx]) {
+					outport_queued[idx] = true;
+					queued_outports.push_back(idx);
+				}
+			}
+
+		return true;
+	}
+
+	Const get_nets(const std::vector<int> &nets)
+	{
+		Const value;
+		auto &bits = value.bits();
+		bits.reserve(nets.size());
+		for (int n : nets)
+			bits.push_back(state_nets[n]);
+		return value;
+	}
+
+	bool set_nets(const std::vector<int> &nets, const Const &value)
+	{
+		bool did_something = false;
+
+		log_assert(GetSize(nets) <= GetSize(value));
+
+		for (int i = 0; i < GetSize(nets); i++)
+			if (set_net(nets[i], value[i]))
+				did_something = true;
+
+		return did_something;
+	}
+
 	Const get_state(SigSpec sig)
 	{
 		Const value;
+		auto &bits = value.bits();
+		bits.reserve(GetSize(sig));
 
-		for (auto bit : sigmap(sig))
-			if (bit.wire == nullptr)
-				value.bits().push_back(bit.data);
-			else if (state_nets.count(bit))
-				value.bits().push_back(state_nets.at(bit));
-			else
-				value.bits().push_back(State::Sz);
+		for (auto bit : sig)
+			bits.push_back(state_nets[compiled->net(bit)]);
 
 		if (shared->debug)
 			log("[%s] get %s: %s\n", hiername().c_str(), log_signal(sig), log_signal(value));
@@ -438,18 +1022,14 @@ struct SimInstance
 	{
 		bool did_something = false;
 
-		sig = sigmap(sig);
 		log_assert(GetSize(sig) <= GetSize(value));
 
 		for (int i = 0; i < GetSize(sig); i++)
-			if (value[i] != State::Sa && state_nets.at(sig[i]) != value[i]) {
-				state_nets.at(sig[i]) = value[i];
-				dirty_bits.insert(sig[i]);
+			if (set_net(compiled->net(sig[i]), value[i]))
 				did_something = true;
-			}
 
 		if (shared->debug)
-			log("[%s] set %s: %s\n", hiername().c_str(), log_signal(sig), log_signal(value));
+			log("[%s] set %s: %s\n", hiername().c_str(), log_signal(sigmap(sig)), log_signal(value));
 		return did_something;
 	}
 
@@ -505,22 +1085,18 @@ struct SimInstance
 		}
 	}
 
-	void update_cell(Cell *cell)
+	void update_cell(int k)
 	{
-		if (ff_database.count(cell))
-			return;
-
-		if (formal_database.count(cell))
-			return;
+		const SimModule::cell_t &c = compiled->cells[k];
+		Cell *cell = c.cell;
 
-		if (mem_cells.count(cell))
+		switch (c.kernel)
 		{
-			dirty_memories.insert(mem_cells[cell]);
+		case SimModule::K_MEMORY:
+			dirty_memories.insert(c.memid);
 			return;
-		}
 
-		if (children.count(cell))
-		{
+		case SimModule::K_CHILD: {
 			auto child = children.at(cell);
 			for (auto &conn: cell->connections())
 				if (cell->input(conn.first) && GetSize(conn.second)) {
@@ -531,60 +1107,86 @@ struct SimInstance
 			return;
 		}
 
-		if (yosys_celltypes.cell_evaluable(cell->type))
-		{
-			RTLIL::SigSpec sig_a, sig_b, sig_c, sig_d, sig_s, sig_y;
-			bool has_a, has_b, has_c, has_d, has_s, has_y;
-
-			has_a = cell->hasPort(ID::A);
-			has_b = cell->hasPort(ID::B);
-			has_c = cell->hasPort(ID::C);
-			has_d = cell->hasPort(ID::D);
-			has_s = cell->hasPort(ID::S);
-			has_y = cell->hasPort(ID::Y);
+		case SimModule::K_UNSUPPORTED:
+			log_error("Unsupported cell type: %s (%s.%s)\n", log_id(cell->type), log_id(module), log_id(cell));
 
-			if (has_a) sig_a = cell->getPort(ID::A);
-			if (has_b) sig_b = cell->getPort(ID::B);
-			if (has_c) sig_c = cell->getPort(ID::C);
-			if (has_d) sig_d = cell->getPort(ID::D);
-			if (has_s) sig_s = cell->getPort(ID::S);
-			if (has_y) sig_y = cell->getPort(ID::Y);
-
-			if (shared->debug)
-				log("[%s] eval %s (%s)\n", hiername().c_str(), log_id(cell), log_id(cell->type));
-
-			// Simple (A -> Y) and (A,B -> Y) cells
-			if (has_a && !has_c && !has_d && !has_s && has_y) {
-				set_state(sig_y, CellTypes::eval(cell, get_state(sig_a), get_state(sig_b)));
-				return;
-			}
+		default:
+			break;
+		}
 
-			// (A,B,C -> Y) cells
-			if (has_a && has_b && has_c && !has_d && !has_s && has_y) {
-				set_state(sig_y, CellTypes::eval(cell, get_state(sig_a), get_state(sig_b), get_state(sig_c)));
-				return;
-			}
+		if (shared->debug)
+			log("[%s] eval %s (%s)\n", hiername().c_str(), log_id(cell), log_id(cell->type));
 
-			// (A,S -> Y) cells
-			if (has_a && !has_b && !has_c && !has_d && has_s && has_y) {
-				set_state(sig_y, CellTypes::eval(cell, get_state(sig_a), get_state(sig_s)));
-				return;
-			}
+		auto bitwise = [&](State (*func)(State, State)) {
+			for (int i = 0; i < GetSize(c.y); i++)
+				set_net(c.y[i], func(state_nets[c.a[i]], state_nets[c.b[i]]));
+		};
 
-			// (A,B,S -> Y) cells
-			if (has_a && has_b && !has_c && !has_d && has_s && has_y) {
-				set_state(sig_y, CellTypes::eval(cell, get_state(sig_a), get_state(sig_b), get_state(sig_s)));
-				return;
+		switch (c.kernel)
+		{
+		case SimModule::K_BUF:
+			for (int i = 0; i < GetSize(c.y); i++)
+				set_net(c.y[i], state_nets[c.a[i]]);
+			break;
+		case SimModule::K_NOT:
+			for (int i = 0; i < GetSize(c.y); i++)
+				set_net(c.y[i], sim_not(state_nets[c.a[i]]));
+			break;
+		case SimModule::K_BITNOT:
+			for (int i = 0; i < GetSize(c.y); i++)
+				set_net(c.y[i], sim_bitnot(state_nets[c.a[i]]));
+			break;
+		case SimModule::K_AND:
+			bitwise(sim_and);
+			break;
+		case SimModule::K_NAND:
+			bitwise([](State a, State b) { return sim_not(sim_and(a, b)); });
+			break;
+		case SimModule::K_OR:
+			bitwise(sim_or);
+			break;
+		case SimModule::K_NOR:
+			bitwise([](State a, State b) { return sim_not(sim_or(a, b)); });
+			break;
+		case SimModule::K_XOR:
+			bitwise(sim_xor);
+			break;
+		case SimModule::K_XNOR:
+			bitwise([](State a, State b) { return sim_not(sim_xor(a, b)); });
+			break;
+		case SimModule::K_ANDNOT:
+			bitwise([](State a, State b) { return sim_and(a, sim_not(b)); });
+			break;
+		case SimModule::K_ORNOT:
+			bitwise([](State a, State b) { return sim_or(a, sim_not(b)); });
+			break;
+		case SimModule::K_MUX: {
+			State s = state_nets[c.s[0]];
+			for (int i = 0; i < GetSize(c.y); i++) {
+				State a = state_nets[c.a[i]], b = state_nets[c.b[i]];
+				set_net(c.y[i], s == State::S0 ? a : s == State::S1 ? b : a == b ? a : State::Sx);
 			}
-
+			break;
+		}
+		case SimModule::K_EVAL_AB:
+			set_nets(c.y, CellTypes::eval(cell, get_nets(c.a), get_nets(c.b)));
+			break;
+		case SimModule::K_EVAL_ABC:
+			set_nets(c.y, CellTypes::eval(cell, get_nets(c.a), get_nets(c.b), get_nets(c.c)));
+			break;
+		case SimModule::K_EVAL_AS:
+			set_nets(c.y, CellTypes::eval(cell, get_nets(c.a), get_nets(c.s)));
+			break;
+		case SimModule::K_EVAL_ABS:
+			set_nets(c.y, CellTypes::eval(cell, get_nets(c.a), get_nets(c.b), get_nets(c.s)));
+			break;
+		default:
 			log_warning("Unsupported evaluable cell type: %s (%s.%s)\n", log_id(cell->type), log_id(module), log_id(cell));
 			return;
 		}
 
-		if (cell->type == ID($print))
-			return;
-
-		log_error("Unsupported cell type: %s (%s.%s)\n", log_id(cell->type), log_id(module), log_id(cell));
+		if (shared->debug)
+			log("[%s] set %s: %s\n", hiername().c_str(), log_signal(sigmap(cell->getPort(ID::Y))), log_signal(get_nets(c.y)));
 	}
 
 	void update_memory(IdString id) {
@@ -617,32 +1219,25 @@ struct SimInstance
 
 	void update_ph1()
 	{
-		pool<Cell*> queue_cells;
-		pool<Wire*> queue_outports;
-
-		queue_cells.swap(dirty_cells);
-
 		while (1)
 		{
-			for (auto bit : dirty_bits)
+			if (num_queued_cells > 0)
 			{
-				if (upd_cells.count(bit))
-					for (auto cell : upd_cells.at(bit))
-						queue_cells.insert(cell);
-
-				if (upd_outports.count(bit) && parent != nullptr)
-					for (auto wire : upd_outports.at(bit))
-						queue_outports.insert(wire);
-			}
-
-			dirty_bits.clear();
-
-			if (!queue_cells.empty())
-			{
-				for (auto cell : queue_cells)
-					update_cell(cell);
-
-				queue_cells.clear();
+				int level = first_queued_level;
+				first_queued_level = compiled->num_levels;
+
+				// cells queued at the level being evaluated or above are
+				// picked up by this pass, others (on loops) by the next one
+				for (; level < compiled->num_levels && num_queued_cells > 0; level++) {
+					auto &queue = queued_cells[level];
+					for (int i = 0; i < GetSize(queue); i++) {
+						int k = queue[i];
+						cell_queued[k] = false;
+						num_queued_cells--;
+						update_cell(k);
+					}
+					queue.clear();
+				}
 				continue;
 			}
 
@@ -650,20 +1245,23 @@ struct SimInstance
 				update_memory(memid);
 			dirty_memories.clear();
 
-			for (auto wire : queue_outports)
+			for (int idx : queued_outports) {
+				outport_queued[idx] = false;
+				Wire *wire = compiled->outports[idx];
 				if (instance->hasPort(wire->name)) {
 					Const value = get_state(wire);
 					parent->set_state(instance->getPort(wire->name), value);
 				}
+			}
 
-			queue_outports.clear();
+			queued_outports.clear();
 
 			for (auto child : dirty_children)
 				child->update_ph1();
 
 			dirty_children.clear();
 
-			if (dirty_bits.empty())
+			if (num_queued_cells == 0 && queued_outports.empty())
 				break;
 		}
 	}
@@ -1087,6 +1685,145 @@ struct SimInstance
 			exit_scope();
 	}
 
+	bool has_memories()
+	{
+		if (!mem_database.empty())
+			return true;
+		for (auto child : children)
+			if (child.second->has_memories())
+				return true;
+		return false;
+	}
+
+	void write_checkpoint(RTLIL_BINARY::Encoder &enc)
+	{
+		checkpoint_string(enc, module->name.str());
+		checkpoint_states(enc, state_nets.data(), GetSize(state_nets));
+
+		enc.varint(GetSize(ff_database));
+		for (auto &it : ff_database) {
+			ff_state_t &ff = it.second;
+			checkpoint_string(enc, it.first->name.str());
+			checkpoint_const(enc, ff.past_d);
+			checkpoint_const(enc, ff.past_ad);
+			enc.u8(ff.past_clk);
+			enc.u8(ff.past_ce);
+			enc.u8(ff.past_srst);
+		}
+
+		enc.varint(GetSize(mem_database));
+		for (auto &it : mem_database) {
+			mem_state_t &mem = it.second;
+			checkpoint_string(enc, it.first.str());
+			checkpoint_const(enc, mem.data);
+			enc.varint(GetSize(mem.past_wr_clk));
+			for (int i = 0; i < GetSize(mem.past_wr_clk); i++) {
+				checkpoint_const(enc, mem.past_wr_clk[i]);
+				checkpoint_const(enc, mem.past_wr_en[i]);
+				checkpoint_const(enc, mem.past_wr_addr[i]);
+				checkpoint_const(enc, mem.past_wr_data[i]);
+			}
+		}
+
+		enc.varint(GetSize(print_database));
+		for (auto &print : print_database) {
+			checkpoint_string(enc, print.cell->name.str());
+			enc.u8(print.initial_done);
+			checkpoint_const(enc, print.past_trg);
+			checkpoint_const(enc, print.past_en);
+			checkpoint_const(enc, print.past_args);
+		}
+
+		enc.varint(GetSize(children));
+		for (auto &it : children) {
+			checkpoint_string(enc, it.first->name.str());
+			it.second->write_checkpoint(enc);
+		}
+	}
+
+	void read_checkpoint(RTLIL_BINARY::Decoder &dec)
+	{
+		auto mismatch = [&]() {
+			log_error("Checkpoint `%s' doesn't match the design at %s.\n", dec.filename->c_str(), hiername().c_str());
+		};
+
+		if (checkpoint_string(dec) != module->name.str())
+			mismatch();
+		std::vector<State> nets = checkpoint_states(dec);
+		if (GetSize(nets) != GetSize(state_nets))
+			mismatch();
+		state_nets = std::move(nets);
+
+		int num_ffs = dec.count();
+		if (num_ffs != GetSize(ff_database))
+			mismatch();
+		for (int i = 0; i < num_ffs; i++) {
+			Cell *cell = module->cell(checkpoint_string(dec));
+			if (cell == nullptr || !ff_database.count(cell))
+				mismatch();
+			ff_state_t &ff = ff_database.at(cell);
+			ff.past_d = checkpoint_const(dec);
+			ff.past_ad = checkpoint_const(dec);
+			ff.past_clk = checkpoint_state(dec);
+			ff.past_ce = checkpoint_state(dec);
+			ff.past_srst = checkpoint_state(dec);
+		}
+
+		int num_mems = dec.count();
+		if (num_mems != GetSize(mem_database))
+			mismatch();
+		for (int i = 0; i < num_mems; i++) {
+			auto it = mem_database.find(checkpoint_string(dec));
+			if (it == mem_database.end())
+				mismatch();
+			mem_state_t &mem = it->second;
+			mem.data = checkpoint_const(dec);
+			mem.restored_data = mem.data;
+			if (GetSize(mem.data) != GetSize(mem.mem->get_init_data()) || dec.count() != GetSize(mem.past_wr_clk))
+				mismatch();
+			for (int i = 0; i < GetSize(mem.past_wr_clk); i++) {
+				mem.past_wr_clk[i] = checkpoint_const(dec);
+				mem.past_wr_en[i] = checkpoint_const(dec);
+				mem.past_wr_addr[i] = checkpoint_const(dec);
+				mem.past_wr_data[i] = checkpoint_const(dec);
+			}
+		}
+
+		int num_prints = dec.count();
+		if (num_prints != GetSize(print_database))
+			mismatch();
+		dict<Cell*, print_state_t*> prints;
+		for (auto &print : print_database)
+			prints[print.cell] = &print;
+		for (int i = 0; i < num_prints; i++) {
+			auto it = prints.find(module->cell(checkpoint_string(dec)));
+			if (it == prints.end())
+				mismatch();
+			print_state_t &print = *it->second;
+			print.initial_done = dec.u8();
+			print.past_trg = checkpoint_const(dec);
+			print.past_en = checkpoint_const(dec);
+			print.past_args = checkpoint_const(dec);
+		}
+
+		int num_children = dec.count();
+		if (num_children != GetSize(children))
+			mismatch();
+		for (int i = 0; i < num_children; i++) {
+			auto it = children.find(module->cell(checkpoint_string(dec)));
+			if (it == children.end())
+				mismatch();
+			it->second->read_checkpoint(dec);
+		}
+	}
+
+	void collect_instances(dict<std::string, SimInstance*> &instances)
+	{
+		instances[hiername()] = this;
+		for (auto &it : children)
+			it.second->collect_instances(instances);
+	}
+
 	void register_memory_addr(IdString memid, int addr)
 	{
 		auto &mdb = mem_database.at(memid);
@@ -1103,6 +1840,8 @@ struct SimInstance
 			auto init_it = trace_mem_init_database.find(std::make_pair(memid, addr));
 			if (init_it != trace_mem_init_database.end())
 				data = init_it->second;
+			else if (!mdb.restored_data.empty())
+				data = mdb.restored_data.extract(index * mem.width, mem.width);
 			else
 				data = mem.get_init_data().extract(index * mem.width, mem.width);
 			shared->output_data.front().second.emplace(output_id, data);
@@ -1116,12 +1855,17 @@ struct SimInstance
 		for (auto &it : signal_database)
 		{
 			Wire *wire = it.first;
-			Const value = get_state(wire);
+			const Const &last = it.second.second;
 			int id = it.second.first;
 
-			if (it.second.second == value)
+			int first_net = compiled->index(SigBit(wire, 0));
+			bool changed = GetSize(last) != wire->width;
+			for (int i = 0; i < wire->width && !changed; i++)
+				changed = last[i] != state_nets[compiled->nets[first_net + i]];
+			if (!changed)
 				continue;
 
+			Const value = get_state(wire);
 			it.second.second = value;
 			data->emplace(id, value);
 		}
@@ -1155,18 +1899,14 @@ struct SimInstance
 		bool did_something = false;
 		for(auto &item : fst_handles) {
 			if (item.second==0) continue; // Ignore signals not found
-			std::string v = shared->fst->valueOf(item.second);
-			did_something |= set_state(item.first, Const::from_string(v));
+			did_something |= set_state(item.first, shared->fst->valueOf(item.second));
 		}
 		for (auto cell : module->cells())
 		{
 			if (cell->is_mem_cell()) {
 				std::string memid = cell->parameters.at(ID::MEMID).decode_string();
 				for (auto &data : fst_memories[memid]) 
-				{
-					std::string v = shared->fst->valueOf(data.second);
-					set_memory_state(memid, Const(data.first), Const::from_string(v));
-				}
+					set_memory_state(memid, Const(data.first), shared->fst->valueOf(data.second));
 			}
 		}
 
@@ -1203,10 +1943,8 @@ struct SimInstance
 	bool setInputs()
 	{
 		bool did_something = false;
-		for(auto &item : fst_inputs) {
-			std::string v = shared->fst->valueOf(item.second);
-			did_something |= set_state(item.first, Const::from_string(v));
-		}
+		for(auto &item : fst_inputs)
+			did_something |= set_state(item.first, shared->fst->valueOf(item.second));
 
 		for (auto child : children)
 			did_something |= child.second->setInputs();
@@ -1245,7 +1983,7 @@ struct SimInstance
 		bool retVal = false;
 		for(auto &item : fst_handles) {
 			if (item.second==0) continue; // Ignore signals not found
-			Const fst_val = Const::from_string(shared->fst->valueOf(item.second));
+			Const fst_val = shared->fst->valueOf(item.second);
 			Const sim_val = get_state(item.first);
 			if (sim_val.size()!=fst_val.size()) {
 				log_warning("Signal '%s.%s' size is different in gold and gate.\n", scope.c_str(), log_id(item.first));
@@ -1291,9 +2029,13 @@ struct SimWorker : SimShared
 	std::string map_filename;
 	std::string summary_filename;
 	std::string scope;
+	int checkpoint_every = 0;
+	std::string checkpoint_dir;
+	std::string restore_filename;
 
 	~SimWorker()
 	{
+		output_thread.reset();
 		outputfiles.clear();
 		delete top;
 	}
@@ -1308,28 +2050,56 @@ struct SimWorker : SimShared
 	{
 		std::map<int,Const> data;
 		top->register_output_step_values(&data);
+		if (output_thread) {
+			output_thread->push(t, std::move(data));
+			return;
+		}
 		output_data.emplace_back(t, data);
+
+		// The header of the output files can be written as soon as the first
+		// step is known, unless -ignore_x has to look at all steps to find the
+		// signals that are used or memory words are still added to the first
+		// step when they are first accessed. Otherwise the rest of the steps
+		// are passed to the output thread instead of being collected.
+		if (GetSize(output_data) == 1 && !outputfiles.empty() && !ignore_x && !top->has_memories()) {
+			std::map<int, bool> use_signal;
+			for (auto &data : output_data.front().second)
+				use_signal[data.first] = true;
+			for (auto &writer : outputfiles)
+				writer->write_header(use_signal);
+			output_thread.reset(new OutputThread(outputfiles));
+			output_thread->push(output_data.front().first, std::move(output_data.front().second));
+			output_data.clear();
+		}
 	}
 
 	void write_output_files()
 	{
-		std::map<int, bool> use_signal;
-		bool first = ignore_x;
-		for(auto& d : output_data)
-		{
-			if (first) {
-				for (auto &data : d.second)
-					use_signal[data.first] = !data.second.is_fully_undef();
-				first = false;
-			} else {
-				for (auto &data : d.second)
-					use_signal[data.first] = true;
+		if (output_thread) {
+			output_thread->finish();
+			output_thread.reset();
+		} else {
+			std::map<int, bool> use_signal;
+			bool first = ignore_x;
+			for(auto& d : output_data)
+			{
+				if (first) {
+					for (auto &data : d.second)
+						use_signal[data.first] = !data.second.is_fully_undef();
+					first = false;
+				} else {
+					for (auto &data : d.second)
+						use_signal[data.first] = true;
+				}
+				if (!ignore_x) break;
+			}
+			for(auto& writer : outputfiles) {
+				writer->write_header(use_signal);
+				for (auto &d : output_data)
+					writer->write_step(d.first, d.second);
 			}
-			if (!ignore_x) break;
 		}
-		for(auto& writer : outputfiles)
-			writer->write(use_signal);
-		
+
 		if (writeback) {
 			pool<Module*> wbmods;
 			top->writeback(wbmods);
@@ -1402,24 +2172,31 @@ struct SimWorker : SimShared
 		top = new SimInstance(this, scope, topmod);
 		register_signals();
 
-		if (debug)
-			log("\n===== 0 =====\n");
-		else if (verbose)
-			log("Simulating cycle 0.\n");
+		int start_cycle = 0;
+		if (!restore_filename.empty()) {
+			uint64_t time;
+			restore_checkpoint(0, start_cycle, time);
+			register_output_step(10*start_cycle);
+		} else {
+			if (debug)
+				log("\n===== 0 =====\n");
+			else if (verbose)
+				log("Simulating cycle 0.\n");
 
-		set_inports(reset, State::S1);
-		set_inports(resetn, State::S0);
+			set_inports(reset, State::S1);
+			set_inports(resetn, State::S0);
 
-		set_inports(clock, State::Sx);
-		set_inports(clockn, State::Sx);
+			set_inports(clock, State::Sx);
+			set_inports(clockn, State::Sx);
 
-		top->set_initstate_outputs(initstate ? State::S1 : State::S0);
+			top->set_initstate_outputs(initstate ? State::S1 : State::S0);
 
-		update(false);
+			update(false);
 
-		register_output_step(0);
+			register_output_step(0);
+		}
 
-		for (int cycle = 0; cycle < numcycles; cycle++)
+		for (int cycle = start_cycle; cycle < numcycles; cycle++)
 		{
 			if (debug)
 				log("\n===== %d =====\n", 10*cycle + 5);
@@ -1449,6 +2226,9 @@ struct SimWorker : SimShared
 
 			update(true);
 			register_output_step(10*cycle + 10);
+
+			if (checkpoint_every > 0 && (cycle+1) % checkpoint_every == 0)
+				write_checkpoint(0, cycle+1, 10*cycle + 10);
 		}
 
 		register_output_step(10*numcycles + 2);
@@ -1541,6 +2321,14 @@ struct SimWorker : SimShared
 
 		bool initial = true;
 		int cycle = 0;
+		uint64_t restore_time = 0;
+		if (!restore_filename.empty()) {
+			restore_checkpoint(1, cycle, restore_time);
+			if (restore_time < fst->getStartTime() || restore_time > stopCount)
+				log_error("Checkpoint time %lu%s is outside of the simulated time range.\n", (unsigned long)restore_time, fst->getTimescaleString());
+			startCount = restore_time;
+			initial = false;
+		}
 		log("Co-simulation from %lu%s to %lu%s", (unsigned long)startCount, fst->getTimescaleString(), (unsigned long)stopCount, fst->getTimescaleString());
 		if (cycles_set) 
 			log(" for %d clock cycle(s)",numcycles);
@@ -1549,6 +2337,9 @@ struct SimWorker : SimShared
 
 		try {
 			fst->reconstructAllAtTimes(fst_clock, startCount, stopCount, [&](uint64_t time) {
+				// the sample of the checkpoint itself was already simulated
+				if (!restore_filename.empty() && time <= restore_time)
+					return;
 				if (verbose)
 					log("Co-simulating %s %d [%lu%s].\n", (all_samples ? "sample" : "cycle"), cycle, (unsigned long)time, fst->getTimescaleString());
 				bool did_something = top->setInputs();
@@ -1567,6 +2358,9 @@ struct SimWorker : SimShared
 					log_error("Signal difference\n");
 				cycle++;
 
+				if (checkpoint_every > 0 && cycle % checkpoint_every == 0)
+					write_checkpoint(1, cycle, time);
+
 				// Limit to number of cycles if provided
 				if (cycles_set && cycle > numcycles *2)
 					throw fst_end_of_data_exception();
@@ -2054,6 +2848,97 @@ struct SimWorker : SimShared
 		write_output_files();
 	}
 
+	void write_checkpoint(int mode, int cycle, uint64_t time)
+	{
+		RTLIL_BINARY::Encoder enc;
+		enc.bytes(checkpoint_magic, sizeof(checkpoint_magic));
+		enc.fixed(checkpoint_version, 4);
+		enc.varint(mode);
+		enc.varint(cycle);
+		enc.varint(time);
+		enc.varint(step);
+
+		top->write_checkpoint(enc);
+
+		enc.varint(GetSize(triggered_assertions));
+		for (auto &assertion : triggered_assertions) {
+			enc.varint(assertion.step);
+			checkpoint_string(enc, assertion.instance->hiername());
+			checkpoint_string(enc, assertion.cell->name.str());
+			enc.zigzag(assertion.lane);
+		}
+		enc.varint(GetSize(display_output));
+		for (auto &output : display_output) {
+			enc.varint(output.step);
+			checkpoint_string(enc, output.instance->hiername());
+			checkpoint_string(enc, output.cell->name.str());
+			checkpoint_string(enc, output.output);
+		}
+
+		std::string filename = stringf("%s/cycle_%d.ckpt", checkpoint_dir.c_str(), cycle);
+		std::ofstream f(filename, std::ios::binary);
+		f.write(enc.buf.data(), enc.buf.size());
+		if (f.fail())
+			log_error("Can't write checkpoint `%s'.\n", filename.c_str());
+		if (verbose)
+			log("Wrote checkpoint `%s'.\n", filename.c_str());
+	}
+
+	// restores the state of top and the results so far, returns the cycle
+	// and time of the checkpoint
+	void restore_checkpoint(int mode, int &cycle, uint64_t &time)
+	{
+		std::ifstream f(restore_filename, std::ios::binary);
+		if (f.fail())
+			log_error("Can't open checkpoint `%s' for reading.\n", restore_filename.c_str());
+		std::string buffer((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+		auto data = reinterpret_cast<const unsigned char*>(buffer.data());
+		RTLIL_BINARY::Decoder dec(data, data + buffer.size(), &restore_filename, "Checkpoint");
+
+		if (memcmp(dec.bytes(sizeof(checkpoint_magic)), checkpoint_magic, sizeof(checkpoint_magic)) != 0)
+			log_error("File `%s' is not a sim checkpoint.\n", restore_filename.c_str());
+		if (dec.fixed(4) != checkpoint_version)
+			log_error("Checkpoint `%s' has an unsupported version.\n", restore_filename.c_str());
+		if (int(dec.varint()) != mode)
+			log_error("Checkpoint `%s' was written %s.\n", restore_filename.c_str(),
+					mode ? "by a simulation without -r" : "while replaying a trace with -r");
+		cycle = dec.varint();
+		time = dec.varint();
+		step = dec.varint();
+
+		top->read_checkpoint(dec);
+
+		dict<std::string, SimInstance*> instances;
+		top->collect_instances(instances);
+		auto find_cell = [&](SimInstance *&instance) {
+			auto it = instances.find(checkpoint_string(dec));
+			Cell *cell = it == instances.end() ? nullptr : it->second->module->cell(checkpoint_string(dec));
+			if (cell == nullptr)
+				log_error("Checkpoint `%s' doesn't match the design.\n", restore_filename.c_str());
+			instance = it->second;
+			return cell;
+		};
+
+		triggered_assertions.clear();
+		for (int i = 0, n = dec.count(); i < n; i++) {
+			int assertion_step = dec.varint();
+			SimInstance *instance;
+			Cell *cell = find_cell(instance);
+			triggered_assertions.emplace_back(assertion_step, instance, cell, dec.zigzag());
+		}
+		display_output.clear();
+		for (int i = 0, n = dec.count(); i < n; i++) {
+			int output_step = dec.varint();
+			SimInstance *instance;
+			Cell *cell = find_cell(instance);
+			display_output.emplace_back(output_step, instance, cell, checkpoint_string(dec));
+		}
+		if (dec.p != dec.end)
+			dec.corrupt();
+
+		log("Restored simulation state of cycle %d from `%s'.\n", cycle, restore_filename.c_str());
+	}
+
 	void write_summary()
 	{
 		if (summary_filename.empty())
@@ -2075,6 +2960,8 @@ struct SimWorker : SimShared
 			json.entry("step", assertion.step);
 			json.entry("type", log_id(assertion.cell->type));
 			json.entry("path", assertion.instance->witness_full_path(assertion.cell));
+			if (assertion.lane >= 0)
+				json.entry("lane", assertion.lane);
 			auto src = assertion.cell->get_string_attribute(ID::src);
 			if (!src.empty()) {
 				json.entry("src", src);
@@ -2208,6 +3095,11 @@ struct SimWorker : SimShared
 			log_error("Stop time is before start time\n");
 		}
 
+		// registers in scope are only needed for the initial state
+		for (auto &var : fst->getVars())
+			if (var.is_reg && (var.scope == scope || var.scope.find(scope+".") == 0))
+				fst->useHandle(var.id);
+
 		int cycle = 0;
 		log("Generate testbench data from %lu%s to %lu%s", (unsigned long)startCount, fst->getTimescaleString(), (unsigned long)stopCount, fst->getTimescaleString());
 		if (cycles_set) 
@@ -2251,23 +3143,25 @@ struct SimWorker : SimShared
 		try {
 			fst->reconstructAllAtTimes(fst_clock, startCount, stopCount, [&](uint64_t time) {
 				for(auto &item : clocks)
-					data_file << stringf("%s",fst->valueOf(item.second).c_str());
+					data_file << fst->valueOf(item.second).as_string();
 				for(auto &item : inputs)
-					data_file << stringf("%s",fst->valueOf(item.second).c_str());
+					data_file << fst->valueOf(item.second).as_string();
 				for(auto &item : outputs)
-					data_file << stringf("%s",fst->valueOf(item.second).c_str());
+					data_file << fst->valueOf(item.second).as_string();
 				data_file << stringf("%s\n",Const(time-prev_time).as_string().c_str());
 
 				if (time==startCount) {
 					// initial state
 					for(auto var : fst->getVars()) {
-						if (var.is_reg && !Const::from_string(fst->valueOf(var.id).c_str()).is_fully_undef()) {
-							if (var.scope == scope) {
-								initstate << stringf("\t\tuut.%s = %d'b%s;\n", var.name.c_str(), var.width, fst->valueOf(var.id).c_str());
-							} else if (var.scope.find(scope+".")==0) {
-								initstate << stringf("\t\tuut.%s.%s = %d'b%s;\n",var.scope.substr(scope.size()+1).c_str(), var.name.c_str(), var.width, fst->valueOf(var.id).c_str());
-							}
-						}
+						if (!var.is_reg || (var.scope != scope && var.scope.find(scope+".") != 0))
+							continue;
+						Const value = fst->valueOf(var.id);
+						if (value.is_fully_undef())
+							continue;
+						if (var.scope == scope)
+							initstate << stringf("\t\tuut.%s = %d'b%s;\n", var.name.c_str(), var.width, value.as_string().c_str());
+						else
+							initstate << stringf("\t\tuut.%s.%s = %d'b%s;\n",var.scope.substr(scope.size()+1).c_str(), var.name.c_str(), var.width, value.as_string().c_str());
 					}
 				}
 				cycle++;
@@ -2341,9 +3235,10 @@ struct VCDWriter : public OutputWriter
 		vcdfile.open(filename.c_str());
 	}
 
-	void write(std::map<int, bool> &use_signal) override
+	void write_header(std::map<int, bool> &use_signal) override
 	{
 		if (!vcdfile.is_open()) return;
+		this->use_signal = use_signal;
 		vcdfile << stringf("$version %s $end\n", worker->date ? yosys_version_str : "Yosys");
 
 		if (worker->date) {
@@ -2372,29 +3267,33 @@ struct VCDWriter : public OutputWriter
 		);
 
 		vcdfile << stringf("$enddefinitions $end\n");
+	}
 
-		for(auto& d : worker->output_data)
+	void write_step(int time, const std::map<int, Const> &data) override
+	{
+		if (!vcdfile.is_open()) return;
+		buffer = stringf("#%d\n", time);
+		for (auto &it : data)
 		{
-			vcdfile << stringf("#%d\n", d.first);
-			for (auto &data : d.second)
-			{
-				if (!use_signal.at(data.first)) continue;
-				Const value = data.second;
-				vcdfile << "b";
-				for (int i = GetSize(value)-1; i >= 0; i--) {
-					switch (value[i]) {
-						case State::S0: vcdfile << "0"; break;
-						case State::S1: vcdfile << "1"; break;
-						case State::Sx: vcdfile << "x"; break;
-						default: vcdfile << "z";
-					}
+			if (!use_signal.at(it.first)) continue;
+			const Const &value = it.second;
+			buffer += 'b';
+			for (int i = GetSize(value)-1; i >= 0; i--) {
+				switch (value[i]) {
+					case State::S0: buffer += '0'; break;
+					case State::S1: buffer += '1'; break;
+					case State::Sx: buffer += 'x'; break;
+					default: buffer += 'z';
 				}
-				vcdfile << stringf(" n%d\n", data.first);
 			}
+			buffer += stringf(" n%d\n", it.first);
 		}
+		vcdfile << buffer;
 	}
 
 	std::ofstream vcdfile;
+	std::map<int, bool> use_signal;
+	std::string buffer;
 };
 
 struct FSTWriter : public OutputWriter
@@ -2408,9 +3307,10 @@ struct FSTWriter : public OutputWriter
 		fstWriterClose(fstfile);
 	}
 
-	void write(std::map<int, bool> &use_signal) override
+	void write_header(std::map<int, bool> &use_signal) override
 	{
 		if (!fstfile) return;
+		this->use_signal = use_signal;
 		std::time_t t = std::time(nullptr);
 		fstWriterSetVersion(fstfile, worker->date ? yosys_version_str : "Yosys");
 		if (worker->date)
@@ -2434,30 +3334,33 @@ struct FSTWriter : public OutputWriter
 				mapping.emplace(id, fst_id);
 			}
 		);
+	}
 
-		for(auto& d : worker->output_data)
+	void write_step(int time, const std::map<int, Const> &data) override
+	{
+		if (!fstfile) return;
+		fstWriterEmitTimeChange(fstfile, time);
+		for (auto &it : data)
 		{
-			fstWriterEmitTimeChange(fstfile, d.first);
-			for (auto &data : d.second)
-			{
-				if (!use_signal.at(data.first)) continue;
-				Const value = data.second;
-				std::stringstream ss;
-				for (int i = GetSize(value)-1; i >= 0; i--) {
-					switch (value[i]) {
-						case State::S0: ss << "0"; break;
-						case State::S1: ss << "1"; break;
-						case State::Sx: ss << "x"; break;
-						default: ss << "z";
-					}
+			if (!use_signal.at(it.first)) continue;
+			const Const &value = it.second;
+			buffer.clear();
+			for (int i = GetSize(value)-1; i >= 0; i--) {
+				switch (value[i]) {
+					case State::S0: buffer += '0'; break;
+					case State::S1: buffer += '1'; break;
+					case State::Sx: buffer += 'x'; break;
+					default: buffer += 'z';
 				}
-				fstWriterEmitValueChange(fstfile, mapping[data.first], ss.str().c_str());
 			}
+			fstWriterEmitValueChange(fstfile, mapping[it.first], buffer.c_str());
 		}
 	}
 
 	struct fstContext *fstfile = nullptr;
 	std::map<int,fstHandle> mapping;
+	std::map<int, bool> use_signal;
+	std::string buffer;
 };
 
 struct AIWWriter : public OutputWriter
@@ -2471,7 +3374,7 @@ struct AIWWriter : public OutputWriter
 		aiwfile << '.' << '\n';
 	}
 
-	void write(std::map<int, bool> &) override
+	void write_header(std::map<int, bool> &) override
 	{
 		if (!aiwfile.is_open()) return;
 		if (worker->map_filename.empty())
@@ -2480,7 +3383,6 @@ struct AIWWriter : public OutputWriter
 		std::ifstream mf(worker->map_filename);
 		std::string type, symbol;
 		int variable, index;
-		int max_input = 0;
 		if (mf.fail())
 			log_cmd_error("Not able to read AIGER witness map file.\n");
 		while (mf >> type >> variable >> index >> symbol) {
@@ -2514,64 +3416,69 @@ struct AIWWriter : public OutputWriter
 			[]() {},
 			[this](const char */*name*/, int /*size*/, Wire *wire, int id, bool) { if (wire != nullptr) mapping[wire] = id; }
 		);
+	}
 
-		std::map<int, Yosys::RTLIL::Const> current;
-		bool first = true;
-		for (auto iter = worker->output_data.begin(); iter != std::prev(worker->output_data.end()); ++iter)
-		{
-			auto& d = *iter;
-			for (auto &data : d.second)
+	// The values of a step are written when the next step arrives, so that
+	// the last step is left out.
+	void write_step(int, const std::map<int, Const> &data) override
+	{
+		if (!aiwfile.is_open()) return;
+		if (have_step)
+			write_current();
+		for (auto &it : data)
+			current[it.first] = it.second;
+		have_step = true;
+	}
+
+	void write_current()
+	{
+		if (first) {
+			for (int i = 0;; i++)
 			{
-				current[data.first] = data.second;
-			}
-			if (first) {
-				for (int i = 0;; i++)
-				{
-					if (aiw_latches.count(i)) {
-						aiwfile << '0';
-						continue;
-					}
-					aiwfile << '\n';
-					break;
+				if (aiw_latches.count(i)) {
+					aiwfile << '0';
+					continue;
 				}
-				first = false;
+				aiwfile << '\n';
+				break;
 			}
+			first = false;
+		}
 
-			bool skip = false;
-			for (auto it : clocks)
-			{
-				auto val = it.second ? State::S1 : State::S0;
-				SigBit bit = aiw_inputs.at(it.first);
+		bool skip = false;
+		for (auto it : clocks)
+		{
+			auto val = it.second ? State::S1 : State::S0;
+			SigBit bit = aiw_inputs.at(it.first);
+			auto v = current[mapping[bit.wire]].at(bit.offset);
+			if (v == val)
+				skip = true;
+		}
+		if (skip)
+			return;
+		for (int i = 0; i <= max_input; i++)
+		{
+			if (aiw_inputs.count(i)) {
+				SigBit bit = aiw_inputs.at(i);
 				auto v = current[mapping[bit.wire]].at(bit.offset);
-				if (v == val)
-					skip = true;
+				if (v == State::S1)
+					aiwfile << '1';
+				else
+					aiwfile << '0';
+				continue;
 			}
-			if (skip)
+			if (aiw_inits.count(i)) {
+				SigBit bit = aiw_inits.at(i);
+				auto v = current[mapping[bit.wire]].at(bit.offset);
+				if (v == State::S1)
+					aiwfile << '1';
+				else
+					aiwfile << '0';
 				continue;
-			for (int i = 0; i <= max_input; i++)
-			{
-				if (aiw_inputs.count(i)) {
-					SigBit bit = aiw_inputs.at(i);
-					auto v = current[mapping[bit.wire]].at(bit.offset);
-					if (v == State::S1)
-						aiwfile << '1';
-					else
-						aiwfile << '0';
-					continue;
-				}
-				if (aiw_inits.count(i)) {
-					SigBit bit = aiw_inits.at(i);
-					auto v = current[mapping[bit.wire]].at(bit.offset);
-					if (v == State::S1)
-						aiwfile << '1';
-					else
-						aiwfile << '0';
-					continue;
-				}
-				aiwfile << '0';
 			}
-			aiwfile << '\n';
-		} 
+			aiwfile << '0';
+		}
+		aiwfile << '\n';
 	}
 
 	std::ofstream aiwfile;
@@ -2579,6 +3486,392 @@ struct AIWWriter : public OutputWriter
 	dict<int, SigBit> aiw_inputs, aiw_inits;
 	dict<int, bool> clocks;
 	std::map<Wire*,int> mapping;
+	int max_input = 0;
+	std::map<int, Const> current;
+	bool have_step = false;
+	bool first = true;
+};
+
+// Bit-parallel random simulation for `sim -lanes'. Every net holds one 64 bit
+// word, with bit i of the word being the value of the net in lane i, so the
+// lanes are evaluated together with the word operations of SimLaneOps, in the
+// cell order of the compiled module. Values are two-valued (undefined values read as 0), and
+// only flat designs without memories, clocked by the -clock/-clockn inputs,
+// are supported.
+struct SimLanes : SimLaneOps
+{
+	struct ff_t
+	{
+		Cell *cell;
+		std::vector<int> d, q;
+		int ce = -1, srst = -1;
+		bool pol_ce = true, pol_srst = true, ce_over_srst = false;
+		Const val_srst;
+	};
+
+	SimWorker *worker;
+	SimInstance *top;
+	const SimModule *compiled;
+	std::vector<op_t> ops;
+	int num_lanes;
+	uint64_t lane_mask;
+	uint64_t rng_state;
+
+	std::vector<int> random_nets, clock_nets, clockn_nets, reset_nets, resetn_nets, initstate_nets;
+
+	// flip-flops clocked in the first and in the second half of a cycle
+	std::vector<ff_t> ffs[2];
+
+	std::vector<Cell*> assert_cells, assume_cells, cover_cells;
+	dict<Cell*, uint64_t> covered;
+	uint64_t failed = 0, dropped = 0;
+
+	uint64_t rng()
+	{
+		rng_state ^= rng_state << 13;
+		rng_state ^= rng_state >> 7;
+		rng_state ^= rng_state << 17;
+		return rng_state;
+	}
+
+	std::vector<int> port_nets(IdString portname)
+	{
+		Wire *w = top->module->wire(portname);
+		if (w == nullptr)
+			log_error("Can't find port %s on module %s.\n", log_id(portname), log_id(top->module));
+		std::vector<int> result;
+		for (auto bit : SigSpec(w))
+			result.push_back(compiled->net(bit));
+		return result;
+	}
+
+	std::string label(Cell *cell)
+	{
+		if (cell->attributes.count(ID::src))
+			return cell->attributes.at(ID::src).decode_string();
+		return log_id(cell);
+	}
+
+	SimLanes(SimWorker *worker, Module *topmod, int num_lanes, uint64_t seed) : worker(worker), num_lanes(num_lanes)
+	{
+		log_assert(worker->top == nullptr);
+		top = worker->top = new SimInstance(worker, worker->scope, topmod);
+		compiled = top->compiled;
+
+		lane_mask = num_lanes == 64 ? ~uint64_t(0) : (uint64_t(1) << num_lanes) - 1;
+		rng_state = seed ^ 0x9e3779b97f4a7c15ULL;
+		if (rng_state == 0)
+			rng_state = 1;
+
+		if (!top->children.empty())
+			log_error("Module %s has submodules, which are not supported with -lanes. Run 'flatten' first.\n", log_id(topmod));
+		if (!top->mem_database.empty())
+			log_error("Module %s has memories, which are not supported with -lanes. Run 'memory_map' first.\n", log_id(topmod));
+
+		for (auto &c : compiled->cells) {
+			ops.push_back(cell_op(c.cell));
+			if (c.kernel > SimModule::K_EVAL_ABS)
+				log_error("Cell %s of type %s is not supported with -lanes.\n", log_id(c.cell), log_id(c.cell->type));
+			if (c.level == compiled->num_levels - 1)
+				log_error("Cell %s is on a combinational loop, which is not supported with -lanes.\n", log_id(c.cell));
+		}
+
+		nets.assign(compiled->index.size(), 0);
+		nets[int(State::S1)] = ~uint64_t(0);
+
+		for (auto portname : worker->clock)
+			for (int n : port_nets(portname))
+				clock_nets.push_back(n);
+		for (auto portname : worker->clockn)
+			for (int n : port_nets(portname))
+				clockn_nets.push_back(n);
+		for (auto portname : worker->reset)
+			for (int n : port_nets(portname))
+				reset_nets.push_back(n);
+		for (auto portname : worker->resetn)
+			for (int n : port_nets(portname))
+				resetn_nets.push_back(n);
+
+		for (auto wire : topmod->wires()) {
+			if (!wire->port_input || worker->clock.count(wire->name) || worker->clockn.count(wire->name) ||
+					worker->reset.count(wire->name) || worker->resetn.count(wire->name))
+				continue;
+			for (auto bit : SigSpec(wire))
+				random_nets.push_back(compiled->net(bit));
+		}
+
+		for (auto cell : topmod->cells())
+		{
+			if (cell->type.in(ID($anyseq), ID($allseq)))
+				for (auto bit : cell->getPort(ID::Y))
+					random_nets.push_back(compiled->net(bit));
+
+			if (cell->type.in(ID($anyconst), ID($allconst)))
+				for (auto bit : cell->getPort(ID::Y))
+					nets[compiled->net(bit)] = rng();
+
+			if (cell->type == ID($initstate))
+				initstate_nets.push_back(compiled->net(cell->getPort(ID::Y)[0]));
+
+			if (cell->type == ID($assert))
+				assert_cells.push_back(cell);
+			if (cell->type == ID($assume))
+				assume_cells.push_back(cell);
+			if (cell->type == ID($cover)) {
+				cover_cells.push_back(cell);
+				covered[cell] = 0;
+			}
+
+			auto it = top->ff_database.find(cell);
+			if (it == top->ff_database.end())
+				continue;
+
+			FfData &ff_data = it->second.data;
+			if (ff_data.has_arst || ff_data.has_aload || ff_data.has_sr)
+				log_error("Flip-flop %s has asynchronous controls, which are not supported with -lanes. Run 'async2sync' first.\n", log_id(cell));
+
+			// the clock inputs rise in the second half of a cycle, global clock flip-flops step with them
+			int half = 1;
+			if (ff_data.has_clk) {
+				int clk = compiled->net(ff_data.sig_clk);
+				if (std::find(clock_nets.begin(), clock_nets.end(), clk) != clock_nets.end())
+					half = ff_data.pol_clk ? 1 : 0;
+				else if (std::find(clockn_nets.begin(), clockn_nets.end(), clk) != clockn_nets.end())
+					half = ff_data.pol_clk ? 0 : 1;
+				else
+					log_error("Flip-flop %s is clocked by %s, which is not a -clock or -clockn input.\n", log_id(cell), log_signal(ff_data.sig_clk));
+			} else if (!ff_data.has_gclk)
+				log_error("Latch %s is not supported with -lanes.\n", log_id(cell));
+
+			ff_t ff;
+			ff.cell = cell;
+			for (auto bit : ff_data.sig_d)
+				ff.d.push_back(compiled->net(bit));
+			for (auto bit : ff_data.sig_q)
+				ff.q.push_back(compiled->net(bit));
+			if (ff_data.has_ce) {
+				ff.ce = compiled->net(ff_data.sig_ce);
+				ff.pol_ce = ff_data.pol_ce;
+			}
+			if (ff_data.has_srst) {
+				ff.srst = compiled->net(ff_data.sig_srst);
+				ff.pol_srst = ff_data.pol_srst;
+				ff.ce_over_srst = ff_data.ce_over_srst;
+				ff.val_srst = ff_data.val_srst;
+			}
+
+			// init values as set up by the SimInstance
+			for (int i = 0; i < ff_data.width; i++) {
+				State init = top->state_nets[ff.q[i]];
+				if (init == State::S0 || init == State::S1)
+					put(ff.q[i], init == State::S1 ? ~uint64_t(0) : 0);
+				else
+					put(ff.q[i], worker->zinit ? 0 : rng());
+			}
+
+			ffs[half].push_back(ff);
+		}
+	}
+
+	// runs CellTypes::eval once per lane, for cell types without a word kernel
+	void eval_per_lane(const SimModule::cell_t &c)
+	{
+		auto lane_const = [&](const std::vector<int> &sig, int lane) {
+			Const value(State::S0, GetSize(sig));
+			for (int i = 0; i < GetSize(sig); i++)
+				if ((nets[sig[i]] >> lane) & 1)
+					value.bits()[i] = State::S1;
+			return value;
+		};
+
+		words_t y(GetSize(c.y));
+		for (int lane = 0; lane < num_lanes; lane++) {
+			Const result;
+			if (c.kernel == SimModule::K_EVAL_AB)
+				result = CellTypes::eval(c.cell, lane_const(c.a, lane), lane_const(c.b, lane));
+			else if (c.kernel == SimModule::K_EVAL_ABC)
+				result = CellTypes::eval(c.cell, lane_const(c.a, lane), lane_const(c.b, lane), lane_const(c.c, lane));
+			else if (c.kernel == SimModule::K_EVAL_AS)
+				result = CellTypes::eval(c.cell, lane_const(c.a, lane), lane_const(c.s, lane));
+			else
+				result = CellTypes::eval(c.cell, lane_const(c.a, lane), lane_const(c.b, lane), lane_const(c.s, lane));
+			for (int i = 0; i < GetSize(y) && i < GetSize(result); i++)
+				if (result[i] == State::S1)
+					y[i] |= uint64_t(1) << lane;
+		}
+		set(c.y, y);
+	}
+
+	void eval_cell(const SimModule::cell_t &c, const op_t &op)
+	{
+		int width = GetSize(c.y);
+
+		switch (c.kernel)
+		{
+		case SimModule::K_BUF:
+			for (int i = 0; i < width; i++)
+				put(c.y[i], nets[c.a[i]]);
+			return;
+		case SimModule::K_NOT:
+		case SimModule::K_BITNOT:
+			for (int i = 0; i < width; i++)
+				put(c.y[i], ~nets[c.a[i]]);
+			return;
+		case SimModule::K_AND:
+			for (int i = 0; i < width; i++)
+				put(c.y[i], nets[c.a[i]] & nets[c.b[i]]);
+			return;
+		case SimModule::K_NAND:
+			for (int i = 0; i < width; i++)
+				put(c.y[i], ~(nets[c.a[i]] & nets[c.b[i]]));
+			return;
+		case SimModule::K_OR:
+			for (int i = 0; i < width; i++)
+				put(c.y[i], nets[c.a[i]] | nets[c.b[i]]);
+			return;
+		case SimModule::K_NOR:
+			for (int i = 0; i < width; i++)
+				put(c.y[i], ~(nets[c.a[i]] | nets[c.b[i]]));
+			return;
+		case SimModule::K_XOR:
+			for (int i = 0; i < width; i++)
+				put(c.y[i], nets[c.a[i]] ^ nets[c.b[i]]);
+			return;
+		case SimModule::K_XNOR:
+			for (int i = 0; i < width; i++)
+				put(c.y[i], ~(nets[c.a[i]] ^ nets[c.b[i]]));
+			return;
+		case SimModule::K_ANDNOT:
+			for (int i = 0; i < width; i++)
+				put(c.y[i], nets[c.a[i]] & ~nets[c.b[i]]);
+			return;
+		case SimModule::K_ORNOT:
+			for (int i = 0; i < width; i++)
+				put(c.y[i], nets[c.a[i]] | ~nets[c.b[i]]);
+			return;
+		case SimModule::K_MUX: {
+			uint64_t s = nets[c.s[0]];
+			for (int i = 0; i < width; i++)
+				put(c.y[i], (nets[c.a[i]] & ~s) | (nets[c.b[i]] & s));
+			return;
+		}
+		default:
+			break;
+		}
+
+		if (!eval_op(op, c.a, c.b, c.c, c.s, c.y))
+			eval_per_lane(c);
+	}
+
+	void clock_ffs(const std::vector<ff_t> &ff_list)
+	{
+		// all flip-flops sample their inputs before any of them is updated
+		std::vector<words_t> next_q;
+		for (auto &ff : ff_list) {
+			uint64_t ce = ff.ce < 0 ? ~uint64_t(0) : ff.pol_ce ? nets[ff.ce] : ~nets[ff.ce];
+			uint64_t srst = ff.srst < 0 ? 0 : ff.pol_srst ? nets[ff.srst] : ~nets[ff.srst];
+			if (ff.ce_over_srst)
+				srst &= ce;
+			words_t q(GetSize(ff.q));
+			for (int i = 0; i < GetSize(q); i++) {
+				q[i] = (nets[ff.d[i]] & ce) | (nets[ff.q[i]] & ~ce);
+				uint64_t rst_val = ff.srst >= 0 && ff.val_srst[i] == State::S1 ? ~uint64_t(0) : 0;
+				q[i] = (q[i] & ~srst) | (rst_val & srst);
+			}
+			next_q.push_back(std::move(q));
+		}
+		for (int k = 0; k < GetSize(ff_list); k++)
+			set(ff_list[k].q, next_q[k]);
+	}
+
+	void check(int cycle)
+	{
+		// lanes violating an assumption are dropped from the simulation
+		for (auto cell : assume_cells) {
+			uint64_t a = nets[compiled->net(cell->getPort(ID::A)[0])];
+			uint64_t en = nets[compiled->net(cell->getPort(ID::EN)[0])];
+			dropped |= en & ~a;
+		}
+
+		for (auto cell : assert_cells) {
+			uint64_t a = nets[compiled->net(cell->getPort(ID::A)[0])];
+			uint64_t en = nets[compiled->net(cell->getPort(ID::EN)[0])];
+			uint64_t fail = en & ~a & lane_mask & ~failed & ~dropped;
+			if (fail == 0)
+				continue;
+			for (int lane = 0; lane < num_lanes; lane++)
+				if ((fail >> lane) & 1) {
+					log("Lane %d: assertion %s.%s (%s) failed in cycle %d.\n", lane,
+							top->hiername().c_str(), log_id(cell), label(cell).c_str(), cycle);
+					worker->triggered_assertions.emplace_back(cycle, top, cell, lane);
+				}
+			failed |= fail;
+		}
+
+		for (auto cell : cover_cells) {
+			uint64_t a = nets[compiled->net(cell->getPort(ID::A)[0])];
+			uint64_t en = nets[compiled->net(cell->getPort(ID::EN)[0])];
+			covered[cell] |= en & a & ~dropped;
+		}
+	}
+
+	int count_lanes(uint64_t mask) const
+	{
+		int count = 0;
+		for (int lane = 0; lane < num_lanes; lane++)
+			count += (mask >> lane) & 1;
+		return count;
+	}
+
+	void run(int numcycles)
+	{
+		for (int cycle = 0; cycle < numcycles; cycle++)
+		{
+			if (worker->verbose)
+				log("Simulating cycle %d.\n", cycle);
+
+			for (int n : random_nets)
+				nets[n] = rng();
+			set(reset_nets, cycle < worker->rstlen ? ~uint64_t(0) : 0);
+			set(resetn_nets, cycle < worker->rstlen ? 0 : ~uint64_t(0));
+			set(initstate_nets, cycle == 0 && worker->initstate ? ~uint64_t(0) : 0);
+
+			for (int half = 0; half < 2; half++)
+			{
+				if (ffs[half].empty() && (half == 0 || !ffs[0].empty()))
+					continue;
+
+				// clock inputs have the value from before their edge in this half
+				set(clock_nets, half == 0 ? ~uint64_t(0) : 0);
+				set(clockn_nets, half == 0 ? 0 : ~uint64_t(0));
+
+				for (int k = 0; k < GetSize(compiled->cells); k++)
+					eval_cell(compiled->cells[k], ops[k]);
+				check(cycle);
+				clock_ffs(ffs[half]);
+			}
+
+			worker->step = cycle + 1;
+			if (((failed | dropped) & lane_mask) == lane_mask) {
+				log("All lanes failed or were dropped in cycle %d.\n", cycle);
+				break;
+			}
+		}
+
+		for (auto cell : cover_cells)
+			log("Cover %s.%s (%s) reached in %d of %d lanes.\n", top->hiername().c_str(), log_id(cell),
+					label(cell).c_str(), count_lanes(covered.at(cell)), num_lanes);
+		if (dropped & lane_mask)
+			log("Dropped %d of %d lanes after failed assumptions.\n", count_lanes(dropped), num_lanes);
+
+		int num_failed = count_lanes(failed);
+		if (num_failed == 0)
+			log("No assertion failed in %d lanes.\n", num_lanes);
+		else if (worker->serious_asserts)
+			log_error("Assertions failed in %d of %d lanes.\n", num_failed, num_lanes);
+		else
+			log_warning("Assertions failed in %d of %d lanes.\n", num_failed, num_lanes);
+	}
 };
 
 struct SimPass : public Pass {
@@ -2641,6 +3934,17 @@ struct SimPass : public Pass {
 		log("    -noinitstate\n");
 		log("        do not activate $initstate cells during the first cycle\n");
 		log("\n");
+		log("    -lanes <integer>\n");
+		log("        simulate the given number of lanes (up to 64) with independent random\n");
+		log("        stimulus at once, using one machine word per net. Inputs other than\n");
+		log("        clocks and resets, $anyseq and $anyconst cells and uninitialized\n");
+		log("        flip-flops get random values, undefined values read as 0. The\n");
+		log("        first failing assertion is reported for each lane. Requires a flat\n");
+		log("        design without memories or asynchronous flip-flops.\n");
+		log("\n");
+		log("    -seed <integer>\n");
+		log("        seed for the random values of -lanes (default: 1)\n");
+		log("\n");
 		log("    -a\n");
 		log("        use all nets in VCD/FST operations, not just those with public names\n");
 		log("\n");
@@ -2658,6 +3962,16 @@ struct SimPass : public Pass {
 		log("    -summary <filename>\n");
 		log("        write a JSON summary to the given file\n");
 		log("\n");
+		log("    -checkpoint-every <integer> <dirname>\n");
+		log("        write the simulation state to <dirname>/cycle_<n>.ckpt after every\n");
+		log("        given number of cycles (samples of the input file with -r)\n");
+		log("\n");
+		log("    -restore <filename>\n");
+		log("        resume from a checkpoint written with -checkpoint-every, instead of\n");
+		log("        starting from the initial state. The design and the -r input file\n");
+		log("        must be the same as when the checkpoint was written. Output files\n");
+		log("        start at the time of the checkpoint.\n");
+		log("\n");
 		log("    -map <filename>\n");
 		log("        read file with port and latch symbols, needed for AIGER witness input\n");
 		log("\n");
@@ -2712,6 +4026,8 @@ struct SimPass : public Pass {
 		SimWorker worker;
 		int numcycles = 20;
 		int append = 0;
+		int lanes = 0;
+		uint64_t seed = 1;
 		bool start_set = false, stop_set = false, at_set = false;
 
 		log_header(design, "Executing SIM pass (simulate the circuit).\n");
@@ -2749,6 +4065,16 @@ struct SimPass : public Pass {
 				worker.initstate = false;
 				continue;
 			}
+			if (args[argidx] == "-lanes" && argidx+1 < args.size()) {
+				lanes = atoi(args[++argidx].c_str());
+				if (lanes < 1 || lanes > 64)
+					log_cmd_error("Number of lanes must be between 1 and 64.\n");
+				continue;
+			}
+			if (args[argidx] == "-seed" && argidx+1 < args.size()) {
+				seed = strtoull(args[++argidx].c_str(), nullptr, 10);
+				continue;
+			}
 			if (args[argidx] == "-rstlen" && argidx+1 < args.size()) {
 				worker.rstlen = atoi(args[++argidx].c_str());
 				continue;
@@ -2815,6 +4141,21 @@ struct SimPass : public Pass {
 				worker.summary_filename = summary_filename;
 				continue;
 			}
+			if (args[argidx] == "-checkpoint-every" && argidx+2 < args.size()) {
+				worker.checkpoint_every = atoi(args[++argidx].c_str());
+				if (worker.checkpoint_every < 1)
+					log_cmd_error("Checkpoint interval must be a positive number of cycles.\n");
+				worker.checkpoint_dir = args[++argidx];
+				rewrite_filename(worker.checkpoint_dir);
+				if (!check_directory_exists(worker.checkpoint_dir) && !create_directory(worker.checkpoint_dir))
+					log_cmd_error("Can't create checkpoint directory `%s'.\n", worker.checkpoint_dir.c_str());
+				continue;
+			}
+			if (args[argidx] == "-restore" && argidx+1 < args.size()) {
+				worker.restore_filename = args[++argidx];
+				rewrite_filename(worker.restore_filename);
+				continue;
+			}
 			if (args[argidx] == "-scope" && argidx+1 < args.size()) {
 				worker.scope = args[++argidx];
 				continue;
@@ -2878,6 +4219,8 @@ struct SimPass : public Pass {
 			log_error("'at' option can only be defined separate of 'start','stop' and 'n'\n");
 		if (stop_set && worker.cycles_set)
 			log_error("'stop' and 'n' can only be used exclusively'\n");
+		if (!worker.restore_filename.empty() && (start_set || at_set))
+			log_cmd_error("Option -restore can't be combined with -start or -at.\n");
 
 		Module *top_mod = nullptr;
 
@@ -2893,13 +4236,22 @@ struct SimPass : public Pass {
 			top_mod = mods.front();
 		}
 
-		if (worker.sim_filename.empty())
+		if (lanes > 0) {
+			if (!worker.sim_filename.empty() || !worker.outputfiles.empty() || worker.writeback)
+				log_cmd_error("Option -lanes can't be combined with -r, -w or waveform output files.\n");
+			if (worker.checkpoint_every > 0 || !worker.restore_filename.empty())
+				log_cmd_error("Options -checkpoint-every and -restore can't be combined with -lanes.\n");
+			SimLanes sim_lanes(&worker, top_mod, lanes, seed);
+			sim_lanes.run(numcycles);
+		} else if (worker.sim_filename.empty())
 			worker.run(top_mod, numcycles);
 		else {
 			std::string filename_trim = file_base_name(worker.sim_filename);
 			if (filename_trim.size() > 4 && ((filename_trim.compare(filename_trim.size()-4, std::string::npos, ".fst") == 0) ||
 				filename_trim.compare(filename_trim.size()-4, std::string::npos, ".vcd") == 0)) {
 				worker.run_cosim_fst(top_mod, numcycles);
+			} else if (worker.checkpoint_every > 0 || !worker.restore_filename.empty()) {
+				log_cmd_error("Options -checkpoint-every and -restore are only supported for FST and VCD input files.\n");
 			} else if (filename_trim.size() > 4 && filename_trim.compare(filename_trim.size()-4, std::string::npos, ".aiw") == 0) {
 				if (worker.map_filename.empty())
 					log_cmd_error("For AIGER witness file map parameter is mandatory.\n");
@@ -0,0 +1,362 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef SIMLANES_H
+#define SIMLANES_H
+
+#include "kernel/yosys.h"
+#include "kernel/bitindex.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Word operations of `sim -lanes' (see SimLanes in sim.cc). Every net holds one
+// 64 bit word, with bit i of the word being the value of the net in lane i. Nets
+// are numbered as by a BitIndex: writes to the constant nets are ignored, and the
+// user sets nets[State::S1] to all ones.
+struct SimLaneOps
+{
+	typedef std::vector<uint64_t> words_t;
+
+	enum op_type_t {
+		OP_PER_LANE,
+		OP_NOT, OP_POS, OP_NEG,
+		OP_AND, OP_OR, OP_XOR, OP_XNOR,
+		OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD,
+		OP_REDUCE_AND, OP_REDUCE_OR, OP_REDUCE_XOR, OP_REDUCE_XNOR,
+		OP_LOGIC_NOT, OP_LOGIC_AND, OP_LOGIC_OR,
+		OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE,
+		OP_SHL, OP_SHR, OP_SSHR,
+		OP_PMUX, OP_BWMUX, OP_NMUX, OP_AOI3, OP_OAI3,
+	};
+
+	// word operation for the cells evaluated by CellTypes::eval in update_cell
+	struct op_t
+	{
+		op_type_t type = OP_PER_LANE;
+		bool signed_a = false, signed_b = false;
+	};
+
+	std::vector<uint64_t> nets;
+
+	static op_t cell_op(RTLIL::Cell *cell)
+	{
+		static const dict<RTLIL::IdString, op_type_t> op_types = {
+			{ID($not), OP_NOT}, {ID($pos), OP_POS}, {ID($neg), OP_NEG},
+			{ID($and), OP_AND}, {ID($or), OP_OR}, {ID($xor), OP_XOR}, {ID($xnor), OP_XNOR},
+			{ID($add), OP_ADD}, {ID($sub), OP_SUB}, {ID($mul), OP_MUL}, {ID($div), OP_DIV}, {ID($mod), OP_MOD},
+			{ID($reduce_and), OP_REDUCE_AND}, {ID($reduce_or), OP_REDUCE_OR}, {ID($reduce_bool), OP_REDUCE_OR},
+			{ID($reduce_xor), OP_REDUCE_XOR}, {ID($reduce_xnor), OP_REDUCE_XNOR},
+			{ID($logic_not), OP_LOGIC_NOT}, {ID($logic_and), OP_LOGIC_AND}, {ID($logic_or), OP_LOGIC_OR},
+			{ID($eq), OP_EQ}, {ID($eqx), OP_EQ}, {ID($ne), OP_NE}, {ID($nex), OP_NE},
+			{ID($lt), OP_LT}, {ID($le), OP_LE}, {ID($gt), OP_GT}, {ID($ge), OP_GE},
+			{ID($shl), OP_SHL}, {ID($sshl), OP_SHL}, {ID($shr), OP_SHR}, {ID($sshr), OP_SSHR},
+			{ID($pmux), OP_PMUX}, {ID($bwmux), OP_BWMUX}, {ID($_NMUX_), OP_NMUX}, {ID($_AOI3_), OP_AOI3}, {ID($_OAI3_), OP_OAI3},
+		};
+
+		op_t op;
+		auto it = op_types.find(cell->type);
+		if (it == op_types.end())
+			return op;
+		op.type = it->second;
+		op.signed_a = cell->hasParam(ID::A_SIGNED) && cell->getParam(ID::A_SIGNED).as_bool();
+		op.signed_b = cell->hasParam(ID::B_SIGNED) && cell->getParam(ID::B_SIGNED).as_bool();
+
+		// as in CellTypes::eval, the operands of binary cells other than
+		// shifts are only signed if both are
+		if (op.type > OP_NEG && op.type != OP_SHL && op.type != OP_SHR && op.type != OP_SSHR && !(op.signed_a && op.signed_b))
+			op.signed_a = op.signed_b = false;
+		return op;
+	}
+
+	words_t get(const std::vector<int> &sig, int width, bool is_signed) const
+	{
+		words_t result(width);
+		for (int i = 0; i < width; i++)
+			result[i] = i < GetSize(sig) ? nets[sig[i]] : is_signed && !sig.empty() ? nets[sig.back()] : 0;
+		return result;
+	}
+
+	void put(int net, uint64_t value)
+	{
+		if (net >= BitIndex::num_const_bits)
+			nets[net] = value;
+	}
+
+	void set(const std::vector<int> &sig, const words_t &value)
+	{
+		for (int i = 0; i < GetSize(sig); i++)
+			put(sig[i], i < GetSize(value) ? value[i] : 0);
+	}
+
+	void set(const std::vector<int> &sig, uint64_t value)
+	{
+		for (int n : sig)
+			put(n, value);
+	}
+
+	static words_t add(const words_t &a, const words_t &b, uint64_t carry)
+	{
+		words_t y(a.size());
+		for (size_t i = 0; i < a.size(); i++) {
+			y[i] = a[i] ^ b[i] ^ carry;
+			carry = (a[i] & b[i]) | (carry & (a[i] ^ b[i]));
+		}
+		return y;
+	}
+
+	static words_t sub(const words_t &a, words_t b)
+	{
+		for (auto &w : b)
+			w = ~w;
+		return add(a, b, ~uint64_t(0));
+	}
+
+	static words_t mul(const words_t &a, const words_t &b)
+	{
+		int width = GetSize(a);
+		words_t y(width);
+		for (int i = 0; i < width; i++) {
+			uint64_t carry = 0;
+			for (int j = i; j < width; j++) {
+				uint64_t p = a[j-i] & b[i];
+				uint64_t s = y[j] ^ p ^ carry;
+				carry = (y[j] & p) | (carry & (y[j] ^ p));
+				y[j] = s;
+			}
+		}
+		return y;
+	}
+
+	// shift by the unsigned amount, bits shifted in from above the value are
+	// set to fill, bits shifted in from below are 0
+	static words_t shift(words_t value, const words_t &amount, bool left, uint64_t fill)
+	{
+		int width = GetSize(value);
+		for (int j = 0; j < GetSize(amount); j++) {
+			uint64_t sel = amount[j];
+			if (sel == 0)
+				continue;
+			int dist = j < 30 ? std::min(1 << j, width) : width;
+			words_t shifted(width);
+			for (int i = 0; i < width; i++) {
+				int pos = left ? i - dist : i + dist;
+				shifted[i] = pos < 0 ? 0 : pos >= width ? fill : value[pos];
+			}
+			for (int i = 0; i < width; i++)
+				value[i] = (value[i] & ~sel) | (shifted[i] & sel);
+		}
+		return value;
+	}
+
+	static uint64_t reduce_or(const words_t &a)
+	{
+		uint64_t y = 0;
+		for (auto w : a)
+			y |= w;
+		return y;
+	}
+
+	// truncating division by magnitude, as const_div and const_mod, with
+	// division by zero giving x (i.e. 0)
+	void div_mod(const std::vector<int> &sig_a, const std::vector<int> &sig_b, bool is_signed, words_t &quotient, words_t &remainder) const
+	{
+		int width = std::max(GetSize(sig_a), GetSize(sig_b)) + 1;
+		words_t a = get(sig_a, width, is_signed), b = get(sig_b, width + 1, is_signed);
+		uint64_t neg_a = is_signed ? a.back() : 0, neg_b = is_signed ? b.back() : 0;
+		auto negate_if = [](words_t &value, uint64_t neg) {
+			for (auto &w : value)
+				w ^= neg;
+			value = add(value, words_t(value.size()), neg);
+		};
+		negate_if(a, neg_a);
+		negate_if(b, neg_b);
+		uint64_t nonzero = reduce_or(b);
+		b.push_back(0);
+
+		quotient.assign(width, 0);
+		words_t r(width + 2);
+		for (int i = width - 1; i >= 0; i--) {
+			r.pop_back();
+			r.insert(r.begin(), a[i]);
+			words_t diff = sub(r, b);
+			uint64_t ge = ~diff.back();
+			for (int j = 0; j < width + 2; j++)
+				r[j] = (r[j] & ~ge) | (diff[j] & ge);
+			quotient[i] = ge;
+		}
+		r.resize(width);
+		remainder = r;
+
+		negate_if(quotient, neg_a ^ neg_b);
+		negate_if(remainder, neg_a);
+		for (int i = 0; i < width; i++) {
+			quotient[i] &= nonzero;
+			remainder[i] &= nonzero;
+		}
+	}
+
+	uint64_t less_than(const std::vector<int> &a, bool signed_a, const std::vector<int> &b, bool signed_b) const
+	{
+		int width = std::max(GetSize(a), GetSize(b)) + 2;
+		return sub(get(a, width, signed_a), get(b, width, signed_b)).back();
+	}
+
+	// Evaluates a cell with the given port nets using the word operation op,
+	// returns false if op is OP_PER_LANE
+	bool eval_op(const op_t &op, const std::vector<int> &sig_a, const std::vector<int> &sig_b,
+			const std::vector<int> &sig_c, const std::vector<int> &sig_s, const std::vector<int> &sig_y)
+	{
+		int width = GetSize(sig_y);
+		bool signed_a = op.signed_a, signed_b = op.signed_b;
+		words_t y(width);
+
+		switch (op.type)
+		{
+		case OP_NOT:
+		case OP_POS:
+		case OP_NEG:
+			y = get(sig_a, width, signed_a);
+			if (op.type == OP_NEG)
+				y = sub(words_t(width), y);
+			else if (op.type == OP_NOT)
+				for (auto &w : y)
+					w = ~w;
+			break;
+		case OP_AND:
+		case OP_OR:
+		case OP_XOR:
+		case OP_XNOR: {
+			words_t a = get(sig_a, width, signed_a), b = get(sig_b, width, signed_b);
+			for (int i = 0; i < width; i++)
+				y[i] = op.type == OP_AND ? a[i] & b[i] : op.type == OP_OR ? a[i] | b[i] :
+						op.type == OP_XOR ? a[i] ^ b[i] : ~(a[i] ^ b[i]);
+			break;
+		}
+		case OP_ADD:
+		case OP_SUB:
+		case OP_MUL: {
+			words_t a = get(sig_a, width, signed_a), b = get(sig_b, width, signed_b);
+			y = op.type == OP_ADD ? add(a, b, 0) : op.type == OP_SUB ? sub(a, b) : mul(a, b);
+			break;
+		}
+		case OP_DIV:
+		case OP_MOD: {
+			words_t quotient, remainder;
+			div_mod(sig_a, sig_b, signed_a, quotient, remainder);
+			words_t &result = op.type == OP_DIV ? quotient : remainder;
+			for (int i = 0; i < width; i++)
+				y[i] = i < GetSize(result) ? result[i] : result.back();
+			break;
+		}
+		case OP_REDUCE_AND:
+			y[0] = ~uint64_t(0);
+			for (int n : sig_a)
+				y[0] &= nets[n];
+			break;
+		case OP_REDUCE_OR:
+		case OP_LOGIC_NOT:
+			y[0] = reduce_or(get(sig_a, GetSize(sig_a), false));
+			if (op.type == OP_LOGIC_NOT)
+				y[0] = ~y[0];
+			break;
+		case OP_REDUCE_XOR:
+		case OP_REDUCE_XNOR:
+			for (int n : sig_a)
+				y[0] ^= nets[n];
+			if (op.type == OP_REDUCE_XNOR)
+				y[0] = ~y[0];
+			break;
+		case OP_LOGIC_AND:
+		case OP_LOGIC_OR: {
+			uint64_t a = reduce_or(get(sig_a, GetSize(sig_a), false)), b = reduce_or(get(sig_b, GetSize(sig_b), false));
+			y[0] = op.type == OP_LOGIC_AND ? a & b : a | b;
+			break;
+		}
+		case OP_EQ:
+		case OP_NE: {
+			int w = std::max(GetSize(sig_a), GetSize(sig_b));
+			words_t a = get(sig_a, w, signed_a), b = get(sig_b, w, signed_b);
+			uint64_t diff = 0;
+			for (int i = 0; i < w; i++)
+				diff |= a[i] ^ b[i];
+			y[0] = op.type == OP_EQ ? ~diff : diff;
+			break;
+		}
+		case OP_LT:
+		case OP_GE:
+			y[0] = less_than(sig_a, signed_a, sig_b, signed_b);
+			if (op.type == OP_GE)
+				y[0] = ~y[0];
+			break;
+		case OP_GT:
+		case OP_LE:
+			y[0] = less_than(sig_b, signed_b, sig_a, signed_a);
+			if (op.type == OP_LE)
+				y[0] = ~y[0];
+			break;
+		case OP_SHL:
+			y = shift(get(sig_a, width, signed_a), get(sig_b, GetSize(sig_b), false), true, 0);
+			break;
+		case OP_SHR:
+		case OP_SSHR: {
+			words_t a = get(sig_a, std::max(width, GetSize(sig_a)), signed_a);
+			uint64_t fill = op.type == OP_SSHR && signed_a && !sig_a.empty() ? nets[sig_a.back()] : 0;
+			y = shift(a, get(sig_b, GetSize(sig_b), false), false, fill);
+			y.resize(width);
+			break;
+		}
+		case OP_PMUX: {
+			// more than one active select gives x, which reads as 0
+			uint64_t any = 0, multiple = 0;
+			for (int k = 0; k < GetSize(sig_s); k++) {
+				uint64_t s = nets[sig_s[k]];
+				multiple |= any & s;
+				any |= s;
+				for (int i = 0; i < width; i++)
+					y[i] |= nets[sig_b[k*width + i]] & s;
+			}
+			for (int i = 0; i < width; i++)
+				y[i] = (y[i] | (nets[sig_a[i]] & ~any)) & ~multiple;
+			break;
+		}
+		case OP_BWMUX:
+			for (int i = 0; i < width; i++)
+				y[i] = (nets[sig_a[i]] & ~nets[sig_s[i]]) | (nets[sig_b[i]] & nets[sig_s[i]]);
+			break;
+		case OP_NMUX:
+			y[0] = ~((nets[sig_a[0]] & ~nets[sig_s[0]]) | (nets[sig_b[0]] & nets[sig_s[0]]));
+			break;
+		case OP_AOI3:
+			y[0] = ~((nets[sig_a[0]] & nets[sig_b[0]]) | nets[sig_c[0]]);
+			break;
+		case OP_OAI3:
+			y[0] = ~((nets[sig_a[0]] | nets[sig_b[0]]) & nets[sig_c[0]]);
+			break;
+		default:
+			return false;
+		}
+
+		set(sig_y, y);
+		return true;
+	}
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
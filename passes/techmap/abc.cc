@@ -48,6 +48,7 @@
 #include "kernel/ff.h"
 #include "kernel/cost.h"
 #include "kernel/log.h"
+#include "kernel/threading.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -56,6 +57,8 @@
 #include <sstream>
 #include <climits>
 #include <vector>
+#include <deque>
+#include <memory>
 
 #ifndef _WIN32
 #  include <unistd.h>
@@ -126,9 +129,70 @@ bool had_init;
 bool clk_polarity, en_polarity, arst_polarity, srst_polarity;
 RTLIL::SigSpec clk_sig, en_sig, arst_sig, srst_sig;
 dict<int, std::string> pi_map, po_map;
+pool<RTLIL::Cell*> extracted_cells;
 
 int undef_bits_lost;
 
+// One ABC run covers a module, or a single clock domain of a module with -dff.
+// Its extraction, the ABC process and the re-integration of the result are
+// separate steps, so that with -j several runs can be in flight at once. The
+// per-run globals above are swapped with an abc_run_t around each step.
+
+struct abc_module_maps_t
+{
+	SigMap assign_map;
+	FfInitVals initvals;
+};
+
+struct abc_run_t
+{
+	// shared by all runs of the same module
+	std::shared_ptr<abc_module_maps_t> maps;
+
+	RTLIL::Module *module = nullptr;
+	int map_autoidx = 0;
+	std::vector<gate_t> signal_list;
+	dict<RTLIL::SigBit, int> signal_map;
+	bool had_init = false;
+	bool clk_polarity = true, en_polarity = true, arst_polarity = true, srst_polarity = true;
+	RTLIL::SigSpec clk_sig, en_sig, arst_sig, srst_sig;
+	dict<int, std::string> pi_map, po_map;
+	pool<RTLIL::Cell*> extracted_cells;
+	std::vector<RTLIL::Cell*> cells;
+
+	std::string tempdir_name, exe_file, abc_command;
+	bool cleanup = true, show_tempdir = false, builtin_lib = true, sop_mode = false;
+
+	// set when the ABC process was started in the background
+	std::vector<std::string> abc_output;
+	int abc_ret = 0;
+#ifdef YOSYS_ENABLE_THREADS
+	std::future<void> abc_done;
+#endif
+};
+
+void swap_run_state(abc_run_t &run)
+{
+	assign_map.swap(run.maps->assign_map);
+	std::swap(initvals, run.maps->initvals);
+	std::swap(module, run.module);
+	std::swap(map_autoidx, run.map_autoidx);
+	std::swap(signal_list, run.signal_list);
+	std::swap(signal_map, run.signal_map);
+	std::swap(had_init, run.had_init);
+	std::swap(clk_polarity, run.clk_polarity);
+	std::swap(en_polarity, run.en_polarity);
+	std::swap(arst_polarity, run.arst_polarity);
+	std::swap(srst_polarity, run.srst_polarity);
+	std::swap(clk_sig, run.clk_sig);
+	std::swap(en_sig, run.en_sig);
+	std::swap(arst_sig, run.arst_sig);
+	std::swap(srst_sig, run.srst_sig);
+	std::swap(pi_map, run.pi_map);
+	std::swap(po_map, run.po_map);
+	std::swap(extracted_cells, run.extracted_cells);
+}
+
 int map_signal(RTLIL::SigBit bit, gate_type_t gate_type = G(NONE), int in1 = -1, int in2 = -1, int in3 = -1, int in4 = -1)
 {
 	assign_map.apply(bit);
@@ -253,7 +317,8 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(ff.sig_q, type, map_signal(ff.sig_d));
 
-		ff.remove();
+		ff.remove_init();
+		extracted_cells.insert(cell);
 		return;
 	}
 
@@ -267,7 +332,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_BUF_) ? G(BUF) : G(NOT), map_signal(sig_a));
 
-		module->remove(cell);
+		extracted_cells.insert(cell);
 		return;
 	}
 
@@ -303,7 +368,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 		else
 			log_abort();
 
-		module->remove(cell);
+		extracted_cells.insert(cell);
 		return;
 	}
 
@@ -325,7 +390,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_MUX_) ? G(MUX) : G(NMUX), mapped_a, mapped_b, mapped_s);
 
-		module->remove(cell);
+		extracted_cells.insert(cell);
 		return;
 	}
 
@@ -347,7 +412,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_AOI3_) ? G(AOI3) : G(OAI3), mapped_a, mapped_b, mapped_c);
 
-		module->remove(cell);
+		extracted_cells.insert(cell);
 		return;
 	}
 
@@ -372,7 +437,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_AOI4_) ? G(AOI4) : G(OAI4), mapped_a, mapped_b, mapped_c, mapped_d);
 
-		module->remove(cell);
+		extracted_cells.insert(cell);
 		return;
 	}
 }
@@ -707,8 +772,11 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		std::vector<std::string> &liberty_files, std::vector<std::string> &genlib_files, std::string constr_file,
 		bool cleanup, vector<int> lut_costs, bool dff_mode, std::string clk_str, bool keepff, std::string delay_target,
 		std::string sop_inputs, std::string sop_products, std::string lutin_shared, bool fast_mode,
-		const std::vector<RTLIL::Cell*> &cells, bool show_tempdir, bool sop_mode, bool abc_dress, std::vector<std::string> &dont_use_cells)
+		const std::vector<RTLIL::Cell*> &cells, bool show_tempdir, bool sop_mode, bool abc_dress, std::vector<std::string> &dont_use_cells,
+		abc_run_t &run, bool defer_removal)
 {
+	swap_run_state(run);
+
 	module = current_module;
 	map_autoidx = autoidx++;
 
@@ -906,9 +974,12 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 			mark_port(wire);
 	}
 
-	for (auto cell : module->cells())
-	for (auto &port_it : cell->connections())
-		mark_port(port_it.second);
+	for (auto cell : module->cells()) {
+		if (extracted_cells.count(cell))
+			continue;
+		for (auto &port_it : cell->connections())
+			mark_port(port_it.second);
+	}
 
 	if (clk_sig.size() != 0)
 		mark_port(clk_sig);
@@ -922,6 +993,15 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 	if (srst_sig.size() != 0)
 		mark_port(srst_sig);
 
+	// With defer_removal the caller removes the extracted cells only after all
+	// runs of the module are extracted, so that the other runs still see them
+	// as users of the signals they share with this run.
+	if (!defer_removal) {
+		for (auto cell : extracted_cells)
+			module->remove(cell);
+		extracted_cells.clear();
+	}
+
 	handle_loops();
 
 	buffer = stringf("%s/input.blif", tempdir_name.c_str());
@@ -1044,11 +1124,16 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 
 	log("Extracted %d gates and %d wires to a netlist network with %d inputs and %d outputs.\n",
 			count_gates, GetSize(signal_list), count_input, count_output);
-	log_push();
+
+	run.tempdir_name = tempdir_name;
+	run.exe_file = exe_file;
+	run.cleanup = cleanup;
+	run.show_tempdir = show_tempdir;
+	run.builtin_lib = liberty_files.empty() && genlib_files.empty();
+	run.sop_mode = sop_mode;
+
 	if (count_output > 0)
 	{
-		log_header(design, "Executing ABC.\n");
-
 		auto &cell_cost = cmos_cost ? CellCosts::cmos_gate_cost() : CellCosts::default_gate_cost();
 
 		buffer = stringf("%s/stdcells.genlib", tempdir_name.c_str());
@@ -1105,12 +1190,39 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 			fclose(f);
 		}
 
-		buffer = stringf("\"%s\" -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
+		run.abc_command = stringf("\"%s\" -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
+	}
+
+	swap_run_state(run);
+}
+
+void abc_module_integrate(RTLIL::Design *design, abc_run_t &run)
+{
+	swap_run_state(run);
+
+	std::string tempdir_name = run.tempdir_name;
+	bool show_tempdir = run.show_tempdir;
+
+	log_push();
+	if (!run.abc_command.empty())
+	{
+		log_header(design, "Executing ABC.\n");
+
+		std::string buffer = run.abc_command;
 		log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
 
 #ifndef YOSYS_LINK_ABC
 		abc_output_filter filt(tempdir_name, show_tempdir);
-		int ret = run_command(buffer, std::bind(&abc_output_filter::next_line, filt, std::placeholders::_1));
+		int ret;
+#ifdef YOSYS_ENABLE_THREADS
+		if (run.abc_done.valid()) {
+			run.abc_done.get();
+			for (auto &line : run.abc_output)
+				filt.next_line(line);
+			ret = run.abc_ret;
+		} else
+#endif
+			ret = run_command(buffer, std::bind(&abc_output_filter::next_line, filt, std::placeholders::_1));
 #else
 		string temp_stdouterr_name = stringf("%s/stdouterr.txt", tempdir_name.c_str());
 		FILE *temp_stdouterr_w = fopen(temp_stdouterr_name.c_str(), "w");
@@ -1133,7 +1245,7 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		// These needs to be mutable, supposedly due to getopt
 		char *abc_argv[5];
 		string tmp_script_name = stringf("%s/abc.script", tempdir_name.c_str());
-		abc_argv[0] = strdup(exe_file.c_str());
+		abc_argv[0] = strdup(run.exe_file.c_str());
 		abc_argv[1] = strdup("-s");
 		abc_argv[2] = strdup("-f");
 		abc_argv[3] = strdup(tmp_script_name.c_str());
@@ -1164,9 +1276,9 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		if (ifs.fail())
 			log_error("Can't open ABC output file `%s'.\n", buffer.c_str());
 
-		bool builtin_lib = liberty_files.empty() && genlib_files.empty();
+		bool builtin_lib = run.builtin_lib;
 		RTLIL::Design *mapped_design = new RTLIL::Design;
-		parse_blif(mapped_design, ifs, builtin_lib ? ID(DFF) : ID(_dff_), false, sop_mode);
+		parse_blif(mapped_design, ifs, builtin_lib ? ID(DFF) : ID(_dff_), false, run.sop_mode);
 
 		ifs.close();
 
@@ -1441,13 +1553,18 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		log("Don't call ABC as there is nothing to map.\n");
 	}
 
-	if (cleanup)
+	if (run.cleanup)
 	{
 		log("Removing temp directory.\n");
 		remove_directory(tempdir_name);
 	}
 
+	// later clock domains of this module see the connections added above
+	assign_map.set(module);
+
 	log_pop();
+
+	swap_run_state(run);
 }
 
 struct AbcPass : public Pass {
@@ -1633,6 +1750,12 @@ struct AbcPass : public Pass {
 		log("        preserve naming by an equivalence check between the original and\n");
 		log("        post-ABC netlists (experimental).\n");
 		log("\n");
+		log("    -j <N>\n");
+		log("        run up to N ABC processes at the same time. the netlists of all clock\n");
+		log("        domains and modules are extracted up front and the results are\n");
+		log("        re-integrated in order as the ABC processes finish. (default: the\n");
+		log("        value of the yosys -j command line option)\n");
+		log("\n");
 		log("When no target cell library is specified the Yosys standard cell library is\n");
 		log("loaded into ABC before the ABC script is executed.\n");
 		log("\n");
@@ -1666,6 +1789,7 @@ struct AbcPass : public Pass {
 		bool show_tempdir = false, sop_mode = false;
 		bool abc_dress = false;
 		vector<int> lut_costs;
+		int jobs = yosys_jobs;
 		markgroups = false;
 
 		map_mux4 = false;
@@ -1836,6 +1960,10 @@ struct AbcPass : public Pass {
 				markgroups = true;
 				continue;
 			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				jobs = std::max(1, atoi(args[++argidx].c_str()));
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -2041,6 +2169,71 @@ struct AbcPass : public Pass {
 			// enabled_gates.insert("NMUX");
 		}
 
+#if defined(YOSYS_LINK_ABC) || !defined(YOSYS_ENABLE_THREADS)
+		// the linked-in ABC is not reentrant, and background runs need threads
+		jobs = 1;
+#endif
+		bool pipelined = jobs > 1;
+		std::deque<std::unique_ptr<abc_run_t>> pending_runs;
+#ifdef YOSYS_ENABLE_THREADS
+		// declared after pending_runs so that the workers are joined first
+		std::unique_ptr<ThreadPool> abc_pool;
+		if (pipelined)
+			abc_pool.reset(new ThreadPool(jobs));
+#endif
+
+		// Re-integrates runs in the order they were extracted. Unless wait is
+		// set, stops at the first run whose ABC process is still running.
+		auto integrate_runs = [&](bool wait) {
+			while (!pending_runs.empty()) {
+				abc_run_t &run = *pending_runs.front();
+#ifdef YOSYS_ENABLE_THREADS
+				if (!wait && run.abc_done.valid() && run.abc_done.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+					break;
+#else
+				(void)wait;
+#endif
+				abc_module_integrate(design, run);
+				pending_runs.pop_front();
+			}
+		};
+
+		// Extracts the given runs of one module. Without -j each run is
+		// re-integrated before the next one is extracted.
+		auto process_runs = [&](RTLIL::Module *mod, std::vector<std::unique_ptr<abc_run_t>> &runs, bool run_dff_mode, std::string run_clk_str) {
+			auto maps = std::make_shared<abc_module_maps_t>();
+			assign_map.swap(maps->assign_map);
+			std::swap(initvals, maps->initvals);
+
+			std::vector<abc_run_t*> module_runs;
+			for (auto &run : runs) {
+				run->maps = maps;
+				bool this_dff_mode = run_clk_str == "$" ? !run->clk_sig.empty() : run_dff_mode;
+				abc_module(design, mod, script_file, exe_file, liberty_files, genlib_files, constr_file, cleanup, lut_costs, this_dff_mode,
+						run_clk_str, keepff, delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, run->cells, show_tempdir,
+						sop_mode, abc_dress, dont_use_cells, *run, pipelined);
+#ifdef YOSYS_ENABLE_THREADS
+				if (abc_pool && !run->abc_command.empty()) {
+					abc_run_t *r = run.get();
+					r->abc_done = abc_pool->submit([r]() {
+						r->abc_ret = run_command(r->abc_command, [r](const std::string &line) { r->abc_output.push_back(line); });
+					});
+				}
+#endif
+				if (pipelined)
+					module_runs.push_back(run.get());
+				pending_runs.push_back(std::move(run));
+				if (!pipelined)
+					integrate_runs(true);
+			}
+
+			for (auto run : module_runs) {
+				for (auto cell : run->extracted_cells)
+					mod->remove(cell);
+				run->extracted_cells.clear();
+			}
+		};
+
 		for (auto mod : design->selected_modules())
 		{
 			if (mod->processes.size() > 0) {
@@ -2048,12 +2241,16 @@ struct AbcPass : public Pass {
 				continue;
 			}
 
+			integrate_runs(false);
+
 			assign_map.set(mod);
 			initvals.set(&assign_map, mod);
 
 			if (!dff_mode || !clk_str.empty()) {
-				abc_module(design, mod, script_file, exe_file, liberty_files, genlib_files, constr_file, cleanup, lut_costs, dff_mode, clk_str, keepff,
-						delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, mod->selected_cells(), show_tempdir, sop_mode, abc_dress, dont_use_cells);
+				std::vector<std::unique_ptr<abc_run_t>> runs;
+				runs.emplace_back(new abc_run_t);
+				runs.back()->cells = mod->selected_cells();
+				process_runs(mod, runs, dff_mode, clk_str);
 				continue;
 			}
 
@@ -2205,21 +2402,25 @@ struct AbcPass : public Pass {
 						std::get<4>(it.first) ? "" : "!", log_signal(std::get<5>(it.first)),
 						std::get<6>(it.first) ? "" : "!", log_signal(std::get<7>(it.first)));
 
+			std::vector<std::unique_ptr<abc_run_t>> runs;
 			for (auto &it : assigned_cells) {
-				clk_polarity = std::get<0>(it.first);
-				clk_sig = assign_map(std::get<1>(it.first));
-				en_polarity = std::get<2>(it.first);
-				en_sig = assign_map(std::get<3>(it.first));
-				arst_polarity = std::get<4>(it.first);
-				arst_sig = assign_map(std::get<5>(it.first));
-				srst_polarity = std::get<6>(it.first);
-				srst_sig = assign_map(std::get<7>(it.first));
-				abc_module(design, mod, script_file, exe_file, liberty_files, genlib_files, constr_file, cleanup, lut_costs, !clk_sig.empty(), "$",
-						keepff, delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, it.second, show_tempdir, sop_mode, abc_dress, dont_use_cells);
-				assign_map.set(mod);
+				runs.emplace_back(new abc_run_t);
+				abc_run_t &run = *runs.back();
+				run.clk_polarity = std::get<0>(it.first);
+				run.clk_sig = assign_map(std::get<1>(it.first));
+				run.en_polarity = std::get<2>(it.first);
+				run.en_sig = assign_map(std::get<3>(it.first));
+				run.arst_polarity = std::get<4>(it.first);
+				run.arst_sig = assign_map(std::get<5>(it.first));
+				run.srst_polarity = std::get<6>(it.first);
+				run.srst_sig = assign_map(std::get<7>(it.first));
+				run.cells = it.second;
 			}
+			process_runs(mod, runs, true, "$");
 		}
 
+		integrate_runs(true);
+
 		assign_map.clear();
 		signal_list.clear();
 		signal_map.clear();
@@ -26,6 +26,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/rtlil.h"
 #include "kernel/log.h"
+#include "kernel/threading.h"
 
 // abc9_exe.cc
 std::string fold_abc9_cmd(std::string str);
@@ -171,6 +172,12 @@ struct Abc9Pass : public ScriptPass
 		log("    -box <file>\n");
 		log("        pass this file with box library to ABC.\n");
 		log("\n");
+		log("    -j <N>\n");
+		log("        write the XAIGER files of all selected modules first, then run up to N\n");
+		log("        ABC processes at the same time with a single abc9_exe call, and read\n");
+		log("        the results back in module order. (default: the value of the yosys\n");
+		log("        -j command line option)\n");
+		log("\n");
 		log("Note that this is a logic optimization pass within Yosys that is calling ABC\n");
 		log("internally. This is not going to \"run ABC on your design\". It will instead run\n");
 		log("ABC on logic snippets extracted from your design. You will not get any useful\n");
@@ -188,6 +195,7 @@ struct Abc9Pass : public ScriptPass
 	bool dff_mode, cleanup;
 	bool lut_mode;
 	int maxlut;
+	int jobs;
 	std::string box_file;
 
 	void clear_flags() override
@@ -198,6 +206,7 @@ struct Abc9Pass : public ScriptPass
 		cleanup = true;
 		lut_mode = false;
 		maxlut = 0;
+		jobs = yosys_jobs;
 		box_file = "";
 	}
 
@@ -250,6 +259,10 @@ struct Abc9Pass : public ScriptPass
 				maxlut = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				jobs = std::max(1, atoi(args[++argidx].c_str()));
+				continue;
+			}
 			if (arg == "-run" && argidx+1 < args.size()) {
 				size_t pos = args[argidx+1].find(':');
 				if (pos == std::string::npos)
@@ -393,6 +406,24 @@ struct Abc9Pass : public ScriptPass
 				auto selected_modules = active_design->selected_modules();
 				active_design->selection_stack.emplace_back(false);
 
+				auto read_back = [&](RTLIL::Module *mod, const std::string &tempdir_name) {
+					run_nocheck(stringf("read_aiger -xaiger -wideports -module_name %s$abc9 -map %s/input.sym %s/output.aig", log_id(mod), tempdir_name.c_str(), tempdir_name.c_str()));
+					run_nocheck(stringf("abc9_ops -reintegrate %s", dff_mode ? "-dff" : ""));
+				};
+
+				auto finish_module = [&](RTLIL::Module *mod, const std::string &tempdir_name) {
+					if (cleanup) {
+						log("Removing temp directory.\n");
+						remove_directory(tempdir_name);
+					}
+					mod->check();
+					active_design->selection().selected_modules.clear();
+					log_pop();
+				};
+
+				// with -j, modules whose ABC run is deferred to a single abc9_exe call
+				std::vector<std::pair<RTLIL::Module*, std::string>> deferred_modules;
+
 				for (auto mod : selected_modules) {
 					if (mod->processes.size() > 0) {
 						log("Skipping module %s as it contains processes.\n", log_id(mod));
@@ -427,6 +458,13 @@ struct Abc9Pass : public ScriptPass
 							log_id(mod),
 							active_design->scratchpad_get_int("write_xaiger.num_inputs"),
 							num_outputs);
+					if (num_outputs && jobs > 1) {
+						deferred_modules.emplace_back(mod, tempdir_name);
+						active_design->selection().selected_modules.clear();
+						log_pop();
+						continue;
+					}
+
 					if (num_outputs) {
 						std::string abc9_exe_cmd;
 						abc9_exe_cmd += stringf("%s -cwd %s", exe_cmd.str().c_str(), tempdir_name.c_str());
@@ -437,19 +475,34 @@ struct Abc9Pass : public ScriptPass
 						else
 							abc9_exe_cmd += stringf(" -box %s", box_file.c_str());
 						run_nocheck(abc9_exe_cmd);
-						run_nocheck(stringf("read_aiger -xaiger -wideports -module_name %s$abc9 -map %s/input.sym %s/output.aig", log_id(mod), tempdir_name.c_str(), tempdir_name.c_str()));
-						run_nocheck(stringf("abc9_ops -reintegrate %s", dff_mode ? "-dff" : ""));
+						read_back(mod, tempdir_name);
 					}
 					else
 						log("Don't call ABC as there is nothing to map.\n");
 
-					if (cleanup) {
-						log("Removing temp directory.\n");
-						remove_directory(tempdir_name);
+					finish_module(mod, tempdir_name);
+				}
+
+				if (!deferred_modules.empty()) {
+					std::string abc9_exe_cmd = stringf("%s -j %d", exe_cmd.str().c_str(), jobs);
+					for (auto &it : deferred_modules)
+						abc9_exe_cmd += stringf(" -cwd %s", it.second.c_str());
+					// the LUT and box libraries are the same for all modules
+					std::string first_tempdir = deferred_modules.front().second;
+					if (!lut_mode)
+						abc9_exe_cmd += stringf(" -lut %s/input.lut", first_tempdir.c_str());
+					if (box_file.empty())
+						abc9_exe_cmd += stringf(" -box %s/input.box", first_tempdir.c_str());
+					else
+						abc9_exe_cmd += stringf(" -box %s", box_file.c_str());
+					run_nocheck(abc9_exe_cmd);
+
+					for (auto &it : deferred_modules) {
+						log_push();
+						active_design->selection().select(it.first);
+						read_back(it.first, it.second);
+						finish_module(it.first, it.second);
 					}
-					mod->check();
-					active_design->selection().selected_modules.clear();
-					log_pop();
 				}
 
 				active_design->selection_stack.pop_back();
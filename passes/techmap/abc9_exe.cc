@@ -24,6 +24,7 @@
 
 #include "kernel/register.h"
 #include "kernel/log.h"
+#include "kernel/threading.h"
 
 #ifndef _WIN32
 #  include <unistd.h>
@@ -164,9 +165,17 @@ struct abc9_output_filter
 	}
 };
 
-void abc9_module(RTLIL::Design *design, std::string script_file, std::string exe_file,
+// Output of an ABC process that was run in the background
+struct abc9_process_t
+{
+	std::vector<std::string> output;
+	int ret = 0;
+};
+
+// Writes the ABC script into tempdir_name and returns the command that runs it.
+std::string abc9_module_prepare(RTLIL::Design *design, std::string script_file, std::string exe_file,
 		vector<int> lut_costs, bool dff_mode, std::string delay_target, std::string /*lutin_shared*/, bool fast_mode,
-		bool show_tempdir, std::string box_file, std::string lut_file,
+		std::string box_file, std::string lut_file,
 		std::vector<std::string> liberty_files, std::string wire_delay, std::string tempdir_name,
 		std::string constr_file, std::vector<std::string> dont_use_cells)
 {
@@ -261,8 +270,6 @@ void abc9_module(RTLIL::Design *design, std::string script_file, std::string exe
 
 	std::string buffer;
 
-	log_header(design, "Executing ABC9.\n");
-
 	if (!lut_costs.empty()) {
 		buffer = stringf("%s/lutdefs.txt", tempdir_name.c_str());
 		f = fopen(buffer.c_str(), "wt");
@@ -273,13 +280,29 @@ void abc9_module(RTLIL::Design *design, std::string script_file, std::string exe
 		fclose(f);
 	}
 
-	buffer = stringf("\"%s\" -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
+	return stringf("\"%s\" -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
+}
+
+// Runs the command returned by abc9_module_prepare(). If process is given,
+// the command has already been run and only its output is logged.
+void abc9_module_run(RTLIL::Design *design, std::string buffer, std::string exe_file, std::string tempdir_name,
+		bool show_tempdir, const abc9_process_t *process = nullptr)
+{
+	log_header(design, "Executing ABC9.\n");
 	log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
 
 #ifndef YOSYS_LINK_ABC
+	(void)exe_file;
 	abc9_output_filter filt(tempdir_name, show_tempdir);
-	int ret = run_command(buffer, std::bind(&abc9_output_filter::next_line, filt, std::placeholders::_1));
+	int ret;
+	if (process != nullptr) {
+		for (auto &line : process->output)
+			filt.next_line(line);
+		ret = process->ret;
+	} else
+		ret = run_command(buffer, std::bind(&abc9_output_filter::next_line, filt, std::placeholders::_1));
 #else
+	log_assert(process == nullptr);
 	string temp_stdouterr_name = stringf("%s/stdouterr.txt", tempdir_name.c_str());
 	FILE *temp_stdouterr_w = fopen(temp_stdouterr_name.c_str(), "w");
 	if (temp_stdouterr_w == NULL)
@@ -425,6 +448,14 @@ struct Abc9ExePass : public Pass {
 		log("        file is expected. temporary files will be created in this directory, and\n");
 		log("        the mapped result will be written to 'output.aig'.\n");
 		log("\n");
+		log("        this option can be used multiple times to run ABC on several netlists\n");
+		log("        with the same options.\n");
+		log("\n");
+		log("    -j <N>\n");
+		log("        when -cwd is used multiple times, run up to N ABC processes at the same\n");
+		log("        time. their output is logged in the order of the -cwd options.\n");
+		log("        (default: the value of the yosys -j command line option)\n");
+		log("\n");
 		log("Note that this is a logic optimization pass within Yosys that is calling ABC\n");
 		log("internally. This is not going to \"run ABC on your design\". It will instead run\n");
 		log("ABC on logic snippets extracted from your design. You will not get any useful\n");
@@ -443,7 +474,8 @@ struct Abc9ExePass : public Pass {
 		std::string script_file, clk_str, box_file, lut_file, constr_file;
 		std::vector<std::string> liberty_files, dont_use_cells;
 		std::string delay_target, lutin_shared = "-S 1", wire_delay;
-		std::string tempdir_name;
+		std::vector<std::string> tempdir_names;
+		int jobs = yosys_jobs;
 		bool fast_mode = false, dff_mode = false;
 		bool show_tempdir = false;
 		vector<int> lut_costs;
@@ -526,7 +558,11 @@ struct Abc9ExePass : public Pass {
 				continue;
 			}
 			if (arg == "-cwd" && argidx+1 < args.size()) {
-				tempdir_name = args[++argidx];
+				tempdir_names.push_back(args[++argidx]);
+				continue;
+			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				jobs = std::max(1, atoi(args[++argidx].c_str()));
 				continue;
 			}
 			if (arg == "-liberty" && argidx+1 < args.size()) {
@@ -598,14 +634,34 @@ struct Abc9ExePass : public Pass {
 		if (!box_file.empty() && !is_absolute_path(box_file) && box_file[0] != '+')
 			box_file = std::string(pwd) + "/" + box_file;
 
-		if (tempdir_name.empty())
+		if (tempdir_names.empty())
 			log_cmd_error("abc9_exe '-cwd' option is mandatory.\n");
 
+		std::vector<std::string> commands;
+		for (auto &tempdir_name : tempdir_names)
+			commands.push_back(abc9_module_prepare(design, script_file, exe_file, lut_costs, dff_mode,
+					delay_target, lutin_shared, fast_mode,
+					box_file, lut_file, liberty_files, wire_delay, tempdir_name,
+					constr_file, dont_use_cells));
+
+#if defined(YOSYS_ENABLE_THREADS) && !defined(YOSYS_LINK_ABC)
+		if (jobs > 1 && GetSize(commands) > 1) {
+			std::vector<abc9_process_t> processes(GetSize(commands));
+			parallel_for(GetSize(commands), jobs, [&](int i) {
+				processes[i].ret = run_command(commands[i], [&](const std::string &line) {
+					processes[i].output.push_back(line);
+				});
+			});
+			for (int i = 0; i < GetSize(commands); i++)
+				abc9_module_run(design, commands[i], exe_file, tempdir_names[i], show_tempdir, &processes[i]);
+			return;
+		}
+#else
+		(void)jobs;
+#endif
 
-		abc9_module(design, script_file, exe_file, lut_costs, dff_mode,
-				delay_target, lutin_shared, fast_mode, show_tempdir,
-				box_file, lut_file, liberty_files, wire_delay, tempdir_name,
-				constr_file, dont_use_cells);
+		for (int i = 0; i < GetSize(commands); i++)
+			abc9_module_run(design, commands[i], exe_file, tempdir_names[i], show_tempdir);
 	}
 } Abc9ExePass;
 
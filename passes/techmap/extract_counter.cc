@@ -881,7 +881,7 @@ struct ExtractCounterPass : public Pass {
 			pool<Cell*> cells_to_remove;
 			pool<pair<Cell*, string>> cells_to_rename;
 
-			ModIndex index(module);
+			ModIndex &index = design->modindex(module);
 			for (auto cell : module->selected_cells())
 				counter_worker(index, cell, total_counters, cells_to_remove, cells_to_rename, settings);
 
@@ -160,6 +160,8 @@ struct FlattenWorker
 			design->select(module, new_proc);
 		}
 
+		// the new cells are connected by rewriting their ports in place
+		module->blackout();
 		for (auto tpl_cell : tpl->cells()) {
 			RTLIL::Cell *new_cell = module->addCell(map_name(cell, tpl_cell), tpl_cell);
 			map_attributes(cell, new_cell, tpl_cell->name);
@@ -451,7 +451,7 @@ struct FlowmapWorker
 
 	RTLIL::Module *module;
 	SigMap sigmap;
-	ModIndex index;
+	ModIndex &index;
 
 	dict<RTLIL::SigBit, ModIndex::PortInfo> node_origins;
 
@@ -1439,7 +1439,7 @@ struct FlowmapWorker
 	              bool relax, int optarea, bool debug, bool debug_relax,
 	              RTLIL::Module *module) :
 		order(order), r_alpha(r_alpha), r_beta(r_beta), r_gamma(r_gamma), debug(debug), debug_relax(debug_relax),
-		module(module), sigmap(module), index(module)
+		module(module), sigmap(module), index(module->design->modindex(module))
 	{
 		log("Labeling cells.\n");
 		discover_nodes(cell_types);
@@ -456,13 +456,12 @@ void simplemap_get_mappers(dict<IdString, void(*)(RTLIL::Module*, RTLIL::Cell*)>
 
 void simplemap(RTLIL::Module *module, RTLIL::Cell *cell)
 {
-	static dict<IdString, void(*)(RTLIL::Module*, RTLIL::Cell*)> mappers;
-	static bool initialized_mappers = false;
-
-	if (!initialized_mappers) {
+	// initialized only once even when called from parallel passes
+	static const dict<IdString, void(*)(RTLIL::Module*, RTLIL::Cell*)> mappers = []() {
+		dict<IdString, void(*)(RTLIL::Module*, RTLIL::Cell*)> mappers;
 		simplemap_get_mappers(mappers);
-		initialized_mappers = true;
-	}
+		return mappers;
+	}();
 
 	mappers.at(cell->type)(module, cell);
 }
@@ -496,9 +495,12 @@ struct SimplemapPass : public Pass {
 		dict<IdString, void(*)(RTLIL::Module*, RTLIL::Cell*)> mappers;
 		simplemap_get_mappers(mappers);
 
-		for (auto mod : design->modules()) {
-			if (!design->selected(mod) || mod->get_blackbox_attribute())
-				continue;
+		std::vector<RTLIL::Module*> modules;
+		for (auto mod : design->modules())
+			if (design->selected(mod) && !mod->get_blackbox_attribute())
+				modules.push_back(mod);
+
+		parallel_for_modules(design, modules, [&](RTLIL::Module *mod) {
 			std::vector<RTLIL::Cell*> cells = mod->cells();
 			for (auto cell : cells) {
 				if (mappers.count(cell->type) == 0)
@@ -509,7 +511,7 @@ struct SimplemapPass : public Pass {
 				mappers.at(cell->type)(mod, cell);
 				mod->remove(cell);
 			}
-		}
+		});
 	}
 } SimplemapPass;
 
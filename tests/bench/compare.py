@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Compare two result files of run_bench.py and report regressions.
+
+Exits with status 1 if a benchmark, or a single command in a benchmark, got
+slower or used more memory than allowed by the thresholds. Changes that are
+below the absolute minimums are treated as noise and never reported.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        results = json.load(f)
+    if results.get("format") != 1:
+        sys.exit(f"{path}: unsupported result format")
+    return results
+
+
+def change(old, new):
+    if old == 0:
+        return 0.0 if new == 0 else float("inf")
+    return new / old - 1.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("baseline", help="result file of the reference version")
+    parser.add_argument("current", help="result file of the version under test")
+    parser.add_argument("--metric", choices=["wall_s", "cpu_s"], default="cpu_s",
+                        help="time to compare (default: cpu_s, which is less sensitive to load)")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="allowed relative slowdown (default: 0.10)")
+    parser.add_argument("--min-time", type=float, default=0.05,
+                        help="ignore slowdowns of less than this many seconds (default: 0.05)")
+    parser.add_argument("--memory-threshold", type=float, default=0.10,
+                        help="allowed relative growth of the peak RSS (default: 0.10)")
+    parser.add_argument("--min-memory", type=float, default=8.0,
+                        help="ignore peak RSS growth of less than this many MB (default: 8)")
+    parser.add_argument("-v", "--verbose", action="store_true", help="also list the individual commands")
+    args = parser.parse_args()
+
+    old, new = load(args.baseline), load(args.current)
+    for key in ("scale", "seed", "skip"):
+        if old.get(key) != new.get(key):
+            print(f"Warning: results were recorded with different `{key}' settings.")
+
+    regressions = []
+
+    def check_time(what, old_value, new_value):
+        rel = change(old_value, new_value)
+        if rel > args.threshold and new_value - old_value >= args.min_time:
+            regressions.append(f"{what}: {old_value:.2f} s -> {new_value:.2f} s ({rel:+.0%})")
+        return rel
+
+    def check_memory(what, old_value, new_value):
+        rel = change(old_value, new_value)
+        if rel > args.memory_threshold and new_value - old_value >= args.min_memory:
+            regressions.append(f"{what}: {old_value:.1f} MB -> {new_value:.1f} MB ({rel:+.0%})")
+        return rel
+
+    metric = args.metric
+    print(f"{'benchmark':32} {'old':>9} {'new':>9} {'change':>8} {'old MB':>9} {'new MB':>9} {'change':>8}")
+    for name, cur in new["benchmarks"].items():
+        ref = old["benchmarks"].get(name)
+        if ref is None:
+            print(f"{name:32} (not in baseline)")
+            continue
+        time_rel = check_time(name, ref[metric], cur[metric])
+        mem_rel = check_memory(name, ref["peak_rss_mb"], cur["peak_rss_mb"])
+        print(f"{name:32} {ref[metric]:9.2f} {cur[metric]:9.2f} {time_rel:+8.1%} "
+              f"{ref['peak_rss_mb']:9.1f} {cur['peak_rss_mb']:9.1f} {mem_rel:+8.1%}")
+
+        for step, cur_step in cur["steps"].items():
+            ref_step = ref["steps"].get(step)
+            if ref_step is None:
+                continue
+            step_rel = check_time(f"{name}: {step}", ref_step[metric], cur_step[metric])
+            if args.verbose:
+                print(f"  {step[:30]:30} {ref_step[metric]:9.2f} {cur_step[metric]:9.2f} {step_rel:+8.1%}")
+
+    for name in old["benchmarks"]:
+        if name not in new["benchmarks"]:
+            print(f"{name:32} (missing)")
+
+    if regressions:
+        print()
+        print("Regressions:")
+        for line in regressions:
+            print(f"  {line}")
+        return 1
+    print()
+    print("No regressions.")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
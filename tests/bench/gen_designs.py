@@ -0,0 +1,263 @@
+#!/usr/bin/env python3
+"""Deterministic generators for the synthetic designs of the benchmark suite.
+
+Every generator takes a scale factor and a seed and always produces the same
+Verilog for the same arguments, so that results of different runs (and of
+different Yosys versions) can be compared. All top modules are called `top`
+and have a `clk` input and an active-high synchronous `rst` input.
+"""
+
+import argparse
+import random
+from pathlib import Path
+
+
+def scaled(value, scale, minimum=1):
+    return max(minimum, int(round(value * scale)))
+
+
+def datapath(scale, seed):
+    """Wide pipelined datapath with adders, multipliers, shifters and logic."""
+    rng = random.Random(seed)
+    width = scaled(128, scale, 16)
+    stages = scaled(16, scale, 2)
+    lines = [
+        "module top(input clk, input rst,",
+        f"\tinput [{width-1}:0] a, b, c,",
+        f"\toutput [{width-1}:0] y);",
+    ]
+    for i in range(stages + 1):
+        lines.append(f"\treg [{width-1}:0] r{i}, s{i};")
+    lines.append("\talways @(posedge clk) begin")
+    lines.append("\t\tif (rst) begin")
+    for i in range(stages + 1):
+        lines.append(f"\t\t\tr{i} <= 0; s{i} <= 0;")
+    lines.append("\t\tend else begin")
+    lines.append("\t\t\tr0 <= a; s0 <= b ^ c;")
+    for i in range(1, stages + 1):
+        p, q = f"r{i-1}", f"s{i-1}"
+        op = rng.choice(["add", "sub", "mul", "shift", "logic", "cmp"])
+        if op == "add":
+            expr = f"{p} + {q} + c"
+        elif op == "sub":
+            expr = f"{p} - {q}"
+        elif op == "mul":
+            expr = f"{p}[15:0] * {q}[15:0] + {p}"
+        elif op == "shift":
+            expr = f"({p} >> {q}[5:0]) | ({p} << {rng.randrange(1, width)})"
+        elif op == "logic":
+            expr = f"({p} & ~{q}) ^ ({q} | {width}'d{rng.getrandbits(width)})"
+        else:
+            expr = f"{p} < {q} ? {p} : {q} + 1"
+        lines.append(f"\t\t\tr{i} <= {expr};")
+        lines.append(f"\t\t\ts{i} <= {q} ^ {{{p}[0], {p}[{width-1}:1]}};")
+    lines.append("\t\tend")
+    lines.append("\tend")
+    lines.append(f"\tassign y = r{stages} ^ s{stages};")
+    lines.append("endmodule")
+    return "\n".join(lines) + "\n"
+
+
+def muxtree(scale, seed):
+    """Deep multiplexer trees, both as a case statement and as nested ternaries."""
+    rng = random.Random(seed)
+    depth = scaled(9, scale, 2)
+    width = scaled(32, scale, 4)
+    inputs = 8
+    lines = [
+        "module top(input clk, input rst,",
+        f"\tinput [{depth-1}:0] sel,",
+        f"\tinput [{inputs*width-1}:0] d,",
+        f"\toutput reg [{width-1}:0] q1, q2);",
+    ]
+    leaves = []
+    for i in range(1 << depth):
+        src = rng.randrange(inputs)
+        rot = rng.randrange(width)
+        const = rng.getrandbits(width)
+        word = f"d[{src*width+width-1}:{src*width}]"
+        if rot:
+            leaves.append(f"{{{word}[{rot-1}:0], {word}[{width-1}:{rot}]}} ^ {width}'d{const}")
+        else:
+            leaves.append(f"{word} ^ {width}'d{const}")
+
+    lines.append("\talways @(posedge clk) begin")
+    lines.append("\t\tif (rst)")
+    lines.append("\t\t\tq1 <= 0;")
+    lines.append("\t\telse case (sel)")
+    for i, leaf in enumerate(leaves):
+        lines.append(f"\t\t\t{depth}'d{i}: q1 <= {leaf};")
+    lines.append("\t\tendcase")
+    lines.append("\tend")
+
+    def tree(level, index):
+        if level < 0:
+            return f"({leaves[index]})"
+        low = tree(level - 1, index)
+        high = tree(level - 1, index | (1 << level))
+        return f"(sel[{level}] ? {high} : {low})"
+
+    lines.append(f"\twire [{width-1}:0] t = {tree(depth - 1, 0)};")
+    lines.append("\talways @(posedge clk)")
+    lines.append("\t\tq2 <= rst ? 0 : t;")
+    lines.append("endmodule")
+    return "\n".join(lines) + "\n"
+
+
+def memory(scale, seed):
+    """Several large memories: simple dual port, byte enables, true dual port, ROM."""
+    rng = random.Random(seed)
+    abits = max(6, 10 + int(round((scale - 1) * 2)))
+    width = 32
+    words = 1 << abits
+    lines = [
+        "module top(input clk, input rst,",
+        f"\tinput [{abits-1}:0] ra, wa, ra2, wa2,",
+        f"\tinput [{width-1}:0] wd, wd2,",
+        "\tinput we, we2,",
+        "\tinput [3:0] be,",
+        f"\toutput reg [{width-1}:0] rd0, rd1, rd2, rd3, rd4);",
+        f"\treg [{width-1}:0] sdp [0:{words-1}];",
+        f"\treg [{width-1}:0] bytes [0:{words-1}];",
+        f"\treg [{width-1}:0] tdp [0:{words-1}];",
+        f"\treg [{width-1}:0] rom [0:{words-1}];",
+        "\tinteger i;",
+        "\tinitial begin",
+    ]
+    for i in range(words):
+        lines.append(f"\t\trom[{i}] = {width}'h{rng.getrandbits(width):08x};")
+    lines += [
+        "\tend",
+        "\talways @(posedge clk) begin",
+        "\t\tif (we) sdp[wa] <= wd;",
+        "\t\trd0 <= sdp[ra];",
+        "\tend",
+        "\talways @(posedge clk) begin",
+        "\t\tfor (i = 0; i < 4; i = i + 1)",
+        "\t\t\tif (be[i]) bytes[wa][i*8 +: 8] <= wd[i*8 +: 8];",
+        "\t\trd1 <= bytes[ra];",
+        "\tend",
+        "\talways @(posedge clk) begin",
+        "\t\tif (we) tdp[wa] <= wd;",
+        "\t\trd2 <= tdp[wa];",
+        "\tend",
+        "\talways @(posedge clk) begin",
+        "\t\tif (we2) tdp[wa2] <= wd2;",
+        "\t\trd3 <= tdp[ra2];",
+        "\tend",
+        "\talways @(posedge clk)",
+        "\t\trd4 <= rst ? 0 : rom[ra ^ ra2];",
+        "endmodule",
+    ]
+    return "\n".join(lines) + "\n"
+
+
+def fsm(scale, seed):
+    """A big state machine with random transitions and registered outputs."""
+    rng = random.Random(seed)
+    states = scaled(256, scale, 4)
+    bits = (states - 1).bit_length()
+    ninputs = 8
+    width = 16
+    lines = [
+        "module top(input clk, input rst,",
+        f"\tinput [{ninputs-1}:0] in,",
+        f"\toutput reg [{width-1}:0] out);",
+        f"\treg [{bits-1}:0] state;",
+        "\talways @(posedge clk) begin",
+        "\t\tif (rst) begin",
+        "\t\t\tstate <= 0;",
+        "\t\t\tout <= 0;",
+        "\t\tend else case (state)",
+    ]
+    for s in range(states):
+        lines.append(f"\t\t\t{bits}'d{s}: begin")
+        lines.append(f"\t\t\t\tout <= {width}'d{rng.getrandbits(width)};")
+        conds = rng.randrange(1, 4)
+        for j in range(conds):
+            kw = "if" if j == 0 else "else if"
+            bit = rng.randrange(ninputs)
+            val = rng.randrange(2)
+            lines.append(f"\t\t\t\t{kw} (in[{bit}] == 1'b{val}) state <= {bits}'d{rng.randrange(states)};")
+        lines.append(f"\t\t\t\telse state <= {bits}'d{(s + 1) % states};")
+        lines.append("\t\t\tend")
+    lines += [
+        "\t\t\tdefault: state <= 0;",
+        "\t\tendcase",
+        "\tend",
+        "endmodule",
+    ]
+    return "\n".join(lines) + "\n"
+
+
+def hierarchy(scale, seed):
+    """A systolic array of separately defined multiply-accumulate modules."""
+    rng = random.Random(seed)
+    size = scaled(8, scale, 2)
+    width = 8
+    lines = [
+        "module pe #(parameter [7:0] K = 0) (input clk, input rst,",
+        f"\tinput [{width-1}:0] a_in, b_in,",
+        f"\toutput reg [{width-1}:0] a_out, b_out,",
+        f"\toutput reg [{4*width-1}:0] acc);",
+        "\talways @(posedge clk) begin",
+        "\t\tif (rst) begin",
+        "\t\t\ta_out <= 0; b_out <= 0; acc <= 0;",
+        "\t\tend else begin",
+        "\t\t\ta_out <= a_in;",
+        "\t\t\tb_out <= b_in ^ K;",
+        "\t\t\tacc <= acc + a_in * b_in;",
+        "\t\tend",
+        "\tend",
+        "endmodule",
+        "",
+        "module top(input clk, input rst,",
+        f"\tinput [{size*width-1}:0] a, b,",
+        f"\toutput [{4*width-1}:0] y);",
+    ]
+    for r in range(size + 1):
+        for c in range(size + 1):
+            lines.append(f"\twire [{width-1}:0] ah_{r}_{c}, bv_{r}_{c};")
+    for r in range(size):
+        for c in range(size):
+            lines.append(f"\twire [{4*width-1}:0] acc_{r}_{c};")
+    for i in range(size):
+        lines.append(f"\tassign ah_{i}_0 = a[{i*width+width-1}:{i*width}];")
+        lines.append(f"\tassign bv_0_{i} = b[{i*width+width-1}:{i*width}];")
+    for r in range(size):
+        for c in range(size):
+            lines.append(f"\tpe #(.K(8'd{rng.getrandbits(8)})) pe_{r}_{c} (.clk(clk), .rst(rst),")
+            lines.append(f"\t\t.a_in(ah_{r}_{c}), .b_in(bv_{r}_{c}), .a_out(ah_{r}_{c+1}), .b_out(bv_{r+1}_{c}),")
+            lines.append(f"\t\t.acc(acc_{r}_{c}));")
+    accs = " ^ ".join(f"acc_{r}_{c}" for r in range(size) for c in range(size))
+    lines.append(f"\tassign y = {accs};")
+    lines.append("endmodule")
+    return "\n".join(lines) + "\n"
+
+
+GENERATORS = {
+    "datapath": datapath,
+    "muxtree": muxtree,
+    "memory": memory,
+    "fsm": fsm,
+    "hierarchy": hierarchy,
+}
+
+
+def generate(name, path, scale=1.0, seed=1):
+    Path(path).write_text(GENERATORS[name](scale, seed))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("outdir", type=Path)
+    parser.add_argument("--scale", type=float, default=1.0, help="design size factor (default: 1.0)")
+    parser.add_argument("--seed", type=int, default=1, help="random seed (default: 1)")
+    args = parser.parse_args()
+    args.outdir.mkdir(parents=True, exist_ok=True)
+    for name in GENERATORS:
+        generate(name, args.outdir / f"{name}.v", args.scale, args.seed)
+
+
+if __name__ == "__main__":
+    main()
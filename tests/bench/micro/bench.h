@@ -0,0 +1,30 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "kernel/yosys.h"
+
+#include <chrono>
+
+YOSYS_NAMESPACE_BEGIN
+
+// Benchmark sizes can be changed from the environment, e.g.
+//   YOSYS_BENCH_CELLS=5000000 bin/objpool
+static inline int bench_param(const char *name, int default_value)
+{
+	const char *value = getenv(name);
+	return value != nullptr ? atoi(value) : default_value;
+}
+
+struct BenchTimer
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	double elapsed() const
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
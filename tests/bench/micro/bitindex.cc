@@ -0,0 +1,63 @@
+// Random lookups of the bits of a large module in a dict<SigBit, int> and
+// in a BitVectorMap<int>.
+
+#include "kernel/bitindex.h"
+#include "bench.h"
+
+#include <random>
+
+USING_YOSYS_NAMESPACE
+
+int main()
+{
+	yosys_setup();
+
+	int num_bits = bench_param("YOSYS_BENCH_BITS", 1000000);
+	int num_lookups = bench_param("YOSYS_BENCH_LOOKUPS", 10000000);
+
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	std::vector<RTLIL::SigBit> bits;
+	for (int i = 0; i < num_bits / 8; i++) {
+		RTLIL::Wire *wire = module->addWire(NEW_ID, 8);
+		for (int j = 0; j < 8; j++)
+			bits.push_back(RTLIL::SigBit(wire, j));
+	}
+
+	std::mt19937 rng(1);
+	std::vector<int> order(num_lookups);
+	for (auto &i : order)
+		i = rng() % bits.size();
+
+	dict<RTLIL::SigBit, int> dict_values;
+	for (int i = 0; i < GetSize(bits); i++)
+		dict_values[bits[i]] = i;
+
+	BitIndex index(module);
+	BitVectorMap<int> vector_values(index);
+	for (int i = 0; i < GetSize(bits); i++)
+		vector_values[bits[i]] = i;
+
+	auto measure = [&](const char *name, const std::function<long long()> &lookups) {
+		BenchTimer timer;
+		long long sum = lookups();
+		double elapsed = timer.elapsed();
+		printf("%-14s %d lookups in %.3f s (%.2f M lookups/s)\n", name, num_lookups, elapsed, num_lookups / elapsed / 1e6);
+		return sum;
+	};
+
+	long long dict_sum = measure("dict", [&]() {
+		long long sum = 0;
+		for (int i : order)
+			sum += dict_values.at(bits[i]);
+		return sum;
+	});
+	long long vector_sum = measure("BitVectorMap", [&]() {
+		long long sum = 0;
+		for (int i : order)
+			sum += vector_values[bits[i]];
+		return sum;
+	});
+
+	return dict_sum == vector_sum ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+// const_add on 32-bit operands, which takes the machine word fast path in
+// kernel/calc.cc, and on the same values widened to 80 bits, which does not.
+
+#include "bench.h"
+
+#include <random>
+
+USING_YOSYS_NAMESPACE
+
+static double time_adds(const std::vector<RTLIL::Const> &values, int num_ops, int width)
+{
+	BenchTimer timer;
+	int count = 0;
+	while (count < num_ops)
+		for (int i = 0; i + 1 < GetSize(values) && count < num_ops; i++, count++)
+			RTLIL::const_add(values[i], values[i+1], false, false, width);
+	return timer.elapsed();
+}
+
+int main()
+{
+	yosys_setup();
+
+	int num_ops = bench_param("YOSYS_BENCH_OPS", 5000000);
+
+	std::mt19937 rng(1);
+	std::vector<RTLIL::Const> values, wide_values;
+	for (int i = 0; i < 1000; i++) {
+		values.push_back(RTLIL::Const(int(rng()), 32));
+		wide_values.push_back(values.back());
+		wide_values.back().bits().resize(80, RTLIL::State::S0);
+	}
+
+	double elapsed = time_adds(values, num_ops, 32);
+	printf("const_add: %d 32-bit adds in %.3f s (%.2f M ops/s)\n",
+			num_ops, elapsed, num_ops / elapsed / 1e6);
+	elapsed = time_adds(wide_values, num_ops / 10, 80);
+	printf("const_add: %d 80-bit adds in %.3f s (%.2f M ops/s)\n",
+			num_ops / 10, elapsed, num_ops / 10 / elapsed / 1e6);
+	return 0;
+}
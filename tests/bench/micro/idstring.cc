@@ -0,0 +1,69 @@
+// Interning of IdStrings from several threads at once inside a concurrent
+// section, at the scale of a large flattened design. This is the
+// idstringStressTest unit test at a size that is too slow for every test run.
+
+#include "bench.h"
+
+#include <thread>
+
+USING_YOSYS_NAMESPACE
+
+// Interns num_names names on num_threads threads, half of them shared by all
+// threads, and returns the number of ids that did not read back as their name.
+static int intern_names(int num_threads, int num_names)
+{
+	int names_per_thread = num_names / num_threads;
+	std::vector<int> mismatches(num_threads);
+
+	auto worker = [&](int thread) {
+		std::vector<RTLIL::IdString> local_ids;
+		for (int i = 0; i < names_per_thread; i++) {
+			std::string name = (i & 1) ? stringf("\\shared_%d", (i >> 1) % 1000) :
+					stringf("\\thread_%d_%d", thread, i);
+			RTLIL::IdString id(name);
+			if (id.str() != name)
+				mismatches[thread]++;
+			local_ids.push_back(id);
+			if (GetSize(local_ids) > 64)
+				local_ids.erase(local_ids.begin());
+		}
+	};
+
+	RTLIL::IdString::concurrent_scope scope;
+	std::vector<std::thread> threads;
+	for (int i = 0; i < num_threads; i++)
+		threads.emplace_back(worker, i);
+	for (auto &t : threads)
+		t.join();
+
+	int total = 0;
+	for (int m : mismatches)
+		total += m;
+	return total;
+}
+
+int main()
+{
+#ifndef YOSYS_ENABLE_THREADS
+	printf("skipped, built without YOSYS_ENABLE_THREADS\n");
+	return 0;
+#else
+	yosys_setup();
+
+	int num_threads = bench_param("YOSYS_BENCH_THREADS", 4);
+	int num_names = bench_param("YOSYS_BENCH_NAMES", 2000000);
+
+	for (int threads : {1, num_threads}) {
+		BenchTimer timer;
+		int mismatches = intern_names(threads, num_names);
+		double t = timer.elapsed();
+		printf("%d thread%s  %d names in %.3f s (%.2f M names/s)\n", threads, threads == 1 ? " " : "s",
+				num_names, t, num_names / t / 1e6);
+		if (mismatches != 0) {
+			printf("%d names did not read back correctly\n", mismatches);
+			return 1;
+		}
+	}
+	return 0;
+#endif
+}
@@ -0,0 +1,40 @@
+// Time to build and to tear down a module of single-bit gates, whose cells
+// and wires come from the module's object pools.
+
+#include "bench.h"
+
+#include <sys/resource.h>
+
+USING_YOSYS_NAMESPACE
+
+static long max_rss_kb()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+int main()
+{
+	yosys_setup();
+
+	int num_cells = bench_param("YOSYS_BENCH_CELLS", 200000);
+
+	long rss_before = max_rss_kb();
+	BenchTimer build_timer;
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Module *module = design->addModule(ID(top));
+	RTLIL::Wire *in = module->addWire(ID(in), 64);
+	for (int i = 0; i < num_cells; i++)
+		module->addAndGate(NEW_ID, RTLIL::SigBit(in, i % 64), RTLIL::SigBit(in, (i * 7) % 64), module->addWire(NEW_ID));
+	double build_time = build_timer.elapsed();
+	long rss_after = max_rss_kb();
+
+	BenchTimer teardown_timer;
+	delete design;
+	double teardown_time = teardown_timer.elapsed();
+
+	printf("%d cells: built in %.3f s, torn down in %.3f s, peak RSS grew by %ld MB\n",
+			num_cells, build_time, teardown_time, (rss_after - rss_before) / 1024);
+	return 0;
+}
@@ -0,0 +1,39 @@
+// opt_merge on a module of single-bit AND gates where every other cell
+// repeats the previous one with A and B swapped.
+
+#include "bench.h"
+
+USING_YOSYS_NAMESPACE
+
+int main()
+{
+	yosys_setup();
+
+	int num_cells = bench_param("YOSYS_BENCH_CELLS", 1000000);
+	int num_inputs = 1024;
+
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	RTLIL::Wire *in = module->addWire(ID(in), num_inputs);
+	RTLIL::Wire *out = module->addWire(ID(out), num_cells);
+	in->port_input = true;
+	out->port_output = true;
+	module->fixup_ports();
+
+	uint32_t state = 1;
+	for (int i = 0; i < num_cells; i += 2) {
+		state ^= state << 13, state ^= state >> 17, state ^= state << 5;
+		SigBit x(in, state % num_inputs), y(in, (state >> 16) % num_inputs);
+		module->addAndGate(stringf("$and%d", i), x, y, SigBit(out, i));
+		if (i+1 < num_cells)
+			module->addAndGate(stringf("$and%d", i+1), y, x, SigBit(out, i+1));
+	}
+
+	BenchTimer timer;
+	run_pass("opt_merge", &design);
+	double elapsed = timer.elapsed();
+
+	printf("opt_merge: %d cells in %.3f s (%.2f M cells/s)\n",
+			num_cells, elapsed, num_cells / elapsed / 1e6);
+	return GetSize(module->cells()) <= num_cells - num_cells / 2 ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+"""Run the Yosys benchmark suite and write the results as JSON.
+
+Each benchmark reads one design and runs a fixed script over it in a single
+Yosys process. The time spent in every top-level command is taken from the
+trace written by `yosys --profile`, and the peak RSS and CPU time of the whole
+process from the operating system. Use compare.py to compare two result files.
+"""
+
+import argparse
+import json
+import os
+import platform
+import subprocess
+import sys
+import time
+from pathlib import Path
+
+import gen_designs
+
+bench_path = Path(__file__).resolve().parent
+base_path = bench_path.parent.parent
+
+# the common flow; {top}, {params} and {reset} are filled in per benchmark
+FLOW = [
+    "hierarchy -check -top {top} {params}",
+    "proc",
+    "flatten",
+    "opt",
+    "sim -clock clk {reset} -n 100",
+    "memory -nomap",
+    "memory_libmap -lib +/ice40/brams.txt",
+    "memory_map",
+    "opt",
+    "techmap",
+    "opt -fast",
+    "abc",
+    "opt_clean",
+    "write_verilog -noattr {output}",
+]
+
+BENCHMARKS = {
+    # synthetic designs, see gen_designs.py
+    "datapath": dict(generator="datapath"),
+    "muxtree": dict(generator="muxtree"),
+    "memory": dict(generator="memory"),
+    "fsm": dict(generator="fsm"),
+    "hierarchy": dict(generator="hierarchy"),
+    # real designs from the test suite
+    "picorv32": dict(files=["tests/functional/picorv32.v"], top="picorv32", reset="-resetn resetn"),
+    "picorv32_axi": dict(files=["tests/functional/picorv32.v"], top="picorv32_axi", reset="-resetn resetn",
+                         params="-chparam ENABLE_MUL 1 -chparam ENABLE_DIV 1 -chparam ENABLE_IRQ 1"),
+}
+
+
+def design_files(name, bench, workdir, scale, seed):
+    if "generator" in bench:
+        path = workdir / f"{name}.v"
+        gen_designs.generate(bench["generator"], path, scale, seed)
+        return [path]
+    return [base_path / f for f in bench["files"]]
+
+
+def script(name, bench, files, workdir, skip):
+    # returns (step, command) pairs; the step names leave out the arguments
+    # that differ between benchmarks and checkouts, so they can be compared
+    steps = [("read_verilog", "read_verilog " + " ".join(str(f) for f in files))]
+    seen = {}
+    for cmd in FLOW:
+        if cmd.split()[0] in skip:
+            continue
+        step = " ".join(word for word in cmd.split() if not word.startswith("{"))
+        seen[step] = seen.get(step, 0) + 1
+        if seen[step] > 1:
+            step += f" #{seen[step]}"
+        steps.append((step, cmd.format(top=bench.get("top", "top"), params=bench.get("params", ""),
+                                       reset=bench.get("reset", "-reset rst"), output=workdir / f"{name}_out.v")))
+    return steps
+
+
+# command lines for the `startup' benchmark, each run STARTUP_RUNS times in a
+# fresh process, as wrapper scripts do for small queries
+STARTUP_RUNS = 100
+STARTUP = {
+    "empty": ["-p", ""],
+    "help": ["-p", "help"],
+}
+
+
+def toplevel_spans(trace):
+    # spans are written in the order in which they were opened; a span is a
+    # top-level command if it starts after the previous top-level one ended
+    spans = []
+    end = None
+    for event in trace["traceEvents"]:
+        if event["ph"] != "X" or event["cat"] != "command":
+            continue
+        if end is not None and event["ts"] < end:
+            continue
+        spans.append(event)
+        end = event["ts"] + event["dur"]
+    return spans
+
+
+def run_once(yosys, name, steps, workdir):
+    trace_file = workdir / f"{name}.trace.json"
+    log_file = workdir / f"{name}.log"
+    cmd = [str(yosys), "-Q", "-q", "-l", str(log_file), "--profile", str(trace_file), "-p", "; ".join(cmd for _, cmd in steps)]
+
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd, stdout=subprocess.DEVNULL)
+    _, status, usage = os.wait4(proc.pid, 0)
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    wall = time.perf_counter() - start
+
+    if proc.returncode != 0:
+        print(f"  {name} failed with status {proc.returncode}, see {log_file}", file=sys.stderr)
+        return None
+
+    # ru_maxrss is in kilobytes on Linux and in bytes on macOS
+    rss_scale = 1024 * 1024 if sys.platform == "darwin" else 1024
+    result = {
+        "wall_s": wall,
+        "cpu_s": usage.ru_utime + usage.ru_stime,
+        "peak_rss_mb": usage.ru_maxrss / rss_scale,
+        "steps": {},
+    }
+
+    trace = json.loads(trace_file.read_text())
+    for event in trace["traceEvents"]:
+        if event["ph"] == "X" and event["cat"] == "startup":
+            result["startup_s"] = event["dur"] / 1e6
+    spans = toplevel_spans(trace)
+    if len(spans) != len(steps):
+        print(f"  {name}: expected {len(steps)} commands in {trace_file}, found {len(spans)}", file=sys.stderr)
+        return None
+    for (step, _), span in zip(steps, spans):
+        result["steps"][step] = {
+            "wall_s": span["dur"] / 1e6,
+            "cpu_s": span["args"]["cpu_ms"] / 1e3,
+            "peak_rss_growth_mb": span["args"]["peak_rss_growth_kb"] / 1024,
+            "cells_after": span["args"]["cells_after"],
+        }
+    return result
+
+
+def run_startup(yosys):
+    # total time of STARTUP_RUNS launches per command line, so that the
+    # results are well above the noise thresholds of compare.py
+    result = {"wall_s": 0.0, "cpu_s": 0.0, "peak_rss_mb": 0.0, "steps": {}}
+    rss_scale = 1024 * 1024 if sys.platform == "darwin" else 1024
+    for step, args in STARTUP.items():
+        wall = cpu = 0.0
+        for _ in range(STARTUP_RUNS):
+            start = time.perf_counter()
+            proc = subprocess.Popen([str(yosys), "-Q", "-T", "-q"] + args, stdout=subprocess.DEVNULL)
+            _, status, usage = os.wait4(proc.pid, 0)
+            wall += time.perf_counter() - start
+            if os.waitstatus_to_exitcode(status) != 0:
+                print(f"  startup: `yosys {' '.join(args)}' failed", file=sys.stderr)
+                return None
+            cpu += usage.ru_utime + usage.ru_stime
+            result["peak_rss_mb"] = max(result["peak_rss_mb"], usage.ru_maxrss / rss_scale)
+        result["steps"][step] = {"wall_s": wall, "cpu_s": cpu}
+        result["wall_s"] += wall
+        result["cpu_s"] += cpu
+    return result
+
+
+def best_of(results):
+    # keep the fastest run for timings (least disturbed by other load) and
+    # the largest value for memory, which does not depend on the load
+    best = dict(results[0])
+    for key in ("wall_s", "cpu_s", "startup_s"):
+        if key in best:
+            best[key] = min(r[key] for r in results)
+    best["peak_rss_mb"] = max(r["peak_rss_mb"] for r in results)
+    best["steps"] = {}
+    for step, data in results[0]["steps"].items():
+        runs = [r["steps"][step] for r in results if step in r["steps"]]
+        best["steps"][step] = dict(data)
+        for key in ("wall_s", "cpu_s"):
+            best["steps"][step][key] = min(r[key] for r in runs)
+    return best
+
+
+def yosys_version(yosys):
+    try:
+        return subprocess.run([str(yosys), "-V"], capture_output=True, text=True).stdout.strip()
+    except OSError:
+        return "unknown"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("-o", "--output", type=Path, default=bench_path / "results.json",
+                        help="result file (default: results.json next to this script)")
+    parser.add_argument("--yosys", type=Path, default=base_path / "yosys", help="yosys binary to benchmark")
+    parser.add_argument("--workdir", type=Path, default=bench_path / "work",
+                        help="directory for generated designs, logs and traces")
+    parser.add_argument("--scale", type=float, default=1.0, help="size factor for the synthetic designs")
+    parser.add_argument("--seed", type=int, default=1, help="random seed for the synthetic designs")
+    parser.add_argument("-r", "--repeat", type=int, default=1, help="run every benchmark N times, keep the best")
+    parser.add_argument("--skip", action="append", default=[], metavar="COMMAND",
+                        help="leave COMMAND out of the flow, e.g. `--skip abc` without yosys-abc")
+    parser.add_argument("benchmarks", nargs="*", help="benchmarks to run (default: all)")
+    args = parser.parse_args()
+
+    available = list(BENCHMARKS) + ["startup"]
+    for name in args.benchmarks:
+        if name not in available:
+            parser.error(f"unknown benchmark `{name}', available: {', '.join(available)}")
+    names = args.benchmarks or available
+
+    args.workdir.mkdir(parents=True, exist_ok=True)
+    results = {
+        "format": 1,
+        "yosys": yosys_version(args.yosys),
+        "host": {"machine": platform.machine(), "system": platform.system(), "cpus": os.cpu_count()},
+        "scale": args.scale,
+        "seed": args.seed,
+        "skip": args.skip,
+        "benchmarks": {},
+    }
+
+    failed = False
+    for name in names:
+        if name == "startup":
+            measure = lambda: run_startup(args.yosys)
+        else:
+            bench = BENCHMARKS[name]
+            files = design_files(name, bench, args.workdir, args.scale, args.seed)
+            steps = script(name, bench, files, args.workdir, args.skip)
+            measure = lambda: run_once(args.yosys, name, steps, args.workdir)
+        runs = []
+        for _ in range(args.repeat):
+            run = measure()
+            if run is None:
+                failed = True
+                break
+            runs.append(run)
+        if not runs:
+            continue
+        result = best_of(runs)
+        results["benchmarks"][name] = result
+        print(f"{name:16} {result['wall_s']:8.2f} s {result['cpu_s']:8.2f} s cpu {result['peak_rss_mb']:8.1f} MB")
+
+    args.output.write_text(json.dumps(results, indent=2) + "\n")
+    print(f"Results written to {args.output}.")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+#include "kernel/bitindex.h"
+
+#include <random>
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelBitIndexTest : public testing::Test {
+protected:
+	static void SetUpTestSuite() { yosys_setup(); }
+};
+
+// A module with num_wires wires of random width, with random connections
+// between them and to constants
+static RTLIL::Module *random_module(RTLIL::Design &design, int num_wires, int num_conns, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	RTLIL::Module *module = design.addModule(NEW_ID);
+	std::vector<RTLIL::Wire*> wires;
+	for (int i = 0; i < num_wires; i++)
+		wires.push_back(module->addWire(NEW_ID, 1 + rng() % 16));
+
+	auto random_bit = [&]() -> RTLIL::SigBit {
+		if (rng() % 8 == 0)
+			return RTLIL::State(rng() % 4);
+		RTLIL::Wire *wire = wires[rng() % wires.size()];
+		return RTLIL::SigBit(wire, rng() % wire->width);
+	};
+
+	for (int i = 0; i < num_conns; i++) {
+		RTLIL::SigBit lhs = random_bit();
+		if (lhs.wire == nullptr)
+			continue;
+		module->connect(lhs, random_bit());
+	}
+	return module;
+}
+
+TEST_F(KernelBitIndexTest, RoundTrip)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = random_module(design, 100, 0, 1);
+	BitIndex index(module);
+
+	int expected_size = BitIndex::num_const_bits;
+	for (auto wire : module->wires())
+		expected_size += wire->width;
+	EXPECT_EQ(index.size(), expected_size);
+
+	for (int i = 0; i < index.size(); i++)
+		EXPECT_EQ(index(index[i]), i);
+	EXPECT_EQ(index(RTLIL::State::S1), RTLIL::State::S1);
+
+	EXPECT_TRUE(index.valid());
+	module->addWire(NEW_ID);
+	EXPECT_FALSE(index.valid());
+}
+
+TEST_F(KernelBitIndexTest, IndexesOfTheSameModuleAreIndependent)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = random_module(design, 100, 0, 2);
+	BitIndex before(module);
+	module->sort();
+	BitIndex after(module);
+
+	// sorting the random names reorders the wires, so the numbering changes
+	EXPECT_FALSE(before.valid());
+	EXPECT_TRUE(after.valid());
+	int moved = 0;
+	for (int i = 0; i < before.size(); i++) {
+		EXPECT_EQ(before(before[i]), i);
+		EXPECT_EQ(after(after[i]), i);
+		if (after(before[i]) != i)
+			moved++;
+	}
+	EXPECT_GT(moved, 0);
+}
+
+TEST_F(KernelBitIndexTest, DenseSigMapMatchesSigMap)
+{
+	RTLIL::Design design;
+	for (unsigned seed = 1; seed <= 20; seed++) {
+		RTLIL::Module *module = random_module(design, 50, 200, seed);
+		SigMap sigmap(module);
+		DenseSigMap dense_sigmap(module);
+
+		// promoting changes the representatives the same way in both
+		std::mt19937 rng(seed);
+		std::vector<RTLIL::Wire*> wires(module->wires().begin(), module->wires().end());
+		for (int i = 0; i < 10; i++) {
+			RTLIL::Wire *wire = wires[rng() % wires.size()];
+			RTLIL::SigBit bit(wire, rng() % wire->width);
+			sigmap.add(bit);
+			dense_sigmap.add(bit);
+		}
+
+		for (auto wire : module->wires())
+			EXPECT_EQ(sigmap(wire), dense_sigmap(wire));
+	}
+}
+
+TEST_F(KernelBitIndexTest, BitVectorMap)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	RTLIL::Wire *a = module->addWire(ID(a), 4);
+	RTLIL::Wire *b = module->addWire(ID(b), 2);
+
+	BitIndex index(module);
+	BitVectorMap<int> values(index, -1);
+	values[RTLIL::SigBit(a, 3)] = 3;
+	values[RTLIL::SigBit(b, 0)] = 4;
+
+	EXPECT_EQ(values.size(), BitIndex::num_const_bits + 6);
+	EXPECT_EQ(values.at(RTLIL::SigBit(a, 3)), 3);
+	EXPECT_EQ(values.at(RTLIL::SigBit(b, 0)), 4);
+	EXPECT_EQ(values.at(RTLIL::SigBit(a, 0)), -1);
+	EXPECT_EQ(values[index(RTLIL::SigBit(b, 0))], 4);
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include "kernel/yosys.h"
+
+#include <random>
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelCalcTest : public testing::Test {};
+
+typedef RTLIL::Const (*const_func_t)(const RTLIL::Const&, const RTLIL::Const&, bool, bool, int);
+
+static RTLIL::Const random_const(std::mt19937 &rng, int width)
+{
+	std::vector<RTLIL::State> bits;
+	for (int i = 0; i < width; i++)
+		bits.push_back(rng() % 2 ? RTLIL::State::S1 : RTLIL::State::S0);
+	return bits;
+}
+
+// Widening an operand past 64 bits (by its own signedness) does not change
+// its value, but moves the operation off the machine word fast path.
+static RTLIL::Const widen(RTLIL::Const c, bool is_signed)
+{
+	RTLIL::State padding = is_signed && !c.empty() ? c.back() : RTLIL::State::S0;
+	c.bits().resize(80, padding);
+	return c;
+}
+
+TEST_F(KernelCalcTest, WordFastPathMatchesBigInteger)
+{
+	std::vector<std::pair<const char*, const_func_t>> funcs = {
+		{"and", RTLIL::const_and}, {"or", RTLIL::const_or}, {"xor", RTLIL::const_xor}, {"xnor", RTLIL::const_xnor},
+		{"not", RTLIL::const_not}, {"add", RTLIL::const_add}, {"sub", RTLIL::const_sub}, {"mul", RTLIL::const_mul},
+		{"lt", RTLIL::const_lt}, {"le", RTLIL::const_le}, {"ge", RTLIL::const_ge}, {"gt", RTLIL::const_gt},
+		{"shl", RTLIL::const_shl}, {"shr", RTLIL::const_shr}, {"sshr", RTLIL::const_sshr}, {"shift", RTLIL::const_shift},
+	};
+
+	std::mt19937 rng(1);
+	for (int iter = 0; iter < 2000; iter++) {
+		int width_a = 1 + rng() % 64, width_b = 1 + rng() % 64, result_len = 1 + rng() % 64;
+		bool signed_a = rng() % 2, signed_b = rng() % 2;
+		RTLIL::Const a = random_const(rng, width_a);
+		RTLIL::Const b = random_const(rng, width_b);
+
+		for (auto &it : funcs) {
+			RTLIL::Const y_fast, y_big;
+			if (strstr(it.first, "sh") != nullptr) {
+				// small non-negative shift amounts, and a keeps its width
+				// because the shifted-in bits depend on it
+				RTLIL::Const shift_b = random_const(rng, 1 + rng() % 6);
+				shift_b.bits().push_back(RTLIL::State::S0);
+				y_fast = it.second(a, shift_b, signed_a, signed_b, result_len);
+				y_big = it.second(a, widen(shift_b, signed_b), signed_a, signed_b, result_len);
+			} else {
+				y_fast = it.second(a, b, signed_a, signed_b, result_len);
+				y_big = it.second(widen(a, signed_a), widen(b, signed_b), signed_a, signed_b, result_len);
+			}
+			EXPECT_EQ(y_fast.as_string(), y_big.as_string()) << it.first << " " << a.as_string() << " " << b.as_string();
+		}
+	}
+}
+
+YOSYS_NAMESPACE_END
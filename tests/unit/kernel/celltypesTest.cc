@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "kernel/yosys.h"
+#include "kernel/celltypes.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelCellTypesTest : public testing::Test {
+protected:
+	static void SetUpTestSuite() { yosys_setup(); }
+};
+
+TEST_F(KernelCellTypesTest, BuiltinTable)
+{
+	const BuiltinCellTypes &builtin = BuiltinCellTypes::get();
+
+	int slot = builtin.slot(ID($alu));
+	ASSERT_GE(slot, 0);
+	EXPECT_EQ(builtin.entries[slot].type, ID($alu));
+	CellType ct = builtin.cell_type(slot);
+	EXPECT_EQ(ct.inputs, pool<RTLIL::IdString>({ID::A, ID::B, ID::CI, ID::BI}));
+	EXPECT_EQ(ct.outputs, pool<RTLIL::IdString>({ID::X, ID::Y, ID::CO}));
+	EXPECT_TRUE(ct.is_evaluable);
+
+	EXPECT_EQ(builtin.slot(RTLIL::IdString("\\top")), -1);
+	EXPECT_EQ(builtin.port_bit(ID::WIDTH), -1);
+
+	// the generated families
+	for (auto type : {"$_DFF_P_", "$_DFF_NP1_", "$_DFFE_PN0P_", "$_SDFFCE_NN1N_", "$_DLATCHSR_PNP_"})
+		EXPECT_GE(builtin.slot(type), 0) << type;
+	EXPECT_EQ(builtin.slot(RTLIL::IdString("$_SDFFCE_NNNN_")), -1);
+	EXPECT_EQ(builtin.cell_type(builtin.slot(ID($_DFFSRE_PPPP_))).inputs,
+			pool<RTLIL::IdString>({ID::C, ID::S, ID::R, ID::D, ID::E}));
+}
+
+TEST_F(KernelCellTypesTest, Groups)
+{
+	CellTypes ct;
+	EXPECT_FALSE(ct.cell_known(ID($add)));
+
+	ct.setup_internals_eval();
+	EXPECT_TRUE(ct.cell_known(ID($add)));
+	EXPECT_TRUE(ct.cell_evaluable(ID($add)));
+	EXPECT_TRUE(ct.cell_input(ID($add), ID::B));
+	EXPECT_FALSE(ct.cell_output(ID($add), ID::B));
+	EXPECT_TRUE(ct.cell_output(ID($add), ID::Y));
+	EXPECT_FALSE(ct.cell_known(ID($tribuf)));
+	EXPECT_FALSE(ct.cell_known(ID($dff)));
+
+	ct.setup_internals_mem();
+	EXPECT_TRUE(ct.cell_known(ID($dff)));
+	EXPECT_FALSE(ct.cell_evaluable(ID($dff)));
+	EXPECT_TRUE(ct.cell_output(ID($mem_v2), ID::RD_DATA));
+	EXPECT_FALSE(ct.cell_known(ID($anyinit)));
+	EXPECT_FALSE(ct.cell_known(ID($_DFF_P_)));
+
+	ct.clear();
+	EXPECT_FALSE(ct.cell_known(ID($add)));
+	EXPECT_TRUE(ct.all_cell_types().empty());
+}
+
+TEST_F(KernelCellTypesTest, DesignModules)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(RTLIL::escape_id("sub"));
+	module->addWire(ID::A)->port_input = true;
+	module->addWire(ID::Y)->port_output = true;
+	module->fixup_ports();
+
+	CellTypes ct(&design);
+	EXPECT_TRUE(ct.cell_known(ID($_AND_)));
+	EXPECT_TRUE(ct.cell_known(module->name));
+	EXPECT_TRUE(ct.cell_input(module->name, ID::A));
+	EXPECT_TRUE(ct.cell_output(module->name, ID::Y));
+	EXPECT_FALSE(ct.cell_output(module->name, ID::A));
+	EXPECT_FALSE(ct.cell_evaluable(module->name));
+}
+
+TEST_F(KernelCellTypesTest, OverrideAndErase)
+{
+	CellTypes ct;
+	ct.setup();
+
+	// a later setup_type() replaces the builtin description
+	ct.setup_type(ID($add), {ID::A}, {ID::Y});
+	EXPECT_FALSE(ct.cell_input(ID($add), ID::B));
+	EXPECT_FALSE(ct.cell_evaluable(ID($add)));
+
+	ct.erase_type(ID($mul));
+	EXPECT_FALSE(ct.cell_known(ID($mul)));
+	EXPECT_TRUE(ct.cell_known(ID($sub)));
+
+	auto all = ct.all_cell_types();
+	EXPECT_EQ(all.count(ID($mul)), 0);
+	EXPECT_EQ(all.at(ID($add)).inputs, pool<RTLIL::IdString>({ID::A}));
+	EXPECT_EQ(all.at(ID($sub)).inputs, pool<RTLIL::IdString>({ID::A, ID::B}));
+
+	// and setting up the group again restores it
+	ct.setup_internals_eval();
+	EXPECT_TRUE(ct.cell_input(ID($add), ID::B));
+	EXPECT_TRUE(ct.cell_known(ID($mul)));
+	EXPECT_EQ(GetSize(ct.all_cell_types()), GetSize(all) + 1);
+}
+
+TEST_F(KernelCellTypesTest, TableMatchesDict)
+{
+	CellTypes table;
+	table.setup();
+
+	// the same types, all described through setup_type()
+	CellTypes dict;
+	for (auto &it : table.all_cell_types())
+		dict.setup_type(it.first, it.second.inputs, it.second.outputs, it.second.is_evaluable);
+	EXPECT_EQ(GetSize(dict.cell_types), GetSize(table.all_cell_types()));
+
+	const BuiltinCellTypes &builtin = BuiltinCellTypes::get();
+	std::vector<RTLIL::IdString> ports = builtin.port_names;
+	ports.push_back(ID::WIDTH);
+	for (auto &entry : builtin.entries) {
+		EXPECT_EQ(table.cell_known(entry.type), dict.cell_known(entry.type));
+		EXPECT_EQ(table.cell_evaluable(entry.type), dict.cell_evaluable(entry.type));
+		for (auto port : ports) {
+			EXPECT_EQ(table.cell_input(entry.type, port), dict.cell_input(entry.type, port)) << log_id(entry.type) << " " << log_id(port);
+			EXPECT_EQ(table.cell_output(entry.type, port), dict.cell_output(entry.type, port)) << log_id(entry.type) << " " << log_id(port);
+		}
+	}
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include "kernel/yosys.h"
+
+#include <random>
+
+YOSYS_NAMESPACE_BEGIN
+
+template<typename A, typename B>
+static std::vector<typename A::const_iterator::value_type> same_order(const A &a, const B &b)
+{
+	std::vector<typename A::const_iterator::value_type> va(a.begin(), a.end());
+	std::vector<typename A::const_iterator::value_type> vb(b.begin(), b.end());
+	EXPECT_EQ(va, vb);
+	return va;
+}
+
+TEST(KernelHashlibTest, FlatDictMatchesDict)
+{
+	std::mt19937 rng(1);
+	dict<int, int> ref;
+	flat_dict<int, int> flat;
+
+	for (int round = 0; round < 20000; round++) {
+		int key = rng() % 3000;
+		switch (rng() % 6) {
+		case 0:
+		case 1:
+			ref[key] = round;
+			flat[key] = round;
+			break;
+		case 2:
+			EXPECT_EQ(ref.insert({key, round}).second, flat.insert({key, round}).second);
+			break;
+		case 3:
+			EXPECT_EQ(ref.erase(key), flat.erase(key));
+			break;
+		case 4:
+			if (!ref.empty()) {
+				int n = rng() % ref.size();
+				auto rit = ref.erase(ref.element(n));
+				auto fit = flat.erase(flat.element(n));
+				EXPECT_EQ(rit == ref.end(), fit == flat.end());
+			}
+			break;
+		default:
+			EXPECT_EQ(ref.count(key), flat.count(key));
+			EXPECT_EQ(ref.at(key, -1), flat.at(key, -1));
+		}
+		ASSERT_EQ(ref.size(), flat.size());
+		if (round % 1000 == 0)
+			same_order(ref, flat);
+	}
+	same_order(ref, flat);
+
+	flat_dict<int, int> copy = flat;
+	EXPECT_TRUE(copy == flat);
+	for (auto &it : ref)
+		EXPECT_EQ(copy.at(it.first), it.second);
+
+	ref.sort();
+	flat.sort();
+	same_order(ref, flat);
+	for (auto &it : ref)
+		EXPECT_EQ(flat.at(it.first), it.second);
+
+	flat.clear();
+	EXPECT_TRUE(flat.empty());
+	EXPECT_EQ(flat.count(1), 0);
+}
+
+TEST(KernelHashlibTest, FlatPoolMatchesPool)
+{
+	std::mt19937 rng(2);
+	pool<std::string> ref;
+	flat_pool<std::string> flat;
+
+	for (int round = 0; round < 20000; round++) {
+		std::string key = stringf("k%d", int(rng() % 2000));
+		switch (rng() % 4) {
+		case 0:
+		case 1:
+			EXPECT_EQ(ref.insert(key).second, flat.insert(key).second);
+			break;
+		case 2:
+			EXPECT_EQ(ref.erase(key), flat.erase(key));
+			break;
+		default:
+			EXPECT_EQ(ref.count(key), flat.count(key));
+		}
+		ASSERT_EQ(ref.size(), flat.size());
+	}
+	same_order(ref, flat);
+
+	while (!ref.empty())
+		EXPECT_EQ(ref.pop(), flat.pop());
+	EXPECT_TRUE(flat.empty());
+}
+
+TEST(KernelHashlibTest, FlatPoolBackedMfp)
+{
+	idict<int, 1, hash_ops<int>, flat_pool<int>> ids;
+	for (int i = 0; i < 1000; i++)
+		EXPECT_EQ(ids(i * 7), i + 1);
+	EXPECT_EQ(ids.at(70), 11);
+	EXPECT_EQ(ids[11], 70);
+	EXPECT_EQ(ids.at(1, -1), -1);
+
+	mfp<int, hash_ops<int>, flat_pool<int>> sets;
+	for (int i = 0; i < 1000; i++)
+		sets.merge(i, i % 10);
+	sets.promote(3);
+	EXPECT_EQ(sets.find(993), 3);
+	EXPECT_EQ(sets.find(12345), 12345);
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "kernel/rtlil.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace RTLIL {
+
+	class KernelIdStringStressTest : public testing::Test {};
+
+	// The defaults are small enough for every test run but still make the
+	// threads race. Raise them for a longer run, e.g.
+	//   YOSYS_STRESS_THREADS=32 YOSYS_STRESS_NAMES=10000000 ./idstringStressTest
+	static int stress_param(const char *name, int default_value)
+	{
+		const char *value = getenv(name);
+		return value != nullptr ? atoi(value) : default_value;
+	}
+
+	TEST_F(KernelIdStringStressTest, ConcurrentIntern)
+	{
+#ifndef YOSYS_ENABLE_THREADS
+		GTEST_SKIP() << "built without YOSYS_ENABLE_THREADS";
+#else
+		int num_threads = stress_param("YOSYS_STRESS_THREADS", 4);
+		int num_names = stress_param("YOSYS_STRESS_NAMES", 40000);
+		int names_per_thread = num_names / num_threads;
+		int num_shared = 1000;
+
+		std::vector<std::vector<IdString>> shared_ids(num_threads);
+		std::vector<int> mismatches(num_threads);
+
+		auto worker = [&](int thread) {
+			std::vector<IdString> local_ids;
+			for (int i = 0; i < names_per_thread; i++) {
+				// every other name is shared by all threads, the rest are unique to this thread
+				std::string name = (i & 1) ? stringf("\\shared_%d", (i >> 1) % num_shared) :
+						stringf("\\thread_%d_%d", thread, i);
+				IdString id(name);
+				if (id.str() != name)
+					mismatches[thread]++;
+				if ((i & 1) && GetSize(shared_ids[thread]) < num_shared)
+					shared_ids[thread].push_back(id);
+				// keep a window of live ids so that refcounts go up and down
+				local_ids.push_back(id);
+				if (GetSize(local_ids) > 64)
+					local_ids.erase(local_ids.begin());
+			}
+		};
+
+		{
+			IdString::concurrent_scope scope;
+			std::vector<std::thread> threads;
+			for (int i = 0; i < num_threads; i++)
+				threads.emplace_back(worker, i);
+			for (auto &t : threads)
+				t.join();
+		}
+
+		for (int i = 0; i < num_threads; i++) {
+			EXPECT_EQ(mismatches[i], 0);
+			ASSERT_EQ(GetSize(shared_ids[i]), GetSize(shared_ids[0]));
+			for (int j = 0; j < GetSize(shared_ids[i]); j++)
+				EXPECT_EQ(shared_ids[i][j].index_, shared_ids[0][j].index_);
+		}
+
+		// ids that are still referenced survive the sweep at the end of the section
+		for (int j = 0; j < GetSize(shared_ids[0]); j++)
+			EXPECT_EQ(shared_ids[0][j].str(), stringf("\\shared_%d", j));
+#endif
+	}
+
+	TEST_F(KernelIdStringStressTest, FreeAfterConcurrentSection)
+	{
+		int idx;
+		{
+			IdString::concurrent_scope scope;
+			IdString id("\\idstring_stress_short_lived");
+			idx = id.index_;
+		}
+		// the id was dropped while the section was active and swept when it ended
+		EXPECT_EQ(IdString::storage_entry(idx).str, nullptr);
+
+		IdString id("\\idstring_stress_short_lived");
+		EXPECT_EQ(id.str(), "\\idstring_stress_short_lived");
+	}
+}
+
+YOSYS_NAMESPACE_END
@@ -11,4 +11,75 @@ TEST(KernelLogTest, logvValidValues)
 	EXPECT_EQ(7, 7);
 }
 
+static std::string read_back(FILE *f)
+{
+	std::string text;
+	rewind(f);
+	char buf[4096];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		text.append(buf, n);
+	return text;
+}
+
+// Logs the same messages to two files, switching the set of log files in
+// between, and returns what ended up in them
+static std::pair<std::string, std::string> log_to_files(bool async)
+{
+	FILE *f1 = tmpfile(), *f2 = tmpfile();
+	std::vector<FILE*> backup_log_files = log_files;
+	log_async = async;
+
+	log_files = {f1};
+	for (int i = 0; i < 20000; i++) {
+		log("message %d\n", i);
+		if (i % 1000 == 0) {
+			log_files = {f1, f2};
+			log("both %d\n", i);
+			log_files = {f2};
+			log("second %d\n", i);
+			log_files = {f1};
+		}
+	}
+	log_flush();
+
+	log_files = backup_log_files;
+	log_async = false;
+	auto result = std::make_pair(read_back(f1), read_back(f2));
+	fclose(f1);
+	fclose(f2);
+	return result;
+}
+
+TEST(KernelLogTest, AsyncWriterKeepsOrder)
+{
+	auto sync = log_to_files(false);
+	auto async = log_to_files(true);
+	EXPECT_GT(sync.first.size(), 200000u);
+	EXPECT_TRUE(sync.first == async.first);
+	EXPECT_TRUE(sync.second == async.second);
+}
+
+TEST(KernelLogTest, AsyncWriterFlush)
+{
+	FILE *f = tmpfile();
+	std::vector<FILE*> backup_log_files = log_files;
+	std::vector<std::ostream*> backup_log_streams = log_streams;
+	std::ostringstream buf;
+	log_async = true;
+	log_files = {f};
+	log_streams = {&buf};
+
+	log("hello\n");
+	// streams are still written right away
+	EXPECT_EQ(buf.str(), "hello\n");
+	log_flush();
+	EXPECT_EQ(read_back(f), "hello\n");
+
+	log_files = backup_log_files;
+	log_streams = backup_log_streams;
+	log_async = false;
+	fclose(f);
+}
+
 YOSYS_NAMESPACE_END
@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include "kernel/yosys.h"
+#include "kernel/modtools.h"
+#include "kernel/threading.h"
+
+#include <random>
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelModToolsTest : public testing::Test {
+protected:
+	static void SetUpTestSuite() { yosys_setup(); }
+};
+
+// A module with random $and/$not cells over a pool of wires
+static RTLIL::Module *random_module(RTLIL::Design &design, std::mt19937 &rng, std::vector<RTLIL::Wire*> &wires)
+{
+	RTLIL::Module *module = design.addModule(NEW_ID);
+	for (int i = 0; i < 40; i++)
+		wires.push_back(module->addWire(NEW_ID, 4));
+	wires[0]->port_input = true;
+	wires[1]->port_output = true;
+	module->fixup_ports();
+	for (int i = 0; i < 60; i++) {
+		RTLIL::Wire *a = wires[rng() % wires.size()], *b = wires[rng() % wires.size()], *y = wires[rng() % wires.size()];
+		if (rng() % 2)
+			module->addAnd(NEW_ID, a, b, y);
+		else
+			module->addNot(NEW_ID, a, y);
+	}
+	return module;
+}
+
+// Compares an index with a freshly built one, bit by bit
+static void expect_up_to_date(RTLIL::Module *module, ModIndex &index)
+{
+	ModIndex fresh(module);
+	for (auto wire : module->wires())
+		for (int i = 0; i < wire->width; i++) {
+			RTLIL::SigBit bit(wire, i);
+			EXPECT_EQ(index.query_is_input(bit), fresh.query_is_input(bit)) << log_signal(bit);
+			EXPECT_EQ(index.query_is_output(bit), fresh.query_is_output(bit)) << log_signal(bit);
+			EXPECT_EQ(index.query_ports(bit), fresh.query_ports(bit)) << log_signal(bit);
+		}
+}
+
+TEST_F(KernelModToolsTest, SharedIndexFollowsChanges)
+{
+	std::mt19937 rng(1);
+	RTLIL::Design design;
+	std::vector<RTLIL::Wire*> wires;
+	RTLIL::Module *module = random_module(design, rng, wires);
+
+	ModIndex &index = design.modindex(module);
+	EXPECT_EQ(&index, &design.modindex(module));
+	expect_up_to_date(module, index);
+
+	// changes through the API are followed incrementally
+	std::vector<RTLIL::Cell*> cells = module->cells();
+	for (int round = 0; round < 50; round++) {
+		RTLIL::Cell *cell = cells[rng() % cells.size()];
+		switch (rng() % 4) {
+		case 0:
+			cell->setPort(ID::A, wires[rng() % wires.size()]);
+			break;
+		case 1:
+			module->connect(wires[rng() % wires.size()], wires[rng() % wires.size()]);
+			break;
+		case 2:
+			module->addNot(NEW_ID, wires[rng() % wires.size()], wires[rng() % wires.size()]);
+			break;
+		default:
+			module->addCell(NEW_ID, cell);
+		}
+		index.query(RTLIL::State::S0);
+		EXPECT_FALSE(index.auto_reload_module);
+	}
+	expect_up_to_date(module, index);
+
+	// port flags only become visible through fixup_ports()
+	wires[2]->port_output = true;
+	module->fixup_ports();
+	EXPECT_TRUE(index.query_is_output(RTLIL::SigBit(wires[2], 0)));
+	expect_up_to_date(module, index);
+
+	// direct writes need a blackout
+	cells = module->cells();
+	cells.front()->connections_[ID::A] = wires[3];
+	module->blackout();
+	expect_up_to_date(module, index);
+}
+
+TEST_F(KernelModToolsTest, SharedIndexLazyReload)
+{
+	std::mt19937 rng(2);
+	RTLIL::Design design;
+	std::vector<RTLIL::Wire*> wires;
+	RTLIL::Module *module = random_module(design, rng, wires);
+
+	ModIndex &index = design.modindex(module);
+	EXPECT_FALSE(index.auto_reload_module);
+
+	// rewriting more than the whole module without looking at the index
+	// makes it give up and rebuild on the next query, but the sigmap is kept
+	// up to date in the meantime
+	for (int round = 0; round < 4; round++)
+		for (auto cell : module->cells())
+			cell->setPort(ID::Y, wires[rng() % wires.size()]);
+	EXPECT_TRUE(index.auto_reload_module);
+	EXPECT_TRUE(index.database.empty());
+	module->connect(wires[4], wires[5]);
+	EXPECT_EQ(index.sigmap(wires[4]), index.sigmap(wires[5]));
+
+	expect_up_to_date(module, index);
+	EXPECT_FALSE(index.auto_reload_module);
+	EXPECT_EQ(index.auto_reload_counter, 0);
+}
+
+TEST_F(KernelModToolsTest, SharedIndexLifetime)
+{
+	std::mt19937 rng(3);
+	RTLIL::Design design;
+	std::vector<RTLIL::Wire*> wires1, wires2;
+	RTLIL::Module *module1 = random_module(design, rng, wires1);
+	RTLIL::Module *module2 = random_module(design, rng, wires2);
+
+	design.modindex(module1);
+	design.modindex(module2);
+	EXPECT_EQ(GetSize(design.modindex_cache_->indexes), 2);
+	EXPECT_EQ(GetSize(module1->monitors), 1);
+
+	design.modindex_invalidate(module1);
+	EXPECT_EQ(GetSize(design.modindex_cache_->indexes), 1);
+	EXPECT_TRUE(module1->monitors.empty());
+
+	design.remove(module2);
+	EXPECT_TRUE(design.modindex_cache_->indexes.empty());
+
+	design.modindex(module1);
+	design.modindex_invalidate();
+	EXPECT_TRUE(design.modindex_cache_->indexes.empty());
+	EXPECT_TRUE(module1->monitors.empty());
+
+	// the design destructor must drop the index before the module
+	design.modindex(module1);
+}
+
+#ifdef YOSYS_ENABLE_THREADS
+TEST_F(KernelModToolsTest, SharedIndexKeepsPassesParallel)
+{
+	std::mt19937 rng(4);
+	RTLIL::Design design;
+	std::vector<RTLIL::Wire*> wires1, wires2;
+	random_module(design, rng, wires1);
+	random_module(design, rng, wires2);
+
+	// wreduce leaves its indexes in the cache
+	run_pass("wreduce", &design);
+	ASSERT_NE(design.modindex_cache_, nullptr);
+	EXPECT_FALSE(design.modindex_cache_->indexes.empty());
+
+	// each job waits for the other one to start, which only happens in time
+	// when they run on two threads
+	std::atomic<int> started(0), overlapped(0);
+	int bak_yosys_jobs = yosys_jobs;
+	yosys_jobs = 2;
+	Pass::parallel_for_modules(&design, design.modules().to_vector(), [&](RTLIL::Module*) {
+		started++;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while (started < 2 && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::yield();
+		if (started == 2)
+			overlapped++;
+	});
+	yosys_jobs = bak_yosys_jobs;
+	EXPECT_EQ(overlapped.load(), 2);
+}
+#endif
+
+YOSYS_NAMESPACE_END
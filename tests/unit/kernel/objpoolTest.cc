@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelObjPoolTest : public testing::Test {
+protected:
+	static void SetUpTestSuite() { yosys_setup(); }
+};
+
+TEST_F(KernelObjPoolTest, ReusesFreedSlots)
+{
+	ObjectPool<std::string> pool;
+	std::vector<std::string*> strings;
+	for (int i = 0; i < 100; i++)
+		strings.push_back(new (pool.allocate()) std::string(100, 'a' + i % 26));
+
+	std::string *freed = strings[42];
+	freed->~basic_string();
+	pool.deallocate(freed);
+	strings[42] = new (pool.allocate()) std::string("reused");
+#ifdef YOSYS_ENABLE_OBJECT_POOL
+	EXPECT_EQ(strings[42], freed);
+#endif
+
+	for (int i = 0; i < 100; i++) {
+		EXPECT_EQ(*strings[i], i == 42 ? std::string("reused") : std::string(100, 'a' + i % 26));
+		strings[i]->~basic_string();
+		pool.deallocate(strings[i]);
+	}
+}
+
+TEST_F(KernelObjPoolTest, ModuleRemove)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	RTLIL::Wire *a = module->addWire(ID(a));
+
+	std::vector<RTLIL::Cell*> cells;
+	pool<RTLIL::Wire*> wires;
+	for (int i = 0; i < 1000; i++) {
+		RTLIL::Wire *y = module->addWire(stringf("\\y%d", i));
+		cells.push_back(module->addNotGate(stringf("\\c%d", i), a, y));
+		if (i % 2)
+			wires.insert(y);
+	}
+	for (int i = 0; i < 1000; i += 2)
+		module->remove(cells[i]);
+	module->remove(wires);
+	for (int i = 0; i < 500; i++)
+		module->addNotGate(stringf("\\d%d", i), a, module->addWire(stringf("\\z%d", i)));
+
+	EXPECT_EQ(GetSize(module->cells()), 1000);
+	// removing a wire that is still connected adds a $delete_wire in its place
+	EXPECT_EQ(GetSize(module->wires()), 1 + 500 + 500 + 500);
+	for (int i = 1; i < 1000; i += 2) {
+		RTLIL::Cell *cell = module->cell(stringf("\\c%d", i));
+		ASSERT_NE(cell, nullptr);
+		EXPECT_EQ(cell->getPort(ID::A), RTLIL::SigSpec(a));
+		// the output wires of these cells were removed
+		EXPECT_TRUE(cell->getPort(ID::Y).as_wire()->name.begins_with("$delete_wire"));
+	}
+	for (int i = 0; i < 500; i++)
+		EXPECT_EQ(module->cell(stringf("\\d%d", i))->getPort(ID::Y), RTLIL::SigSpec(module->wire(stringf("\\z%d", i))));
+}
+
+TEST_F(KernelObjPoolTest, ModuleReusesSlots)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	RTLIL::Wire *a = module->addWire(ID(a));
+
+	// std::set compares the addresses, pool<> would hash the (new) hashidx_
+	std::set<RTLIL::Wire*> old_wires;
+	std::set<RTLIL::Cell*> old_cells;
+	for (int i = 0; i < 1000; i++) {
+		RTLIL::Wire *y = module->addWire(NEW_ID);
+		old_wires.insert(y);
+		old_cells.insert(module->addNotGate(NEW_ID, a, y));
+	}
+	for (auto cell : old_cells)
+		module->remove(cell);
+	module->remove(pool<RTLIL::Wire*>(old_wires.begin(), old_wires.end()));
+	EXPECT_EQ(GetSize(module->cells()), 0);
+	EXPECT_EQ(GetSize(module->wires()), 1);
+
+	int reused_wires = 0, reused_cells = 0;
+	for (int i = 0; i < 1000; i++) {
+		RTLIL::Wire *y = module->addWire(NEW_ID);
+		reused_wires += old_wires.count(y);
+		reused_cells += old_cells.count(module->addNotGate(NEW_ID, a, y));
+	}
+#ifdef YOSYS_ENABLE_OBJECT_POOL
+	// the new objects take the slots of the removed ones instead of new slabs
+	EXPECT_EQ(reused_wires, 1000);
+	EXPECT_EQ(reused_cells, 1000);
+#endif
+	EXPECT_EQ(GetSize(module->cells()), 1000);
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include "kernel/yosys.h"
+#include "kernel/json.h"
+#include "kernel/profiler.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelProfilerTest : public testing::Test {
+protected:
+	static void SetUpTestSuite() { yosys_setup(); }
+};
+
+TEST_F(KernelProfilerTest, NestedSpans)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	RTLIL::Wire *a = module->addWire(ID(a), 8);
+	RTLIL::Wire *y = module->addWire(ID(y), 8);
+	a->port_input = true;
+	y->port_output = true;
+	module->fixup_ports();
+	// two identical cells, one of which opt removes
+	module->addNot(ID(n1), a, module->addWire(ID(t1), 8));
+	module->addNot(ID(n2), a, module->addWire(ID(t2), 8));
+	module->connect(y, module->wire(ID(t1)));
+
+	Profiler profiler;
+	yosys_profiler = &profiler;
+	run_pass("opt -fast", &design);
+	yosys_profiler = nullptr;
+
+	ASSERT_GE(GetSize(profiler.spans), 2);
+	EXPECT_TRUE(profiler.open_spans.empty());
+	const Profiler::Span &opt = profiler.spans[0];
+	EXPECT_EQ(opt.name, "opt");
+	EXPECT_EQ(opt.command, "opt -fast");
+	EXPECT_EQ(opt.depth, 0);
+	EXPECT_EQ(opt.begin.num_cells, 2);
+	EXPECT_EQ(opt.end.num_cells, 1);
+	EXPECT_EQ(opt.begin.num_wires, 4);
+
+	for (int i = 1; i < GetSize(profiler.spans); i++) {
+		const Profiler::Span &span = profiler.spans[i];
+		EXPECT_EQ(span.depth, 1);
+		EXPECT_GE(span.begin.wall_ns, opt.begin.wall_ns);
+		EXPECT_LE(span.end.wall_ns, opt.end.wall_ns);
+	}
+
+	std::stringstream buf;
+	profiler.write(buf);
+	std::string err;
+	Json trace = Json::parse(buf.str(), err);
+	ASSERT_TRUE(err.empty()) << err;
+	int num_spans = 0;
+	for (auto &event : trace["traceEvents"].array_items())
+		if (event["ph"].string_value() == "X") {
+			if (num_spans++ == 0) {
+				EXPECT_EQ(event["name"].string_value(), "opt");
+				EXPECT_EQ(event["args"]["cells_after"].int_value(), 1);
+			}
+		}
+	EXPECT_EQ(num_spans, GetSize(profiler.spans));
+}
+
+YOSYS_NAMESPACE_END
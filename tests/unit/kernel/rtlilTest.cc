@@ -74,6 +74,52 @@ namespace RTLIL {
 		}
 
 	}
+
+	TEST_F(KernelRtlilTest, ConstPacked)
+	{
+		std::vector<State> v;
+		for (int i = 0; i < 100; i++)
+			v.push_back(State(i * 7 % 4));
+		Const c(v);
+		Const c_packed(v);
+		EXPECT_TRUE(c_packed.pack());
+		EXPECT_TRUE(c_packed.is_packed());
+
+		// reads do not unpack
+		EXPECT_EQ(c_packed.size(), 100);
+		for (int i = 0; i < 100; i++)
+			EXPECT_EQ(c_packed[i], v[i]);
+		EXPECT_TRUE(c_packed == c);
+		EXPECT_EQ(c_packed.hash(), c.hash());
+		EXPECT_EQ(c_packed.as_string(), c.as_string());
+		EXPECT_TRUE(c_packed.is_packed());
+
+		Const copy = c_packed;
+		EXPECT_TRUE(copy.is_packed());
+		EXPECT_TRUE(copy == c);
+
+		// the word-level checks agree with the per-bit ones
+		for (auto state : {State::S0, State::S1, State::Sx, State::Sz}) {
+			for (int width : {0, 1, 31, 32, 33, 64, 65}) {
+				Const plain(state, width);
+				Const packed(state, width);
+				packed.pack();
+				EXPECT_EQ(packed.is_fully_zero(), plain.is_fully_zero());
+				EXPECT_EQ(packed.is_fully_ones(), plain.is_fully_ones());
+				EXPECT_EQ(packed.is_fully_def(), plain.is_fully_def());
+				EXPECT_EQ(packed.is_fully_undef(), plain.is_fully_undef());
+				EXPECT_EQ(packed.is_fully_undef_x_only(), plain.is_fully_undef_x_only());
+				EXPECT_EQ(packed.as_bool(), plain.as_bool());
+				EXPECT_TRUE(packed.is_packed());
+			}
+		}
+
+		// bits() unpacks
+		c_packed.bits()[0] = State::Sm;
+		EXPECT_TRUE(c_packed.is_bits());
+		EXPECT_FALSE(c_packed.pack());
+		EXPECT_TRUE(c_packed.is_bits());
+	}
 }
 
 YOSYS_NAMESPACE_END
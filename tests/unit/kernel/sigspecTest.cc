@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "kernel/yosys.h"
+
+#include <atomic>
+
+// Count heap allocations made by this test binary. GCC warns about free()
+// on pointers from operator new once it inlines both into the caller.
+#if defined(__GNUC__) && !defined(__clang__)
+#  pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<long long> num_allocations(0);
+
+void *operator new(size_t size)
+{
+	num_allocations++;
+	if (void *p = malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelSigSpecTest : public testing::Test {
+protected:
+	static void SetUpTestSuite() { yosys_setup(); }
+};
+
+TEST_F(KernelSigSpecTest, SmallSignalsDoNotAllocate)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	RTLIL::Wire *wire = module->addWire(ID(w), 8);
+	RTLIL::Cell *cell = module->addCell(ID(c), ID($not));
+	cell->setPort(ID::A, SigSpec());
+	int count = 0;
+
+	long long start = num_allocations;
+	{
+		SigSpec whole(wire);
+		SigSpec copy = whole;
+		SigSpec part(wire, 2, 4);
+		SigSpec bit = part.extract(1);
+		SigSpec bit_copy = bit;
+		for (auto &b : bit_copy)
+			count += b.offset;
+		count += copy == whole;
+		count += copy.is_wire() + part.is_chunk() + bit.as_bit().offset;
+		cell->setPort(ID::A, part);
+		cell->setPort(ID::A, whole);
+	}
+	EXPECT_EQ(num_allocations - start, 0);
+	EXPECT_EQ(count, 3 + 1 + 2 + 3);
+}
+
+// A word-level module with chains of arithmetic, comparisons and muxes,
+// including duplicated and partially constant logic for opt to remove
+static void build_design(RTLIL::Design &design, int num_stages)
+{
+	RTLIL::Module *module = design.addModule(ID(top));
+	RTLIL::Wire *a = module->addWire(ID(a), 16);
+	RTLIL::Wire *b = module->addWire(ID(b), 16);
+	RTLIL::Wire *c = module->addWire(ID(c), 16);
+	RTLIL::Wire *y = module->addWire(ID(y), 16);
+	a->port_input = b->port_input = c->port_input = true;
+	y->port_output = true;
+
+	SigSpec acc = a;
+	for (int i = 0; i < num_stages; i++) {
+		SigSpec sum = module->Add(NEW_ID, acc, b);
+		SigSpec sum2 = module->Add(NEW_ID, b, acc);
+		SigSpec masked = module->And(NEW_ID, sum2, RTLIL::Const(0xff00, 16));
+		SigSpec lt = module->Lt(NEW_ID, acc, c);
+		SigSpec sel = module->Mux(NEW_ID, sum, masked, lt);
+		acc = module->Xor(NEW_ID, sel, {acc.extract(8, 8), acc.extract(0, 8)});
+	}
+	module->connect(y, acc);
+	module->fixup_ports();
+}
+
+TEST_F(KernelSigSpecTest, SynthScriptAllocations)
+{
+	int num_stages = 100;
+
+	RTLIL::Design design;
+	build_design(design, num_stages);
+
+	long long start = num_allocations;
+	run_pass("opt", &design);
+	run_pass("wreduce", &design);
+	run_pass("alumacc", &design);
+	run_pass("opt", &design);
+	run_pass("simplemap", &design);
+	run_pass("opt", &design);
+
+	// About 18k allocations per stage with single-chunk and single-bit
+	// signals kept inline, and 22k when they are on the heap.
+	EXPECT_LT(num_allocations - start, 20000LL * num_stages);
+	EXPECT_GT(GetSize(design.module(ID(top))->cells()), 0);
+}
+
+YOSYS_NAMESPACE_END
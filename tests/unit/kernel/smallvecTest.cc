@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "kernel/yosys.h"
+
+#include <random>
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelSmallvecTest : public testing::Test {};
+
+TEST_F(KernelSmallvecTest, StaysInlineUpToN)
+{
+	smallvec<int, 2> v;
+	v.push_back(1);
+	v.push_back(2);
+	EXPECT_EQ(v.capacity(), 2u);
+	v.push_back(3);
+	EXPECT_GT(v.capacity(), 2u);
+	EXPECT_EQ(std::vector<int>(v), std::vector<int>({1, 2, 3}));
+
+	v.resize(1);
+	smallvec<int, 2> w = std::move(v);
+	EXPECT_EQ(w.size(), 1u);
+	EXPECT_EQ(w[0], 1);
+	EXPECT_TRUE(v.empty());
+	EXPECT_EQ(v.capacity(), 2u);
+}
+
+// Apply the same random operations to a smallvec and a std::vector, using a
+// type with a destructor so that lifetime mistakes show up (e.g. in ASan)
+TEST_F(KernelSmallvecTest, MatchesStdVector)
+{
+	std::mt19937 rng(1);
+	for (int iter = 0; iter < 200; iter++) {
+		smallvec<std::string, 2> v, other_v;
+		std::vector<std::string> ref, other_ref;
+
+		for (int step = 0; step < 50; step++) {
+			std::string value = std::to_string(rng() % 100) + std::string(rng() % 30, 'x');
+			size_t pos = ref.empty() ? 0 : rng() % ref.size();
+			switch (rng() % 10) {
+			case 0:
+			case 1:
+				v.push_back(value);
+				ref.push_back(value);
+				break;
+			case 2:
+				if (!ref.empty()) {
+					v.push_back(v[pos]);
+					ref.push_back(ref[pos]);
+				}
+				break;
+			case 3:
+				v.insert(v.begin() + pos, value);
+				ref.insert(ref.begin() + pos, value);
+				break;
+			case 4: {
+				// the inserted range is part of the vector itself
+				v.insert(v.begin() + pos, v.begin(), v.begin() + pos);
+				std::vector<std::string> prefix(ref.begin(), ref.begin() + pos);
+				ref.insert(ref.begin() + pos, prefix.begin(), prefix.end());
+				break;
+			}
+			case 5:
+				if (!ref.empty()) {
+					size_t len = rng() % (ref.size() - pos + 1);
+					v.erase(v.begin() + pos, v.begin() + pos + len);
+					ref.erase(ref.begin() + pos, ref.begin() + pos + len);
+				}
+				break;
+			case 6: {
+				size_t size = rng() % 5;
+				v.resize(size, value);
+				ref.resize(size, value);
+				break;
+			}
+			case 7:
+				v.swap(other_v);
+				ref.swap(other_ref);
+				break;
+			case 8:
+				other_v = v;
+				other_ref = ref;
+				break;
+			case 9:
+				if (rng() % 4 == 0) {
+					v.clear();
+					ref.clear();
+				}
+				break;
+			}
+			ASSERT_EQ(std::vector<std::string>(v), ref);
+			ASSERT_EQ(std::vector<std::string>(other_v), other_ref);
+		}
+	}
+}
+
+YOSYS_NAMESPACE_END
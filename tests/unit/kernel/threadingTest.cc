@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include "kernel/yosys.h"
+#include "kernel/threading.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelThreadingTest : public testing::Test {};
+
+TEST_F(KernelThreadingTest, ParallelForRunsEveryJobOnce)
+{
+	std::vector<int> counts(1000);
+	parallel_for(GetSize(counts), 8, [&](int i) {
+		counts[i]++;
+	});
+	for (int count : counts)
+		EXPECT_EQ(count, 1);
+}
+
+TEST_F(KernelThreadingTest, ParallelForRethrowsLowestJob)
+{
+	std::atomic<int> done(0);
+	try {
+		parallel_for(100, 4, [&](int i) {
+			done++;
+			if (i == 17 || i == 42)
+				throw std::runtime_error(std::to_string(i));
+		});
+		FAIL() << "no exception thrown";
+	} catch (std::runtime_error &e) {
+		EXPECT_STREQ(e.what(), "17");
+	}
+	EXPECT_EQ(done.load(), 100);
+}
+
+#ifdef YOSYS_ENABLE_THREADS
+TEST_F(KernelThreadingTest, ThreadPoolFutures)
+{
+	std::vector<int> results(100);
+	std::vector<std::future<void>> futures;
+	{
+		ThreadPool pool(4);
+		for (int i = 0; i < GetSize(results); i++)
+			futures.push_back(pool.submit([&results, i]() {
+				if (i == 42)
+					throw std::runtime_error("42");
+				results[i] = i * i;
+			}));
+		futures[0].wait();
+		EXPECT_EQ(results[0], 0);
+	}
+	for (int i = 0; i < GetSize(results); i++) {
+		if (i == 42) {
+			EXPECT_THROW(futures[i].get(), std::runtime_error);
+			continue;
+		}
+		futures[i].get();
+		EXPECT_EQ(results[i], i * i);
+	}
+}
+#endif
+
+TEST_F(KernelThreadingTest, LogThreadBuffer)
+{
+	std::stringstream out;
+	log_streams.push_back(&out);
+
+	std::vector<LogBuffer> buffers(4);
+	parallel_for(GetSize(buffers), 4, [&](int i) {
+		log_thread_buffer = &buffers[i];
+		log("job %d\n", i);
+		log_thread_buffer = nullptr;
+	});
+	EXPECT_EQ(out.str(), "");
+
+	for (auto &buffer : buffers)
+		log_replay(buffer);
+	EXPECT_EQ(out.str(), "job 0\njob 1\njob 2\njob 3\n");
+
+	log_streams.pop_back();
+}
+
+TEST_F(KernelThreadingTest, LogErrorThrowsOnWorkerThread)
+{
+	std::stringstream out;
+	log_streams.push_back(&out);
+	bool bak_log_error_throw = log_error_throw;
+	log_error_throw = true;
+
+	// a second round would hang if the first one kept the error lock
+	for (int round = 0; round < 2; round++) {
+		std::vector<LogBuffer> buffers(8);
+		std::vector<bool> buffer_kept(GetSize(buffers));
+		EXPECT_THROW(parallel_for(GetSize(buffers), 4, [&](int i) {
+			log_thread_buffer = &buffers[i];
+			try {
+				if (i % 3 == 1)
+					log_error("job %d failed\n", i);
+			} catch (...) {
+				buffer_kept[i] = log_thread_buffer == &buffers[i];
+				log_thread_buffer = nullptr;
+				throw;
+			}
+			log_thread_buffer = nullptr;
+		}), log_cmd_error_exception);
+		for (int i = 1; i < GetSize(buffers); i += 3)
+			EXPECT_TRUE(buffer_kept[i]) << i;
+	}
+	EXPECT_NE(out.str().find("ERROR: job 1 failed"), std::string::npos);
+
+	log_error_throw = bak_log_error_throw;
+	log_streams.pop_back();
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+class PassesOptMergeTest : public testing::Test {
+protected:
+	static void SetUpTestSuite() { yosys_setup(); }
+};
+
+TEST_F(PassesOptMergeTest, NormalizedInputs)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	RTLIL::Wire *a = module->addWire(ID(a), 4);
+	RTLIL::Wire *b = module->addWire(ID(b), 4);
+
+	module->addAnd(NEW_ID, a, b, module->addWire(NEW_ID, 4));
+	module->addAnd(NEW_ID, b, a, module->addWire(NEW_ID, 4));
+	module->addReduceXor(NEW_ID, {SigBit(a, 0), SigBit(a, 1)}, module->addWire(NEW_ID));
+	module->addReduceXor(NEW_ID, {SigBit(a, 1), SigBit(a, 0)}, module->addWire(NEW_ID));
+	module->addReduceAnd(NEW_ID, {SigBit(a, 0), SigBit(a, 1), SigBit(a, 1)}, module->addWire(NEW_ID));
+	module->addReduceAnd(NEW_ID, {SigBit(a, 1), SigBit(a, 0), SigBit(a, 0)}, module->addWire(NEW_ID));
+	module->addSub(NEW_ID, a, b, module->addWire(NEW_ID, 4));
+	module->addSub(NEW_ID, b, a, module->addWire(NEW_ID, 4));
+
+	run_pass("opt_merge", &design);
+	EXPECT_EQ(GetSize(module->cells()), 5);
+}
+
+YOSYS_NAMESPACE_END
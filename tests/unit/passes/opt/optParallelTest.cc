@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include "kernel/yosys.h"
+
+#include <random>
+#include <set>
+
+YOSYS_NAMESPACE_BEGIN
+
+class PassesOptParallelTest : public testing::Test {
+protected:
+	static void SetUpTestSuite() { yosys_setup(); }
+};
+
+// Three levels of four modules each, where every module above the lowest
+// level instantiates modules of the level below. Each module has work for
+// all the passes: constant operands for opt_expr, unused cells for
+// opt_clean, flip-flops with constant enables for opt_dff and zero-extended
+// arithmetic for wreduce.
+static void build_design(RTLIL::Design &design)
+{
+	std::mt19937 rng(1);
+	std::vector<RTLIL::Module*> children;
+	for (int level = 0; level < 3; level++) {
+		std::vector<RTLIL::Module*> modules;
+		for (int m = 0; m < 4; m++) {
+			RTLIL::Module *module = design.addModule(stringf("\\m%d_%d", level, m));
+			RTLIL::Wire *clk = module->addWire(ID(clk));
+			RTLIL::Wire *en = module->addWire(ID(en));
+			RTLIL::Wire *a = module->addWire(ID(a), 8);
+			RTLIL::Wire *b = module->addWire(ID(b), 8);
+			RTLIL::Wire *y = module->addWire(ID(y), 16);
+			clk->port_input = en->port_input = a->port_input = b->port_input = true;
+			y->port_output = true;
+			module->fixup_ports();
+
+			SigSpec acc = module->Add(NEW_ID, {Const(0, 8), a}, {Const(0, 8), b});
+			for (int i = 0; i < 4; i++) {
+				SigSpec masked = module->And(NEW_ID, acc, Const(rng() & 0xffff, 16));
+				module->Not(NEW_ID, masked);
+				SigSpec q = module->addWire(NEW_ID, 16);
+				module->addDffe(NEW_ID, clk, i % 2 ? State::S1 : SigSpec(en), masked, q);
+				acc = module->Xor(NEW_ID, q, module->Or(NEW_ID, acc, Const(0, 16)));
+			}
+			for (int i = 0; level > 0 && i < 3; i++) {
+				RTLIL::Module *child = children[rng() % children.size()];
+				RTLIL::Cell *cell = module->addCell(NEW_ID, child->name);
+				cell->setPort(ID(clk), clk);
+				cell->setPort(ID(en), en);
+				cell->setPort(ID(a), acc.extract(0, 8));
+				cell->setPort(ID(b), acc.extract(8, 8));
+				SigSpec child_y = module->addWire(NEW_ID, 16);
+				cell->setPort(ID(y), child_y);
+				acc = module->Sub(NEW_ID, acc, child_y);
+			}
+			module->connect(y, acc);
+			modules.push_back(module);
+		}
+		children = modules;
+	}
+}
+
+// Which choices the passes make where there are several can depend on the
+// order of IdString indices, which differs from run to run in one process
+// and between threads. Compare what does not depend on it: the ports and the
+// set of cell types of each module.
+static std::string run_opt(int jobs, std::set<std::string> *all_cell_types = nullptr)
+{
+	RTLIL::Design design;
+	build_design(design);
+
+	int bak_yosys_jobs = yosys_jobs;
+	yosys_jobs = jobs;
+	for (auto command : {"opt_expr", "opt_clean", "opt_dff", "wreduce", "opt_expr -full", "simplemap", "opt_dff -sat", "clean"})
+		run_pass(command, &design);
+	yosys_jobs = bak_yosys_jobs;
+
+	std::string summary;
+	design.sort();
+	for (auto module : design.modules()) {
+		summary += log_id(module);
+		for (auto port : module->ports)
+			summary += stringf(" %s[%d]", log_id(port), module->wire(port)->width);
+		std::set<std::string> cell_types;
+		for (auto cell : module->cells())
+			cell_types.insert(cell->type.str());
+		for (auto &type : cell_types)
+			summary += " " + type;
+		summary += "\n";
+		if (all_cell_types)
+			all_cell_types->insert(cell_types.begin(), cell_types.end());
+	}
+	return summary;
+}
+
+TEST_F(PassesOptParallelTest, SameCellTypesForAnyNumberOfJobs)
+{
+	std::set<std::string> cell_types;
+	std::string serial = run_opt(1, &cell_types);
+	EXPECT_EQ(run_opt(2), serial);
+	EXPECT_EQ(run_opt(4), serial);
+
+	// every module went through all the passes
+	for (auto type : {"$and", "$or", "$not", "$dff", "$dffe"})
+		EXPECT_EQ(cell_types.count(type), 0u) << type;
+	EXPECT_EQ(cell_types.count("$_XOR_"), 1u);
+}
+
+YOSYS_NAMESPACE_END
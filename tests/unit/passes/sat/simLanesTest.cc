@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include "kernel/yosys.h"
+#include "kernel/celltypes.h"
+#include "passes/sat/simlanes.h"
+
+#include <random>
+
+YOSYS_NAMESPACE_BEGIN
+
+class PassesSatSimLanesTest : public testing::Test {
+protected:
+	static void SetUpTestSuite() { yosys_setup(); }
+};
+
+static RTLIL::Const lane_const(const SimLaneOps &lanes, const std::vector<int> &sig, int lane)
+{
+	RTLIL::Const value(RTLIL::State::S0, GetSize(sig));
+	for (int i = 0; i < GetSize(sig); i++)
+		if ((lanes.nets[sig[i]] >> lane) & 1)
+			value.bits()[i] = RTLIL::State::S1;
+	return value;
+}
+
+TEST_F(PassesSatSimLanesTest, WordOpsMatchCellTypesEval)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+
+	// signed and unsigned cells (shifts with a signed or unsigned A and an
+	// unsigned B), with operands narrower and wider than the result
+	std::vector<RTLIL::IdString> types = {
+		ID($add), ID($sub), ID($mul), ID($div), ID($mod),
+		ID($shl), ID($shr), ID($sshl), ID($sshr),
+		ID($lt), ID($le), ID($gt), ID($ge), ID($eq), ID($ne),
+	};
+	std::vector<std::tuple<int, int, int>> widths = {{5, 3, 7}, {3, 5, 4}, {6, 6, 12}, {7, 2, 7}};
+	for (auto type : types)
+		for (auto &w : widths)
+			for (bool is_signed : {false, true}) {
+				bool is_shift = type.in(ID($shl), ID($shr), ID($sshl), ID($sshr));
+				RTLIL::Cell *cell = module->addCell(NEW_ID, type);
+				cell->setPort(ID::A, module->addWire(NEW_ID, std::get<0>(w)));
+				cell->setPort(ID::B, module->addWire(NEW_ID, std::get<1>(w)));
+				cell->setPort(ID::Y, module->addWire(NEW_ID, std::get<2>(w)));
+				cell->setParam(ID::A_SIGNED, is_signed);
+				cell->setParam(ID::B_SIGNED, is_signed && !is_shift);
+				cell->fixup_parameters();
+			}
+
+	BitIndex index(module);
+	auto port = [&](RTLIL::Cell *cell, RTLIL::IdString name) {
+		std::vector<int> result;
+		for (auto bit : cell->getPort(name))
+			result.push_back(index(bit));
+		return result;
+	};
+
+	std::mt19937_64 rng(1);
+	SimLaneOps lanes;
+	lanes.nets.assign(index.size(), 0);
+	lanes.nets[RTLIL::State::S1] = ~uint64_t(0);
+	for (int i = BitIndex::num_const_bits; i < index.size(); i++)
+		lanes.nets[i] = rng();
+
+	for (auto cell : module->cells()) {
+		SimLaneOps::op_t op = SimLaneOps::cell_op(cell);
+		std::vector<int> a = port(cell, ID::A), b = port(cell, ID::B), y = port(cell, ID::Y);
+		ASSERT_TRUE(lanes.eval_op(op, a, b, {}, {}, y)) << log_id(cell->type);
+
+		for (int lane = 0; lane < 64; lane++) {
+			RTLIL::Const value_a = lane_const(lanes, a, lane), value_b = lane_const(lanes, b, lane);
+			// undefined bits (division by zero) read as 0 in the lanes
+			RTLIL::Const expected = CellTypes::eval(cell, value_a, value_b);
+			for (auto &bit : expected.bits())
+				if (bit != RTLIL::State::S1)
+					bit = RTLIL::State::S0;
+			EXPECT_EQ(lane_const(lanes, y, lane).as_string(), expected.as_string()) << log_id(cell->type)
+					<< " A_SIGNED=" << cell->getParam(ID::A_SIGNED).as_int()
+					<< " A=" << value_a.as_string() << " B=" << value_b.as_string();
+		}
+	}
+}
+
+YOSYS_NAMESPACE_END
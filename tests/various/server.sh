@@ -0,0 +1,47 @@
+#!/usr/bin/env bash
+
+trap 'echo "ERROR in server.sh" >&2; exit 1' ERR
+
+rm -f server.sock
+../../yosys -q --server server.sock &
+server_pid=$!
+# don't leave the server running if a check fails
+trap 'kill $server_pid 2>/dev/null; rm -f server.sock' EXIT
+
+python3 - <<EOF
+import json, socket, time
+
+s = socket.socket(socket.AF_UNIX)
+for _ in range(100):
+    try:
+        s.connect("server.sock")
+        break
+    except OSError:
+        time.sleep(0.1)
+f = s.makefile("rw")
+
+def request(**kwargs):
+    f.write(json.dumps(kwargs) + "\n")
+    f.flush()
+    response = json.loads(f.readline())
+    assert response["id"] == kwargs["id"], response
+    return response
+
+# a named design is kept between requests and can be copied from
+r = request(id=1, design="lib", commands=["add -mod cell", "add -wire a cell", "add -wire y cell"])
+assert r["status"] == "ok", r
+r = request(id=2, script="design -copy-from lib -as top cell\nselect -assert-count 2 top/w:*")
+assert r["status"] == "ok", r
+
+# errors are reported and don't stop the server
+r = request(id=3, design="lib", commands=["read_verilog nonexistent.v"])
+assert r["status"] == "error" and "nonexistent.v" in r["error"], r
+r = request(id=4, design="lib", commands=["select -assert-count 2 w:*"])
+assert r["status"] == "ok", r
+
+r = request(id=5, design="lib", reset=True, commands=["select -assert-count 0 w:*"], shutdown=True)
+assert r["status"] == "ok", r
+EOF
+
+wait $server_pid
+test ! -e server.sock